@@ -0,0 +1,368 @@
+/***********************************************/
+/* Alocação de registradores por coloração de  */
+/* grafo (Chaitin/Briggs)                      */
+/* Grafo de interferência, união conservadora  */
+/* de cópias, simplificação com coloração      */
+/* otimista e rematerialização de constantes   */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "x86.h"
+
+/* Cores na ordem de preferência (como na varredura linear) */
+static const int cores[] = {
+    X86_RSI, X86_RDI, X86_R8, X86_R9, X86_RCX, X86_RDX, X86_RAX,
+    X86_RBX, X86_R12, X86_R13, X86_R14, X86_R15
+};
+#define K ((int)(sizeof(cores) / sizeof(cores[0])))
+
+/*
+ * Nós 0..X86_NUM_REGS-1 são os registradores físicos (pré-coloridos); o
+ * virtual v é o nó X86_NUM_REGS + v, ou seja, o próprio número do
+ * registrador virtual.
+ */
+typedef struct {
+    int num_nos;
+    int palavras;
+    unsigned long *matriz;      /* interferência, num_nos x num_nos bits */
+    int **adj;                  /* vizinhos (podem ter nós já unidos) */
+    int *num_adj;
+    int *cap_adj;
+    int *grau;                  /* vizinhos ainda presentes */
+    int *alias;                 /* nó que absorveu este na união */
+    int *cor;
+    double *custo;
+    char *usado;                /* virtual aparece no código */
+    char *removido;             /* já empilhado na simplificação */
+
+    int num_copias;
+    int cap_copias;
+    int *copia_dst;
+    int *copia_src;
+} Grafo;
+
+static int interfere(Grafo *g, int a, int b) {
+    return BIT_TEM(g->matriz + (size_t)a * g->palavras, b);
+}
+
+static void add_vizinho(Grafo *g, int a, int b) {
+    if (g->num_adj[a] == g->cap_adj[a]) {
+        g->cap_adj[a] = g->cap_adj[a] ? g->cap_adj[a] * 2 : 8;
+        g->adj[a] = (int*)realloc(g->adj[a], sizeof(int) * g->cap_adj[a]);
+    }
+    g->adj[a][g->num_adj[a]++] = b;
+    g->grau[a]++;
+}
+
+static void add_aresta(Grafo *g, int a, int b) {
+    if (a == b || interfere(g, a, b)) return;
+    // fisico com fisico nao interessa
+    if (!X86_EH_VIRTUAL(a) && !X86_EH_VIRTUAL(b)) return;
+    BIT_POE(g->matriz + (size_t)a * g->palavras, b);
+    BIT_POE(g->matriz + (size_t)b * g->palavras, a);
+    add_vizinho(g, a, b);
+    add_vizinho(g, b, a);
+}
+
+static int achar(Grafo *g, int n) {
+    while (g->alias[n] != n) n = g->alias[n];
+    return n;
+}
+
+/* mov entre registradores: candidata à união */
+static int eh_copia(MInstr *m) {
+    return m->op == M_MOV && m->ops[0].tipo == OPR_REG && m->ops[1].tipo == OPR_REG;
+}
+
+static double peso(MBloco *b) {
+    double p = 1;
+    for (int d = 0; d < b->profundidade && d < 6; d++) p *= 10;
+    return p;
+}
+
+/*
+ * Percorre cada bloco de trás para frente com o conjunto de vivos: o que
+ * uma instrução escreve (ou destrói) interfere com tudo o que está vivo
+ * depois dela. Numa cópia a origem não interfere com o destino.
+ */
+static void construir(MFuncao *mf, Grafo *g) {
+    VivacidadeX86 viv;
+    x86_calcular_vivacidade(mf, &viv);
+    unsigned long *vivos = (unsigned long*)calloc(g->palavras + 1, sizeof(unsigned long));
+
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        memset(vivos, 0, sizeof(unsigned long) * g->palavras);
+        for (int v = 0; v < mf->num_vregs; v++) {
+            if (BIT_TEM(viv.saida[b->ordem], v)) BIT_POE(vivos, X86_NUM_REGS + v);
+        }
+
+        for (MInstr *m = b->ultimo; m; m = m->ant) {
+            int usos[8], defs[8 + X86_NUM_REGS];
+            int num_usos = x86_usos(m, usos);
+            int num_defs = x86_defs(m, defs);
+            int destruidos = x86_regs_destruidos(m);
+            for (int r = 0; r < X86_NUM_REGS; r++) {
+                if (destruidos & (1 << r)) defs[num_defs++] = r;
+            }
+
+            int origem = -1;
+            if (eh_copia(m)) {
+                origem = m->ops[1].reg;
+                g->usado[origem] = 1;
+                g->usado[m->ops[0].reg] = 1;
+                if (g->num_copias == g->cap_copias) {
+                    g->cap_copias = g->cap_copias ? g->cap_copias * 2 : 16;
+                    g->copia_dst = (int*)realloc(g->copia_dst, sizeof(int) * g->cap_copias);
+                    g->copia_src = (int*)realloc(g->copia_src, sizeof(int) * g->cap_copias);
+                }
+                g->copia_dst[g->num_copias] = m->ops[0].reg;
+                g->copia_src[g->num_copias] = origem;
+                g->num_copias++;
+            }
+
+            for (int d = 0; d < num_defs; d++) {
+                int n = defs[d];
+                if (n == X86_RSP || n == X86_RBP) continue;
+                g->usado[n] = 1;
+                g->custo[n] += peso(b);
+                for (int w = 0; w < g->palavras; w++) {
+                    unsigned long bits = vivos[w];
+                    while (bits) {
+                        int bit = __builtin_ctzl(bits);
+                        bits &= bits - 1;
+                        int l = w * 8 * (int)sizeof(unsigned long) + bit;
+                        if (l != origem) add_aresta(g, n, l);
+                    }
+                }
+            }
+            for (int d = 0; d < num_defs; d++) BIT_TIRA(vivos, defs[d]);
+            for (int u = 0; u < num_usos; u++) {
+                g->usado[usos[u]] = 1;
+                g->custo[usos[u]] += peso(b);
+                BIT_POE(vivos, usos[u]);
+            }
+        }
+    }
+    free(vivos);
+    x86_liberar_vivacidade(mf, &viv);
+}
+
+/* Absorve b em a: a herda as interferências de b */
+static void unir(Grafo *g, int a, int b) {
+    g->alias[b] = a;
+    g->custo[a] += g->custo[b];
+    for (int k = 0; k < g->num_adj[b]; k++) {
+        int t = g->adj[b][k];
+        if (g->alias[t] != t) continue;
+        if (interfere(g, a, t)) g->grau[t]--;
+        else add_aresta(g, a, t);
+    }
+}
+
+/* Briggs: a união tem menos de K vizinhos de grau significativo */
+static int briggs(Grafo *g, int a, int b) {
+    int significativos = 0;
+    for (int lado = 0; lado < 2; lado++) {
+        int n = lado == 0 ? a : b;
+        for (int k = 0; k < g->num_adj[n]; k++) {
+            int t = g->adj[n][k];
+            if (g->alias[t] != t) continue;
+            if (lado == 1 && interfere(g, a, t)) continue;
+            if (!X86_EH_VIRTUAL(t) || g->grau[t] >= K) significativos++;
+        }
+    }
+    return significativos < K;
+}
+
+/*
+ * George: todo vizinho de v já interfere com o físico r ou é de grau
+ * baixo. Vizinhos físicos têm cor diferente de r e não atrapalham.
+ */
+static int george(Grafo *g, int r, int v) {
+    for (int k = 0; k < g->num_adj[v]; k++) {
+        int t = g->adj[v][k];
+        if (g->alias[t] != t || !X86_EH_VIRTUAL(t)) continue;
+        if (g->grau[t] < K) continue;
+        if (!interfere(g, r, t)) return 0;
+    }
+    return 1;
+}
+
+static int alocavel(int reg) {
+    for (int c = 0; c < K; c++) {
+        if (cores[c] == reg) return 1;
+    }
+    return 0;
+}
+
+static int unir_copias(MFuncao *mf, Grafo *g) {
+    int unidas = 0, mudou = 1;
+    while (mudou) {
+        mudou = 0;
+        for (int c = 0; c < g->num_copias; c++) {
+            int a = achar(g, g->copia_dst[c]);
+            int b = achar(g, g->copia_src[c]);
+            if (a == b) continue;
+            if (!X86_EH_VIRTUAL(b)) {
+                int t = a;
+                a = b;
+                b = t;
+            }
+            if (!X86_EH_VIRTUAL(b) || interfere(g, a, b)) continue;
+            if (mf->remat && mf->remat[b - X86_NUM_REGS]) continue;
+            if (X86_EH_VIRTUAL(a) && mf->remat && mf->remat[a - X86_NUM_REGS]) continue;
+
+            int ok = X86_EH_VIRTUAL(a) ? briggs(g, a, b) : (alocavel(a) && george(g, a, b));
+            if (!ok) continue;
+            unir(g, a, b);
+            unidas++;
+            mudou = 1;
+        }
+    }
+    return unidas;
+}
+
+/*
+ * Virtuais definidos uma única vez por "mov $imm": em vez de ir para a
+ * pilha, a constante é refeita em cada uso.
+ */
+static void marcar_rematerializaveis(MFuncao *mf) {
+    int *defs = (int*)calloc(mf->num_vregs + 1, sizeof(int));
+    mf->remat = (char*)calloc(mf->num_vregs + 1, 1);
+    mf->remat_valor = (long long*)calloc(mf->num_vregs + 1, sizeof(long long));
+
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        for (MInstr *m = b->primeiro; m; m = m->prox) {
+            int regs[8];
+            int num = x86_defs(m, regs);
+            for (int k = 0; k < num; k++) {
+                if (!X86_EH_VIRTUAL(regs[k])) continue;
+                int v = regs[k] - X86_NUM_REGS;
+                defs[v]++;
+                if (m->op == M_MOV && m->ops[1].tipo == OPR_IMM) {
+                    mf->remat[v] = 1;
+                    mf->remat_valor[v] = m->ops[1].imm;
+                }
+            }
+        }
+    }
+    for (int v = 0; v < mf->num_vregs; v++) {
+        if (defs[v] != 1) mf->remat[v] = 0;
+    }
+    free(defs);
+}
+
+/*
+ * Simplificação com escolha otimista (Briggs): nós de grau menor que K
+ * saem primeiro; sem nenhum, sai o de menor custo/grau, que ainda pode
+ * receber cor na seleção. Só vai para a pilha quem de fato fica sem cor.
+ */
+static void colorir(MFuncao *mf, Grafo *g) {
+    int *pilha = (int*)malloc(sizeof(int) * (g->num_nos + 1));
+    int topo = 0, restantes = 0;
+
+    for (int n = X86_NUM_REGS; n < g->num_nos; n++) {
+        if (g->usado[n] && g->alias[n] == n) restantes++;
+        else g->removido[n] = 1;
+    }
+
+    while (restantes > 0) {
+        int escolhido = -1;
+        double melhor = 0;
+        for (int n = X86_NUM_REGS; n < g->num_nos; n++) {
+            if (g->removido[n]) continue;
+            if (g->grau[n] < K) {
+                escolhido = n;
+                break;
+            }
+            double custo = g->custo[n];
+            if (mf->remat[n - X86_NUM_REGS]) custo /= 4;
+            custo /= g->grau[n];
+            if (escolhido < 0 || custo < melhor) {
+                escolhido = n;
+                melhor = custo;
+            }
+        }
+
+        g->removido[escolhido] = 1;
+        pilha[topo++] = escolhido;
+        restantes--;
+        for (int k = 0; k < g->num_adj[escolhido]; k++) {
+            int t = g->adj[escolhido][k];
+            if (g->alias[t] == t) g->grau[t]--;
+        }
+    }
+
+    while (topo > 0) {
+        int n = pilha[--topo];
+        int ocupadas = 0;
+        for (int k = 0; k < g->num_adj[n]; k++) {
+            int t = achar(g, g->adj[n][k]);
+            if (g->cor[t] >= 0) ocupadas |= 1 << g->cor[t];
+        }
+        for (int c = 0; c < K && g->cor[n] < 0; c++) {
+            if (!(ocupadas & (1 << cores[c]))) g->cor[n] = cores[c];
+        }
+    }
+    free(pilha);
+}
+
+void x86_alocar_grafo(MFuncao *mf) {
+    x86_preparar_alocacao(mf);
+    x86_numerar(mf);
+    marcar_rematerializaveis(mf);
+
+    Grafo g;
+    memset(&g, 0, sizeof(g));
+    g.num_nos = X86_NUM_REGS + mf->num_vregs;
+    g.palavras = (g.num_nos + 8 * (int)sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long));
+    g.matriz = (unsigned long*)calloc((size_t)g.num_nos * g.palavras + 1, sizeof(unsigned long));
+    g.adj = (int**)calloc(g.num_nos, sizeof(int*));
+    g.num_adj = (int*)calloc(g.num_nos, sizeof(int));
+    g.cap_adj = (int*)calloc(g.num_nos, sizeof(int));
+    g.grau = (int*)calloc(g.num_nos, sizeof(int));
+    g.alias = (int*)malloc(sizeof(int) * g.num_nos);
+    g.cor = (int*)malloc(sizeof(int) * g.num_nos);
+    g.custo = (double*)calloc(g.num_nos, sizeof(double));
+    g.usado = (char*)calloc(g.num_nos, 1);
+    g.removido = (char*)calloc(g.num_nos, 1);
+    for (int n = 0; n < g.num_nos; n++) {
+        g.alias[n] = n;
+        g.cor[n] = X86_EH_VIRTUAL(n) ? -1 : n;
+    }
+
+    construir(mf, &g);
+    mf->num_copias_unidas = unir_copias(mf, &g);
+    colorir(mf, &g);
+
+    for (int v = 0; v < mf->num_vregs; v++) {
+        int n = X86_NUM_REGS + v;
+        if (!g.usado[n]) continue;
+        mf->num_intervalos++;
+        int cor = g.cor[achar(&g, n)];
+        if (cor >= 0) {
+            mf->reg_vreg[v] = cor;
+            if (x86_preservado(cor)) mf->salvos |= 1 << cor;
+            mf->remat[v] = 0;
+        } else {
+            mf->num_spills++;
+            if (!mf->remat[v]) mf->slot_vreg[v] = mf->num_slots++;
+        }
+    }
+
+    for (int n = 0; n < g.num_nos; n++) free(g.adj[n]);
+    free(g.adj);
+    free(g.num_adj);
+    free(g.cap_adj);
+    free(g.grau);
+    free(g.alias);
+    free(g.cor);
+    free(g.custo);
+    free(g.usado);
+    free(g.removido);
+    free(g.matriz);
+    free(g.copia_dst);
+    free(g.copia_src);
+}
@@ -0,0 +1,198 @@
+/***********************************************/
+/* Alocação de registradores por varredura     */
+/* linear (Poletto e Sarkar)                   */
+/* Um intervalo de vida por virtual, calculado */
+/* da vivacidade dos blocos de máquina         */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "x86.h"
+
+/*
+ * Ordem de preferência: primeiro os que a função pode destruir à vontade
+ * (um intervalo que atravessa uma chamada conflita com todos eles e acaba
+ * num preservado), depois os preservados, que custam salvar no prólogo.
+ * r10 e r11 ficam para o reescritor.
+ */
+static const int ordem_regs[] = {
+    X86_RSI, X86_RDI, X86_R8, X86_R9, X86_RCX, X86_RDX, X86_RAX,
+    X86_RBX, X86_R12, X86_R13, X86_R14, X86_R15
+};
+#define NUM_ALOCAVEIS ((int)(sizeof(ordem_regs) / sizeof(ordem_regs[0])))
+
+typedef struct {
+    int vreg;
+    int inicio;
+    int fim;
+    int reg;
+} Intervalo;
+
+/* Trechos em que um registrador físico está ocupado pelo próprio código */
+typedef struct {
+    int num;
+    int cap;
+    int *ini;
+    int *fim;
+} Faixas;
+
+static void add_faixa(Faixas *f, int ini, int fim) {
+    if (f->num == f->cap) {
+        f->cap = f->cap ? f->cap * 2 : 16;
+        f->ini = (int*)realloc(f->ini, sizeof(int) * f->cap);
+        f->fim = (int*)realloc(f->fim, sizeof(int) * f->cap);
+    }
+    f->ini[f->num] = ini;
+    f->fim[f->num] = fim;
+    f->num++;
+}
+
+static int conflita(Faixas *f, int ini, int fim) {
+    for (int k = 0; k < f->num; k++) {
+        if (f->ini[k] <= fim && f->fim[k] >= ini) return 1;
+    }
+    return 0;
+}
+
+static void estender(Intervalo *iv, int v, int pos) {
+    if (pos < iv[v].inicio) iv[v].inicio = pos;
+    if (pos > iv[v].fim) iv[v].fim = pos;
+}
+
+static int comparar_inicio(const void *a, const void *b) {
+    const Intervalo *x = *(Intervalo* const*)a;
+    const Intervalo *y = *(Intervalo* const*)b;
+    if (x->inicio != y->inicio) return x->inicio - y->inicio;
+    return x->vreg - y->vreg;
+}
+
+/*
+ * Intervalos dos virtuais e faixas ocupadas dos físicos. Registradores
+ * físicos aparecem só em trechos curtos dentro de um bloco (argumentos,
+ * retorno, divisão) e nos pontos em que uma instrução os destrói.
+ */
+static void construir_intervalos(MFuncao *mf, Intervalo *iv, Faixas *faixas) {
+    VivacidadeX86 viv;
+    x86_calcular_vivacidade(mf, &viv);
+
+    for (int v = 0; v < mf->num_vregs; v++) {
+        iv[v].vreg = v;
+        iv[v].inicio = INT_MAX;
+        iv[v].fim = -1;
+        iv[v].reg = -1;
+    }
+
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        if (!b->primeiro) continue;
+        int primeiro = 2 * b->primeiro->pos;
+        int ultimo = 2 * b->ultimo->pos + 1;
+        for (int v = 0; v < mf->num_vregs; v++) {
+            if (BIT_TEM(viv.entrada[b->ordem], v)) estender(iv, v, primeiro);
+            if (BIT_TEM(viv.saida[b->ordem], v)) estender(iv, v, ultimo);
+        }
+
+        int ultimo_def[X86_NUM_REGS];
+        for (int r = 0; r < X86_NUM_REGS; r++) ultimo_def[r] = primeiro;
+
+        for (MInstr *m = b->primeiro; m; m = m->prox) {
+            int regs[8];
+            int num = x86_usos(m, regs);
+            for (int k = 0; k < num; k++) {
+                if (X86_EH_VIRTUAL(regs[k])) estender(iv, regs[k] - X86_NUM_REGS, 2 * m->pos);
+                else add_faixa(&faixas[regs[k]], ultimo_def[regs[k]], 2 * m->pos);
+            }
+            num = x86_defs(m, regs);
+            for (int k = 0; k < num; k++) {
+                if (X86_EH_VIRTUAL(regs[k])) {
+                    estender(iv, regs[k] - X86_NUM_REGS, 2 * m->pos + 1);
+                } else {
+                    ultimo_def[regs[k]] = 2 * m->pos + 1;
+                    add_faixa(&faixas[regs[k]], 2 * m->pos + 1, 2 * m->pos + 1);
+                }
+            }
+            int destruidos = x86_regs_destruidos(m);
+            for (int r = 0; r < X86_NUM_REGS; r++) {
+                if (destruidos & (1 << r)) add_faixa(&faixas[r], 2 * m->pos + 1, 2 * m->pos + 1);
+            }
+        }
+    }
+    x86_liberar_vivacidade(mf, &viv);
+}
+
+static void para_pilha(MFuncao *mf, Intervalo *i) {
+    i->reg = -1;
+    mf->slot_vreg[i->vreg] = mf->num_slots++;
+    mf->num_spills++;
+}
+
+/*
+ * Varredura linear: os intervalos são visitados pelo início; quando não
+ * há registrador livre sem conflito, vai para a pilha o intervalo (o atual
+ * ou um ativo que possa ceder o registrador) que termina mais tarde.
+ */
+void x86_alocar_linear(MFuncao *mf) {
+    x86_preparar_alocacao(mf);
+    x86_numerar(mf);
+
+    Intervalo *iv = (Intervalo*)malloc(sizeof(Intervalo) * (mf->num_vregs + 1));
+    Faixas faixas[X86_NUM_REGS];
+    memset(faixas, 0, sizeof(faixas));
+    construir_intervalos(mf, iv, faixas);
+
+    Intervalo **ordem = (Intervalo**)malloc(sizeof(Intervalo*) * (mf->num_vregs + 1));
+    int num = 0;
+    for (int v = 0; v < mf->num_vregs; v++) {
+        if (iv[v].fim >= 0) ordem[num++] = &iv[v];
+    }
+    qsort(ordem, num, sizeof(Intervalo*), comparar_inicio);
+    mf->num_intervalos = num;
+
+    Intervalo *ativos[X86_NUM_REGS];
+    memset(ativos, 0, sizeof(ativos));
+
+    for (int k = 0; k < num; k++) {
+        Intervalo *atual = ordem[k];
+
+        // intervalos encerrados liberam o registrador
+        for (int r = 0; r < X86_NUM_REGS; r++) {
+            if (ativos[r] && ativos[r]->fim < atual->inicio) ativos[r] = NULL;
+        }
+
+        for (int p = 0; p < NUM_ALOCAVEIS && atual->reg < 0; p++) {
+            int r = ordem_regs[p];
+            if (!ativos[r] && !conflita(&faixas[r], atual->inicio, atual->fim)) atual->reg = r;
+        }
+
+        if (atual->reg < 0) {
+            Intervalo *vitima = NULL;
+            for (int p = 0; p < NUM_ALOCAVEIS; p++) {
+                int r = ordem_regs[p];
+                if (!ativos[r] || conflita(&faixas[r], atual->inicio, atual->fim)) continue;
+                if (!vitima || ativos[r]->fim > vitima->fim) vitima = ativos[r];
+            }
+            if (vitima && vitima->fim > atual->fim) {
+                atual->reg = vitima->reg;
+                para_pilha(mf, vitima);
+            } else {
+                para_pilha(mf, atual);
+                continue;
+            }
+        }
+        ativos[atual->reg] = atual;
+    }
+
+    for (int v = 0; v < mf->num_vregs; v++) {
+        if (iv[v].fim < 0 || iv[v].reg < 0) continue;
+        mf->reg_vreg[v] = iv[v].reg;
+        if (x86_preservado(iv[v].reg)) mf->salvos |= 1 << iv[v].reg;
+    }
+
+    for (int r = 0; r < X86_NUM_REGS; r++) {
+        free(faixas[r].ini);
+        free(faixas[r].fim);
+    }
+    free(ordem);
+    free(iv);
+}
@@ -0,0 +1,152 @@
+/***********************************************/
+/* Alocação de registradores x86-64            */
+/* Alocação trivial (todo virtual na pilha) e  */
+/* reescrita dos virtuais para físicos, com    */
+/* recargas e guardas dos que ficaram na pilha */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "x86.h"
+
+/* Nenhum virtual alocado ainda */
+void x86_preparar_alocacao(MFuncao *mf) {
+    free(mf->reg_vreg);
+    free(mf->slot_vreg);
+    mf->reg_vreg = (int*)malloc(sizeof(int) * (mf->num_vregs + 1));
+    mf->slot_vreg = (int*)malloc(sizeof(int) * (mf->num_vregs + 1));
+    for (int v = 0; v < mf->num_vregs; v++) mf->reg_vreg[v] = mf->slot_vreg[v] = -1;
+    free(mf->remat);
+    free(mf->remat_valor);
+    mf->remat = NULL;
+    mf->remat_valor = NULL;
+}
+
+/*
+ * Sem alocação: cada virtual usado ganha uma posição própria na pilha e é
+ * recarregado em cada uso.
+ */
+void x86_alocar_pilha(MFuncao *mf) {
+    int regs[8];
+    x86_preparar_alocacao(mf);
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        for (MInstr *m = b->primeiro; m; m = m->prox) {
+            int num = x86_usos(m, regs);
+            num += x86_defs(m, regs + num);
+            for (int k = 0; k < num; k++) {
+                if (!X86_EH_VIRTUAL(regs[k])) continue;
+                int v = regs[k] - X86_NUM_REGS;
+                if (mf->slot_vreg[v] < 0) {
+                    mf->slot_vreg[v] = mf->num_slots++;
+                    mf->num_spills++;
+                }
+            }
+        }
+    }
+    mf->num_intervalos = mf->num_spills;
+}
+
+static MOperando posicao(MFuncao *mf, int v) {
+    return x86_mem(X86_RBP, -1, 1, -(mf->bytes_arrays + 8LL * (mf->slot_vreg[v] + 1)));
+}
+
+/*
+ * Troca os virtuais pelo registrador alocado. Os que estão na pilha usam
+ * os temporários r10/r11: são recarregados antes da instrução e guardados
+ * depois dela quando ela os escreve. Uma instrução lê no máximo dois
+ * virtuais distintos na pilha (a seleção garante isso); o que ela só
+ * escreve reaproveita um temporário já lido. Virtuais rematerializáveis
+ * (mf->remat) não têm posição: a constante é refeita antes de cada uso.
+ */
+void x86_reescrever(MFuncao *mf) {
+    const int temps[2] = { X86_TEMP0, X86_TEMP1 };
+
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        MInstr *m = b->primeiro;
+        while (m) {
+            MInstr *prox = m->prox;
+
+            // definição de um virtual rematerializado: refeita em cada uso
+            if (mf->remat && m->op == M_MOV && m->ops[0].tipo == OPR_REG &&
+                X86_EH_VIRTUAL(m->ops[0].reg) && mf->remat[m->ops[0].reg - X86_NUM_REGS] &&
+                mf->reg_vreg[m->ops[0].reg - X86_NUM_REGS] < 0) {
+                x86_remover(b, m);
+                free(m);
+                m = prox;
+                continue;
+            }
+
+            int usos[8], defs[8];
+            int num_usos = x86_usos(m, usos);
+            int num_defs = x86_defs(m, defs);
+
+            // lidos primeiro; um virtual so escrito reaproveita o primeiro temporario
+            int na_pilha[3], temp_de[3], num_pilha = 0, num_lidos = 0;
+            for (int k = 0; k < num_usos + num_defs; k++) {
+                int r = k < num_usos ? usos[k] : defs[k - num_usos];
+                if (!X86_EH_VIRTUAL(r) || mf->reg_vreg[r - X86_NUM_REGS] >= 0) continue;
+                int repetido = 0;
+                for (int p = 0; p < num_pilha; p++) repetido |= na_pilha[p] == r;
+                if (repetido) continue;
+                if (k < num_usos ? num_lidos == 2 : num_pilha == 3) {
+                    fprintf(stderr, "ERRO INTERNO: instrucao com mais de dois valores na pilha em %s\n",
+                            mf->nome);
+                    exit(1);
+                }
+                temp_de[num_pilha] = k < num_usos ? temps[num_lidos++] : temps[0];
+                na_pilha[num_pilha++] = r;
+            }
+
+            for (int p = 0; p < num_pilha; p++) {
+                int v = na_pilha[p] - X86_NUM_REGS;
+                int refeito = mf->remat && mf->remat[v];
+                for (int k = 0; k < num_usos; k++) {
+                    if (usos[k] != na_pilha[p]) continue;
+                    MInstr *carga = x86_nova(M_MOV, refeito ? 4 : 8);
+                    carga->ops[0] = x86_reg(temp_de[p]);
+                    carga->ops[1] = refeito ? x86_imm(mf->remat_valor[v]) : posicao(mf, v);
+                    x86_inserir_antes(b, m, carga);
+                    if (refeito) mf->num_remat++;
+                    else mf->num_recargas++;
+                }
+                for (int k = 0; k < num_defs; k++) {
+                    if (defs[k] != na_pilha[p] || refeito) continue;
+                    MInstr *guarda = x86_nova(M_MOV, 8);
+                    guarda->ops[0] = posicao(mf, v);
+                    guarda->ops[1] = x86_reg(temp_de[p]);
+                    x86_inserir_depois(b, m, guarda);
+                    mf->num_guardas++;
+                }
+            }
+
+            for (int k = 0; k < 2; k++) {
+                MOperando *o = &m->ops[k];
+                if (o->tipo != OPR_REG && o->tipo != OPR_MEM) continue;
+                int *campos[2] = { &o->reg, o->tipo == OPR_MEM ? &o->indice : NULL };
+                for (int c = 0; c < 2; c++) {
+                    if (!campos[c] || !X86_EH_VIRTUAL(*campos[c])) continue;
+                    int v = *campos[c] - X86_NUM_REGS;
+                    if (mf->reg_vreg[v] >= 0) {
+                        *campos[c] = mf->reg_vreg[v];
+                    } else {
+                        for (int p = 0; p < num_pilha; p++) {
+                            if (na_pilha[p] == *campos[c]) {
+                                *campos[c] = temp_de[p];
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+
+            // copia de um registrador para ele mesmo (intervalos encadeados)
+            if (m->op == M_MOV && m->ops[0].tipo == OPR_REG && m->ops[1].tipo == OPR_REG &&
+                m->ops[0].reg == m->ops[1].reg) {
+                x86_remover(b, m);
+                free(m);
+            }
+            m = prox;
+        }
+    }
+}
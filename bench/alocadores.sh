@@ -0,0 +1,48 @@
+#!/bin/sh
+# Compara os alocadores de registradores (varredura linear e coloração de
+# grafo) nos mesmos programas: soma as estatísticas do --relatorio e mede
+# o tempo de execução de cada executável.
+#
+# uso: sh bench/alocadores.sh   (CC aponta para o compilador, padrão
+#      ./cminus_compiler; REPETICOES controla quantas execuções são medidas)
+
+CC=${CC:-./cminus_compiler}
+REPETICOES=${REPETICOES:-3}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/cminus_bench.$$
+mkdir -p "$TMP"
+
+printf "%-10s %-7s %6s %6s %8s %7s %7s %9s\n" programa alocador pilha recarg guardas copias remat tempo
+for prog in "$DIR"/*.cm; do
+    nome=$(basename "$prog" .cm)
+    for aloc in linear grafo; do
+        bin="$TMP/$nome.$aloc"
+        if ! "$CC" -O --relatorio --alocador=$aloc "$prog" -o "$bin" 2> "$TMP/rel"; then
+            echo "$nome: falha ao compilar com --alocador=$aloc"
+            continue
+        fi
+        estat=$(awk '/^\[alocacao\]/ {
+                    for (i = 1; i <= NF; i++) {
+                        if ($i == "pilha,") p += $(i-2)
+                        if ($i ~ /^recargas/) r += $(i-1)
+                        if ($i ~ /^guardas/) g += $(i-1)
+                        if ($i == "copias") c += $(i-1)
+                        if ($i ~ /^rematerializacoes/) m += $(i-1)
+                    }
+                } END { printf "%6d %6d %8d %7d %7d", p, r, g, c, m }' "$TMP/rel")
+
+        inicio=$(date +%s.%N)
+        k=0
+        while [ $k -lt "$REPETICOES" ]; do
+            "$bin" > "$TMP/$nome.$aloc.saida" < /dev/null
+            k=$((k + 1))
+        done
+        fim=$(date +%s.%N)
+        tempo=$(echo "$inicio $fim $REPETICOES" | awk '{ printf "%.3fs", ($2 - $1) / $3 }')
+        printf "%-10s %-7s %s %9s\n" "$nome" "$aloc" "$estat" "$tempo"
+    done
+    if ! cmp -s "$TMP/$nome.linear.saida" "$TMP/$nome.grafo.saida"; then
+        echo "$nome: saidas diferentes entre os alocadores"
+    fi
+done
+rm -rf "$TMP"
@@ -0,0 +1,67 @@
+#!/bin/sh
+# Cache de código por função (--cache): tempo de compilação de um programa
+# gerado com N funções sem o cache, com o cache vazio, com o cache cheio
+# e depois de editar uma só função. O executável com cache é conferido
+# byte a byte com o compilado sem ele. Os nomes das funções não podem ter
+# dígitos, então vêm de três letras.
+#
+# uso: sh bench/cache.sh [N]   (padrão 400; CC aponta para o compilador,
+#      padrão ./cminus_compiler; OPCOES, padrão -O, vai para todas)
+
+CC=${CC:-./cminus_compiler}
+N=${1:-400}
+OPCOES=${OPCOES--O}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/cminus_cache.$$
+mkdir -p "$TMP"
+CMINUS_CACHE="$TMP/cache"
+export CMINUS_CACHE
+
+# gerar arquivo constante: N funções independentes chamadas pelo main
+gerar() {
+    awk -v n="$N" -v k="$2" 'BEGIN {
+        a = "abcdefghijklmnopqrstuvwxyz"
+        print "int g[100];"
+        for (f = 0; f < n; f++) {
+            nome = "f" substr(a, int(f / 676) % 26 + 1, 1) substr(a, int(f / 26) % 26 + 1, 1) substr(a, f % 26 + 1, 1)
+            nomes[f] = nome
+            print "int " nome "(int a, int b) {"
+            print "  int i; int s; int t[10];"
+            print "  i = 0; s = a;"
+            print "  while (i < b) {"
+            for (j = 0; j < 8; j++) {
+                c = (f * 7 + j * 13) % 97 + 1
+                if (f == n - 1 && j == 0) c = k
+                print "    s = s + (i * " c " + a / " (j % 5 + 1) ");"
+                print "    if (s > " c * 50 " ) { s = s - " c "; t[i - i / 10 * 10] = s; } else { g[i - i / 100 * 100] = s; }"
+            }
+            print "    i = i + 1;"
+            print "  }"
+            print "  return s + t[3];"
+            print "}"
+        }
+        print "void main(void) { int s; s = 0;"
+        for (f = 0; f < n; f++) print "  s = s + " nomes[f] "(s, 3);"
+        print "  output(s); }"
+    }' > "$1"
+}
+
+# cada compilação muda o cache: mede uma só
+REPETICOES=1
+. "$DIR/comum.sh"
+
+gerar "$TMP/prog.cm" 1
+gerar "$TMP/editado.cm" 2
+
+sem=$(medir /dev/null $CC $OPCOES -o "$TMP/sem" "$TMP/prog.cm")
+frio=$(medir /dev/null $CC $OPCOES --cache -o "$TMP/frio" "$TMP/prog.cm")
+quente=$(medir /dev/null $CC $OPCOES --cache -o "$TMP/quente" "$TMP/prog.cm")
+editado=$(medir /dev/null $CC $OPCOES --cache -o "$TMP/editado" "$TMP/editado.cm")
+$CC $OPCOES -o "$TMP/editado.sem" "$TMP/editado.cm"
+
+printf "%d funcoes, %s\n" "$N" "$OPCOES"
+printf "%-22s %8ss\n" "sem cache" "$sem" "cache vazio" "$frio" "cache cheio" "$quente" \
+    "uma funcao editada" "$editado"
+cmp -s "$TMP/sem" "$TMP/quente" || echo "executavel com cache diferente do compilado sem ele"
+cmp -s "$TMP/editado.sem" "$TMP/editado" || echo "executavel editado diferente do compilado sem cache"
+rm -rf "$TMP"
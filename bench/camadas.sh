@@ -0,0 +1,32 @@
+#!/bin/sh
+# Execução em camadas (--camadas) contra a máquina virtual pura (--vm) e
+# o código nativo compilado antes de executar (-O --run), nos mesmos
+# programas. A saída das camadas é conferida com a da máquina virtual.
+# Com LIMITE muda o --limite-quente das camadas.
+#
+# uso: sh bench/camadas.sh [programa.cm ...]   (padrão: bench/*.cm; CC
+#      aponta para o compilador, padrão ./cminus_compiler; REPETICOES,
+#      padrão 1, controla quantas execuções são medidas)
+
+CC=${CC:-./cminus_compiler}
+LIMITE=${LIMITE:-1000}
+REPETICOES=${REPETICOES:-1}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/cminus_camadas.$$
+mkdir -p "$TMP"
+[ $# -gt 0 ] || set -- "$DIR"/*.cm
+
+. "$DIR/comum.sh"
+
+printf "%-10s %9s %9s %9s\n" programa vm camadas run
+for prog in "$@"; do
+    nome=$(basename "$prog" .cm)
+    vm=$(medir "$TMP/vm.saida" "$CC" --vm "$prog")
+    camadas=$(medir "$TMP/camadas.saida" "$CC" --camadas --limite-quente="$LIMITE" "$prog")
+    run=$(medir "$TMP/run.saida" "$CC" -O --run "$prog")
+    printf "%-10s %8ss %8ss %8ss\n" "$nome" "$vm" "$camadas" "$run"
+    if ! cmp -s "$TMP/vm.saida" "$TMP/camadas.saida"; then
+        echo "$nome: saida das camadas diferente da maquina virtual"
+    fi
+done
+rm -rf "$TMP"
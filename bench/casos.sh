@@ -0,0 +1,33 @@
+#!/bin/sh
+# Cadeias de if-else-if com tabela de saltos e busca binária: para cada
+# programa, o tempo do executável com -O, com -O pelo compilador ANTES (se
+# dado, por exemplo um build anterior ao passe casos) e com --via-c (o
+# compilador de C do sistema faz troca parecida), e quantas cadeias o
+# passe trocou, por quantas tabelas e desvios de busca.
+# As saídas são conferidas.
+#
+# uso: sh bench/casos.sh [programa.cm ...]   (padrão: os de bench/casos e
+#      bench/*.cm; CC aponta para o compilador, padrão ./cminus_compiler;
+#      ANTES para o compilador de comparação, sem padrão; REPETICOES,
+#      padrão 5, controla quantas execuções são medidas)
+
+CC=${CC:-./cminus_compiler}
+REPETICOES=${REPETICOES:-5}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/cminus_casos.$$
+mkdir -p "$TMP"
+[ $# -eq 0 ] && set -- "$DIR"/casos/*.cm "$DIR"/*.cm
+
+. "$DIR/comum.sh"
+
+printf "%-10s %9s %9s %9s %8s %7s %7s\n" programa "-O" antes "via C" cadeias tabelas desvios
+for prog in "$@"; do
+    nome=$(basename "$prog" .cm)
+    "$CC" -O --relatorio "$prog" -o "$TMP/$nome.com" 2> "$TMP/rel" || continue
+    estat=$(awk '/^\[casos\]/ { c += $3; t += $7; d += $10 } END { printf "%8d %7d %7d", c, t, d }' "$TMP/rel")
+
+    medir_antes_via_c "$nome" "$prog" || continue
+    printf "%-10s %9s %9s %9s %s\n" "$nome" "$com" "$antes" "$c" "$estat"
+    conferir_antes_via_c "$nome"
+done
+rm -rf "$TMP"
@@ -0,0 +1,42 @@
+# Funções comuns aos scripts de bench/, carregadas com . "$DIR/comum.sh"
+# depois de definido o REPETICOES do script (padrão 1 aqui). Não é um
+# benchmark: não roda sozinho.
+
+REPETICOES=${REPETICOES:-1}
+
+# medir saida comando...: melhor tempo, em segundos, de REPETICOES
+# execuções do comando com stdin de ENTRADA (padrão /dev/null) e stdout
+# em 'saida' (a da última execução fica para ser conferida)
+medir() {
+    saida=$1
+    shift
+    k=0
+    while [ $k -lt "$REPETICOES" ]; do
+        inicio=$(date +%s.%N)
+        "$@" > "$saida" < "${ENTRADA:-/dev/null}"
+        fim=$(date +%s.%N)
+        echo "$inicio $fim"
+        k=$((k + 1))
+    done | awk 'NR == 1 || $2 - $1 < m { m = $2 - $1 } END { printf "%.3f", m }'
+}
+
+# medir_antes_via_c nome programa.cm: põe em com, antes e c os tempos de
+# $TMP/nome.com (já compilado com -O pelo script), do -O pelo compilador
+# ANTES (se dado; senão antes é -) e de --via-c; falha se o C não compila
+medir_antes_via_c() {
+    "$CC" --via-c "$2" -o "$TMP/$1.c" || return 1
+    com=$(medir "$TMP/$1.com.saida" "$TMP/$1.com")s
+    antes=-
+    if [ -n "$ANTES" ] && "$ANTES" -O "$2" -o "$TMP/$1.antes"; then
+        antes=$(medir "$TMP/$1.antes.saida" "$TMP/$1.antes")s
+    fi
+    c=$(medir "$TMP/$1.c.saida" "$TMP/$1.c")s
+}
+
+# conferir_antes_via_c nome: as saídas de medir_antes_via_c têm que ser iguais
+conferir_antes_via_c() {
+    if [ "$antes" != - ] && ! cmp -s "$TMP/$1.com.saida" "$TMP/$1.antes.saida"; then
+        echo "$1: saida diferente (antes)"
+    fi
+    cmp -s "$TMP/$1.com.saida" "$TMP/$1.c.saida" || echo "$1: saida diferente (via C)"
+}
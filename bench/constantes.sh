@@ -0,0 +1,33 @@
+#!/bin/sh
+# Divisão e produto por constante: para cada programa, o tempo do
+# executável com -O, com -O pelo compilador ANTES (se dado, por exemplo
+# um build anterior à troca do idiv/imul) e com --via-c (o compilador de C
+# do sistema faz a mesma troca), e quantos idiv e imul sobraram no
+# assembly. As saídas são conferidas.
+#
+# uso: sh bench/constantes.sh [programa.cm ...]   (padrão: os de
+#      bench/constantes e bench/*.cm; CC aponta para o compilador, padrão
+#      ./cminus_compiler; ANTES para o compilador de comparação, sem
+#      padrão; REPETICOES, padrão 5, controla quantas execuções são medidas)
+
+CC=${CC:-./cminus_compiler}
+REPETICOES=${REPETICOES:-5}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/cminus_constantes.$$
+mkdir -p "$TMP"
+[ $# -eq 0 ] && set -- "$DIR"/constantes/*.cm "$DIR"/*.cm
+
+. "$DIR/comum.sh"
+
+printf "%-10s %9s %9s %9s %6s %6s\n" programa "-O" antes "via C" idiv imul
+for prog in "$@"; do
+    nome=$(basename "$prog" .cm)
+    "$CC" -O "$prog" -o "$TMP/$nome.com" || continue
+    estat=$("$CC" -O --asm "$prog" | awk '/^[a-z_]+:/ { f = /^cm_/ } f && /\tidiv/ { d++ } f && /\timul/ { m++ }
+        END { printf "%6d %6d", d, m }')
+
+    medir_antes_via_c "$nome" "$prog" || continue
+    printf "%-10s %9s %9s %9s %s\n" "$nome" "$com" "$antes" "$c" "$estat"
+    conferir_antes_via_c "$nome"
+done
+rm -rf "$TMP"
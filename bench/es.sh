@@ -0,0 +1,64 @@
+#!/bin/sh
+# Mede o runtime de input()/output() num programa limitado por E/S
+# (bench/es/eco.cm): nos executores em processo compara o runtime com
+# buffers (padrão) com scanf/printf ingênuos (--es-stdio); no executável
+# nativo e no de --via-c compara stdin num arquivo (mmap) com stdin num
+# pipe (read em blocos). As saídas são conferidas entre si.
+#
+# uso: sh bench/es.sh [N]   (N inteiros de entrada, padrão 2000000; CC
+#      aponta para o compilador, padrão ./cminus_compiler; REPETICOES,
+#      padrão 1, controla quantas execuções são medidas)
+
+CC=${CC:-./cminus_compiler}
+N=${1:-2000000}
+REPETICOES=${REPETICOES:-1}
+DIR=$(dirname "$0")
+PROG="$DIR/es/eco.cm"
+TMP=${TMPDIR:-/tmp}/cminus_es.$$
+mkdir -p "$TMP"
+
+# entrada pseudoaleatória reproduzível, com negativos
+awk -v n="$N" 'BEGIN {
+    x = 12345
+    print n
+    for (i = 0; i < n; i++) {
+        x = (x * 1103515245 + 12345) % 2147483648
+        print (x % 2000001) - 1000000
+    }
+}' > "$TMP/entrada"
+
+# medir lê stdin do arquivo; pelo pipe (o runtime não pode mapear stdin)
+# a entrada passa por cat
+ENTRADA="$TMP/entrada"
+. "$DIR/comum.sh"
+pelo_pipe() {
+    cat "$ENTRADA" | "$@"
+}
+
+"$CC" -O "$PROG" -o "$TMP/nativo" || exit 1
+"$CC" --via-c "$PROG" -o "$TMP/via-c" || exit 1
+
+printf "%-12s %-16s %9s %9s\n" modo runtime tempo relativo
+for modo in vm fechamentos run nativo via-c; do
+    base="scanf/printf"
+    atual="buffers"
+    case $modo in
+        vm)          lento=$(medir "$TMP/$modo.stdio.saida" "$CC" --vm --es-stdio "$PROG")
+                     rapido=$(medir "$TMP/$modo.saida" "$CC" --vm "$PROG") ;;
+        fechamentos) lento=$(medir "$TMP/$modo.stdio.saida" "$CC" --fechamentos --es-stdio "$PROG")
+                     rapido=$(medir "$TMP/$modo.saida" "$CC" --fechamentos "$PROG") ;;
+        run)         lento=$(medir "$TMP/$modo.stdio.saida" "$CC" -O --run --es-stdio "$PROG")
+                     rapido=$(medir "$TMP/$modo.saida" "$CC" -O --run "$PROG") ;;
+        *)           base="pipe (read)"
+                     atual="arquivo (mmap)"
+                     lento=$(medir "$TMP/$modo.stdio.saida" pelo_pipe "$TMP/$modo")
+                     rapido=$(medir "$TMP/$modo.saida" "$TMP/$modo") ;;
+    esac
+    printf "%-12s %-16s %8ss %9s\n" "$modo" "$base" "$lento" "1.0x"
+    printf "%-12s %-16s %8ss %8sx\n" "$modo" "$atual" "$rapido" \
+        "$(echo "$lento $rapido" | awk '{ printf "%.1f", ($2 > 0 ? $1 / $2 : 0) }')"
+    for s in "$TMP/$modo.stdio.saida" "$TMP/$modo.saida"; do
+        cmp -s "$TMP/vm.saida" "$s" || echo "$modo: saida diferente da de --vm"
+    done
+done
+rm -rf "$TMP"
@@ -0,0 +1,34 @@
+#!/bin/sh
+# Desvios sem valores 0/1 e if-else com cmov: para cada programa, o tempo
+# do executável com -O, com -O pelo compilador ANTES (se dado, por exemplo
+# um build anterior ao passe escolhas) e com --via-c, quantos desvios o
+# passe trocou por escolhas, e quantos cmov e set<cc> ficaram no
+# assembly. As saídas são conferidas.
+#
+# uso: sh bench/escolhas.sh [programa.cm ...]   (padrão: os de
+#      bench/escolhas e bench/*.cm; CC aponta para o compilador, padrão
+#      ./cminus_compiler; ANTES para o compilador de comparação, sem
+#      padrão; REPETICOES, padrão 5, controla quantas execuções são medidas)
+
+CC=${CC:-./cminus_compiler}
+REPETICOES=${REPETICOES:-5}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/cminus_escolhas.$$
+mkdir -p "$TMP"
+[ $# -eq 0 ] && set -- "$DIR"/escolhas/*.cm "$DIR"/*.cm
+
+. "$DIR/comum.sh"
+
+printf "%-10s %9s %9s %9s %8s %6s %6s\n" programa "-O" antes "via C" trocados cmov setcc
+for prog in "$@"; do
+    nome=$(basename "$prog" .cm)
+    "$CC" -O --relatorio "$prog" -o "$TMP/$nome.com" 2> "$TMP/rel" || continue
+    trocados=$(awk '/^\[escolhas\]/ { t += $3 } END { printf "%8d", t }' "$TMP/rel")
+    estat=$("$CC" -O --asm "$prog" | awk '/^[a-z_]+:/ { f = /^cm_/ } f && /\tcmov/ { c++ } f && /\tset/ { s++ }
+        END { printf "%6d %6d", c, s }')
+
+    medir_antes_via_c "$nome" "$prog" || continue
+    printf "%-10s %9s %9s %9s %s %s\n" "$nome" "$com" "$antes" "$c" "$trocados" "$estat"
+    conferir_antes_via_c "$nome"
+done
+rm -rf "$TMP"
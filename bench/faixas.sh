@@ -0,0 +1,58 @@
+#!/bin/sh
+# Mede o interpretador em faixas (--faixas: até 16 entradas de uma vez,
+# cada int um vetor) contra o interpretador por fechamentos executado uma
+# vez por entrada, o mesmo interpretador sem vetores, e contra o lote
+# nativo (-O --lote). As saídas são conferidas entre si.
+#
+# uso: sh bench/faixas.sh [programa.cm] [N] [M]   (padrão
+#      bench/faixas/passos.cm com N = 64 entradas de M = 3000 números;
+#      CC aponta para o compilador, padrão ./cminus_compiler)
+
+CC=${CC:-./cminus_compiler}
+DIR=$(dirname "$0")
+PROG=${1:-$DIR/faixas/passos.cm}
+N=${2:-64}
+M=${3:-3000}
+TMP=${TMPDIR:-/tmp}/cminus_faixas.$$
+mkdir -p "$TMP/entradas"
+
+awk -v n="$N" -v m="$M" -v dir="$TMP/entradas" 'BEGIN {
+    srand(3)
+    for (i = 1; i <= n; i++) {
+        arq = sprintf("%s/t%05d.in", dir, i)
+        printf "%d", m > arq
+        for (j = 0; j < m; j++) printf " %d", 1 + int(rand() * 1000000) > arq
+        print "" > arq
+        close(arq)
+    }
+}'
+
+agora() { date +%s.%N; }
+taxa() { echo "$1 $2 $N" | awk '{ printf "%8.3fs %8.0f execucoes/s", $2 - $1, $3 / ($2 - $1) }'; }
+
+printf "%-22s %9s %19s\n" modo tempo taxa
+inicio=$(agora)
+"$CC" --faixas "$TMP/entradas" "$PROG" > "$TMP/relatorio"
+fim=$(agora)
+printf "%-22s %s\n" "--faixas" "$(taxa "$inicio" "$fim")"
+for e in "$TMP"/entradas/*.in; do mv "${e%.in}.saida" "${e%.in}.faixas"; done
+
+inicio=$(agora)
+for e in "$TMP"/entradas/*.in; do
+    "$CC" --fechamentos "$PROG" < "$e" > "${e%.in}.fechamentos"
+done
+fim=$(agora)
+printf "%-22s %s\n" "--fechamentos" "$(taxa "$inicio" "$fim")"
+
+inicio=$(agora)
+"$CC" -O --lote "$TMP/entradas" "$PROG" > "$TMP/relatorio"
+fim=$(agora)
+printf "%-22s %s\n" "-O --lote" "$(taxa "$inicio" "$fim")"
+
+for e in "$TMP"/entradas/*.in; do
+    b=${e%.in}
+    if ! cmp -s "$b.faixas" "$b.fechamentos" || ! cmp -s "$b.faixas" "$b.saida"; then
+        echo "$(basename "$e"): saidas diferentes"
+    fi
+done
+rm -rf "$TMP"
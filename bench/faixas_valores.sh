@@ -0,0 +1,40 @@
+#!/bin/sh
+# Passe de faixas de valores: para cada programa, o tempo do executável
+# com -O e com -O --sem-faixas, os dois também com --verificar-indices
+# (a remoção de verificações usa as faixas nos dois casos), e quantos
+# desvios o passe dobrou e quantas instruções trocou. As saídas são
+# conferidas.
+#
+# uso: sh bench/faixas_valores.sh [programa.cm ...]   (padrão: os de
+#      bench/faixas_valores e bench/*.cm; CC aponta para o compilador,
+#      padrão ./cminus_compiler; REPETICOES, padrão 5, controla quantas
+#      execuções são medidas)
+
+CC=${CC:-./cminus_compiler}
+REPETICOES=${REPETICOES:-5}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/cminus_faixas_valores.$$
+mkdir -p "$TMP"
+[ $# -eq 0 ] && set -- "$DIR"/faixas_valores/*.cm "$DIR"/*.cm
+
+. "$DIR/comum.sh"
+
+printf "%-12s %9s %11s %9s %11s %8s %8s\n" programa "-O" "sem-faixas" "verif" "verif sem" desvios trocadas
+for prog in "$@"; do
+    nome=$(basename "$prog" .cm)
+    "$CC" -O --relatorio "$prog" -o "$TMP/$nome.com" 2> "$TMP/rel" || continue
+    "$CC" -O --sem-faixas "$prog" -o "$TMP/$nome.sem" || continue
+    "$CC" -O --verificar-indices "$prog" -o "$TMP/$nome.vcom" || continue
+    "$CC" -O --sem-faixas --verificar-indices "$prog" -o "$TMP/$nome.vsem" || continue
+    estat=$(awk '/^\[faixas\]/ { d += $3; t += $6 } END { printf "%8d %8d", d, t }' "$TMP/rel")
+
+    com=$(medir "$TMP/$nome.com.saida" "$TMP/$nome.com")s
+    sem=$(medir "$TMP/$nome.sem.saida" "$TMP/$nome.sem")s
+    vcom=$(medir "$TMP/$nome.vcom.saida" "$TMP/$nome.vcom")s
+    vsem=$(medir "$TMP/$nome.vsem.saida" "$TMP/$nome.vsem")s
+    printf "%-12s %9s %11s %9s %11s %s\n" "$nome" "$com" "$sem" "$vcom" "$vsem" "$estat"
+    for v in sem vcom vsem; do
+        cmp -s "$TMP/$nome.com.saida" "$TMP/$nome.$v.saida" || echo "$nome: saida diferente ($v)"
+    done
+done
+rm -rf "$TMP"
@@ -0,0 +1,57 @@
+#!/bin/sh
+# Mede a execução em lote (--lote: o programa é carregado uma vez e cada
+# entrada roda num fork) contra as alternativas de um corretor ingênuo:
+# executar o binário nativo com fork+exec por entrada, ou compilar e
+# executar (-O --run) por entrada. As saídas são conferidas entre si.
+#
+# uso: sh bench/lote.sh [programa.cm] [N]   (padrão bench/es/eco.cm com
+#      N = 500 entradas pequenas; CC aponta para o compilador, padrão
+#      ./cminus_compiler)
+
+CC=${CC:-./cminus_compiler}
+DIR=$(dirname "$0")
+PROG=${1:-$DIR/es/eco.cm}
+N=${2:-500}
+TMP=${TMPDIR:-/tmp}/cminus_lote.$$
+mkdir -p "$TMP/entradas"
+
+awk -v n="$N" -v dir="$TMP/entradas" 'BEGIN {
+    for (i = 1; i <= n; i++) {
+        arq = sprintf("%s/t%05d.in", dir, i)
+        print 3, i, 7 * i, -i > arq
+        close(arq)
+    }
+}'
+"$CC" -O "$PROG" -o "$TMP/nativo" || exit 1
+
+agora() { date +%s.%N; }
+taxa() { echo "$1 $2 $N" | awk '{ printf "%8.3fs %8.0f execucoes/s", $2 - $1, $3 / ($2 - $1) }'; }
+
+printf "%-22s %9s %19s\n" modo tempo taxa
+inicio=$(agora)
+"$CC" -O --lote "$TMP/entradas" "$PROG" > "$TMP/relatorio"
+fim=$(agora)
+printf "%-22s %s\n" "--lote" "$(taxa "$inicio" "$fim")"
+tail -n 1 "$TMP/relatorio"
+
+inicio=$(agora)
+for e in "$TMP"/entradas/*.in; do
+    "$TMP/nativo" < "$e" > "${e%.in}.nativo"
+done
+fim=$(agora)
+printf "%-22s %s\n" "fork+exec nativo" "$(taxa "$inicio" "$fim")"
+
+inicio=$(agora)
+for e in "$TMP"/entradas/*.in; do
+    "$CC" -O --run "$PROG" < "$e" > "${e%.in}.run"
+done
+fim=$(agora)
+printf "%-22s %s\n" "compilar e -O --run" "$(taxa "$inicio" "$fim")"
+
+for e in "$TMP"/entradas/*.in; do
+    b=${e%.in}
+    if ! cmp -s "$b.saida" "$b.nativo" || ! cmp -s "$b.saida" "$b.run"; then
+        echo "$(basename "$e"): saidas diferentes"
+    fi
+done
+rm -rf "$TMP"
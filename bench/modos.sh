@@ -0,0 +1,51 @@
+#!/bin/sh
+# Compara os modos de execução nos mesmos programas. O interpretador de
+# referência sobre a árvore (--arvore) é a linha de base: a coluna
+# "relativo" diz quantas vezes cada modo é mais rápido que ele, e a saída
+# de cada modo é conferida com a dele.
+#
+# uso: sh bench/modos.sh [programa.cm ...]   (padrão: bench/*.cm; CC
+#      aponta para o compilador, padrão ./cminus_compiler; REPETICOES,
+#      padrão 1, controla quantas execuções são medidas)
+
+CC=${CC:-./cminus_compiler}
+REPETICOES=${REPETICOES:-1}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/cminus_modos.$$
+mkdir -p "$TMP"
+[ $# -gt 0 ] || set -- "$DIR"/*.cm
+
+. "$DIR/comum.sh"
+
+printf "%-10s %-11s %9s %9s\n" programa modo tempo relativo
+for prog in "$@"; do
+    nome=$(basename "$prog" .cm)
+    base=""
+    for modo in arvore fechamentos vm run nativo via-c; do
+        case $modo in
+            arvore) tempo=$(medir "$TMP/$modo.saida" "$CC" --arvore "$prog") ;;
+            fechamentos) tempo=$(medir "$TMP/$modo.saida" "$CC" --fechamentos "$prog") ;;
+            vm)     tempo=$(medir "$TMP/$modo.saida" "$CC" --vm "$prog") ;;
+            run)    tempo=$(medir "$TMP/$modo.saida" "$CC" -O --run "$prog") ;;
+            nativo)
+                if ! "$CC" -O "$prog" -o "$TMP/$nome.bin"; then
+                    echo "$nome: falha ao compilar"
+                    continue
+                fi
+                tempo=$(medir "$TMP/$modo.saida" "$TMP/$nome.bin") ;;
+            via-c)
+                if ! "$CC" --via-c "$prog" -o "$TMP/$nome.c.bin"; then
+                    echo "$nome: falha ao compilar pelo C"
+                    continue
+                fi
+                tempo=$(medir "$TMP/$modo.saida" "$TMP/$nome.c.bin") ;;
+        esac
+        [ -n "$base" ] || base=$tempo
+        printf "%-10s %-11s %8ss %8sx\n" "$nome" "$modo" "$tempo" \
+            "$(echo "$base $tempo" | awk '{ printf "%.1f", ($2 > 0 ? $1 / $2 : 0) }')"
+        if [ $modo != arvore ] && ! cmp -s "$TMP/arvore.saida" "$TMP/$modo.saida"; then
+            echo "$nome: saida de $modo diferente da do interpretador de referencia"
+        fi
+    done
+done
+rm -rf "$TMP"
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Custo da verificação de índices (--verificar-indices): para cada
+# programa, o tempo do executável sem e com verificação, com -O (que
+# elimina e tira verificações dos laços) e sem -O (todas ficam), e quantas
+# verificações o -O removeu ou tirou dos laços. As saídas são conferidas.
+#
+# uso: sh bench/verificacoes.sh   (CC aponta para o compilador, padrão
+#      ./cminus_compiler; REPETICOES, padrão 5, controla quantas execuções são medidas)
+
+CC=${CC:-./cminus_compiler}
+REPETICOES=${REPETICOES:-5}
+DIR=$(dirname "$0")
+TMP=${TMPDIR:-/tmp}/cminus_verificacoes.$$
+mkdir -p "$TMP"
+
+. "$DIR/comum.sh"
+
+printf "%-10s %9s %9s %9s %9s %9s %7s\n" programa "-O" "-O verif" "sem -O" "verif" removidas icadas
+for prog in "$DIR"/*.cm; do
+    nome=$(basename "$prog" .cm)
+    "$CC" -O "$prog" -o "$TMP/$nome.sem" || continue
+    "$CC" -O --verificar-indices --relatorio "$prog" -o "$TMP/$nome.com" 2> "$TMP/rel" || continue
+    "$CC" "$prog" -o "$TMP/$nome.o0" || continue
+    "$CC" --verificar-indices "$prog" -o "$TMP/$nome.o0com" || continue
+    estat=$(awk '/^\[verificacoes\]/ { r += $3; i += $5 } END { printf "%9d %7d", r, i }' "$TMP/rel")
+
+    sem=$(medir "$TMP/$nome.sem.saida" "$TMP/$nome.sem")s
+    com=$(medir "$TMP/$nome.com.saida" "$TMP/$nome.com")s
+    o0=$(medir "$TMP/$nome.o0.saida" "$TMP/$nome.o0")s
+    o0com=$(medir "$TMP/$nome.o0com.saida" "$TMP/$nome.o0com")s
+    printf "%-10s %9s %9s %9s %9s %s\n" "$nome" "$sem" "$com" "$o0" "$o0com" "$estat"
+    cmp -s "$TMP/$nome.sem.saida" "$TMP/$nome.com.saida" || echo "$nome: saida com verificacao diferente"
+    cmp -s "$TMP/$nome.o0.saida" "$TMP/$nome.o0com.saida" || echo "$nome: saida com verificacao diferente sem -O"
+done
+rm -rf "$TMP"
@@ -0,0 +1,709 @@
+/***********************************************/
+/* Compilação da árvore sintática para o       */
+/* bytecode de registradores da máquina        */
+/* virtual                                     */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bytecode.h"
+
+typedef enum {
+    NOME_LOCAL,         /* escalar local ou parâmetro: registrador */
+    NOME_ARRAY_LOCAL,   /* deslocamento na área de arrays do quadro */
+    NOME_PONTEIRO,      /* parâmetro array: registrador com o endereço */
+    NOME_GLOBAL,        /* escalar global: posição na memória */
+    NOME_ARRAY_GLOBAL   /* array global: posição na memória */
+} TipoNome;
+
+typedef struct Nome {
+    char *nome;
+    TipoNome tipo;
+    int valor;
+    int nivel;
+    struct Nome *prox;
+} Nome;
+
+typedef struct {
+    BcPrograma *prog;
+    BcFuncao *f;
+    Nome *nomes;
+    int nivel;
+    int prox_reg;       /* primeiro registrador temporário livre */
+    int prox_var;       /* próximo registrador reservado a um escalar local */
+    int tam_arrays_globais;     /* fim da área dos globais até aqui */
+    int num_escalares_globais;
+    int superinstrucoes;
+} Compilador;
+
+static int compilar_expressao(Compilador *c, TreeNode *node);
+static void compilar_expressao_em(Compilador *c, TreeNode *node, int destino);
+static void compilar_statement(Compilador *c, TreeNode *node);
+
+static void erro_bc(Compilador *c, const char *mensagem, const char *nome) {
+    fprintf(stderr, "ERRO SEMANTICO: %s: %s\n", mensagem, nome);
+    c->prog->erros++;
+}
+
+/* Escopos */
+
+static void declarar(Compilador *c, char *nome, TipoNome tipo, int valor) {
+    Nome *n = (Nome*)malloc(sizeof(Nome));
+    n->nome = nome;
+    n->tipo = tipo;
+    n->valor = valor;
+    n->nivel = c->nivel;
+    n->prox = c->nomes;
+    c->nomes = n;
+}
+
+static Nome* buscar(Compilador *c, const char *nome) {
+    for (Nome *n = c->nomes; n; n = n->prox) {
+        if (strcmp(n->nome, nome) == 0) return n;
+    }
+    return NULL;
+}
+
+static void fechar_escopo(Compilador *c) {
+    while (c->nomes && c->nomes->nivel == c->nivel) {
+        Nome *n = c->nomes;
+        c->nomes = n->prox;
+        free(n);
+    }
+    c->nivel--;
+}
+
+static int buscar_funcao(Compilador *c, const char *nome) {
+    for (int i = 0; i < c->prog->num_funcoes; i++) {
+        if (strcmp(c->prog->funcoes[i].nome, nome) == 0) return i;
+    }
+    return -1;
+}
+
+/* Emissão */
+
+static int emitir(Compilador *c, BcInstr i) {
+    BcFuncao *f = c->f;
+    if (f->tam_codigo == f->cap_codigo) {
+        f->cap_codigo = f->cap_codigo ? f->cap_codigo * 2 : 64;
+        f->codigo = (BcInstr*)realloc(f->codigo, sizeof(BcInstr) * f->cap_codigo);
+    }
+    f->codigo[f->tam_codigo] = i;
+    return f->tam_codigo++;
+}
+
+static int constante(Compilador *c, int valor) {
+    BcFuncao *f = c->f;
+    for (int k = 0; k < f->num_constantes; k++) {
+        if (f->constantes[k] == valor) return k;
+    }
+    if (f->num_constantes == f->cap_constantes) {
+        f->cap_constantes = f->cap_constantes ? f->cap_constantes * 2 : 8;
+        f->constantes = (int*)realloc(f->constantes, sizeof(int) * f->cap_constantes);
+    }
+    f->constantes[f->num_constantes] = valor;
+    return f->num_constantes++;
+}
+
+/* Índice da constante se cabe num campo de 8 bits (superinstruções), senão -1 */
+static int constante_curta(Compilador *c, int valor) {
+    if (!c->superinstrucoes) return -1;
+    BcFuncao *f = c->f;
+    for (int k = 0; k < f->num_constantes && k <= 0xff; k++) {
+        if (f->constantes[k] == valor) return k;
+    }
+    return f->num_constantes <= 0xff ? constante(c, valor) : -1;
+}
+
+static void carregar_constante(Compilador *c, int destino, int valor) {
+    if (valor >= -32768 && valor <= 32767) emitir(c, BC_ABX(BC_LOADI, destino, valor));
+    else emitir(c, BC_ABX(BC_LOADK, destino, constante(c, valor)));
+}
+
+static int novo_registrador(Compilador *c) {
+    int r = c->prox_reg++;
+    if (r >= BC_MAX_REGS) {
+        fprintf(stderr, "ERRO: funcao %s usa mais de %d registradores no bytecode\n",
+                c->f->nome, BC_MAX_REGS);
+        exit(1);
+    }
+    if (c->prox_reg > c->f->num_regs) c->f->num_regs = c->prox_reg;
+    return r;
+}
+
+/* Desvio com alvo ainda desconhecido: completado por ajustar_desvio() */
+static int desvio(Compilador *c, BcOp op, int a) {
+    return emitir(c, BC_ABX(op, a, 0));
+}
+
+static void ajustar_desvio(Compilador *c, int pos, int alvo) {
+    int dist = alvo - (pos + 1);
+    if (dist < -32768 || dist > 32767) {
+        fprintf(stderr, "ERRO: funcao %s grande demais para o bytecode\n", c->f->nome);
+        exit(1);
+    }
+    BcInstr i = c->f->codigo[pos];
+    c->f->codigo[pos] = BC_ABX(BC_OP(i), BC_A(i), dist);
+}
+
+/* Acrescenta 'valor' a uma das listas da função (reg_vars, lacos...) */
+static void anotar(int **lista, int *num, int valor) {
+    *lista = (int*)realloc(*lista, sizeof(int) * (*num + 1));
+    (*lista)[(*num)++] = valor;
+}
+
+/* Expressões */
+
+static int eh_array(Nome *n) {
+    return n->tipo == NOME_ARRAY_LOCAL || n->tipo == NOME_PONTEIRO || n->tipo == NOME_ARRAY_GLOBAL;
+}
+
+/* Registrador com o endereço do array (pode ser o do próprio parâmetro) */
+static int endereco_array(Compilador *c, Nome *n) {
+    if (n->tipo == NOME_PONTEIRO) return n->valor;
+    int r = novo_registrador(c);
+    if (n->tipo == NOME_ARRAY_LOCAL) emitir(c, BC_ABX(BC_LADDR, r, n->valor));
+    else carregar_constante(c, r, n->valor);
+    return r;
+}
+
+static int eh_num(TreeNode *node) {
+    return strcmp(node->node_type, "Num") == 0;
+}
+
+static BcOp op_do_operador(const char *op) {
+    if (strcmp(op, "+") == 0) return BC_ADD;
+    if (strcmp(op, "-") == 0) return BC_SUB;
+    if (strcmp(op, "*") == 0) return BC_MUL;
+    if (strcmp(op, "/") == 0) return BC_DIV;
+    if (strcmp(op, "<") == 0) return BC_LT;
+    if (strcmp(op, "<=") == 0) return BC_LE;
+    if (strcmp(op, ">") == 0) return BC_GT;
+    if (strcmp(op, ">=") == 0) return BC_GE;
+    if (strcmp(op, "==") == 0) return BC_EQ;
+    return BC_NE;
+}
+
+static BcOp comparacao_inversa(BcOp op) {
+    switch (op) {
+        case BC_LT: return BC_GE;
+        case BC_LE: return BC_GT;
+        case BC_GT: return BC_LE;
+        case BC_GE: return BC_LT;
+        case BC_EQ: return BC_NE;
+        default:    return BC_EQ;
+    }
+}
+
+/* A subárvore atribui a alguma variável? */
+static int tem_atribuicao(TreeNode *node) {
+    if (strcmp(node->node_type, "Assign-Expression") == 0) return 1;
+    for (int i = 0; i < node->num_children; i++) {
+        if (tem_atribuicao(node->children[i])) return 1;
+    }
+    return 0;
+}
+
+/*
+ * 'r' já avaliado é o registrador de uma variável e 'depois' pode
+ * atribuir a ela: guarda o valor numa cópia antes de avaliar 'depois'.
+ */
+static int proteger(Compilador *c, int r, int base, TreeNode *depois) {
+    if (r < base && tem_atribuicao(depois)) {
+        int copia = novo_registrador(c);
+        emitir(c, BC_ABC(BC_MOVE, copia, r, 0));
+        return copia;
+    }
+    return r;
+}
+
+static void compilar_chamada(Compilador *c, TreeNode *node, int destino) {
+    TreeNode *args = node->children[0];
+    TreeNode *lista = args->num_children > 0 ? args->children[0] : NULL;
+    int num_args = lista ? lista->num_children : 0;
+
+    if (strcmp(node->value, "input") == 0 || strcmp(node->value, "output") == 0) {
+        int eh_input = node->value[0] == 'i';
+        if (num_args != !eh_input) {
+            erro_bc(c, "Número incorreto de argumentos", node->value);
+            return;
+        }
+        int base = c->prox_reg;
+        if (eh_input) {
+            emitir(c, BC_ABX(BC_INPUT, destino >= 0 ? destino : novo_registrador(c), 0));
+        } else {
+            emitir(c, BC_ABX(BC_OUTPUT, compilar_expressao(c, lista->children[0]), 0));
+            if (destino >= 0) emitir(c, BC_ABX(BC_LOADI, destino, 0));
+        }
+        c->prox_reg = base;
+        return;
+    }
+
+    int indice = buscar_funcao(c, node->value);
+    if (indice < 0) {
+        erro_bc(c, "Função não declarada", node->value);
+        return;
+    }
+    if (num_args != c->prog->funcoes[indice].num_params) {
+        erro_bc(c, "Número incorreto de argumentos", node->value);
+        return;
+    }
+
+    // argumentos em registradores consecutivos no topo, da esquerda para a direita
+    int base = c->prox_reg;
+    int primeiro = novo_registrador(c);
+    for (int a = 1; a < num_args; a++) novo_registrador(c);
+    for (int a = 0; a < num_args; a++) compilar_expressao_em(c, lista->children[a], primeiro + a);
+    emitir(c, BC_ABX(BC_CALL, primeiro, indice));
+    if (destino >= 0 && destino != primeiro) emitir(c, BC_ABC(BC_MOVE, destino, primeiro, 0));
+    c->prox_reg = base;
+}
+
+/* 'destino' negativo: o valor da atribuição não é usado */
+static void compilar_atribuicao(Compilador *c, TreeNode *node, int destino) {
+    TreeNode *var = node->children[0];
+    Nome *n = buscar(c, var->value);
+    if (!n) {
+        erro_bc(c, "Variável não declarada", var->value);
+        return;
+    }
+
+    if (strcmp(var->node_type, "Variavel-Array") == 0) {
+        if (!eh_array(n)) {
+            erro_bc(c, "Variável não é array", var->value);
+            return;
+        }
+        // o índice é avaliado antes do valor
+        int base = c->prox_reg;
+        int k = n->tipo != NOME_PONTEIRO ? constante_curta(c, n->valor) : -1;
+        int end = k < 0 ? endereco_array(c, n) : -1;
+        int indice = proteger(c, compilar_expressao(c, var->children[0]), base, node->children[1]);
+        int valor;
+        if (destino >= 0) {
+            compilar_expressao_em(c, node->children[1], destino);
+            valor = destino;
+        } else {
+            valor = compilar_expressao(c, node->children[1]);
+        }
+        if (k >= 0) {
+            BcOp op = n->tipo == NOME_ARRAY_LOCAL ? BC_STOREL : BC_STOREG;
+            emitir(c, BC_ABC(op, k, indice, valor));
+        } else {
+            emitir(c, BC_ABC(BC_STORE, end, indice, valor));
+        }
+        c->prox_reg = base;
+    } else if (n->tipo == NOME_LOCAL) {
+        compilar_expressao_em(c, node->children[1], n->valor);
+        if (destino >= 0 && destino != n->valor) emitir(c, BC_ABC(BC_MOVE, destino, n->valor, 0));
+    } else if (n->tipo == NOME_GLOBAL) {
+        int base = c->prox_reg;
+        int valor = destino >= 0 ? destino : novo_registrador(c);
+        compilar_expressao_em(c, node->children[1], valor);
+        emitir(c, BC_ABX(BC_SETG, valor, n->valor));
+        c->prox_reg = base;
+    } else {
+        erro_bc(c, "Atribuição a array inteiro", var->value);
+    }
+}
+
+/* Valor da expressão em 'destino' */
+static void compilar_expressao_em(Compilador *c, TreeNode *node, int destino) {
+    if (strcmp(node->node_type, "Num") == 0) {
+        carregar_constante(c, destino, atoi(node->value));
+        return;
+    }
+
+    if (strcmp(node->node_type, "Variavel") == 0) {
+        Nome *n = buscar(c, node->value);
+        if (!n) {
+            erro_bc(c, "Variável não declarada", node->value);
+            return;
+        }
+        if (n->tipo == NOME_LOCAL || n->tipo == NOME_PONTEIRO) {
+            if (destino != n->valor) emitir(c, BC_ABC(BC_MOVE, destino, n->valor, 0));
+        } else if (n->tipo == NOME_GLOBAL) {
+            emitir(c, BC_ABX(BC_GETG, destino, n->valor));
+        } else if (n->tipo == NOME_ARRAY_LOCAL) {
+            emitir(c, BC_ABX(BC_LADDR, destino, n->valor));
+        } else {
+            carregar_constante(c, destino, n->valor);
+        }
+        return;
+    }
+
+    if (strcmp(node->node_type, "Variavel-Array") == 0) {
+        Nome *n = buscar(c, node->value);
+        if (!n || !eh_array(n)) {
+            erro_bc(c, n ? "Variável não é array" : "Variável não declarada", node->value);
+            return;
+        }
+        int base = c->prox_reg;
+        int k = n->tipo != NOME_PONTEIRO ? constante_curta(c, n->valor) : -1;
+        if (k >= 0) {
+            // base constante: índice e base somados na própria instrução
+            BcOp op = n->tipo == NOME_ARRAY_LOCAL ? BC_LOADL : BC_LOADG;
+            emitir(c, BC_ABC(op, destino, compilar_expressao(c, node->children[0]), k));
+        } else {
+            int end = endereco_array(c, n);
+            int indice = compilar_expressao(c, node->children[0]);
+            emitir(c, BC_ABC(BC_LOAD, destino, end, indice));
+        }
+        c->prox_reg = base;
+        return;
+    }
+
+    if (strcmp(node->node_type, "Assign-Expression") == 0) {
+        compilar_atribuicao(c, node, destino);
+        return;
+    }
+
+    if (strcmp(node->node_type, "Function-Call") == 0) {
+        compilar_chamada(c, node, destino);
+        return;
+    }
+
+    if (node->num_children == 3) {
+        int base = c->prox_reg;
+        BcOp op = op_do_operador(node->children[1]->value);
+        TreeNode *esq = node->children[0];
+        TreeNode *dir = node->children[2];
+        // constante à direita vira operando da instrução (soma e produto comutam)
+        if ((op == BC_ADD || op == BC_MUL) && eh_num(esq) && !eh_num(dir)) {
+            esq = node->children[2];
+            dir = node->children[0];
+        }
+        int k = -1;
+        if (op >= BC_ADD && op <= BC_DIV && eh_num(dir)) {
+            int v = atoi(dir->value);
+            if (op != BC_DIV || (v != 0 && v != -1)) k = constante_curta(c, v);
+        }
+        int a = proteger(c, compilar_expressao(c, esq), base, dir);
+        if (k >= 0) emitir(c, BC_ABC(BC_ADDK + (op - BC_ADD), destino, a, k));
+        else emitir(c, BC_ABC(op, destino, a, compilar_expressao(c, dir)));
+        c->prox_reg = base;
+        return;
+    }
+
+    erro_bc(c, "Expressão inválida", node->node_type);
+}
+
+/*
+ * Registrador com o valor da expressão: o da própria variável quando ela
+ * é um escalar local, senão um temporário novo.
+ */
+static int compilar_expressao(Compilador *c, TreeNode *node) {
+    if (strcmp(node->node_type, "Variavel") == 0) {
+        Nome *n = buscar(c, node->value);
+        if (n && (n->tipo == NOME_LOCAL || n->tipo == NOME_PONTEIRO)) return n->valor;
+    }
+    int r = novo_registrador(c);
+    compilar_expressao_em(c, node, r);
+    return r;
+}
+
+/* Comandos */
+
+/*
+ * Desvio tomado quando a condição é falsa; devolve a posição a ajustar.
+ * Uma comparação vira uma superinstrução com a comparação inversa,
+ * seguida do JMP que ela executa ou pula.
+ */
+static int desvio_se_falso(Compilador *c, TreeNode *cond) {
+    if (c->superinstrucoes && cond->num_children == 3) {
+        BcOp op = op_do_operador(cond->children[1]->value);
+        if (op >= BC_LT) {
+            int inverso = comparacao_inversa(op) - BC_LT;
+            TreeNode *dir = cond->children[2];
+            int base = c->prox_reg;
+            int a = proteger(c, compilar_expressao(c, cond->children[0]), base, dir);
+            int k = eh_num(dir) ? constante_curta(c, atoi(dir->value)) : -1;
+            if (k >= 0) emitir(c, BC_ABC(BC_JLTK + inverso, a, k, 0));
+            else emitir(c, BC_ABC(BC_JLT + inverso, a, compilar_expressao(c, dir), 0));
+            c->prox_reg = base;
+            return desvio(c, BC_JMP, 0);
+        }
+    }
+    return desvio(c, BC_JMPF, compilar_expressao(c, cond));
+}
+
+static void compilar_declaracao_local(Compilador *c, TreeNode *decl) {
+    BcFuncao *f = c->f;
+    if (decl->num_children > 1) {
+        declarar(c, decl->value, NOME_ARRAY_LOCAL, f->tam_arrays);
+        anotar(&f->desloc_arrays, &f->num_arrays, f->tam_arrays);
+        f->tam_arrays += atoi(decl->children[1]->value);
+    } else {
+        // cada declaração tem o seu registrador, reservado na entrada da
+        // função (abaixo dos temporários): um escalar mantém o valor entre
+        // iterações do laço em que foi declarado, como na IR
+        int r = c->prox_var++;
+        declarar(c, decl->value, NOME_LOCAL, r);
+        anotar(&f->reg_vars, &f->num_vars, r);
+    }
+}
+
+static void compilar_composto(Compilador *c, TreeNode *node) {
+    c->nivel++;
+    TreeNode *locais = node->children[0];
+    for (int i = 0; i < locais->num_children; i++) {
+        compilar_declaracao_local(c, locais->children[i]);
+    }
+    TreeNode *comandos = node->children[1];
+    for (int i = 0; i < comandos->num_children; i++) {
+        compilar_statement(c, comandos->children[i]);
+    }
+    fechar_escopo(c);
+}
+
+static void compilar_statement(Compilador *c, TreeNode *node) {
+    int base = c->prox_reg;
+
+    if (strcmp(node->node_type, "Expressao-declaracao") == 0) {
+        TreeNode *e = node->children[0];
+        if (strcmp(e->node_type, "Assign-Expression") == 0) compilar_atribuicao(c, e, -1);
+        else if (strcmp(e->node_type, "Function-Call") == 0) compilar_chamada(c, e, -1);
+        else compilar_expressao(c, e);
+    }
+    else if (strcmp(node->node_type, "Composto-declaracao") == 0) {
+        compilar_composto(c, node);
+        return;
+    }
+    else if (strcmp(node->node_type, "If-Statement") == 0 ||
+             strcmp(node->node_type, "If-Else-Statement") == 0) {
+        int para_senao = desvio_se_falso(c, node->children[0]);
+        c->prox_reg = base;
+        compilar_statement(c, node->children[1]);
+        if (node->num_children > 2) {
+            int para_fim = desvio(c, BC_JMP, 0);
+            ajustar_desvio(c, para_senao, c->f->tam_codigo);
+            compilar_statement(c, node->children[2]);
+            ajustar_desvio(c, para_fim, c->f->tam_codigo);
+        } else {
+            ajustar_desvio(c, para_senao, c->f->tam_codigo);
+        }
+    }
+    else if (strcmp(node->node_type, "While-Statement") == 0) {
+        int inicio = c->f->tam_codigo;
+        anotar(&c->f->lacos, &c->f->num_lacos, inicio);
+        int para_fim = desvio_se_falso(c, node->children[0]);
+        c->prox_reg = base;
+        compilar_statement(c, node->children[1]);
+        ajustar_desvio(c, desvio(c, BC_JMP, 0), inicio);
+        ajustar_desvio(c, para_fim, c->f->tam_codigo);
+    }
+    else if (strcmp(node->node_type, "Return-Statement") == 0) {
+        if (node->num_children > 0) {
+            emitir(c, BC_ABX(BC_RET, compilar_expressao(c, node->children[0]), 0));
+        } else {
+            emitir(c, BC_ABX(BC_RET0, 0, 0));
+        }
+    }
+    c->prox_reg = base;
+}
+
+/* Declarações */
+
+/* Escalares declarados em qualquer bloco do corpo */
+static int contar_escalares(TreeNode *node) {
+    if (strcmp(node->node_type, "Var-declaracao") == 0) return node->num_children == 1;
+    int total = 0;
+    for (int i = 0; i < node->num_children; i++) total += contar_escalares(node->children[i]);
+    return total;
+}
+
+static void compilar_funcao(Compilador *c, TreeNode *node) {
+    BcPrograma *p = c->prog;
+    p->funcoes = (BcFuncao*)realloc(p->funcoes, sizeof(BcFuncao) * (p->num_funcoes + 1));
+    BcFuncao *f = &p->funcoes[p->num_funcoes];
+    memset(f, 0, sizeof(BcFuncao));
+    f->nome = node->value;
+    f->retorna_int = strcmp(node->children[0]->value, "int") == 0;
+    if (strcmp(f->nome, "main") == 0) p->principal = p->num_funcoes;
+
+    TreeNode *params = node->children[1];
+    TreeNode *lista = params->num_children > 0 ? params->children[0] : NULL;
+    f->num_params = lista ? lista->num_children : 0;
+    f->param_array = (int*)calloc(f->num_params + 1, sizeof(int));
+    // visível no próprio corpo (recursão)
+    p->num_funcoes++;
+
+    c->f = f;
+    c->prox_reg = 0;
+    c->nivel++;
+    for (int i = 0; i < f->num_params; i++) {
+        TreeNode *param = lista->children[i];
+        int array = strcmp(param->node_type, "params-lista") == 0;
+        int r = novo_registrador(c);
+        declarar(c, param->value, array ? NOME_PONTEIRO : NOME_LOCAL, r);
+        f->param_array[i] = array;
+        if (!array) anotar(&f->reg_vars, &f->num_vars, r);
+    }
+    // os escalares locais vêm logo depois; ENTRAR() da vm os zera
+    c->prox_var = c->prox_reg;
+    for (int i = contar_escalares(node->children[2]); i > 0; i--) novo_registrador(c);
+
+    compilar_composto(c, node->children[2]);
+    // retorno implícito no fim do corpo
+    emitir(c, BC_ABX(BC_RET0, 0, 0));
+    fechar_escopo(c);
+}
+
+static void compilar_global(Compilador *c, TreeNode *node) {
+    BcPrograma *p = c->prog;
+    int pos;
+    if (node->num_children > 1) {
+        pos = c->tam_arrays_globais;
+        declarar(c, node->value, NOME_ARRAY_GLOBAL, pos);
+        c->tam_arrays_globais += atoi(node->children[1]->value);
+    } else {
+        pos = c->num_escalares_globais++;
+        declarar(c, node->value, NOME_GLOBAL, pos);
+    }
+    p->nomes_globais = (char**)realloc(p->nomes_globais, sizeof(char*) * (p->num_globais + 1));
+    p->nomes_globais[p->num_globais] = node->value;
+    anotar(&p->pos_globais, &p->num_globais, pos);
+}
+
+BcPrograma* bc_compilar(TreeNode *raiz, int superinstrucoes) {
+    Compilador c;
+    memset(&c, 0, sizeof(c));
+    c.superinstrucoes = superinstrucoes;
+    c.prog = (BcPrograma*)calloc(1, sizeof(BcPrograma));
+    c.prog->principal = -1;
+
+    // escalares globais primeiro (Bx de GETG/SETG tem 16 bits)
+    TreeNode *declaracoes = raiz->children[0];
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        TreeNode *decl = declaracoes->children[i];
+        if (strcmp(decl->node_type, "Fun-declaracao") != 0 && decl->num_children <= 1) {
+            c.num_escalares_globais++;
+        }
+    }
+    c.tam_arrays_globais = c.num_escalares_globais;
+    c.num_escalares_globais = 0;
+
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        TreeNode *decl = declaracoes->children[i];
+        if (strcmp(decl->node_type, "Fun-declaracao") == 0) compilar_funcao(&c, decl);
+        else compilar_global(&c, decl);
+    }
+    c.prog->tam_globais = c.tam_arrays_globais;
+
+    if (c.num_escalares_globais > 0xffff) {
+        fprintf(stderr, "ERRO: globais escalares demais para o bytecode\n");
+        exit(1);
+    }
+    while (c.nomes) {
+        Nome *n = c.nomes;
+        c.nomes = n->prox;
+        free(n);
+    }
+    return c.prog;
+}
+
+/* Listagem */
+
+static const char *nomes_ops[BC_NUM_OPS] = {
+    "move", "loadi", "loadk", "getg", "setg", "laddr", "load", "store",
+    "add", "sub", "mul", "div", "lt", "le", "gt", "ge", "eq", "ne",
+    "jmp", "jmpf", "call", "input", "output", "ret", "ret0",
+    "addk", "subk", "mulk", "divk",
+    "jlt", "jle", "jgt", "jge", "jeq", "jne",
+    "jltk", "jlek", "jgtk", "jgek", "jeqk", "jnek",
+    "loadg", "loadl", "storeg", "storel"
+};
+
+const char* bc_nome_op(BcOp op) {
+    return op < BC_NUM_OPS ? nomes_ops[op] : "?";
+}
+
+void bc_imprimir(BcPrograma *p, FILE *saida) {
+    for (int i = 0; i < p->num_funcoes; i++) {
+        BcFuncao *f = &p->funcoes[i];
+        fprintf(saida, "funcao %d %s: %d parametros, %d registradores, %d ints de arrays\n",
+                i, f->nome, f->num_params, f->num_regs, f->tam_arrays);
+        for (int pc = 0; pc < f->tam_codigo; pc++) {
+            BcInstr ins = f->codigo[pc];
+            BcOp op = BC_OP(ins);
+            fprintf(saida, "  %4d  %-7s", pc, nomes_ops[op]);
+            switch (op) {
+                case BC_MOVE:
+                    fprintf(saida, "r%d, r%d", BC_A(ins), BC_B(ins));
+                    break;
+                case BC_LOADI:
+                    fprintf(saida, "r%d, %d", BC_A(ins), BC_SBX(ins));
+                    break;
+                case BC_LOADK:
+                    fprintf(saida, "r%d, %d", BC_A(ins), f->constantes[BC_BX(ins)]);
+                    break;
+                case BC_GETG:
+                case BC_SETG:
+                case BC_LADDR:
+                    fprintf(saida, "r%d, @%d", BC_A(ins), BC_BX(ins));
+                    break;
+                case BC_JMP:
+                    fprintf(saida, "%d", pc + 1 + BC_SBX(ins));
+                    break;
+                case BC_JMPF:
+                    fprintf(saida, "r%d, %d", BC_A(ins), pc + 1 + BC_SBX(ins));
+                    break;
+                case BC_CALL:
+                    fprintf(saida, "r%d, %s", BC_A(ins), p->funcoes[BC_BX(ins)].nome);
+                    break;
+                case BC_INPUT:
+                case BC_OUTPUT:
+                case BC_RET:
+                    fprintf(saida, "r%d", BC_A(ins));
+                    break;
+                case BC_RET0:
+                case BC_NUM_OPS:
+                    break;
+                case BC_ADDK:
+                case BC_SUBK:
+                case BC_MULK:
+                case BC_DIVK:
+                    fprintf(saida, "r%d, r%d, %d", BC_A(ins), BC_B(ins), f->constantes[BC_C(ins)]);
+                    break;
+                case BC_LOADG:
+                case BC_LOADL:
+                    fprintf(saida, "r%d, @%d[r%d]", BC_A(ins), f->constantes[BC_C(ins)], BC_B(ins));
+                    break;
+                case BC_STOREG:
+                case BC_STOREL:
+                    fprintf(saida, "@%d[r%d], r%d", f->constantes[BC_A(ins)], BC_B(ins), BC_C(ins));
+                    break;
+                default:
+                    // comparação e desvio: o alvo está no JMP seguinte, parte da instrução
+                    if (op >= BC_JLT && op <= BC_JNEK) {
+                        if (op >= BC_JLTK) {
+                            fprintf(saida, "r%d, %d", BC_A(ins), f->constantes[BC_B(ins)]);
+                        } else {
+                            fprintf(saida, "r%d, r%d", BC_A(ins), BC_B(ins));
+                        }
+                        pc++;
+                        fprintf(saida, ", %d", pc + 1 + BC_SBX(f->codigo[pc]));
+                        break;
+                    }
+                    fprintf(saida, "r%d, r%d, r%d", BC_A(ins), BC_B(ins), BC_C(ins));
+                    break;
+            }
+            fprintf(saida, "\n");
+        }
+    }
+}
+
+void bc_liberar(BcPrograma *p) {
+    for (int i = 0; i < p->num_funcoes; i++) {
+        free(p->funcoes[i].codigo);
+        free(p->funcoes[i].constantes);
+        free(p->funcoes[i].param_array);
+        free(p->funcoes[i].reg_vars);
+        free(p->funcoes[i].desloc_arrays);
+        free(p->funcoes[i].lacos);
+    }
+    free(p->funcoes);
+    free(p->nomes_globais);
+    free(p->pos_globais);
+    free(p);
+}
@@ -0,0 +1,184 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdio.h>
+#include "tree.h"
+
+/*
+ * Bytecode de registradores para a máquina virtual.
+ *
+ * Cada instrução é uma palavra de 32 bits: opcode nos 8 bits baixos e os
+ * operandos acima dele, em dois formatos
+ *
+ *   ABC:  op | A (8) | B (8) | C (8)
+ *   ABx:  op | A (8) | Bx (16, sem sinal, ou sBx com sinal)
+ *
+ * A, B e C são registradores da função (no máximo BC_MAX_REGS). Os
+ * registradores ficam numa pilha contígua: os parâmetros ocupam os
+ * primeiros, depois cada escalar local e por fim os temporários. Numa
+ * chamada os argumentos vão para registradores consecutivos a partir de A,
+ * que passam a ser os primeiros registradores da função chamada; o valor
+ * de retorno volta em A.
+ *
+ * Globais e arrays locais vivem num único buffer plano de int: os globais
+ * escalares primeiro, depois os arrays globais e acima deles a pilha dos
+ * arrays locais. O "endereço" de um array é o índice no buffer.
+ */
+
+#define BC_MAX_REGS 256
+#define VM_MAX_MEMORIA  (1 << 24)   /* globais + arrays locais, em ints */
+
+typedef enum {
+    BC_MOVE,        /* R[A] = R[B] */
+    BC_LOADI,       /* R[A] = sBx */
+    BC_LOADK,       /* R[A] = K[Bx] */
+    BC_GETG,        /* R[A] = M[Bx] (global escalar) */
+    BC_SETG,        /* M[Bx] = R[A] */
+    BC_LADDR,       /* R[A] = início dos arrays locais + Bx */
+    BC_LOAD,        /* R[A] = M[R[B] + R[C]] */
+    BC_STORE,       /* M[R[A] + R[B]] = R[C] */
+    BC_ADD,         /* R[A] = R[B] op R[C] */
+    BC_SUB,
+    BC_MUL,
+    BC_DIV,
+    BC_LT,
+    BC_LE,
+    BC_GT,
+    BC_GE,
+    BC_EQ,
+    BC_NE,
+    BC_JMP,         /* pc += sBx */
+    BC_JMPF,        /* se R[A] == 0: pc += sBx */
+    BC_CALL,        /* R[A] = F[Bx](R[A], R[A+1], ...) */
+    BC_INPUT,       /* R[A] = input() */
+    BC_OUTPUT,      /* output(R[A]) */
+    BC_RET,         /* retorna R[A] */
+    BC_RET0,        /* retorna 0 (função void ou fim do corpo) */
+
+    /*
+     * Superinstruções, escolhidas pelos pares mais executados no perfil
+     * (--perfil-vm) dos programas de bench/. Nenhuma é gerada com
+     * --sem-superinstrucoes.
+     */
+    BC_ADDK,        /* R[A] = R[B] op K[C] */
+    BC_SUBK,
+    BC_MULK,
+    BC_DIVK,        /* K[C] nunca é 0 nem -1 */
+    BC_JLT,         /* se R[A] op R[B]: executa o JMP seguinte, senão o pula */
+    BC_JLE,
+    BC_JGT,
+    BC_JGE,
+    BC_JEQ,
+    BC_JNE,
+    BC_JLTK,        /* se R[A] op K[B]: executa o JMP seguinte, senão o pula */
+    BC_JLEK,
+    BC_JGTK,
+    BC_JGEK,
+    BC_JEQK,
+    BC_JNEK,
+    BC_LOADG,       /* R[A] = M[K[C] + R[B]] (array global) */
+    BC_LOADL,       /* R[A] = M[arrays locais + K[C] + R[B]] */
+    BC_STOREG,      /* M[K[A] + R[B]] = R[C] */
+    BC_STOREL,      /* M[arrays locais + K[A] + R[B]] = R[C] */
+    BC_NUM_OPS
+} BcOp;
+
+typedef unsigned int BcInstr;
+
+#define BC_OP(i)    ((BcOp)((i) & 0xff))
+#define BC_A(i)     (((i) >> 8) & 0xff)
+#define BC_B(i)     (((i) >> 16) & 0xff)
+#define BC_C(i)     (((i) >> 24) & 0xff)
+#define BC_BX(i)    ((i) >> 16)
+#define BC_SBX(i)   ((int)(short)((i) >> 16))
+
+#define BC_ABC(op, a, b, c) \
+    ((BcInstr)(op) | ((BcInstr)(a) << 8) | ((BcInstr)(b) << 16) | ((BcInstr)(c) << 24))
+#define BC_ABX(op, a, bx) \
+    ((BcInstr)(op) | ((BcInstr)(a) << 8) | ((BcInstr)((bx) & 0xffff) << 16))
+
+typedef struct {
+    char *nome;
+    int retorna_int;
+    int num_params;
+    int num_regs;           /* parâmetros + locais + temporários */
+    int tam_arrays;         /* ints dos arrays locais, zerados na entrada */
+
+    /*
+     * Correspondência com a IR, para a troca de camada (--camadas):
+     * registrador de cada escalar na ordem das variáveis da IR (parâmetros
+     * escalares e depois locais, na ordem de declaração), deslocamento de
+     * cada array local e pc do cabeçalho de cada While, na ordem do corpo.
+     */
+    int *param_array;       /* 1 se o parâmetro é array */
+    int *reg_vars;
+    int num_vars;
+    int *desloc_arrays;
+    int num_arrays;
+    int *lacos;
+    int num_lacos;
+
+    BcInstr *codigo;
+    int tam_codigo;
+    int cap_codigo;
+
+    int *constantes;
+    int num_constantes;
+    int cap_constantes;
+} BcFuncao;
+
+typedef struct {
+    BcFuncao *funcoes;      /* índice = ordem de declaração */
+    int num_funcoes;
+    int principal;          /* índice de main, -1 se não existe */
+    int tam_globais;        /* ints dos globais no início da memória */
+    char **nomes_globais;   /* nome e posição na memória de cada global */
+    int *pos_globais;
+    int num_globais;
+    int erros;
+} BcPrograma;
+
+/* 'superinstrucoes' liga a geração das instruções fundidas */
+BcPrograma* bc_compilar(TreeNode *raiz, int superinstrucoes);
+void bc_imprimir(BcPrograma *p, FILE *saida);
+void bc_liberar(BcPrograma *p);
+const char* bc_nome_op(BcOp op);
+
+/*
+ * Executa main; retorna o código de saída (0, ou 1 em erro de execução).
+ * Com 'perfil' conta as instruções executadas por opcode e por par de
+ * opcodes consecutivos e imprime as contagens no fim.
+ */
+int vm_executar(BcPrograma *p, FILE *perfil);
+
+/*
+ * Execução em camadas: a máquina virtual conta as chamadas e as voltas de
+ * laço de cada função e, quando a soma chega a 'limite', pede código
+ * nativo com pedir(dados, funcao, -1); um laço que continua quente depois
+ * disso é pedido com pedir(dados, funcao, laco). Quem compila publica o
+ * código em nativas[funcao] ou osr[funcao][laco], e a máquina passa a
+ * usá-lo na próxima chamada da função ou na próxima volta do laço.
+ *
+ * O código de uma função recebe os argumentos como long (arrays como
+ * ponteiro para a memória); o de um laço recebe o ponteiro para os
+ * registradores do quadro, os parâmetros array e os arrays locais, e
+ * termina a função. No máximo VM_ARGS_NATIVOS argumentos. A memória é de
+ * quem chama, com VM_MAX_MEMORIA ints zerados, para que fique ao alcance
+ * do código nativo.
+ */
+#define VM_ARGS_NATIVOS 16
+
+typedef struct {
+    int *memoria;
+    unsigned limite;
+    void **nativas;                 /* publicados com __atomic_store_n */
+    void ***osr;
+    void (*pedir)(void *dados, int funcao, int laco);
+    void *dados;
+    long long entradas_nativas;     /* chamadas que foram para o código nativo */
+    long long entradas_osr;         /* laços continuados no código nativo */
+} BcCamadas;
+
+int vm_executar_camadas(BcPrograma *p, BcCamadas *camadas);
+
+#endif // BYTECODE_H
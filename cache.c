@@ -0,0 +1,394 @@
+/***********************************************/
+/* Caches em disco: diretório comum e cache    */
+/* do código de máquina por função (--cache),  */
+/* com chaves pelo conteúdo normalizado        */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "cache.h"
+
+#define MAGICO_X86 "CMX1"
+
+unsigned long long cache_fnv1a(const void *dados, size_t tam, unsigned long long h) {
+    const unsigned char *p = (const unsigned char*)dados;
+    for (size_t i = 0; i < tam; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+char* cache_diretorio(void) {
+    const char *dir = getenv("CMINUS_CACHE");
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    char *caminho = (char*)malloc(4096);
+    if (dir && *dir) snprintf(caminho, 4096, "%s", dir);
+    else if (xdg && *xdg) snprintf(caminho, 4096, "%s/cminus", xdg);
+    else if (home && *home) snprintf(caminho, 4096, "%s/.cache/cminus", home);
+    else snprintf(caminho, 4096, "/tmp/cminus-cache");
+    return caminho;
+}
+
+int cache_criar_diretorio(char *caminho) {
+    for (char *p = caminho + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        int ok = mkdir(caminho, 0755) == 0 || errno == EEXIST;
+        *p = '/';
+        if (!ok) return 0;
+    }
+    return mkdir(caminho, 0755) == 0 || errno == EEXIST;
+}
+
+/* Chaves */
+
+static unsigned long long texto(unsigned long long h, const char *s) {
+    return cache_fnv1a(s ? s : "", s ? strlen(s) + 1 : 1, h);
+}
+
+/* O compilador faz parte da chave: um executável novo não usa código antigo */
+static unsigned long long hash_executavel(void) {
+    unsigned long long h = CACHE_FNV_INICIO;
+    FILE *arq = fopen("/proc/self/exe", "rb");
+    if (!arq) return h;
+    char bloco[65536];
+    size_t n;
+    while ((n = fread(bloco, 1, sizeof(bloco), arq)) > 0) h = cache_fnv1a(bloco, n, h);
+    fclose(arq);
+    return h;
+}
+
+/*
+ * Percurso da subárvore de uma função. Locais e parâmetros entram pela
+ * ordem de declaração no escopo (renomear não muda a chave); globais e
+ * funções chamadas entram pelo nome e pelo que o código depende deles.
+ */
+typedef struct {
+    TreeNode *declaracoes;      /* nível de cima do programa */
+    unsigned long long h;
+    char **locais;
+    int num_locais;
+    int cap_locais;
+} Normalizador;
+
+static TreeNode* declaracao(Normalizador *n, const char *tipo, const char *nome) {
+    for (int i = 0; i < n->declaracoes->num_children; i++) {
+        TreeNode *d = n->declaracoes->children[i];
+        if (strcmp(d->node_type, tipo) == 0 && strcmp(d->value, nome) == 0) return d;
+    }
+    return NULL;
+}
+
+static void declarar_local(Normalizador *n, char *nome) {
+    if (n->num_locais == n->cap_locais) {
+        n->cap_locais = n->cap_locais ? n->cap_locais * 2 : 16;
+        n->locais = (char**)realloc(n->locais, sizeof(char*) * n->cap_locais);
+    }
+    n->locais[n->num_locais++] = nome;
+}
+
+static void referencia(Normalizador *n, const char *nome) {
+    char buf[64];
+    for (int v = n->num_locais - 1; v >= 0; v--) {
+        if (strcmp(n->locais[v], nome) == 0) {
+            snprintf(buf, sizeof(buf), "L%d", v);
+            n->h = texto(n->h, buf);
+            return;
+        }
+    }
+    // global: o código usa o símbolo e, se é array, o endereço
+    TreeNode *d = declaracao(n, "Var-declaracao", nome);
+    n->h = texto(n->h, "G");
+    n->h = texto(n->h, nome);
+    n->h = texto(n->h, d && d->num_children > 1 ? d->children[1]->value : "");
+}
+
+static void chamada(Normalizador *n, const char *nome) {
+    n->h = texto(n->h, "C");
+    n->h = texto(n->h, nome);
+    TreeNode *d = declaracao(n, "Fun-declaracao", nome);
+    if (!d) return;                     // input/output
+    n->h = texto(n->h, d->children[0]->value);
+    TreeNode *params = d->children[1];
+    TreeNode *lista = params->num_children > 0 ? params->children[0] : NULL;
+    for (int p = 0; lista && p < lista->num_children; p++) {
+        n->h = texto(n->h, lista->children[p]->node_type);
+    }
+}
+
+static void normalizar(Normalizador *n, TreeNode *node, TreeNode *pai) {
+    const char *tipo = node->node_type;
+    n->h = texto(n->h, tipo);
+    if (strcmp(tipo, "Var-declaracao") == 0 ||
+        (pai && strcmp(pai->node_type, "Param-lista") == 0)) {
+        declarar_local(n, node->value);
+    } else if (strcmp(tipo, "Variavel") == 0 || strcmp(tipo, "Variavel-Array") == 0) {
+        referencia(n, node->value);
+    } else if (strcmp(tipo, "Function-Call") == 0) {
+        chamada(n, node->value);
+    } else {
+        n->h = texto(n->h, node->value);
+    }
+
+    int escopo = n->num_locais;
+    for (int i = 0; i < node->num_children; i++) {
+        normalizar(n, node->children[i], node);
+    }
+    if (strcmp(tipo, "Composto-declaracao") == 0) n->num_locais = escopo;
+}
+
+static unsigned long long hash_funcao(TreeNode *declaracoes, TreeNode *fun) {
+    Normalizador n;
+    memset(&n, 0, sizeof(n));
+    n.declaracoes = declaracoes;
+    n.h = texto(CACHE_FNV_INICIO, fun->value);
+    for (int i = 0; i < fun->num_children; i++) normalizar(&n, fun->children[i], fun);
+    free(n.locais);
+    return n.h;
+}
+
+static int indice_funcao(CacheX86 *cache, const char *nome) {
+    for (int i = 0; i < cache->num; i++) {
+        if (strcmp(cache->nomes[i], nome) == 0) return i;
+    }
+    return -1;
+}
+
+/* Marca as funções alcançáveis a partir de 'i' no grafo de chamadas */
+static void alcancar(CacheX86 *cache, int i, char *marcadas) {
+    if (i < 0 || marcadas[i]) return;
+    marcadas[i] = 1;
+    NoChamadas *no = grafo_chamadas_buscar(cache->grafo, cache->nomes[i]);
+    for (int c = 0; no && c < no->num_chamados; c++) {
+        alcancar(cache, indice_funcao(cache, no->chamados[c]->nome), marcadas);
+    }
+}
+
+/* Arquivos: "CMX1", texto, símbolos (nome, seção, valor), referências */
+
+static void escrever_int(FILE *arq, long long v) {
+    fwrite(&v, sizeof(v), 1, arq);
+}
+
+static void escrever_nome(FILE *arq, const char *s) {
+    escrever_int(arq, (long long)strlen(s));
+    fwrite(s, 1, strlen(s), arq);
+}
+
+static int ler_int(FILE *arq, long long *v, long long maximo) {
+    return fread(v, sizeof(*v), 1, arq) == 1 && *v >= 0 && *v <= maximo;
+}
+
+static char* ler_nome(FILE *arq) {
+    long long tam;
+    if (!ler_int(arq, &tam, 4096)) return NULL;
+    char *s = (char*)malloc(tam + 1);
+    if (fread(s, 1, tam, arq) != (size_t)tam) {
+        free(s);
+        return NULL;
+    }
+    s[tam] = '\0';
+    return s;
+}
+
+static void caminho_chave(CacheX86 *cache, unsigned long long chave, char *caminho, size_t tam) {
+    snprintf(caminho, tam, "%s/x86/%016llx", cache->diretorio, chave);
+}
+
+static void liberar_codigo(CodigoX86 *c) {
+    for (int s = 0; s < c->num_simbolos; s++) free((char*)c->simbolos[s].nome);
+    for (int r = 0; r < c->num_relocs; r++) free((char*)c->relocs[r].simbolo);
+    x86_codigo_liberar(c);
+    free(c);
+}
+
+/* Código gravado com a chave, ou NULL se não existe ou está incompleto */
+static CodigoX86* ler_codigo(CacheX86 *cache, unsigned long long chave) {
+    char caminho[4200];
+    caminho_chave(cache, chave, caminho, sizeof(caminho));
+    FILE *arq = fopen(caminho, "rb");
+    if (!arq) return NULL;
+
+    CodigoX86 *c = (CodigoX86*)malloc(sizeof(CodigoX86));
+    x86_codigo_iniciar(c);
+    char magico[4];
+    long long tam, num, v;
+    int ok = fread(magico, 1, 4, arq) == 4 && memcmp(magico, MAGICO_X86, 4) == 0 &&
+             ler_int(arq, &tam, 1 << 30);
+    if (ok) {
+        c->texto = (unsigned char*)malloc(tam ? tam : 1);
+        c->tam_texto = c->cap_texto = (int)tam;
+        ok = fread(c->texto, 1, tam, arq) == (size_t)tam && ler_int(arq, &num, 1 << 20);
+    }
+    if (ok) {
+        c->simbolos = (SimboloX86*)calloc(num ? num : 1, sizeof(SimboloX86));
+        c->cap_simbolos = (int)num;
+        for (int s = 0; ok && s < num; s++) {
+            SimboloX86 *sim = &c->simbolos[s];
+            ok = (sim->nome = ler_nome(arq)) != NULL && ler_int(arq, &v, SECAO_BSS) &&
+                 ler_int(arq, &sim->valor, tam);
+            sim->secao = (SecaoX86)v;
+            if (sim->nome) c->num_simbolos++;
+        }
+        ok = ok && ler_int(arq, &num, 1 << 24);
+    }
+    if (ok) {
+        c->relocs = (RelocX86*)calloc(num ? num : 1, sizeof(RelocX86));
+        c->cap_relocs = (int)num;
+        for (int r = 0; ok && r < num; r++) {
+            RelocX86 *rel = &c->relocs[r];
+            long long pos, fim;
+            ok = (rel->simbolo = ler_nome(arq)) != NULL && ler_int(arq, &pos, tam - 4) &&
+                 ler_int(arq, &fim, tam) && fread(&rel->desloc, sizeof(rel->desloc), 1, arq) == 1;
+            rel->pos = (int)pos;
+            rel->fim = (int)fim;
+            if (rel->simbolo) c->num_relocs++;
+        }
+        ok = ok && fgetc(arq) == EOF;
+    }
+    fclose(arq);
+    if (!ok) {
+        liberar_codigo(c);
+        return NULL;
+    }
+    return c;
+}
+
+CacheX86* cache_x86_abrir(TreeNode *raiz, GrafoChamadas *grafo, OpcoesOtimizacao *otimizacao,
+                          AlocadorX86 alocador, int verificar_indices, FILE *relatorio) {
+    CacheX86 *cache = (CacheX86*)calloc(1, sizeof(CacheX86));
+    cache->relatorio = relatorio;
+    cache->grafo = grafo;
+    cache->inline_ativo = grafo && otimizacao && otimizacao->inline_ativo;
+    cache->diretorio = cache_diretorio();
+
+    char caminho[4200];
+    snprintf(caminho, sizeof(caminho), "%s/x86", cache->diretorio);
+    if (!cache_criar_diretorio(caminho)) perror(caminho);
+
+    // executável e opções de geração
+    char opcoes[256];
+    CustoInline *ci = otimizacao ? &otimizacao->custo_inline : NULL;
+    snprintf(opcoes, sizeof(opcoes), "O%d I%d %d %d %d %d %d %d F%d A%d V%d", otimizacao != NULL,
+             cache->inline_ativo, ci ? ci->limite : 0, ci ? ci->limite_folha : 0,
+             ci ? ci->bonus_chamada : 0, ci ? ci->bonus_constante : 0, ci ? ci->bonus_array : 0,
+             ci ? ci->tamanho_maximo : 0, otimizacao ? otimizacao->faixas_ativo : 0,
+             (int)alocador, verificar_indices);
+    unsigned long long base = texto(hash_executavel(), opcoes);
+
+    TreeNode *declaracoes = raiz->children[0];
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        if (strcmp(declaracoes->children[i]->node_type, "Fun-declaracao") == 0) cache->num++;
+    }
+    cache->nomes = (char**)malloc(sizeof(char*) * (cache->num + 1));
+    cache->chaves = (unsigned long long*)malloc(sizeof(unsigned long long) * (cache->num + 1));
+    cache->codigos = (CodigoX86**)calloc(cache->num + 1, sizeof(CodigoX86*));
+    unsigned long long *conteudo = (unsigned long long*)malloc(sizeof(unsigned long long) * (cache->num + 1));
+    int k = 0;
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        TreeNode *d = declaracoes->children[i];
+        if (strcmp(d->node_type, "Fun-declaracao") != 0) continue;
+        cache->nomes[k] = d->value;
+        conteudo[k++] = hash_funcao(declaracoes, d);
+    }
+
+    // com inline, o corpo de cada função alcançável pode acabar no código
+    char *marcadas = (char*)malloc(cache->num + 1);
+    for (int i = 0; i < cache->num; i++) {
+        unsigned long long h = cache_fnv1a(&conteudo[i], sizeof(conteudo[i]), base);
+        if (cache->inline_ativo) {
+            memset(marcadas, 0, cache->num + 1);
+            alcancar(cache, i, marcadas);
+            for (int j = 0; j < cache->num; j++) {
+                if (marcadas[j] && j != i) h = cache_fnv1a(&conteudo[j], sizeof(conteudo[j]), h);
+            }
+        }
+        cache->chaves[i] = h;
+        cache->codigos[i] = ler_codigo(cache, h);
+        if (cache->codigos[i]) cache->acertos++;
+    }
+    free(marcadas);
+    free(conteudo);
+    return cache;
+}
+
+void cache_x86_otimizar(CacheX86 *cache, IrModulo *mod, GrafoChamadas *grafo,
+                        OpcoesOtimizacao *op, FILE *relatorio) {
+    // quem falta, e o que pode ser expandido nelas
+    char *marcadas = (char*)calloc(cache->num + 1, 1);
+    for (int i = 0; i < cache->num; i++) {
+        if (cache->codigos[i]) continue;
+        if (cache->inline_ativo) alcancar(cache, i, marcadas);
+        else marcadas[i] = 1;
+    }
+
+    if (relatorio) grafo_chamadas_imprimir(grafo, relatorio);
+    for (int i = 0; i < grafo->num; i++) {
+        int k = indice_funcao(cache, grafo->ordem[i]->nome);
+        IrFuncao *f = ir_buscar_funcao(mod, grafo->ordem[i]->nome);
+        if (k < 0 || !marcadas[k] || !f) continue;
+        otimizar_funcao(mod, f, grafo, op, relatorio);
+        cache->otimizadas++;
+    }
+    free(marcadas);
+}
+
+CodigoX86* cache_x86_buscar(CacheX86 *cache, const char *funcao) {
+    int k = indice_funcao(cache, funcao);
+    return k < 0 ? NULL : cache->codigos[k];
+}
+
+void cache_x86_gravar(CacheX86 *cache, const char *funcao, CodigoX86 *codigo) {
+    int k = indice_funcao(cache, funcao);
+    if (k < 0) return;
+    cache->compiladas++;
+    if (codigo->tam_bss > 0) return;
+
+    char caminho[4200], temporario[4300];
+    caminho_chave(cache, cache->chaves[k], caminho, sizeof(caminho));
+    snprintf(temporario, sizeof(temporario), "%s.%d", caminho, (int)getpid());
+    FILE *arq = fopen(temporario, "wb");
+    if (!arq) return;
+    fwrite(MAGICO_X86, 1, 4, arq);
+    escrever_int(arq, codigo->tam_texto);
+    fwrite(codigo->texto, 1, codigo->tam_texto, arq);
+    escrever_int(arq, codigo->num_simbolos);
+    for (int s = 0; s < codigo->num_simbolos; s++) {
+        escrever_nome(arq, codigo->simbolos[s].nome);
+        escrever_int(arq, codigo->simbolos[s].secao);
+        escrever_int(arq, codigo->simbolos[s].valor);
+    }
+    escrever_int(arq, codigo->num_relocs);
+    for (int r = 0; r < codigo->num_relocs; r++) {
+        RelocX86 *rel = &codigo->relocs[r];
+        escrever_nome(arq, rel->simbolo);
+        escrever_int(arq, rel->pos);
+        escrever_int(arq, rel->fim);
+        fwrite(&rel->desloc, sizeof(rel->desloc), 1, arq);
+    }
+    // rename é atômico: quem lê ao mesmo tempo vê o arquivo inteiro ou nada
+    if (fclose(arq) == 0 && rename(temporario, caminho) == 0) cache->gravadas++;
+    else remove(temporario);
+}
+
+void cache_x86_fechar(CacheX86 *cache) {
+    if (cache->relatorio) {
+        fprintf(cache->relatorio, "[cache x86] %d funcoes: %d do cache, %d compiladas (%d gravadas), "
+                "%d otimizadas em %s/x86\n", cache->num, cache->acertos, cache->compiladas,
+                cache->gravadas, cache->otimizadas, cache->diretorio);
+    }
+    for (int i = 0; i < cache->num; i++) {
+        if (cache->codigos[i]) liberar_codigo(cache->codigos[i]);
+    }
+    free(cache->nomes);
+    free(cache->chaves);
+    free(cache->codigos);
+    free(cache->diretorio);
+    free(cache);
+}
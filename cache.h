@@ -0,0 +1,67 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "tree.h"
+#include "otimizador.h"
+#include "x86.h"
+
+/*
+ * Caches em disco. O diretório é CMINUS_CACHE, senão
+ * $XDG_CACHE_HOME/cminus, ~/.cache/cminus ou /tmp/cminus-cache; as chaves
+ * são hashes FNV-1a de 64 bits.
+ */
+#define CACHE_FNV_INICIO 0xcbf29ce484222325ULL
+
+unsigned long long cache_fnv1a(const void *dados, size_t tam, unsigned long long h);
+char* cache_diretorio(void);                /* malloc */
+int cache_criar_diretorio(char *caminho);   /* mkdir -p; 0 se falhou */
+
+/*
+ * Cache do código de máquina por função (--cache). A chave de cada função
+ * é o hash da sua subárvore normalizada (locais e parâmetros trocados pela
+ * ordem de declaração, sem nomes), com cada global usado pelo nome e
+ * tamanho e cada função chamada pelo nome e assinatura, mais as opções de
+ * geração e o próprio executável do compilador. Com -O e inline, a função
+ * também depende do corpo das que ela alcança no grafo de chamadas, que
+ * podem ser expandidas nela.
+ *
+ * Editar uma função recompila só ela (e, com inline, quem a alcança): as
+ * outras vêm do disco já codificadas, com as referências a símbolos ainda
+ * por ligar, sem passar pela otimização nem pelo backend.
+ */
+struct CacheX86 {
+    char *diretorio;
+    FILE *relatorio;
+    GrafoChamadas *grafo;
+    int inline_ativo;
+    int num;
+    char **nomes;               /* funções na ordem de declaração */
+    unsigned long long *chaves;
+    CodigoX86 **codigos;        /* lido do disco, ou NULL se falta */
+    int acertos;
+    int compiladas;
+    int gravadas;
+    int otimizadas;
+};
+
+/*
+ * Calcula as chaves e lê do disco o código das funções já em cache. Sem
+ * -O, 'grafo' e 'otimizacao' são NULL; 'verificar_indices' é o do ir_gerar. As estatísticas vão para 'relatorio'.
+ */
+CacheX86* cache_x86_abrir(TreeNode *raiz, GrafoChamadas *grafo, OpcoesOtimizacao *otimizacao,
+                          AlocadorX86 alocador, int verificar_indices, FILE *relatorio);
+
+/* Como otimizar_modulo, só nas funções que faltam no cache e nas que elas alcançam */
+void cache_x86_otimizar(CacheX86 *cache, IrModulo *mod, GrafoChamadas *grafo,
+                        OpcoesOtimizacao *op, FILE *relatorio);
+
+/* Código já codificado da função, ou NULL */
+CodigoX86* cache_x86_buscar(CacheX86 *cache, const char *funcao);
+void cache_x86_gravar(CacheX86 *cache, const char *funcao, CodigoX86 *codigo);
+
+/* Imprime as estatísticas no relatório e libera (depois de ligado o código) */
+void cache_x86_fechar(CacheX86 *cache);
+
+#endif // CACHE_H
@@ -0,0 +1,371 @@
+/***********************************************/
+/* Execução em camadas (--camadas)             */
+/* Tudo começa na máquina virtual; funções e   */
+/* laços quentes são compilados numa thread à  */
+/* parte e a execução passa ao código nativo   */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "camadas.h"
+#include "bytecode.h"
+#include "entrada_saida.h"
+
+/*
+ * O código nativo fica numa área logo abaixo da memória da máquina
+ * virtual, no mesmo mapa: os globais (cm_<nome> no .bss de cada unidade)
+ * e as funções de unidades anteriores ficam ao alcance do rel32.
+ */
+#define TAM_AREA_CODIGO (64 << 20)
+
+typedef struct Pedido {
+    int funcao;
+    int laco;                   /* -1: a função inteira */
+    struct Pedido *prox;
+} Pedido;
+
+typedef struct {
+    TreeNode *raiz;
+    BcPrograma *prog;
+    OpcoesOtimizacao *otimizacao;
+    OpcoesX86 x86;
+    FILE *relatorio;
+    BcCamadas camadas;
+
+    /* Só a thread de compilação mexe daqui até 'esgotada' */
+    IrModulo *mod;              /* gerado e otimizado no primeiro pedido */
+    void **enderecos;           /* por função: código nativo ou NULL */
+    char *tentada;              /* por função: pedido já atendido */
+    char **tentado_laco;
+    char **simbolos;            /* cm_<nome> de cada função */
+    char **simbolos_globais;
+    unsigned char *area;        /* código nativo seguido da memória */
+    size_t usado;
+    int compilacoes;
+    int esgotada;               /* sem espaço ou sem IR: não compila mais */
+
+    pthread_t thread;
+    pthread_mutex_t trava;
+    pthread_cond_t sinal;
+    Pedido *fila;
+    Pedido *fim_fila;
+    int parar;
+} Camadas;
+
+static double milissegundos(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) * 1e3 + (double)(b.tv_nsec - a.tv_nsec) / 1e6;
+}
+
+static char* prefixar(const char *nome) {
+    char *s = (char*)malloc(strlen(nome) + 4);
+    sprintf(s, "cm_%s", nome);
+    return s;
+}
+
+static int indice_funcao(Camadas *cm, const char *nome) {
+    for (int k = 0; k < cm->prog->num_funcoes; k++) {
+        if (strcmp(cm->prog->funcoes[k].nome, nome) == 0) return k;
+    }
+    return -1;
+}
+
+/* Chamado pela máquina virtual: só enfileira */
+static void pedir(void *dados, int funcao, int laco) {
+    Camadas *cm = (Camadas*)dados;
+    Pedido *p = (Pedido*)malloc(sizeof(Pedido));
+    p->funcao = funcao;
+    p->laco = laco;
+    p->prox = NULL;
+    pthread_mutex_lock(&cm->trava);
+    if (cm->fim_fila) cm->fim_fila->prox = p;
+    else cm->fila = p;
+    cm->fim_fila = p;
+    pthread_cond_signal(&cm->sinal);
+    pthread_mutex_unlock(&cm->trava);
+}
+
+/* A IR do programa inteiro, otimizada como no -O */
+static int preparar_ir(Camadas *cm) {
+    cm->mod = ir_gerar(cm->raiz, 0);
+    if (cm->mod->erros > 0) return 0;
+    otimizar_modulo(cm->mod, grafo_chamadas_construir(cm->raiz), cm->otimizacao, NULL);
+    return 1;
+}
+
+static int na_unidade(IrFuncao **unidade, int tam, IrFuncao *f) {
+    for (int u = 0; u < tam; u++) {
+        if (unidade[u] == f) return 1;
+    }
+    return 0;
+}
+
+/*
+ * Compila 'raiz' com as funções que ela alcança e que ainda não têm código
+ * nativo, liga e publica cada uma. Retorna o endereço de 'raiz' ou NULL.
+ */
+static void* compilar_unidade(Camadas *cm, IrFuncao *raiz, int *num_funcoes, int *bytes) {
+    BcCamadas *cs = &cm->camadas;
+    IrFuncao **unidade = (IrFuncao**)malloc(sizeof(IrFuncao*) * (cm->prog->num_funcoes + 1));
+    int tam = 0;
+    unidade[tam++] = raiz;
+    for (int u = 0; u < tam; u++) {
+        for (int b = 0; b < unidade[u]->num_blocos; b++) {
+            for (IrInstr *i = unidade[u]->blocos[b]->primeiro; i; i = i->prox) {
+                if (i->op != IR_CALL || ir_eh_builtin(i->nome)) continue;
+                IrFuncao *g = ir_buscar_funcao(cm->mod, i->nome);
+                if (!cm->enderecos[indice_funcao(cm, i->nome)] && !na_unidade(unidade, tam, g)) {
+                    unidade[tam++] = g;
+                }
+            }
+        }
+    }
+
+    CodigoX86 c;
+    x86_codigo_iniciar(&c);
+    for (int u = 0; u < tam; u++) {
+        x86_codificar_funcao(&c, x86_gerar_funcao(cm->mod, unidade[u], &cm->x86));
+    }
+    x86_codigo_externo(&c, "rt_input", (void*)es_input);
+    x86_codigo_externo(&c, "rt_output", (void*)es_output);
+
+    size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+    size_t tam_texto = ((size_t)c.tam_texto + pagina - 1) & ~(pagina - 1);
+    unsigned char *destino = cm->area + cm->usado;
+    unsigned char *memoria = (unsigned char*)cs->memoria;
+    void *codigo = NULL;
+    if (cm->usado + tam_texto > TAM_AREA_CODIGO) {
+        cm->esgotada = 1;
+        if (cm->relatorio) fprintf(cm->relatorio, "[camadas] area de codigo cheia\n");
+        goto fim;
+    }
+
+    // funções de unidades anteriores e globais: posições fixas na área
+    for (int k = 0; k < cm->prog->num_funcoes; k++) {
+        if (cm->enderecos[k]) {
+            x86_codigo_definir(&c, cm->simbolos[k], SECAO_TEXTO,
+                               (long long)((unsigned char*)cm->enderecos[k] - destino));
+        }
+    }
+    for (int g = 0; g < cm->prog->num_globais; g++) {
+        x86_codigo_definir(&c, cm->simbolos_globais[g], SECAO_BSS, 4LL * cm->prog->pos_globais[g]);
+    }
+    if (!x86_codigo_ligar(&c, (unsigned long long)(size_t)destino,
+                          (unsigned long long)(size_t)memoria)) {
+        cm->esgotada = 1;
+        goto fim;
+    }
+    if (mprotect(destino, tam_texto, PROT_READ | PROT_WRITE) != 0) {
+        perror("mprotect");
+        cm->esgotada = 1;
+        goto fim;
+    }
+    memcpy(destino, c.texto, c.tam_texto);
+    if (mprotect(destino, tam_texto, PROT_READ | PROT_EXEC) != 0) {
+        perror("mprotect");
+        cm->esgotada = 1;
+        goto fim;
+    }
+    cm->usado += tam_texto;
+
+    // a máquina virtual só vê o endereço depois que o código está pronto
+    for (int u = 0; u < tam; u++) {
+        int k = indice_funcao(cm, unidade[u]->nome);
+        if (k < 0) continue;
+        cm->enderecos[k] = destino + x86_codigo_simbolo(&c, cm->simbolos[k])->valor;
+        if (cm->prog->funcoes[k].num_params <= VM_ARGS_NATIVOS) {
+            __atomic_store_n(&cs->nativas[k], cm->enderecos[k], __ATOMIC_RELEASE);
+        }
+    }
+    char *nome = prefixar(raiz->nome);
+    codigo = destino + x86_codigo_simbolo(&c, nome)->valor;
+    free(nome);
+    *num_funcoes = tam;
+    *bytes = c.tam_texto;
+
+fim:
+    free(unidade);
+    x86_codigo_liberar(&c);
+    return codigo;
+}
+
+/* Atende um pedido da máquina virtual (na thread de compilação) */
+static void atender(Camadas *cm, int funcao, int laco) {
+    BcFuncao *bf = &cm->prog->funcoes[funcao];
+    if (cm->esgotada) return;
+    if (laco < 0) {
+        if (cm->tentada[funcao] || cm->enderecos[funcao]) return;
+        cm->tentada[funcao] = 1;
+    } else {
+        if (cm->tentado_laco[funcao][laco]) return;
+        cm->tentado_laco[funcao][laco] = 1;
+    }
+
+    // argumentos do código nativo: os da função ou estado + arrays
+    int args = bf->num_params;
+    if (laco >= 0) {
+        args = 1 + bf->num_arrays;
+        for (int j = 0; j < bf->num_params; j++) args += bf->param_array[j];
+    }
+    if (args > VM_ARGS_NATIVOS) {
+        if (cm->relatorio) {
+            fprintf(cm->relatorio, "[camadas] %s: %d argumentos, fica na maquina virtual\n",
+                    bf->nome, args);
+        }
+        return;
+    }
+
+    struct timespec inicio, fim;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    if (!cm->mod && !preparar_ir(cm)) {
+        cm->esgotada = 1;
+        return;
+    }
+    IrFuncao *raiz;
+    if (laco < 0) {
+        raiz = ir_buscar_funcao(cm->mod, bf->nome);
+    } else {
+        char *nome = (char*)malloc(strlen(bf->nome) + 24);
+        sprintf(nome, "%s.osr%d", bf->nome, laco);
+        raiz = ir_gerar_osr(cm->mod, cm->raiz, bf->nome, laco, bf->reg_vars, nome);
+        otimizar_funcao(cm->mod, raiz, NULL, cm->otimizacao, NULL);
+    }
+
+    int num_funcoes = 0, bytes = 0;
+    void *codigo = compilar_unidade(cm, raiz, &num_funcoes, &bytes);
+    if (!codigo) return;
+    if (laco >= 0) __atomic_store_n(&cm->camadas.osr[funcao][laco], codigo, __ATOMIC_RELEASE);
+    cm->compilacoes++;
+
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    if (cm->relatorio) {
+        if (laco < 0) fprintf(cm->relatorio, "[camadas] %s: codigo nativo", bf->nome);
+        else fprintf(cm->relatorio, "[camadas] %s: laco %d com entrada no cabecalho", bf->nome, laco);
+        fprintf(cm->relatorio, " em %.2fms (%d funcoes, %d bytes)\n",
+                milissegundos(inicio, fim), num_funcoes, bytes);
+    }
+}
+
+static void* compilar_em_fundo(void *arg) {
+    Camadas *cm = (Camadas*)arg;
+    for (;;) {
+        pthread_mutex_lock(&cm->trava);
+        while (!cm->fila && !cm->parar) pthread_cond_wait(&cm->sinal, &cm->trava);
+        // no fim da execução os pedidos pendentes não valem mais nada
+        Pedido *p = cm->parar ? NULL : cm->fila;
+        if (p) {
+            cm->fila = p->prox;
+            if (!cm->fila) cm->fim_fila = NULL;
+        }
+        pthread_mutex_unlock(&cm->trava);
+        if (!p) return NULL;
+        atender(cm, p->funcao, p->laco);
+        free(p);
+    }
+}
+
+int camadas_executar(TreeNode *raiz, OpcoesOtimizacao *otimizacao, OpcoesX86 *x86,
+                     unsigned limite, FILE *relatorio) {
+    BcPrograma *prog = bc_compilar(raiz, 1);
+    if (prog->erros > 0) {
+        bc_liberar(prog);
+        return 1;
+    }
+
+    Camadas cm;
+    memset(&cm, 0, sizeof(cm));
+    cm.raiz = raiz;
+    cm.prog = prog;
+    cm.otimizacao = otimizacao;
+    cm.x86 = *x86;
+    cm.x86.relatorio = NULL;
+    cm.relatorio = relatorio;
+
+    // memória zerada sob demanda; a área do código ganha permissão por unidade
+    size_t tam_memoria = sizeof(int) * VM_MAX_MEMORIA;
+    cm.area = (unsigned char*)mmap(NULL, TAM_AREA_CODIGO + tam_memoria, PROT_NONE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (cm.area == MAP_FAILED ||
+        mprotect(cm.area + TAM_AREA_CODIGO, tam_memoria, PROT_READ | PROT_WRITE) != 0) {
+        perror("mmap");
+        bc_liberar(prog);
+        return 1;
+    }
+
+    int n = prog->num_funcoes;
+    BcCamadas *cs = &cm.camadas;
+    cs->memoria = (int*)(cm.area + TAM_AREA_CODIGO);
+    cs->limite = limite > 0 ? limite : 1;
+    cs->nativas = (void**)calloc(n + 1, sizeof(void*));
+    cs->osr = (void***)malloc(sizeof(void**) * (n + 1));
+    cs->pedir = pedir;
+    cs->dados = &cm;
+    cm.enderecos = (void**)calloc(n + 1, sizeof(void*));
+    cm.tentada = (char*)calloc(n + 1, 1);
+    cm.tentado_laco = (char**)malloc(sizeof(char*) * (n + 1));
+    cm.simbolos = (char**)malloc(sizeof(char*) * (n + 1));
+    for (int k = 0; k < n; k++) {
+        cs->osr[k] = (void**)calloc(prog->funcoes[k].num_lacos + 1, sizeof(void*));
+        cm.tentado_laco[k] = (char*)calloc(prog->funcoes[k].num_lacos + 1, 1);
+        cm.simbolos[k] = prefixar(prog->funcoes[k].nome);
+    }
+    cm.simbolos_globais = (char**)malloc(sizeof(char*) * (prog->num_globais + 1));
+    for (int g = 0; g < prog->num_globais; g++) {
+        cm.simbolos_globais[g] = prefixar(prog->nomes_globais[g]);
+    }
+
+    pthread_mutex_init(&cm.trava, NULL);
+    pthread_cond_init(&cm.sinal, NULL);
+    int status = 1;
+    if (pthread_create(&cm.thread, NULL, compilar_em_fundo, &cm) != 0) {
+        fprintf(stderr, "ERRO: nao foi possivel criar a thread de compilacao\n");
+    } else {
+        // divisão por zero no código nativo: como no --run
+        fflush(stdout);
+        signal(SIGFPE, es_ao_sinal);
+        signal(SIGSEGV, es_ao_sinal);
+        status = vm_executar_camadas(prog, cs);
+        signal(SIGFPE, SIG_DFL);
+        signal(SIGSEGV, SIG_DFL);
+
+        pthread_mutex_lock(&cm.trava);
+        cm.parar = 1;
+        pthread_cond_signal(&cm.sinal);
+        pthread_mutex_unlock(&cm.trava);
+        pthread_join(cm.thread, NULL);
+    }
+
+    if (relatorio) {
+        fprintf(relatorio, "[camadas] %d compilacoes, %lld chamadas e %lld lacos no codigo nativo\n",
+                cm.compilacoes, cs->entradas_nativas, cs->entradas_osr);
+    }
+
+    while (cm.fila) {
+        Pedido *p = cm.fila;
+        cm.fila = p->prox;
+        free(p);
+    }
+    for (int k = 0; k < n; k++) {
+        free(cs->osr[k]);
+        free(cm.tentado_laco[k]);
+        free(cm.simbolos[k]);
+    }
+    for (int g = 0; g < prog->num_globais; g++) free(cm.simbolos_globais[g]);
+    free(cm.simbolos_globais);
+    free(cm.simbolos);
+    free(cm.tentado_laco);
+    free(cm.tentada);
+    free(cm.enderecos);
+    free(cs->osr);
+    free(cs->nativas);
+    pthread_mutex_destroy(&cm.trava);
+    pthread_cond_destroy(&cm.sinal);
+    munmap(cm.area, TAM_AREA_CODIGO + tam_memoria);
+    bc_liberar(prog);
+    return status;
+}
@@ -0,0 +1,29 @@
+#ifndef CAMADAS_H
+#define CAMADAS_H
+
+#include <stdio.h>
+#include "tree.h"
+#include "otimizador.h"
+#include "x86.h"
+
+/*
+ * Execução em camadas (--camadas): o programa inteiro começa na máquina
+ * virtual de bytecode, que conta as chamadas e as voltas de laço de cada
+ * função. Uma função cuja contagem chega a 'limite' é compilada numa
+ * thread à parte, sem parar a execução, pelo mesmo caminho do -O --run
+ * (IR otimizada e backend x86), junto com as funções que ela chama e que
+ * ainda não têm código; a partir daí as chamadas a ela vão direto para o
+ * código nativo. Um While que continua quente ganha uma variante que
+ * começa no seu cabeçalho (ir_gerar_osr), e a execução em curso passa
+ * para ela na próxima volta do laço.
+ *
+ * Erros de execução dentro do código nativo são os do --run (o processo
+ * termina pelo sinal, com a saída já produzida preservada); na máquina
+ * virtual, os dela. Com 'relatorio' informa cada compilação e, no fim,
+ * quantas vezes a execução passou ao código nativo. Retorna o código de
+ * saída.
+ */
+int camadas_executar(TreeNode *raiz, OpcoesOtimizacao *otimizacao, OpcoesX86 *x86,
+                     unsigned limite, FILE *relatorio);
+
+#endif // CAMADAS_H
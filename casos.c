@@ -0,0 +1,389 @@
+/***********************************************/
+/* Casos                                       */
+/* Troca cadeias de if-else-if que comparam o  */
+/* mesmo valor com constantes por tabela de    */
+/* saltos ou busca binária                     */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+
+/* Cadeias mais curtas ficam como estão */
+#define MIN_CASOS 4
+/*
+ * Cadeias espalhadas (sem tabela para todos os casos) mais curtas também:
+ * com valores sorteados, cada desvio da busca binária erra a previsão
+ * metade das vezes, e a cadeia só erra no desvio de saída. Medido com
+ * cadeias de 8 a 256 casos e valores sorteados, a busca só empata a
+ * partir de 128 casos.
+ */
+#define MIN_BUSCA 128
+/* Trechos com até tantos casos são testados um a um */
+#define MAX_LINEAR 3
+/* Tabela: no máximo DENSIDADE posições por caso e MAX_TABELA no total */
+#define DENSIDADE 3
+#define MAX_TABELA 1024
+
+typedef struct {
+    int valor;
+    IrBloco *alvo;
+    IrBloco *origem;            /* bloco da cadeia de onde saía a aresta */
+} Caso;
+
+typedef struct {
+    IrFuncao *f;
+    IrInstr *x;
+    Caso *casos;
+    int num_casos;
+    IrBloco *padrao;            /* o último else */
+    IrBloco *origem_padrao;
+    int tabelas;
+    int desvios;
+} Cadeia;
+
+/*
+ * Teste do desvio de 'bloco': x == constante, ou x != constante com os
+ * alvos trocados. Retorna x, ou NULL para outro desvio.
+ */
+static IrInstr* teste(IrBloco *bloco, int *valor, IrBloco **igual, IrBloco **diferente) {
+    IrInstr *t = ir_terminador(bloco);
+    if (!t || t->op != IR_BR) return NULL;
+    IrInstr *c = ir_valor(t->args[0]);
+    if (c->op != IR_EQ && c->op != IR_NE) return NULL;
+    IrInstr *a = ir_valor(c->args[0]);
+    IrInstr *b = ir_valor(c->args[1]);
+    if (a->op == IR_CONST) {
+        IrInstr *troca = a;
+        a = b;
+        b = troca;
+    }
+    if (a->op == IR_CONST || b->op != IR_CONST) return NULL;
+    *valor = b->imm;
+    *igual = t->alvos[c->op == IR_NE];
+    *diferente = t->alvos[c->op == IR_EQ];
+    return a;
+}
+
+/* Elo da cadeia depois do primeiro: só o teste, alcançado só pelo else anterior */
+static int elo(IrBloco *bloco, IrBloco *anterior) {
+    if (bloco->num_preds != 1 || bloco->preds[0] != anterior) return 0;
+    IrInstr *t = ir_terminador(bloco);
+    for (IrInstr *i = bloco->primeiro; i != t; i = i->prox) {
+        switch (i->op) {
+            case IR_CONST:
+            case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+            case IR_EQ: case IR_NE:
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 1;
+}
+
+static int alvo_usado(Cadeia *cad, IrBloco *alvo) {
+    for (int k = 0; k < cad->num_casos; k++) {
+        if (cad->casos[k].alvo == alvo) return 1;
+    }
+    return 0;
+}
+
+static int comparar_casos(const void *a, const void *b) {
+    int x = ((const Caso*)a)->valor, y = ((const Caso*)b)->valor;
+    return x < y ? -1 : x > y;
+}
+
+static IrInstr* nova(Cadeia *cad, IrBloco *bloco, IrOp op, IrTipo tipo) {
+    IrInstr *i = ir_nova_instr(cad->f, op, tipo);
+    ir_inserir_fim(bloco, i);
+    return i;
+}
+
+static IrInstr* constante(Cadeia *cad, IrBloco *bloco, int valor) {
+    IrInstr *c = nova(cad, bloco, IR_CONST, IR_T_INT);
+    c->imm = valor;
+    return c;
+}
+
+/* Aresta nova bloco -> alvo do caso, no lugar da que saía da cadeia */
+static void ligar_caso(Caso *caso, IrBloco *bloco) {
+    ir_trocar_origem_phis(caso->alvo, caso->origem, bloco);
+}
+
+/* Aresta nova bloco -> padrão: os phis recebem o valor que vinha do fim da cadeia */
+static void ligar_padrao(Cadeia *cad, IrBloco *bloco) {
+    for (IrInstr *p = cad->padrao->primeiro; p && p->op == IR_PHI; p = p->prox) {
+        for (int a = 0; a < p->num_args; a++) {
+            if (p->origens[a] == cad->origem_padrao) {
+                ir_add_phi_arg(p, p->args[a], bloco);
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Ponto de divisão da busca entre os casos [lo, hi): na metade central, o
+ * maior salto entre valores vizinhos, para não partir trechos densos.
+ */
+static int divisao(Cadeia *cad, int lo, int hi) {
+    int n = hi - lo, meio = lo + n / 2;
+    int melhor = meio;
+    long long maior = -1;
+    for (int m = lo + n / 4; m <= hi - n / 4; m++) {
+        if (m <= lo || m >= hi) continue;
+        long long salto = (long long)cad->casos[m].valor - cad->casos[m - 1].valor;
+        int distancia = abs(m - meio), melhor_distancia = abs(melhor - meio);
+        if (salto > maior || (salto == maior && distancia < melhor_distancia)) {
+            maior = salto;
+            melhor = m;
+        }
+    }
+    return melhor;
+}
+
+/* Os casos [lo, hi), já ordenados, vão para uma tabela só */
+static int densa(Cadeia *cad, int lo, int hi) {
+    int n = hi - lo;
+    long long faixa = (long long)cad->casos[hi - 1].valor - cad->casos[lo].valor + 1;
+    return n > MAX_LINEAR && faixa <= MAX_TABELA && faixa <= (long long)DENSIDADE * n;
+}
+
+/* Código que despacha os casos [lo, hi) a partir de 'bloco', ainda sem terminador */
+static void gerar(Cadeia *cad, IrBloco *bloco, int lo, int hi) {
+    int n = hi - lo;
+    if (densa(cad, lo, hi)) {
+        IrInstr **valores = (IrInstr**)malloc(sizeof(IrInstr*) * n);
+        for (int k = 0; k < n; k++) valores[k] = constante(cad, bloco, cad->casos[lo + k].valor);
+        IrInstr *t = nova(cad, bloco, IR_CASOS, IR_T_VOID);
+        ir_add_arg(t, cad->x);
+        ir_add_alvo(t, cad->padrao);
+        for (int k = 0; k < n; k++) {
+            ir_add_arg(t, valores[k]);
+            ir_add_alvo(t, cad->casos[lo + k].alvo);
+            ligar_caso(&cad->casos[lo + k], bloco);
+        }
+        ligar_padrao(cad, bloco);
+        free(valores);
+        cad->tabelas++;
+        return;
+    }
+
+    if (n <= MAX_LINEAR) {
+        for (int k = lo; k < hi; k++) {
+            IrInstr *c = constante(cad, bloco, cad->casos[k].valor);
+            IrInstr *igual = nova(cad, bloco, IR_EQ, IR_T_INT);
+            ir_add_arg(igual, cad->x);
+            ir_add_arg(igual, c);
+            IrBloco *prox = k + 1 < hi ? ir_novo_bloco(cad->f) : cad->padrao;
+            IrInstr *br = nova(cad, bloco, IR_BR, IR_T_VOID);
+            ir_add_arg(br, igual);
+            ir_add_alvo(br, cad->casos[k].alvo);
+            ir_add_alvo(br, prox);
+            ligar_caso(&cad->casos[k], bloco);
+            if (prox == cad->padrao) ligar_padrao(cad, bloco);
+            cad->desvios++;
+            bloco = prox;
+        }
+        return;
+    }
+
+    int m = divisao(cad, lo, hi);
+    IrInstr *c = constante(cad, bloco, cad->casos[m].valor);
+    IrInstr *menor = nova(cad, bloco, IR_LT, IR_T_INT);
+    ir_add_arg(menor, cad->x);
+    ir_add_arg(menor, c);
+    IrBloco *esquerda = ir_novo_bloco(cad->f);
+    IrBloco *direita = ir_novo_bloco(cad->f);
+    IrInstr *br = nova(cad, bloco, IR_BR, IR_T_VOID);
+    ir_add_arg(br, menor);
+    ir_add_alvo(br, esquerda);
+    ir_add_alvo(br, direita);
+    cad->desvios++;
+    gerar(cad, esquerda, lo, m);
+    gerar(cad, direita, m, hi);
+}
+
+/*
+ * Segue a cadeia a partir do desvio de 'inicio' e, com MIN_CASOS casos ou
+ * mais, a troca se couber numa tabela só ou tiver MIN_BUSCA casos. Os testes dos elos sobem para 'inicio' (o código morto
+ * os remove) e os elos ficam inalcançáveis. Marca os elos em aux.
+ */
+static int trocar_cadeia(Cadeia *cad, IrBloco *inicio) {
+    int valor;
+    IrBloco *igual, *diferente;
+    cad->x = teste(inicio, &valor, &igual, &diferente);
+    if (!cad->x) return 0;
+
+    int num_elos = 0;
+    IrBloco **elos = (IrBloco**)malloc(sizeof(IrBloco*) * (cad->f->num_blocos + 1));
+    cad->num_casos = 0;
+    IrBloco *bloco = inicio;
+    for (;;) {
+        elos[num_elos++] = bloco;
+        int repetido = 0;
+        for (int k = 0; k < cad->num_casos; k++) repetido |= cad->casos[k].valor == valor;
+        // um valor repetido nunca chega ao segundo teste
+        if (!repetido) {
+            Caso *caso = &cad->casos[cad->num_casos++];
+            caso->valor = valor;
+            caso->alvo = igual;
+            caso->origem = bloco;
+        }
+        cad->padrao = diferente;
+        cad->origem_padrao = bloco;
+
+        IrBloco *prox = diferente;
+        int v;
+        IrBloco *i, *d;
+        if (!elo(prox, bloco) || teste(prox, &v, &i, &d) != cad->x || alvo_usado(cad, i)) break;
+        bloco = prox;
+        valor = v;
+        igual = i;
+        diferente = d;
+    }
+    // cada alvo com uma aresta só (o padrão também não pode ser alvo de caso)
+    while (num_elos > 1 && alvo_usado(cad, cad->padrao)) {
+        num_elos--;
+        cad->padrao = elos[num_elos];
+        cad->origem_padrao = elos[num_elos - 1];
+        while (cad->num_casos > 0 && cad->casos[cad->num_casos - 1].origem == cad->padrao) {
+            cad->num_casos--;
+        }
+    }
+    if (cad->num_casos < MIN_CASOS || alvo_usado(cad, cad->padrao)) {
+        free(elos);
+        return 0;
+    }
+    qsort(cad->casos, cad->num_casos, sizeof(Caso), comparar_casos);
+    if (cad->num_casos < MIN_BUSCA && !densa(cad, 0, cad->num_casos)) {
+        free(elos);
+        return 0;
+    }
+
+    IrInstr *t = ir_terminador(inicio);
+    for (int e = 1; e < num_elos; e++) {
+        IrInstr *fim = ir_terminador(elos[e]);
+        IrInstr *i = elos[e]->primeiro;
+        while (i != fim) {
+            IrInstr *prox = i->prox;
+            ir_remover(i);
+            ir_inserir_antes(t, i);
+            i = prox;
+        }
+        elos[e]->aux = 1;
+    }
+    ir_remover(t);
+    gerar(cad, inicio, 0, cad->num_casos);
+    free(elos);
+    return 1;
+}
+
+static IrInstr* argumento_de(IrInstr *phi, IrBloco *origem) {
+    for (int a = 0; a < phi->num_args; a++) {
+        if (phi->origens[a] == origem) return phi->args[a];
+    }
+    return NULL;
+}
+
+/*
+ * Junção j que só tem phis e o salto para k, com os phis usados só pelos
+ * phis de k: os predecessores de j passam a saltar direto para k, que
+ * recebe deles os valores. Retorna 0 quando j não serve.
+ */
+static int encurtar(IrBloco *j, int *usos) {
+    IrInstr *t = ir_terminador(j);
+    if (!t || t->op != IR_JMP || j->num_preds == 0) return 0;
+    IrBloco *k = t->alvos[0];
+    if (k == j || !k->primeiro || k->primeiro->op != IR_PHI) return 0;
+    for (int p = 0; p < j->num_preds; p++) {
+        IrBloco *pred = j->preds[p];
+        // nem laço fechado em j nem aresta repetida para k
+        if (pred->ordem >= j->ordem) return 0;
+        for (int q = 0; q < k->num_preds; q++) {
+            if (k->preds[q] == pred) return 0;
+        }
+    }
+    for (IrInstr *i = j->primeiro; i != t; i = i->prox) {
+        if (i->op != IR_PHI) return 0;
+        int em_k = 0;
+        for (IrInstr *q = k->primeiro; q && q->op == IR_PHI; q = q->prox) {
+            em_k += ir_valor(argumento_de(q, j)) == i;
+        }
+        if (em_k != usos[i->id]) return 0;
+    }
+
+    for (IrInstr *q = k->primeiro; q && q->op == IR_PHI; q = q->prox) {
+        IrInstr *v = ir_valor(argumento_de(q, j));
+        for (int a = 0; a < q->num_args; a++) {
+            if (q->origens[a] == j) ir_remover_arg(q, a--);
+        }
+        for (int p = 0; p < j->num_preds; p++) {
+            IrInstr *w = v->op == IR_PHI && v->bloco == j ? argumento_de(v, j->preds[p]) : v;
+            ir_add_phi_arg(q, w, j->preds[p]);
+        }
+    }
+    for (int p = 0; p < j->num_preds; p++) {
+        IrInstr *fim = ir_terminador(j->preds[p]);
+        for (int a = 0; a < fim->num_alvos; a++) {
+            if (fim->alvos[a] == j) fim->alvos[a] = k;
+        }
+    }
+    return 1;
+}
+
+/*
+ * As junções aninhadas dos if-else da cadeia, uma por elo, ficam no
+ * caminho de cada caso: viram uma só, e os casos saltam direto para ela.
+ */
+static void juntar_juncoes(IrFuncao *f) {
+    int *usos = (int*)malloc(sizeof(int) * (f->prox_valor + 1));
+    int mudou = 1;
+    while (mudou) {
+        mudou = 0;
+        memset(usos, 0, sizeof(int) * (f->prox_valor + 1));
+        for (int b = 0; b < f->num_blocos; b++) {
+            for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+                for (int a = 0; a < i->num_args; a++) usos[ir_valor(i->args[a])->id]++;
+            }
+        }
+        for (int b = 1; b < f->num_blocos && !mudou; b++) mudou = encurtar(f->blocos[b], usos);
+        if (mudou) ir_calcular_cfg(f);
+    }
+    free(usos);
+}
+
+/*
+ * Procura cadeias de if-else-if que comparam um mesmo valor com
+ * constantes distintas e as refaz como busca binária (desvios por x <
+ * constante), com tabela de saltos (IR_CASOS) nos trechos densos e testes
+ * um a um nos trechos curtos. Retorna quantas cadeias trocou; 'tabelas' e
+ * 'desvios' recebem quantas tabelas e desvios a troca criou.
+ */
+int otimizar_casos(IrFuncao *f, int *tabelas, int *desvios) {
+    ir_calcular_cfg(f);
+
+    Cadeia cad;
+    memset(&cad, 0, sizeof(cad));
+    cad.f = f;
+    cad.casos = (Caso*)malloc(sizeof(Caso) * (f->num_blocos + 1));
+
+    int n = f->num_blocos, trocadas = 0;
+    for (int b = 0; b < n; b++) f->blocos[b]->aux = 0;
+    for (int b = 0; b < n; b++) {
+        if (!f->blocos[b]->aux) trocadas += trocar_cadeia(&cad, f->blocos[b]);
+    }
+    free(cad.casos);
+
+    if (trocadas > 0) {
+        ir_calcular_cfg(f);
+        juntar_juncoes(f);
+        ir_eliminar_codigo_morto(f);
+    }
+    *tabelas = cad.tabelas;
+    *desvios = cad.desvios;
+    return trocadas;
+}
@@ -0,0 +1,170 @@
+/***********************************************/
+/* Eliminação de chamadas de cauda             */
+/* Chamadas recursivas da própria função       */
+/* seguidas de return viram um laço; as demais */
+/* são marcadas para o gerador de código       */
+/* trocar call + ret por um salto              */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+
+/*
+ * Se o bloco termina em jmp para um bloco que só retorna, troca o jmp pelo
+ * próprio ret (com o valor que o phi do destino receberia deste bloco).
+ * Assim o caso "if (...) { ...; f(x); }" também termina em call + ret.
+ */
+static void antecipar_retorno(IrFuncao *f, IrBloco *bloco) {
+    IrInstr *jmp = ir_terminador(bloco);
+    if (!jmp || jmp->op != IR_JMP) return;
+    IrBloco *destino = jmp->alvos[0];
+
+    IrInstr *ret = destino->primeiro;
+    while (ret && ret->op == IR_PHI) ret = ret->prox;
+    if (!ret || ret->op != IR_RET) return;
+
+    IrInstr *valor = NULL;
+    if (ret->num_args > 0) {
+        valor = ir_valor(ret->args[0]);
+        if (valor->op == IR_PHI && valor->bloco == destino) {
+            IrInstr *phi = valor;
+            valor = NULL;
+            for (int a = 0; a < phi->num_args; a++) {
+                if (phi->origens[a] == bloco) valor = phi->args[a];
+            }
+            if (!valor) return;
+        } else if (valor->bloco == destino) {
+            return;
+        }
+    }
+
+    IrInstr *novo = ir_nova_instr(f, IR_RET, IR_T_VOID);
+    if (valor) ir_add_arg(novo, valor);
+    ir_remover(jmp);
+    ir_inserir_fim(bloco, novo);
+}
+
+/*
+ * Chamada em posição de cauda no bloco: o bloco termina em ret do valor da
+ * chamada (ou ret sem valor) e entre os dois só há instruções sem efeito.
+ */
+static IrInstr* chamada_de_cauda(IrBloco *bloco) {
+    IrInstr *ret = ir_terminador(bloco);
+    if (!ret || ret->op != IR_RET) return NULL;
+
+    IrInstr *i = ret->ant;
+    while (i && i->op != IR_CALL && !ir_tem_efeito(i)) i = i->ant;
+    if (!i || i->op != IR_CALL) return NULL;
+    if (ret->num_args > 0 && ir_valor(ret->args[0]) != i) return NULL;
+    return i;
+}
+
+/* O bloco tem uma chamada seguida de desvio (candidata a antecipar_retorno) */
+static int termina_em_chamada(IrBloco *bloco) {
+    IrInstr *i = bloco->ultimo;
+    if (!i || i->op != IR_JMP) return 0;
+    for (i = i->ant; i && i->op != IR_CALL; i = i->ant) {
+        if (ir_tem_efeito(i)) return 0;
+    }
+    return i != NULL;
+}
+
+/* Arrays locais do chamador deixam de existir quando ele salta */
+static int usa_array_local(IrInstr *call) {
+    for (int a = 0; a < call->num_args; a++) {
+        IrInstr *arg = ir_valor(call->args[a]);
+        if (arg->op == IR_ENDERECO && !arg->nome) return 1;
+    }
+    return 0;
+}
+
+/*
+ * Cria o laço da recursão própria: a entrada antiga vira cabeçalho e cada
+ * parâmetro vira um phi entre o valor recebido e os argumentos das
+ * chamadas de cauda.
+ */
+static void criar_laco(IrFuncao *f, IrInstr **chamadas, int num) {
+    IrBloco *cabecalho = f->blocos[0];
+    IrBloco *entrada = ir_novo_bloco(f);
+    f->blocos[f->num_blocos - 1] = cabecalho;
+    f->blocos[0] = entrada;
+
+    IrInstr *jmp = ir_nova_instr(f, IR_JMP, IR_T_VOID);
+    ir_add_alvo(jmp, cabecalho);
+    ir_inserir_fim(entrada, jmp);
+
+    IrInstr **phis = (IrInstr**)calloc(f->num_params + 1, sizeof(IrInstr*));
+    IrInstr *i = cabecalho->primeiro;
+    while (i) {
+        IrInstr *prox = i->prox;
+        if (i->op == IR_PARAM) {
+            // o parametro antigo vira o phi, mantendo todos os seus usos
+            IrInstr *param = ir_nova_instr(f, IR_PARAM, i->tipo);
+            param->imm = i->imm;
+            ir_inserir_antes(jmp, param);
+
+            ir_remover(i);
+            i->op = IR_PHI;
+            ir_inserir_inicio(cabecalho, i);
+            ir_add_phi_arg(i, param, entrada);
+            phis[param->imm] = i;
+        }
+        i = prox;
+    }
+
+    for (int c = 0; c < num; c++) {
+        IrInstr *call = chamadas[c];
+        IrBloco *bloco = call->bloco;
+        for (int p = 0; p < f->num_params; p++) {
+            // parametro sem uso nao tem phi
+            if (phis[p]) ir_add_phi_arg(phis[p], call->args[p], bloco);
+        }
+        IrInstr *ret = ir_terminador(bloco);
+        ir_remover(ret);
+        ir_remover(call);
+        IrInstr *volta = ir_nova_instr(f, IR_JMP, IR_T_VOID);
+        ir_add_alvo(volta, cabecalho);
+        ir_inserir_fim(bloco, volta);
+    }
+    free(phis);
+}
+
+/*
+ * Recursão própria em cauda vira laço (se a função não tem arrays locais,
+ * que cada ativação precisa ter separados); outras chamadas de cauda
+ * recebem IR_FLAG_CAUDA quando cabem nos registradores de argumento.
+ * Retorna quantas chamadas foram convertidas.
+ */
+int otimizar_chamadas_cauda(IrFuncao *f, FILE *relatorio) {
+    IrInstr **proprias = (IrInstr**)malloc(sizeof(IrInstr*) * (f->num_blocos + 1));
+    int num_proprias = 0, saltos = 0;
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        if (termina_em_chamada(f->blocos[b])) antecipar_retorno(f, f->blocos[b]);
+        IrInstr *call = chamada_de_cauda(f->blocos[b]);
+        if (!call) continue;
+
+        if (strcmp(call->nome, f->nome) == 0 && f->num_arrays_locais == 0) {
+            proprias[num_proprias++] = call;
+            if (relatorio) {
+                fprintf(relatorio, "[cauda] %s: chamada a %s convertida em laco\n",
+                        f->nome, call->nome);
+            }
+        } else if (call->num_args <= MAX_ARGS_CAUDA && !usa_array_local(call)) {
+            call->flags |= IR_FLAG_CAUDA;
+            saltos++;
+            if (relatorio) {
+                fprintf(relatorio, "[cauda] %s: chamada a %s convertida em salto\n",
+                        f->nome, call->nome);
+            }
+        }
+    }
+
+    if (num_proprias > 0) criar_laco(f, proprias, num_proprias);
+    ir_calcular_cfg(f);
+    free(proprias);
+    return num_proprias + saltos;
+}
@@ -72,8 +72,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "tokens.h"
 #include "tree.h"  
+#include "semantico.h"
+#include "ir.h"
+#include "otimizador.h"
+#include "x86.h"
+#include "cache.h"
+#include "bytecode.h"
+#include "interpretador.h"
+#include "transpilador_c.h"
+#include "entrada_saida.h"
+#include "camadas.h"
 
 extern int yylex();
 extern int line_num;
@@ -81,12 +94,9 @@ extern FILE* yyin;
 extern char* yytext;
 void yyerror(const char *s);
 
-// Declaração da função do analisador semântico
-void execute_semantic_analysis(TreeNode *root);
 
 
-
-#line 90 "cminus.tab.c"
+#line 100 "cminus.tab.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -563,13 +573,13 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int16 yyrline[] =
 {
-       0,    53,    53,    62,    67,    75,    79,    86,    91,   102,
-     106,   113,   123,   128,   135,   140,   148,   153,   161,   170,
-     176,   182,   188,   194,   198,   202,   206,   210,   217,   222,
-     229,   235,   245,   254,   258,   266,   272,   279,   283,   291,
-     298,   305,   306,   307,   308,   309,   310,   314,   321,   328,
-     329,   333,   340,   347,   348,   352,   356,   360,   364,   373,
-     381,   387,   393,   398
+       0,    63,    63,    72,    77,    85,    89,    96,   101,   112,
+     116,   123,   133,   138,   145,   150,   158,   163,   171,   180,
+     186,   192,   198,   204,   208,   212,   216,   220,   227,   232,
+     239,   245,   255,   264,   268,   276,   282,   289,   293,   301,
+     308,   315,   316,   317,   318,   319,   320,   324,   331,   338,
+     339,   343,   350,   357,   358,   362,   366,   370,   374,   383,
+     391,   397,   403,   408
 };
 #endif
 
@@ -1199,531 +1209,531 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* program: declaration_list  */
-#line 54 "cminus.y"
+#line 64 "cminus.y"
         { 
             (yyval.node) = new_node("Programa", NULL);
             add_child((yyval.node), (yyvsp[0].node));
             root = (yyval.node);
         }
-#line 1209 "cminus.tab.c"
+#line 1219 "cminus.tab.c"
     break;
 
   case 3: /* declaration_list: declaration_list declaration  */
-#line 63 "cminus.y"
+#line 73 "cminus.y"
         {
             (yyval.node) = (yyvsp[-1].node);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1218 "cminus.tab.c"
+#line 1228 "cminus.tab.c"
     break;
 
   case 4: /* declaration_list: declaration  */
-#line 68 "cminus.y"
+#line 78 "cminus.y"
         {
             (yyval.node) = new_node("Declaracao-lista", NULL);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1227 "cminus.tab.c"
+#line 1237 "cminus.tab.c"
     break;
 
   case 5: /* declaration: var_declaration  */
-#line 76 "cminus.y"
+#line 86 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1235 "cminus.tab.c"
+#line 1245 "cminus.tab.c"
     break;
 
   case 6: /* declaration: fun_declaration  */
-#line 80 "cminus.y"
+#line 90 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1243 "cminus.tab.c"
+#line 1253 "cminus.tab.c"
     break;
 
   case 7: /* var_declaration: type_specifier ID SEMI  */
-#line 87 "cminus.y"
+#line 97 "cminus.y"
         {
             (yyval.node) = new_node("Var-declaracao", (yyvsp[-1].string));
             add_child((yyval.node), (yyvsp[-2].node));
         }
-#line 1252 "cminus.tab.c"
+#line 1262 "cminus.tab.c"
     break;
 
   case 8: /* var_declaration: type_specifier ID LBRACKET NUM RBRACKET SEMI  */
-#line 92 "cminus.y"
+#line 102 "cminus.y"
         {
             char num_str[32];
             sprintf(num_str, "%d", (yyvsp[-2].number));
-            (yyval.node) = new_node("Fun-declaracao", (yyvsp[-4].string));
+            (yyval.node) = new_node("Var-declaracao", (yyvsp[-4].string));
             add_child((yyval.node), (yyvsp[-5].node));
             add_child((yyval.node), new_node("Size", num_str));
         }
-#line 1264 "cminus.tab.c"
+#line 1274 "cminus.tab.c"
     break;
 
   case 9: /* type_specifier: INT  */
-#line 103 "cminus.y"
+#line 113 "cminus.y"
         {
             (yyval.node) = new_node("Tipo", "int");
         }
-#line 1272 "cminus.tab.c"
+#line 1282 "cminus.tab.c"
     break;
 
   case 10: /* type_specifier: VOID  */
-#line 107 "cminus.y"
+#line 117 "cminus.y"
         {
             (yyval.node) = new_node("Tipo", "void");
         }
-#line 1280 "cminus.tab.c"
+#line 1290 "cminus.tab.c"
     break;
 
   case 11: /* fun_declaration: type_specifier ID LPAREN params RPAREN compound_stmt  */
-#line 114 "cminus.y"
+#line 124 "cminus.y"
         {
             (yyval.node) = new_node("Fun-declaracao", (yyvsp[-4].string));
             add_child((yyval.node), (yyvsp[-5].node));  // return type
             add_child((yyval.node), (yyvsp[-2].node));  // parameters
             add_child((yyval.node), (yyvsp[0].node));  // function body
         }
-#line 1291 "cminus.tab.c"
+#line 1301 "cminus.tab.c"
     break;
 
   case 12: /* params: param_list  */
-#line 124 "cminus.y"
+#line 134 "cminus.y"
         {
             (yyval.node) = new_node("params", NULL);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1300 "cminus.tab.c"
+#line 1310 "cminus.tab.c"
     break;
 
   case 13: /* params: VOID  */
-#line 129 "cminus.y"
+#line 139 "cminus.y"
         {
             (yyval.node) = new_node("params", "void");
         }
-#line 1308 "cminus.tab.c"
+#line 1318 "cminus.tab.c"
     break;
 
   case 14: /* param_list: param_list COMMA param  */
-#line 136 "cminus.y"
+#line 146 "cminus.y"
         {
             (yyval.node) = (yyvsp[-2].node);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1317 "cminus.tab.c"
+#line 1327 "cminus.tab.c"
     break;
 
   case 15: /* param_list: param  */
-#line 141 "cminus.y"
+#line 151 "cminus.y"
         {
             (yyval.node) = new_node("Param-lista", NULL);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1326 "cminus.tab.c"
+#line 1336 "cminus.tab.c"
     break;
 
   case 16: /* param: type_specifier ID  */
-#line 149 "cminus.y"
+#line 159 "cminus.y"
         {
             (yyval.node) = new_node("params", (yyvsp[0].string));
             add_child((yyval.node), (yyvsp[-1].node));
         }
-#line 1335 "cminus.tab.c"
+#line 1345 "cminus.tab.c"
     break;
 
   case 17: /* param: type_specifier ID LBRACKET RBRACKET  */
-#line 154 "cminus.y"
+#line 164 "cminus.y"
         {
             (yyval.node) = new_node("params-lista", (yyvsp[-2].string));
             add_child((yyval.node), (yyvsp[-3].node));
         }
-#line 1344 "cminus.tab.c"
+#line 1354 "cminus.tab.c"
     break;
 
   case 18: /* compound_stmt: LBRACE local_declarations statement_list RBRACE  */
-#line 162 "cminus.y"
+#line 172 "cminus.y"
         {
             (yyval.node) = new_node("Composto-declaracao", NULL);
             add_child((yyval.node), (yyvsp[-2].node));  // local declarations
             add_child((yyval.node), (yyvsp[-1].node));  // statement list
         }
-#line 1354 "cminus.tab.c"
+#line 1364 "cminus.tab.c"
     break;
 
   case 19: /* local_declarations: local_declarations var_declaration  */
-#line 171 "cminus.y"
+#line 181 "cminus.y"
         {
             (yyval.node) = (yyvsp[-1].node);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1363 "cminus.tab.c"
+#line 1373 "cminus.tab.c"
     break;
 
   case 20: /* local_declarations: %empty  */
-#line 176 "cminus.y"
+#line 186 "cminus.y"
         {
             (yyval.node) = new_node("local-declaracao", NULL);
         }
-#line 1371 "cminus.tab.c"
+#line 1381 "cminus.tab.c"
     break;
 
   case 21: /* statement_list: statement_list statement  */
-#line 183 "cminus.y"
+#line 193 "cminus.y"
         {
             (yyval.node) = (yyvsp[-1].node);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1380 "cminus.tab.c"
+#line 1390 "cminus.tab.c"
     break;
 
   case 22: /* statement_list: %empty  */
-#line 188 "cminus.y"
+#line 198 "cminus.y"
         {
             (yyval.node) = new_node("Statement-lista", NULL);
         }
-#line 1388 "cminus.tab.c"
+#line 1398 "cminus.tab.c"
     break;
 
   case 23: /* statement: expression_stmt  */
-#line 195 "cminus.y"
+#line 205 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1396 "cminus.tab.c"
+#line 1406 "cminus.tab.c"
     break;
 
   case 24: /* statement: compound_stmt  */
-#line 199 "cminus.y"
+#line 209 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1404 "cminus.tab.c"
+#line 1414 "cminus.tab.c"
     break;
 
   case 25: /* statement: selection_stmt  */
-#line 203 "cminus.y"
+#line 213 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1412 "cminus.tab.c"
+#line 1422 "cminus.tab.c"
     break;
 
   case 26: /* statement: iteration_stmt  */
-#line 207 "cminus.y"
+#line 217 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1420 "cminus.tab.c"
+#line 1430 "cminus.tab.c"
     break;
 
   case 27: /* statement: return_stmt  */
-#line 211 "cminus.y"
+#line 221 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1428 "cminus.tab.c"
+#line 1438 "cminus.tab.c"
     break;
 
   case 28: /* expression_stmt: expression SEMI  */
-#line 218 "cminus.y"
+#line 228 "cminus.y"
         {
             (yyval.node) = new_node("Expressao-declaracao", NULL);
             add_child((yyval.node), (yyvsp[-1].node));
         }
-#line 1437 "cminus.tab.c"
+#line 1447 "cminus.tab.c"
     break;
 
   case 29: /* expression_stmt: SEMI  */
-#line 223 "cminus.y"
+#line 233 "cminus.y"
         {
             (yyval.node) = new_node("statement-vazio", NULL);
         }
-#line 1445 "cminus.tab.c"
+#line 1455 "cminus.tab.c"
     break;
 
   case 30: /* selection_stmt: IF LPAREN expression RPAREN statement  */
-#line 230 "cminus.y"
+#line 240 "cminus.y"
         {
             (yyval.node) = new_node("If-Statement", NULL);
             add_child((yyval.node), (yyvsp[-2].node));  // condition
             add_child((yyval.node), (yyvsp[0].node));  // then branch
         }
-#line 1455 "cminus.tab.c"
+#line 1465 "cminus.tab.c"
     break;
 
   case 31: /* selection_stmt: IF LPAREN expression RPAREN statement ELSE statement  */
-#line 236 "cminus.y"
+#line 246 "cminus.y"
         {
             (yyval.node) = new_node("If-Else-Statement", NULL);
             add_child((yyval.node), (yyvsp[-4].node));  // condition
             add_child((yyval.node), (yyvsp[-2].node));  // then branch
             add_child((yyval.node), (yyvsp[0].node));  // else branch
         }
-#line 1466 "cminus.tab.c"
+#line 1476 "cminus.tab.c"
     break;
 
   case 32: /* iteration_stmt: WHILE LPAREN expression RPAREN statement  */
-#line 246 "cminus.y"
+#line 256 "cminus.y"
         {
             (yyval.node) = new_node("While-Statement", NULL);
             add_child((yyval.node), (yyvsp[-2].node));  // condition
             add_child((yyval.node), (yyvsp[0].node));  // body
         }
-#line 1476 "cminus.tab.c"
+#line 1486 "cminus.tab.c"
     break;
 
   case 33: /* return_stmt: RETURN SEMI  */
-#line 255 "cminus.y"
+#line 265 "cminus.y"
         {
             (yyval.node) = new_node("Return-Statement", "void");
         }
-#line 1484 "cminus.tab.c"
+#line 1494 "cminus.tab.c"
     break;
 
   case 34: /* return_stmt: RETURN expression SEMI  */
-#line 259 "cminus.y"
+#line 269 "cminus.y"
         {
             (yyval.node) = new_node("Return-Statement", NULL);
             add_child((yyval.node), (yyvsp[-1].node));
         }
-#line 1493 "cminus.tab.c"
+#line 1503 "cminus.tab.c"
     break;
 
   case 35: /* expression: var ASSIGN expression  */
-#line 267 "cminus.y"
+#line 277 "cminus.y"
         {
             (yyval.node) = new_node("Assign-Expression", NULL);
             add_child((yyval.node), (yyvsp[-2].node));  // variable
             add_child((yyval.node), (yyvsp[0].node));  // value
         }
-#line 1503 "cminus.tab.c"
+#line 1513 "cminus.tab.c"
     break;
 
   case 36: /* expression: simple_expression  */
-#line 273 "cminus.y"
+#line 283 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1511 "cminus.tab.c"
+#line 1521 "cminus.tab.c"
     break;
 
   case 37: /* var: ID  */
-#line 280 "cminus.y"
+#line 290 "cminus.y"
         {
             (yyval.node) = new_node("Variavel", (yyvsp[0].string));
         }
-#line 1519 "cminus.tab.c"
+#line 1529 "cminus.tab.c"
     break;
 
   case 38: /* var: ID LBRACKET expression RBRACKET  */
-#line 284 "cminus.y"
+#line 294 "cminus.y"
         {
             (yyval.node) = new_node("Variavel-Array", (yyvsp[-3].string));
             add_child((yyval.node), (yyvsp[-1].node));  // index
         }
-#line 1528 "cminus.tab.c"
+#line 1538 "cminus.tab.c"
     break;
 
   case 39: /* simple_expression: additive_expression relop additive_expression  */
-#line 292 "cminus.y"
+#line 302 "cminus.y"
         {
             (yyval.node) = new_node("Expressao", NULL);
             add_child((yyval.node), (yyvsp[-2].node));  // left operand
             add_child((yyval.node), (yyvsp[-1].node));  // operator
             add_child((yyval.node), (yyvsp[0].node));  // right operand
         }
-#line 1539 "cminus.tab.c"
+#line 1549 "cminus.tab.c"
     break;
 
   case 40: /* simple_expression: additive_expression  */
-#line 299 "cminus.y"
+#line 309 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1547 "cminus.tab.c"
+#line 1557 "cminus.tab.c"
     break;
 
   case 41: /* relop: LTE  */
-#line 305 "cminus.y"
+#line 315 "cminus.y"
             { (yyval.node) = new_node("operador", "<="); }
-#line 1553 "cminus.tab.c"
+#line 1563 "cminus.tab.c"
     break;
 
   case 42: /* relop: LT  */
-#line 306 "cminus.y"
+#line 316 "cminus.y"
             { (yyval.node) = new_node("operador", "<"); }
-#line 1559 "cminus.tab.c"
+#line 1569 "cminus.tab.c"
     break;
 
   case 43: /* relop: GT  */
-#line 307 "cminus.y"
+#line 317 "cminus.y"
             { (yyval.node) = new_node("operador", ">"); }
-#line 1565 "cminus.tab.c"
+#line 1575 "cminus.tab.c"
     break;
 
   case 44: /* relop: GTE  */
-#line 308 "cminus.y"
+#line 318 "cminus.y"
             { (yyval.node) = new_node("operador", ">="); }
-#line 1571 "cminus.tab.c"
+#line 1581 "cminus.tab.c"
     break;
 
   case 45: /* relop: EQ  */
-#line 309 "cminus.y"
+#line 319 "cminus.y"
             { (yyval.node) = new_node("operador", "=="); }
-#line 1577 "cminus.tab.c"
+#line 1587 "cminus.tab.c"
     break;
 
   case 46: /* relop: NEQ  */
-#line 310 "cminus.y"
+#line 320 "cminus.y"
             { (yyval.node) = new_node("operador", "!="); }
-#line 1583 "cminus.tab.c"
+#line 1593 "cminus.tab.c"
     break;
 
   case 47: /* additive_expression: additive_expression addop term  */
-#line 315 "cminus.y"
+#line 325 "cminus.y"
         {
             (yyval.node) = new_node("soma-Expressao", NULL);
             add_child((yyval.node), (yyvsp[-2].node));  // left operand
             add_child((yyval.node), (yyvsp[-1].node));  // operator
             add_child((yyval.node), (yyvsp[0].node));  // right operand
         }
-#line 1594 "cminus.tab.c"
+#line 1604 "cminus.tab.c"
     break;
 
   case 48: /* additive_expression: term  */
-#line 322 "cminus.y"
+#line 332 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1602 "cminus.tab.c"
+#line 1612 "cminus.tab.c"
     break;
 
   case 49: /* addop: PLUS  */
-#line 328 "cminus.y"
+#line 338 "cminus.y"
               { (yyval.node) = new_node("operador", "+"); }
-#line 1608 "cminus.tab.c"
+#line 1618 "cminus.tab.c"
     break;
 
   case 50: /* addop: MINUS  */
-#line 329 "cminus.y"
+#line 339 "cminus.y"
               { (yyval.node) = new_node("operador", "-"); }
-#line 1614 "cminus.tab.c"
+#line 1624 "cminus.tab.c"
     break;
 
   case 51: /* term: term mulop factor  */
-#line 334 "cminus.y"
+#line 344 "cminus.y"
         {
             (yyval.node) = new_node("mult-Expressao", NULL);
             add_child((yyval.node), (yyvsp[-2].node));  // left operand
             add_child((yyval.node), (yyvsp[-1].node));  // operator
             add_child((yyval.node), (yyvsp[0].node));  // right operand
         }
-#line 1625 "cminus.tab.c"
+#line 1635 "cminus.tab.c"
     break;
 
   case 52: /* term: factor  */
-#line 341 "cminus.y"
+#line 351 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1633 "cminus.tab.c"
+#line 1643 "cminus.tab.c"
     break;
 
   case 53: /* mulop: TIMES  */
-#line 347 "cminus.y"
+#line 357 "cminus.y"
               { (yyval.node) = new_node("operador", "*"); }
-#line 1639 "cminus.tab.c"
+#line 1649 "cminus.tab.c"
     break;
 
   case 54: /* mulop: DIVIDE  */
-#line 348 "cminus.y"
+#line 358 "cminus.y"
               { (yyval.node) = new_node("operador", "/"); }
-#line 1645 "cminus.tab.c"
+#line 1655 "cminus.tab.c"
     break;
 
   case 55: /* factor: LPAREN expression RPAREN  */
-#line 353 "cminus.y"
+#line 363 "cminus.y"
         {
             (yyval.node) = (yyvsp[-1].node);
         }
-#line 1653 "cminus.tab.c"
+#line 1663 "cminus.tab.c"
     break;
 
   case 56: /* factor: var  */
-#line 357 "cminus.y"
+#line 367 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1661 "cminus.tab.c"
+#line 1671 "cminus.tab.c"
     break;
 
   case 57: /* factor: call  */
-#line 361 "cminus.y"
+#line 371 "cminus.y"
         {
             (yyval.node) = (yyvsp[0].node);
         }
-#line 1669 "cminus.tab.c"
+#line 1679 "cminus.tab.c"
     break;
 
   case 58: /* factor: NUM  */
-#line 365 "cminus.y"
+#line 375 "cminus.y"
         {
             char num_str[32];
             sprintf(num_str, "%d", (yyvsp[0].number));
             (yyval.node) = new_node("Num", num_str);
         }
-#line 1679 "cminus.tab.c"
+#line 1689 "cminus.tab.c"
     break;
 
   case 59: /* call: ID LPAREN args RPAREN  */
-#line 374 "cminus.y"
+#line 384 "cminus.y"
         {
             (yyval.node) = new_node("Function-Call", (yyvsp[-3].string));
             add_child((yyval.node), (yyvsp[-1].node));
         }
-#line 1688 "cminus.tab.c"
+#line 1698 "cminus.tab.c"
     break;
 
   case 60: /* args: arg_list  */
-#line 382 "cminus.y"
+#line 392 "cminus.y"
         {
             (yyval.node) = new_node("Argumentos", NULL);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1697 "cminus.tab.c"
+#line 1707 "cminus.tab.c"
     break;
 
   case 61: /* args: %empty  */
-#line 387 "cminus.y"
+#line 397 "cminus.y"
         {
             (yyval.node) = new_node("Argumentos", "void");
         }
-#line 1705 "cminus.tab.c"
+#line 1715 "cminus.tab.c"
     break;
 
   case 62: /* arg_list: arg_list COMMA expression  */
-#line 394 "cminus.y"
+#line 404 "cminus.y"
         {
             (yyval.node) = (yyvsp[-2].node);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1714 "cminus.tab.c"
+#line 1724 "cminus.tab.c"
     break;
 
   case 63: /* arg_list: expression  */
-#line 399 "cminus.y"
+#line 409 "cminus.y"
         {
             (yyval.node) = new_node("Argument-List", NULL);
             add_child((yyval.node), (yyvsp[0].node));
         }
-#line 1723 "cminus.tab.c"
+#line 1733 "cminus.tab.c"
     break;
 
 
-#line 1727 "cminus.tab.c"
+#line 1737 "cminus.tab.c"
 
       default: break;
     }
@@ -1916,21 +1926,270 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 405 "cminus.y"
+#line 415 "cminus.y"
 
 void yyerror(const char *s) {
     fprintf(stderr, "ERRO SINTATICO: '%s' LINHA: %d\n", yytext, line_num);
 }
 
+// Opções de linha de comando
+typedef struct {
+    const char *arquivo;
+    int imprimir_ir;     // --ir: imprime a representação intermediária
+    int otimizar;        // -O: executa os passes de otimização
+    int relatorio;       // --relatorio: relatório dos passes (stderr)
+    int asm_x86;         // --asm: imprime o assembly x86-64
+    const char *saida;   // -o arquivo: gera o executável
+    int montador_externo; // --montador-externo: gera com as/ld em vez do codificador
+    int executar;        // --run: executa o programa em memória
+    const char *lote;    // --lote dir: executa em memória com cada dir/*.in, um fork por entrada
+    LimitesLote limites; // --limite-cpu=S, --limite-memoria=MB dos filhos de --lote (CPU também em --faixas)
+    int vm;              // --vm: executa na máquina virtual de bytecode
+    int bytecode;        // --bytecode: imprime o bytecode da máquina virtual
+    int perfil_vm;       // --perfil-vm: contagens de instruções da máquina virtual (stderr)
+    int sem_superinstrucoes; // --sem-superinstrucoes: só o conjunto básico do bytecode
+    int arvore;          // --arvore: executa com o interpretador de referência sobre a árvore
+    int perfil_arvore;   // --perfil-arvore: contagens de nós executados (stderr)
+    int fechamentos;     // --fechamentos: executa com o interpretador por fechamentos
+    const char *faixas;  // --faixas dir: executa cada dir/*.in, várias entradas por vetor
+    int camadas;         // --camadas: máquina virtual, com as funções quentes compiladas em fundo
+    int limite_quente;   // --limite-quente=N: chamadas + voltas de laço até compilar
+    int imprimir_c;      // --c: imprime o programa traduzido para C
+    int via_c;           // --via-c: compila pelo C com o compilador do sistema
+    int es_stdio;        // --es-stdio: input()/output() com scanf/printf nos executores em processo
+    int cache;           // --cache: código de máquina por função em cache no disco
+    int verificar_indices; // --verificar-indices: erro de execução em acesso fora do array (IR e x86)
+    AlocadorX86 alocador; // --alocador=pilha|linear|grafo
+    OpcoesOtimizacao otimizacao;
+} Opcoes;
+
+// --inline-<parametro>=N ajusta o modelo de custo do inline
+static int ler_parametro_inline(const char *arg, CustoInline *c) {
+    static const struct { const char *nome; size_t campo; } parametros[] = {
+        { "--inline-limite=",    offsetof(CustoInline, limite) },
+        { "--inline-folha=",     offsetof(CustoInline, limite_folha) },
+        { "--inline-chamada=",   offsetof(CustoInline, bonus_chamada) },
+        { "--inline-constante=", offsetof(CustoInline, bonus_constante) },
+        { "--inline-array=",     offsetof(CustoInline, bonus_array) },
+        { "--inline-maximo=",    offsetof(CustoInline, tamanho_maximo) },
+    };
+    for (size_t p = 0; p < sizeof(parametros) / sizeof(parametros[0]); p++) {
+        size_t n = strlen(parametros[p].nome);
+        if (strncmp(arg, parametros[p].nome, n) == 0) {
+            *(int*)((char*)c + parametros[p].campo) = atoi(arg + n);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int ler_opcoes(int argc, char **argv, Opcoes *op) {
+    memset(op, 0, sizeof(Opcoes));
+    opcoes_otimizacao_padrao(&op->otimizacao);
+    op->alocador = ALOCADOR_LINEAR;
+    op->limites.cpu_segundos = 5;
+    op->limites.memoria_mb = 512;
+    op->limite_quente = 1000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ir") == 0) op->imprimir_ir = 1;
+        else if (strcmp(argv[i], "-O") == 0) op->otimizar = 1;
+        else if (strcmp(argv[i], "--relatorio") == 0) op->relatorio = 1;
+        else if (strcmp(argv[i], "--asm") == 0) op->asm_x86 = 1;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) op->saida = argv[++i];
+        else if (strcmp(argv[i], "--montador-externo") == 0) op->montador_externo = 1;
+        else if (strcmp(argv[i], "--run") == 0) op->executar = 1;
+        else if (strcmp(argv[i], "--lote") == 0 && i + 1 < argc) op->lote = argv[++i];
+        else if (strncmp(argv[i], "--limite-cpu=", 13) == 0) op->limites.cpu_segundos = atoi(argv[i] + 13);
+        else if (strncmp(argv[i], "--limite-memoria=", 17) == 0) op->limites.memoria_mb = atoi(argv[i] + 17);
+        else if (strcmp(argv[i], "--vm") == 0) op->vm = 1;
+        else if (strcmp(argv[i], "--bytecode") == 0) op->bytecode = 1;
+        else if (strcmp(argv[i], "--perfil-vm") == 0) op->vm = op->perfil_vm = 1;
+        else if (strcmp(argv[i], "--sem-superinstrucoes") == 0) op->sem_superinstrucoes = 1;
+        else if (strcmp(argv[i], "--arvore") == 0) op->arvore = 1;
+        else if (strcmp(argv[i], "--perfil-arvore") == 0) op->arvore = op->perfil_arvore = 1;
+        else if (strcmp(argv[i], "--fechamentos") == 0) op->fechamentos = 1;
+        else if (strcmp(argv[i], "--faixas") == 0 && i + 1 < argc) op->faixas = argv[++i];
+        else if (strcmp(argv[i], "--camadas") == 0) op->camadas = 1;
+        else if (strncmp(argv[i], "--limite-quente=", 16) == 0) op->limite_quente = atoi(argv[i] + 16);
+        else if (strcmp(argv[i], "--c") == 0) op->imprimir_c = 1;
+        else if (strcmp(argv[i], "--via-c") == 0) op->via_c = 1;
+        else if (strcmp(argv[i], "--es-stdio") == 0) op->es_stdio = 1;
+        else if (strcmp(argv[i], "--cache") == 0) op->cache = 1;
+        else if (strcmp(argv[i], "--verificar-indices") == 0) op->verificar_indices = 1;
+        else if (strcmp(argv[i], "--alocador=pilha") == 0) op->alocador = ALOCADOR_PILHA;
+        else if (strcmp(argv[i], "--alocador=linear") == 0) op->alocador = ALOCADOR_LINEAR;
+        else if (strcmp(argv[i], "--alocador=grafo") == 0) op->alocador = ALOCADOR_GRAFO;
+        else if (strcmp(argv[i], "--sem-inline") == 0) op->otimizacao.inline_ativo = 0;
+        else if (strcmp(argv[i], "--sem-faixas") == 0) op->otimizacao.faixas_ativo = 0;
+        else if (ler_parametro_inline(argv[i], &op->otimizacao.custo_inline)) continue;
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Opcao desconhecida: %s\n", argv[i]);
+            return 0;
+        }
+        else op->arquivo = argv[i];
+    }
+    return 1;
+}
+
+// Codifica o programa e escreve o ELF direto, sem processos externos
+static int gerar_executavel(IrModulo *mod, OpcoesX86 *x86, const char *saida) {
+    CodigoX86 codigo;
+    x86_codigo_iniciar(&codigo);
+    x86_codificar_modulo(mod, x86, &codigo);
+    x86_codificar_runtime(&codigo);
+    int status = x86_escrever_elf(&codigo, saida);
+    x86_codigo_liberar(&codigo);
+    return status;
+}
+
+// Roda uma ferramenta do sistema com os argumentos como estão, sem shell
+static int executar_ferramenta(char *const argv[]) {
+    // o filho herda os buffers: nada pendente antes do fork
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        execvp(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return 1;
+    }
+    return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+// Monta e liga o assembly com as ferramentas do sistema (as e ld)
+static int montar_executavel(IrModulo *mod, OpcoesX86 *x86, const char *saida) {
+    size_t n = strlen(saida) + 3;
+    char *fonte = (char*)malloc(n);
+    char *objeto = (char*)malloc(n);
+    snprintf(fonte, n, "%s.s", saida);
+    snprintf(objeto, n, "%s.o", saida);
+
+    int status = 1;
+    FILE *arq = fopen(fonte, "w");
+    if (!arq) {
+        perror(fonte);
+    } else {
+        x86_emitir_modulo(mod, x86, arq);
+        fclose(arq);
+        char *as[] = { "as", "-o", objeto, fonte, NULL };
+        char *ld[] = { "ld", "-o", (char*)saida, objeto, NULL };
+        status = executar_ferramenta(as) || executar_ferramenta(ld);
+        remove(fonte);
+        remove(objeto);
+        if (status) fprintf(stderr, "Falha ao montar/ligar %s\n", saida);
+    }
+
+    free(fonte);
+    free(objeto);
+    return status;
+}
+
+// Compila a árvore para bytecode e executa na máquina virtual, sem IR
+static int interpretar(TreeNode *root, Opcoes *op) {
+    BcPrograma *prog = bc_compilar(root, !op->sem_superinstrucoes);
+    int status = 1;
+    if (prog->erros == 0) {
+        if (op->bytecode) bc_imprimir(prog, stdout);
+        status = op->vm ? vm_executar(prog, op->perfil_vm ? stderr : NULL) : 0;
+    }
+    bc_liberar(prog);
+    return status;
+}
+
+// Gera a IR e executa as etapas pedidas nas opções
+static int compilar(TreeNode *root, Opcoes *op) {
+    start_semantic_analysis(root);
+    if (semantic_error_count > 0) return 1;
+    if (op->es_stdio) es_usar_stdio(1);
+    // só a IR e o x86 geram as verificações; a árvore sempre verifica
+    if (op->verificar_indices && (op->fechamentos || op->faixas || op->camadas || op->vm ||
+                                  op->bytecode || op->imprimir_c || op->via_c)) {
+        fprintf(stderr, "--verificar-indices nao vale com --fechamentos, --faixas, --camadas, "
+                        "--vm, --bytecode, --c ou --via-c\n");
+        return 1;
+    }
+    if (op->arvore) return arvore_executar(root, op->perfil_arvore ? stderr : NULL);
+    if (op->fechamentos) return fechamentos_executar(root);
+    if (op->faixas) return faixas_executar_lote(root, op->faixas, op->limites.cpu_segundos);
+    if (op->camadas) {
+        OpcoesX86 x86 = { .alocador = op->alocador };
+        return camadas_executar(root, &op->otimizacao, &x86, (unsigned)op->limite_quente,
+                                op->relatorio ? stderr : NULL);
+    }
+    if (op->vm || op->bytecode) return interpretar(root, op);
+    if (op->imprimir_c) return c_emitir_programa(root, stdout) > 0;
+    if (op->via_c) {
+        FILE *relatorio = op->relatorio ? stderr : NULL;
+        return op->saida ? c_gerar_executavel(root, op->saida, relatorio) : c_executar(root, relatorio);
+    }
+
+    IrModulo *mod = ir_gerar(root, op->verificar_indices);
+    if (mod->erros > 0) return 1;
+
+    // o cache só guarda código codificado: não vale para --ir, --asm e as/ld
+    FILE *relatorio = op->relatorio ? stderr : NULL;
+    GrafoChamadas *grafo = op->otimizar ? grafo_chamadas_construir(root) : NULL;
+    CacheX86 *cache = NULL;
+    if (op->cache && !op->imprimir_ir && !op->asm_x86 &&
+        (op->executar || op->lote || (op->saida && !op->montador_externo))) {
+        cache = cache_x86_abrir(root, grafo, op->otimizar ? &op->otimizacao : NULL, op->alocador,
+                                op->verificar_indices, relatorio);
+    }
+
+    if (op->otimizar) {
+        if (cache) cache_x86_otimizar(cache, mod, grafo, &op->otimizacao, relatorio);
+        else otimizar_modulo(mod, grafo, &op->otimizacao, relatorio);
+    }
+    if (op->imprimir_ir) {
+        ir_imprimir_modulo(mod, stdout);
+    }
+    // o backend tira as funções do SSA: vem depois de tudo o que usa a IR
+    OpcoesX86 x86 = { .alocador = op->alocador, .relatorio = relatorio, .cache = cache };
+    int status = 0;
+    if (op->asm_x86) {
+        x86_emitir_modulo(mod, &x86, stdout);
+    } else if (op->executar) {
+        status = x86_executar(mod, &x86);
+    } else if (op->lote) {
+        status = x86_executar_lote(mod, &x86, op->lote, &op->limites);
+    } else if (op->saida && op->montador_externo) {
+        status = montar_executavel(mod, &x86, op->saida);
+    } else if (op->saida) {
+        status = gerar_executavel(mod, &x86, op->saida);
+    }
+    if (cache) cache_x86_fechar(cache);
+    return status;
+}
+
 int main(int argc, char **argv) {
-    if (argc > 1) {
-        if (!(yyin = fopen(argv[1], "r"))) {
-            perror(argv[1]);
+    Opcoes op;
+    if (!ler_opcoes(argc, argv, &op)) {
+        return 1;
+    }
+    if (op.arquivo) {
+        if (!(yyin = fopen(op.arquivo, "r"))) {
+            perror(op.arquivo);
             return 1;
         }
     }
     
     int result = yyparse();
+
+    // Sem opções de geração de código mantém a saída original
+    if (op.imprimir_ir || op.otimizar || op.asm_x86 || op.saida || op.executar || op.lote ||
+        op.vm || op.bytecode || op.arvore || op.fechamentos || op.faixas || op.camadas || op.imprimir_c || op.via_c) {
+        if (result != 0 || root == NULL) return 1;
+        return compilar(root, &op);
+    }
     
     if (result == 0 && root != NULL) {
         // Chama o analisador semântico após o parsing bem-sucedido
@@ -2,8 +2,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "tokens.h"
 #include "tree.h"  
+#include "semantico.h"
+#include "ir.h"
+#include "otimizador.h"
+#include "x86.h"
+#include "cache.h"
+#include "bytecode.h"
+#include "interpretador.h"
+#include "transpilador_c.h"
+#include "entrada_saida.h"
+#include "camadas.h"
 
 extern int yylex();
 extern int line_num;
@@ -11,9 +24,6 @@ extern FILE* yyin;
 extern char* yytext;
 void yyerror(const char *s);
 
-// Declaração da função do analisador semântico
-void execute_semantic_analysis(TreeNode *root);
-
 
 %}
 
@@ -92,7 +102,7 @@ var_declaration
         {
             char num_str[32];
             sprintf(num_str, "%d", $4);
-            $$ = new_node("Fun-declaracao", $2);
+            $$ = new_node("Var-declaracao", $2);
             add_child($$, $1);
             add_child($$, new_node("Size", num_str));
         }
@@ -407,15 +417,264 @@ void yyerror(const char *s) {
     fprintf(stderr, "ERRO SINTATICO: '%s' LINHA: %d\n", yytext, line_num);
 }
 
+// Opções de linha de comando
+typedef struct {
+    const char *arquivo;
+    int imprimir_ir;     // --ir: imprime a representação intermediária
+    int otimizar;        // -O: executa os passes de otimização
+    int relatorio;       // --relatorio: relatório dos passes (stderr)
+    int asm_x86;         // --asm: imprime o assembly x86-64
+    const char *saida;   // -o arquivo: gera o executável
+    int montador_externo; // --montador-externo: gera com as/ld em vez do codificador
+    int executar;        // --run: executa o programa em memória
+    const char *lote;    // --lote dir: executa em memória com cada dir/*.in, um fork por entrada
+    LimitesLote limites; // --limite-cpu=S, --limite-memoria=MB dos filhos de --lote (CPU também em --faixas)
+    int vm;              // --vm: executa na máquina virtual de bytecode
+    int bytecode;        // --bytecode: imprime o bytecode da máquina virtual
+    int perfil_vm;       // --perfil-vm: contagens de instruções da máquina virtual (stderr)
+    int sem_superinstrucoes; // --sem-superinstrucoes: só o conjunto básico do bytecode
+    int arvore;          // --arvore: executa com o interpretador de referência sobre a árvore
+    int perfil_arvore;   // --perfil-arvore: contagens de nós executados (stderr)
+    int fechamentos;     // --fechamentos: executa com o interpretador por fechamentos
+    const char *faixas;  // --faixas dir: executa cada dir/*.in, várias entradas por vetor
+    int camadas;         // --camadas: máquina virtual, com as funções quentes compiladas em fundo
+    int limite_quente;   // --limite-quente=N: chamadas + voltas de laço até compilar
+    int imprimir_c;      // --c: imprime o programa traduzido para C
+    int via_c;           // --via-c: compila pelo C com o compilador do sistema
+    int es_stdio;        // --es-stdio: input()/output() com scanf/printf nos executores em processo
+    int cache;           // --cache: código de máquina por função em cache no disco
+    int verificar_indices; // --verificar-indices: erro de execução em acesso fora do array (IR e x86)
+    AlocadorX86 alocador; // --alocador=pilha|linear|grafo
+    OpcoesOtimizacao otimizacao;
+} Opcoes;
+
+// --inline-<parametro>=N ajusta o modelo de custo do inline
+static int ler_parametro_inline(const char *arg, CustoInline *c) {
+    static const struct { const char *nome; size_t campo; } parametros[] = {
+        { "--inline-limite=",    offsetof(CustoInline, limite) },
+        { "--inline-folha=",     offsetof(CustoInline, limite_folha) },
+        { "--inline-chamada=",   offsetof(CustoInline, bonus_chamada) },
+        { "--inline-constante=", offsetof(CustoInline, bonus_constante) },
+        { "--inline-array=",     offsetof(CustoInline, bonus_array) },
+        { "--inline-maximo=",    offsetof(CustoInline, tamanho_maximo) },
+    };
+    for (size_t p = 0; p < sizeof(parametros) / sizeof(parametros[0]); p++) {
+        size_t n = strlen(parametros[p].nome);
+        if (strncmp(arg, parametros[p].nome, n) == 0) {
+            *(int*)((char*)c + parametros[p].campo) = atoi(arg + n);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int ler_opcoes(int argc, char **argv, Opcoes *op) {
+    memset(op, 0, sizeof(Opcoes));
+    opcoes_otimizacao_padrao(&op->otimizacao);
+    op->alocador = ALOCADOR_LINEAR;
+    op->limites.cpu_segundos = 5;
+    op->limites.memoria_mb = 512;
+    op->limite_quente = 1000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ir") == 0) op->imprimir_ir = 1;
+        else if (strcmp(argv[i], "-O") == 0) op->otimizar = 1;
+        else if (strcmp(argv[i], "--relatorio") == 0) op->relatorio = 1;
+        else if (strcmp(argv[i], "--asm") == 0) op->asm_x86 = 1;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) op->saida = argv[++i];
+        else if (strcmp(argv[i], "--montador-externo") == 0) op->montador_externo = 1;
+        else if (strcmp(argv[i], "--run") == 0) op->executar = 1;
+        else if (strcmp(argv[i], "--lote") == 0 && i + 1 < argc) op->lote = argv[++i];
+        else if (strncmp(argv[i], "--limite-cpu=", 13) == 0) op->limites.cpu_segundos = atoi(argv[i] + 13);
+        else if (strncmp(argv[i], "--limite-memoria=", 17) == 0) op->limites.memoria_mb = atoi(argv[i] + 17);
+        else if (strcmp(argv[i], "--vm") == 0) op->vm = 1;
+        else if (strcmp(argv[i], "--bytecode") == 0) op->bytecode = 1;
+        else if (strcmp(argv[i], "--perfil-vm") == 0) op->vm = op->perfil_vm = 1;
+        else if (strcmp(argv[i], "--sem-superinstrucoes") == 0) op->sem_superinstrucoes = 1;
+        else if (strcmp(argv[i], "--arvore") == 0) op->arvore = 1;
+        else if (strcmp(argv[i], "--perfil-arvore") == 0) op->arvore = op->perfil_arvore = 1;
+        else if (strcmp(argv[i], "--fechamentos") == 0) op->fechamentos = 1;
+        else if (strcmp(argv[i], "--faixas") == 0 && i + 1 < argc) op->faixas = argv[++i];
+        else if (strcmp(argv[i], "--camadas") == 0) op->camadas = 1;
+        else if (strncmp(argv[i], "--limite-quente=", 16) == 0) op->limite_quente = atoi(argv[i] + 16);
+        else if (strcmp(argv[i], "--c") == 0) op->imprimir_c = 1;
+        else if (strcmp(argv[i], "--via-c") == 0) op->via_c = 1;
+        else if (strcmp(argv[i], "--es-stdio") == 0) op->es_stdio = 1;
+        else if (strcmp(argv[i], "--cache") == 0) op->cache = 1;
+        else if (strcmp(argv[i], "--verificar-indices") == 0) op->verificar_indices = 1;
+        else if (strcmp(argv[i], "--alocador=pilha") == 0) op->alocador = ALOCADOR_PILHA;
+        else if (strcmp(argv[i], "--alocador=linear") == 0) op->alocador = ALOCADOR_LINEAR;
+        else if (strcmp(argv[i], "--alocador=grafo") == 0) op->alocador = ALOCADOR_GRAFO;
+        else if (strcmp(argv[i], "--sem-inline") == 0) op->otimizacao.inline_ativo = 0;
+        else if (strcmp(argv[i], "--sem-faixas") == 0) op->otimizacao.faixas_ativo = 0;
+        else if (ler_parametro_inline(argv[i], &op->otimizacao.custo_inline)) continue;
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Opcao desconhecida: %s\n", argv[i]);
+            return 0;
+        }
+        else op->arquivo = argv[i];
+    }
+    return 1;
+}
+
+// Codifica o programa e escreve o ELF direto, sem processos externos
+static int gerar_executavel(IrModulo *mod, OpcoesX86 *x86, const char *saida) {
+    CodigoX86 codigo;
+    x86_codigo_iniciar(&codigo);
+    x86_codificar_modulo(mod, x86, &codigo);
+    x86_codificar_runtime(&codigo);
+    int status = x86_escrever_elf(&codigo, saida);
+    x86_codigo_liberar(&codigo);
+    return status;
+}
+
+// Roda uma ferramenta do sistema com os argumentos como estão, sem shell
+static int executar_ferramenta(char *const argv[]) {
+    // o filho herda os buffers: nada pendente antes do fork
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        execvp(argv[0], argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return 1;
+    }
+    return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+// Monta e liga o assembly com as ferramentas do sistema (as e ld)
+static int montar_executavel(IrModulo *mod, OpcoesX86 *x86, const char *saida) {
+    size_t n = strlen(saida) + 3;
+    char *fonte = (char*)malloc(n);
+    char *objeto = (char*)malloc(n);
+    snprintf(fonte, n, "%s.s", saida);
+    snprintf(objeto, n, "%s.o", saida);
+
+    int status = 1;
+    FILE *arq = fopen(fonte, "w");
+    if (!arq) {
+        perror(fonte);
+    } else {
+        x86_emitir_modulo(mod, x86, arq);
+        fclose(arq);
+        char *as[] = { "as", "-o", objeto, fonte, NULL };
+        char *ld[] = { "ld", "-o", (char*)saida, objeto, NULL };
+        status = executar_ferramenta(as) || executar_ferramenta(ld);
+        remove(fonte);
+        remove(objeto);
+        if (status) fprintf(stderr, "Falha ao montar/ligar %s\n", saida);
+    }
+
+    free(fonte);
+    free(objeto);
+    return status;
+}
+
+// Compila a árvore para bytecode e executa na máquina virtual, sem IR
+static int interpretar(TreeNode *root, Opcoes *op) {
+    BcPrograma *prog = bc_compilar(root, !op->sem_superinstrucoes);
+    int status = 1;
+    if (prog->erros == 0) {
+        if (op->bytecode) bc_imprimir(prog, stdout);
+        status = op->vm ? vm_executar(prog, op->perfil_vm ? stderr : NULL) : 0;
+    }
+    bc_liberar(prog);
+    return status;
+}
+
+// Gera a IR e executa as etapas pedidas nas opções
+static int compilar(TreeNode *root, Opcoes *op) {
+    start_semantic_analysis(root);
+    if (semantic_error_count > 0) return 1;
+    if (op->es_stdio) es_usar_stdio(1);
+    // só a IR e o x86 geram as verificações; a árvore sempre verifica
+    if (op->verificar_indices && (op->fechamentos || op->faixas || op->camadas || op->vm ||
+                                  op->bytecode || op->imprimir_c || op->via_c)) {
+        fprintf(stderr, "--verificar-indices nao vale com --fechamentos, --faixas, --camadas, "
+                        "--vm, --bytecode, --c ou --via-c\n");
+        return 1;
+    }
+    if (op->arvore) return arvore_executar(root, op->perfil_arvore ? stderr : NULL);
+    if (op->fechamentos) return fechamentos_executar(root);
+    if (op->faixas) return faixas_executar_lote(root, op->faixas, op->limites.cpu_segundos);
+    if (op->camadas) {
+        OpcoesX86 x86 = { .alocador = op->alocador };
+        return camadas_executar(root, &op->otimizacao, &x86, (unsigned)op->limite_quente,
+                                op->relatorio ? stderr : NULL);
+    }
+    if (op->vm || op->bytecode) return interpretar(root, op);
+    if (op->imprimir_c) return c_emitir_programa(root, stdout) > 0;
+    if (op->via_c) {
+        FILE *relatorio = op->relatorio ? stderr : NULL;
+        return op->saida ? c_gerar_executavel(root, op->saida, relatorio) : c_executar(root, relatorio);
+    }
+
+    IrModulo *mod = ir_gerar(root, op->verificar_indices);
+    if (mod->erros > 0) return 1;
+
+    // o cache só guarda código codificado: não vale para --ir, --asm e as/ld
+    FILE *relatorio = op->relatorio ? stderr : NULL;
+    GrafoChamadas *grafo = op->otimizar ? grafo_chamadas_construir(root) : NULL;
+    CacheX86 *cache = NULL;
+    if (op->cache && !op->imprimir_ir && !op->asm_x86 &&
+        (op->executar || op->lote || (op->saida && !op->montador_externo))) {
+        cache = cache_x86_abrir(root, grafo, op->otimizar ? &op->otimizacao : NULL, op->alocador,
+                                op->verificar_indices, relatorio);
+    }
+
+    if (op->otimizar) {
+        if (cache) cache_x86_otimizar(cache, mod, grafo, &op->otimizacao, relatorio);
+        else otimizar_modulo(mod, grafo, &op->otimizacao, relatorio);
+    }
+    if (op->imprimir_ir) {
+        ir_imprimir_modulo(mod, stdout);
+    }
+    // o backend tira as funções do SSA: vem depois de tudo o que usa a IR
+    OpcoesX86 x86 = { .alocador = op->alocador, .relatorio = relatorio, .cache = cache };
+    int status = 0;
+    if (op->asm_x86) {
+        x86_emitir_modulo(mod, &x86, stdout);
+    } else if (op->executar) {
+        status = x86_executar(mod, &x86);
+    } else if (op->lote) {
+        status = x86_executar_lote(mod, &x86, op->lote, &op->limites);
+    } else if (op->saida && op->montador_externo) {
+        status = montar_executavel(mod, &x86, op->saida);
+    } else if (op->saida) {
+        status = gerar_executavel(mod, &x86, op->saida);
+    }
+    if (cache) cache_x86_fechar(cache);
+    return status;
+}
+
 int main(int argc, char **argv) {
-    if (argc > 1) {
-        if (!(yyin = fopen(argv[1], "r"))) {
-            perror(argv[1]);
+    Opcoes op;
+    if (!ler_opcoes(argc, argv, &op)) {
+        return 1;
+    }
+    if (op.arquivo) {
+        if (!(yyin = fopen(op.arquivo, "r"))) {
+            perror(op.arquivo);
             return 1;
         }
     }
     
     int result = yyparse();
+
+    // Sem opções de geração de código mantém a saída original
+    if (op.imprimir_ir || op.otimizar || op.asm_x86 || op.saida || op.executar || op.lote ||
+        op.vm || op.bytecode || op.arvore || op.fechamentos || op.faixas || op.camadas || op.imprimir_c || op.via_c) {
+        if (result != 0 || root == NULL) return 1;
+        return compilar(root, &op);
+    }
     
     if (result == 0 && root != NULL) {
         // Chama o analisador semântico após o parsing bem-sucedido
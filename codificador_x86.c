@@ -0,0 +1,554 @@
+/***********************************************/
+/* Codificador de instruções x86-64            */
+/* Traduz as instruções de máquina já alocadas */
+/* para bytes, com símbolos e referências      */
+/* rel32 resolvidas em x86_codigo_ligar()      */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "x86.h"
+#include "cache.h"
+
+void x86_codigo_iniciar(CodigoX86 *c) {
+    memset(c, 0, sizeof(CodigoX86));
+}
+
+void x86_codigo_liberar(CodigoX86 *c) {
+    free(c->texto);
+    free(c->simbolos);
+    free(c->relocs);
+    memset(c, 0, sizeof(CodigoX86));
+}
+
+static void byte(CodigoX86 *c, int b) {
+    if (c->tam_texto == c->cap_texto) {
+        c->cap_texto = c->cap_texto ? c->cap_texto * 2 : 4096;
+        c->texto = (unsigned char*)realloc(c->texto, c->cap_texto);
+    }
+    c->texto[c->tam_texto++] = (unsigned char)b;
+}
+
+static void dword(CodigoX86 *c, long long v) {
+    for (int k = 0; k < 4; k++) byte(c, (int)((v >> (8 * k)) & 0xff));
+}
+
+static void qword(CodigoX86 *c, long long v) {
+    for (int k = 0; k < 8; k++) byte(c, (int)((v >> (8 * k)) & 0xff));
+}
+
+static void escrever_dword(CodigoX86 *c, int pos, long long v) {
+    for (int k = 0; k < 4; k++) c->texto[pos + k] = (unsigned char)((v >> (8 * k)) & 0xff);
+}
+
+SimboloX86* x86_codigo_simbolo(CodigoX86 *c, const char *nome) {
+    for (int s = 0; s < c->num_simbolos; s++) {
+        if (strcmp(c->simbolos[s].nome, nome) == 0) return &c->simbolos[s];
+    }
+    return NULL;
+}
+
+void x86_codigo_definir(CodigoX86 *c, const char *nome, SecaoX86 secao, long long valor) {
+    if (x86_codigo_simbolo(c, nome)) {
+        fprintf(stderr, "ERRO INTERNO: simbolo %s definido duas vezes\n", nome);
+        exit(1);
+    }
+    if (c->num_simbolos == c->cap_simbolos) {
+        c->cap_simbolos = c->cap_simbolos ? c->cap_simbolos * 2 : 32;
+        c->simbolos = (SimboloX86*)realloc(c->simbolos, sizeof(SimboloX86) * c->cap_simbolos);
+    }
+    SimboloX86 *s = &c->simbolos[c->num_simbolos++];
+    s->nome = nome;
+    s->secao = secao;
+    s->valor = valor;
+}
+
+void x86_codigo_bss(CodigoX86 *c, const char *nome, long long bytes) {
+    c->tam_bss = (c->tam_bss + 7) & ~7LL;
+    x86_codigo_definir(c, nome, SECAO_BSS, c->tam_bss);
+    c->tam_bss += bytes;
+}
+
+/* Campo rel32 em 'pos' para 'simbolo + desloc'; o rip é o fim da instrução */
+static void reloc(CodigoX86 *c, int pos, const char *simbolo, long long desloc) {
+    if (c->num_relocs == c->cap_relocs) {
+        c->cap_relocs = c->cap_relocs ? c->cap_relocs * 2 : 64;
+        c->relocs = (RelocX86*)realloc(c->relocs, sizeof(RelocX86) * c->cap_relocs);
+    }
+    RelocX86 *r = &c->relocs[c->num_relocs++];
+    r->pos = pos;
+    r->fim = -1;
+    r->simbolo = simbolo;
+    r->desloc = desloc;
+}
+
+/*
+ * Referências ainda sem o fim da instrução (um imediato pode vir depois do
+ * deslocamento) são completadas quando a instrução termina.
+ */
+static void fechar_relocs(CodigoX86 *c, int primeira) {
+    for (int r = primeira; r < c->num_relocs; r++) {
+        if (c->relocs[r].fim < 0) c->relocs[r].fim = c->tam_texto;
+    }
+}
+
+static int cabe8(long long v) {
+    return v >= -128 && v <= 127;
+}
+
+static int cabe32(long long v) {
+    return v >= -2147483648LL && v <= 2147483647LL;
+}
+
+static void fisico(MFuncao *mf, int reg) {
+    if (reg < 0 || reg >= X86_NUM_REGS) {
+        fprintf(stderr, "ERRO INTERNO: registrador virtual %d sem alocacao em %s\n", reg, mf->nome);
+        exit(1);
+    }
+}
+
+/*
+ * Prefixo REX. 'campo' vai no campo reg do ModRM (ou é -1), 'rm' é o
+ * registrador do r/m ou o operando de memória. Com operandos de 8 bits,
+ * spl/bpl/sil/dil só existem com REX.
+ */
+static void rex(CodigoX86 *c, int tam, int campo, MOperando *rm, int byte_campo) {
+    int r = 0x40;
+    if (tam == 8) r |= 0x08;
+    if (campo >= 8) r |= 0x04;
+    if (rm && rm->tipo == OPR_MEM) {
+        if (rm->indice >= 8) r |= 0x02;
+        if (rm->reg >= 8) r |= 0x01;
+    } else if (rm && rm->tipo == OPR_REG && rm->reg >= 8) {
+        r |= 0x01;
+    }
+    int forcar = 0;
+    if (tam == 1) {
+        if (byte_campo && campo >= 4 && campo < 8) forcar = 1;
+        if (rm && rm->tipo == OPR_REG && rm->reg >= 4 && rm->reg < 8) forcar = 1;
+    }
+    if (r != 0x40 || forcar) byte(c, r);
+}
+
+/* ModRM (+ SIB + deslocamento) com 'campo' no campo reg */
+static void modrm(CodigoX86 *c, MFuncao *mf, int campo, MOperando *rm) {
+    campo &= 7;
+    if (rm->tipo == OPR_REG) {
+        fisico(mf, rm->reg);
+        byte(c, 0xc0 | (campo << 3) | (rm->reg & 7));
+        return;
+    }
+
+    if (rm->reg < 0) {
+        // relativo ao rip
+        byte(c, (campo << 3) | 5);
+        reloc(c, c->tam_texto, rm->simbolo, rm->imm);
+        dword(c, 0);
+        return;
+    }
+
+    fisico(mf, rm->reg);
+    int base = rm->reg & 7;
+    int mod;
+    if (rm->imm == 0 && base != 5) mod = 0;     // rbp/r13 sempre com deslocamento
+    else if (cabe8(rm->imm)) mod = 1;
+    else mod = 2;
+
+    if (rm->indice >= 0 || base == 4) {
+        // SIB: obrigatório com índice e com base rsp/r12
+        int indice = 4, escala = 0;
+        if (rm->indice >= 0) {
+            fisico(mf, rm->indice);
+            indice = rm->indice & 7;
+            escala = rm->escala == 8 ? 3 : rm->escala == 4 ? 2 : rm->escala == 2 ? 1 : 0;
+        }
+        byte(c, (mod << 6) | (campo << 3) | 4);
+        byte(c, (escala << 6) | (indice << 3) | base);
+    } else {
+        byte(c, (mod << 6) | (campo << 3) | base);
+    }
+    if (mod == 1) byte(c, (int)(rm->imm & 0xff));
+    else if (mod == 2) dword(c, rm->imm);
+}
+
+/* Instrução "opcode /r" com um ou dois bytes de opcode */
+static void op_rm(CodigoX86 *c, MFuncao *mf, int tam, int opcode, int campo, MOperando *rm,
+                  int byte_campo) {
+    rex(c, tam, campo, rm, byte_campo);
+    if (opcode > 0xff) byte(c, opcode >> 8);
+    byte(c, opcode & 0xff);
+    modrm(c, mf, campo, rm);
+}
+
+/* add/sub/and/xor/cmp: mesma família de opcodes, extensão em /n para imediatos */
+static void aritmetica(CodigoX86 *c, MFuncao *mf, MInstr *m, int base, int extensao) {
+    MOperando *d = &m->ops[0], *o = &m->ops[1];
+    if (o->tipo == OPR_IMM) {
+        if (cabe8(o->imm)) {
+            op_rm(c, mf, m->tam, 0x83, extensao, d, 0);
+            byte(c, (int)(o->imm & 0xff));
+        } else {
+            op_rm(c, mf, m->tam, 0x81, extensao, d, 0);
+            dword(c, o->imm);
+        }
+    } else if (o->tipo == OPR_REG) {
+        fisico(mf, o->reg);
+        op_rm(c, mf, m->tam, base + 1, o->reg, d, 0);
+    } else {
+        fisico(mf, d->reg);
+        op_rm(c, mf, m->tam, base + 3, d->reg, o, 0);
+    }
+}
+
+static void mov(CodigoX86 *c, MFuncao *mf, MInstr *m) {
+    MOperando *d = &m->ops[0], *o = &m->ops[1];
+    if (o->tipo == OPR_IMM) {
+        if (d->tipo == OPR_REG && (m->tam == 4 || !cabe32(o->imm))) {
+            // mov $imm, r32 (zera a parte alta) ou movabs $imm64, r64
+            fisico(mf, d->reg);
+            rex(c, m->tam == 4 ? 4 : 8, -1, d, 0);
+            byte(c, 0xb8 + (d->reg & 7));
+            if (m->tam == 4) dword(c, o->imm);
+            else qword(c, o->imm);
+        } else if (m->tam == 1) {
+            op_rm(c, mf, 1, 0xc6, 0, d, 0);
+            byte(c, (int)(o->imm & 0xff));
+        } else {
+            op_rm(c, mf, m->tam, 0xc7, 0, d, 0);
+            dword(c, o->imm);
+        }
+    } else if (o->tipo == OPR_REG) {
+        fisico(mf, o->reg);
+        op_rm(c, mf, m->tam, m->tam == 1 ? 0x88 : 0x89, o->reg, d, 1);
+    } else {
+        fisico(mf, d->reg);
+        op_rm(c, mf, m->tam, m->tam == 1 ? 0x8a : 0x8b, d->reg, o, 1);
+    }
+}
+
+/* Desvios para blocos e endereços de tabelas pendentes até o fim da função */
+typedef struct {
+    int pos;
+    MBloco *alvo;
+    MTabela *tabela;
+} Pendente;
+
+typedef struct {
+    int *inicio;                /* deslocamento de cada bloco (por id), -1 */
+    int *tabelas;               /* deslocamento de cada tabela (por id) */
+    Pendente *pendentes;
+    int num_pendentes;
+    int cap_pendentes;
+} Rotulos;
+
+/* Campo rel32 em 'pos', resolvido no fim da função */
+static void pendente(Rotulos *rot, int pos, MBloco *alvo, MTabela *tabela) {
+    if (rot->num_pendentes == rot->cap_pendentes) {
+        rot->cap_pendentes = rot->cap_pendentes ? rot->cap_pendentes * 2 : 32;
+        rot->pendentes = (Pendente*)realloc(rot->pendentes, sizeof(Pendente) * rot->cap_pendentes);
+    }
+    rot->pendentes[rot->num_pendentes].pos = pos;
+    rot->pendentes[rot->num_pendentes].alvo = alvo;
+    rot->pendentes[rot->num_pendentes].tabela = tabela;
+    rot->num_pendentes++;
+}
+
+/*
+ * jmp/jcc para um bloco: para trás a distância já é conhecida e cabe
+ * muitas vezes em 8 bits; para frente usa sempre rel32.
+ */
+static void desvio(CodigoX86 *c, Rotulos *rot, MInstr *m) {
+    MBloco *alvo = m->ops[0].bloco;
+    int destino = rot->inicio[alvo->id];
+    if (destino >= 0 && cabe8(destino - (c->tam_texto + 2))) {
+        byte(c, m->op == M_JMP ? 0xeb : 0x70 + m->cond);
+        byte(c, destino - (c->tam_texto + 1));
+        return;
+    }
+    if (m->op == M_JMP) {
+        byte(c, 0xe9);
+    } else {
+        byte(c, 0x0f);
+        byte(c, 0x80 + m->cond);
+    }
+    if (destino >= 0) {
+        dword(c, destino - (c->tam_texto + 4));
+        return;
+    }
+    pendente(rot, c->tam_texto, alvo, NULL);
+    dword(c, 0);
+}
+
+static void codificar_instr(CodigoX86 *c, MFuncao *mf, Rotulos *rot, MInstr *m, MBloco *seguinte) {
+    MOperando *d = &m->ops[0], *o = &m->ops[1];
+    switch (m->op) {
+        case M_MOV:   mov(c, mf, m); break;
+        case M_ADD:   aritmetica(c, mf, m, 0x00, 0); break;
+        case M_SUB:   aritmetica(c, mf, m, 0x28, 5); break;
+        case M_XOR:   aritmetica(c, mf, m, 0x30, 6); break;
+        case M_AND:   aritmetica(c, mf, m, 0x20, 4); break;
+        case M_CMP:   aritmetica(c, mf, m, 0x38, 7); break;
+
+        case M_MOVSX:
+            fisico(mf, d->reg);
+            op_rm(c, mf, 8, 0x63, d->reg, o, 0);
+            break;
+
+        case M_MOVZX8:
+            fisico(mf, d->reg);
+            op_rm(c, mf, 1, 0x0fb6, d->reg, o, 0);
+            break;
+
+        case M_LEA:
+            fisico(mf, d->reg);
+            if (o->tipo == OPR_TABELA) {
+                // a tabela vem depois do código da função: rel32 pendente
+                rex(c, m->tam, d->reg, NULL, 0);
+                byte(c, 0x8d);
+                byte(c, ((d->reg & 7) << 3) | 5);
+                pendente(rot, c->tam_texto, NULL, o->tabela);
+                dword(c, 0);
+                break;
+            }
+            op_rm(c, mf, m->tam, 0x8d, d->reg, o, 0);
+            break;
+
+        case M_IMUL:
+            fisico(mf, d->reg);
+            if (o->tipo == OPR_IMM) {
+                // forma de três operandos com destino = origem
+                int curto = cabe8(o->imm);
+                op_rm(c, mf, m->tam, curto ? 0x6b : 0x69, d->reg, d, 0);
+                if (curto) byte(c, (int)(o->imm & 0xff));
+                else dword(c, o->imm);
+            } else {
+                op_rm(c, mf, m->tam, 0x0faf, d->reg, o, 0);
+            }
+            break;
+
+        case M_CDQ:
+            byte(c, 0x99);
+            break;
+
+        case M_SHL:
+        case M_SAR:
+        case M_SHR:
+            // c1 /n ib, ou d1 /n para deslocar de 1 (como o as)
+            op_rm(c, mf, m->tam, o->imm == 1 ? 0xd1 : 0xc1,
+                  m->op == M_SHL ? 4 : m->op == M_SAR ? 7 : 5, d, 0);
+            if (o->imm != 1) byte(c, (int)(o->imm & 0xff));
+            break;
+
+        case M_IDIV: op_rm(c, mf, m->tam, 0xf7, 7, d, 0); break;
+        case M_DIV:  op_rm(c, mf, m->tam, 0xf7, 6, d, 0); break;
+        case M_NEG:  op_rm(c, mf, m->tam, 0xf7, 3, d, 0); break;
+
+        case M_SETCC:
+            op_rm(c, mf, 1, 0x0f90 + m->cond, 0, d, 0);
+            break;
+
+        case M_CMOV:
+            fisico(mf, d->reg);
+            op_rm(c, mf, m->tam, 0x0f40 + m->cond, d->reg, o, 0);
+            break;
+
+        case M_PUSH:
+        case M_POP:
+            if (m->op == M_PUSH && d->tipo == OPR_IMM) {
+                byte(c, cabe8(d->imm) ? 0x6a : 0x68);
+                if (cabe8(d->imm)) byte(c, (int)(d->imm & 0xff));
+                else dword(c, d->imm);
+                break;
+            }
+            if (d->tipo == OPR_MEM) {
+                // pushq/popq de memória: tamanho padrão de 64 bits, sem REX.W
+                op_rm(c, mf, 4, m->op == M_PUSH ? 0xff : 0x8f, m->op == M_PUSH ? 6 : 0, d, 0);
+                break;
+            }
+            fisico(mf, d->reg);
+            if (d->reg >= 8) byte(c, 0x41);
+            byte(c, (m->op == M_PUSH ? 0x50 : 0x58) + (d->reg & 7));
+            break;
+
+        case M_JMP:
+            if (d->tipo == OPR_SIMBOLO) {
+                byte(c, 0xe9);
+                reloc(c, c->tam_texto, d->simbolo, 0);
+                dword(c, 0);
+                break;
+            }
+            if (d->tipo == OPR_REG) {
+                // jmp *r: ff /4, 64 bits sem REX.W
+                op_rm(c, mf, 4, 0xff, 4, d, 0);
+                break;
+            }
+            // desvio para o bloco seguinte vira queda
+            if (d->bloco == seguinte) break;
+            desvio(c, rot, m);
+            break;
+
+        case M_JCC:
+            desvio(c, rot, m);
+            break;
+
+        case M_CALL:
+            byte(c, 0xe8);
+            reloc(c, c->tam_texto, d->simbolo, 0);
+            dword(c, 0);
+            break;
+
+        case M_LEAVE:
+            byte(c, 0xc9);
+            break;
+
+        case M_RET:
+            byte(c, 0xc3);
+            break;
+
+        case M_REP_STOSQ:
+            byte(c, 0xf3);
+            byte(c, 0x48);
+            byte(c, 0xab);
+            break;
+
+        case M_SYSCALL:
+            byte(c, 0x0f);
+            byte(c, 0x05);
+            break;
+
+        case M_RETORNO:
+        case M_CAUDA:
+        case M_ZERAR:
+            fprintf(stderr, "ERRO INTERNO: pseudo-instrucao nao expandida em %s\n", mf->nome);
+            exit(1);
+    }
+}
+
+void x86_codificar_funcao(CodigoX86 *c, MFuncao *mf) {
+    // funções alinhadas em 16 bytes; o preenchimento nunca é executado
+    while (c->tam_texto % 16) byte(c, 0xcc);
+    x86_codigo_definir(c, mf->nome, SECAO_TEXTO, c->tam_texto);
+
+    int maior_id = 0;
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        if (b->id > maior_id) maior_id = b->id;
+    }
+    Rotulos rot;
+    memset(&rot, 0, sizeof(rot));
+    rot.inicio = (int*)malloc(sizeof(int) * (maior_id + 1));
+    for (int k = 0; k <= maior_id; k++) rot.inicio[k] = -1;
+
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        rot.inicio[b->id] = c->tam_texto;
+        for (MInstr *m = b->primeiro; m; m = m->prox) {
+            int primeira = c->num_relocs;
+            codificar_instr(c, mf, &rot, m, b->prox);
+            fechar_relocs(c, primeira);
+        }
+    }
+
+    rot.tabelas = (int*)malloc(sizeof(int) * (mf->num_tabelas + 1));
+    for (MTabela *t = mf->tabelas; t; t = t->prox) {
+        rot.tabelas[t->id] = c->tam_texto;
+        for (int k = 0; k < t->num_alvos; k++) dword(c, rot.inicio[t->alvos[k]->id] - rot.tabelas[t->id]);
+    }
+
+    for (int p = 0; p < rot.num_pendentes; p++) {
+        Pendente *pend = &rot.pendentes[p];
+        int destino = pend->tabela ? rot.tabelas[pend->tabela->id] : rot.inicio[pend->alvo->id];
+        escrever_dword(c, pend->pos, destino - (pend->pos + 4));
+    }
+    free(rot.pendentes);
+    free(rot.tabelas);
+    free(rot.inicio);
+}
+
+/*
+ * Função 'nome' que só salta para um endereço absoluto fora do código
+ * (rotinas do próprio compilador na execução em memória). r11 é livre
+ * em qualquer chamada.
+ */
+void x86_codigo_externo(CodigoX86 *c, const char *nome, void *endereco) {
+    while (c->tam_texto % 16) byte(c, 0xcc);
+    x86_codigo_definir(c, nome, SECAO_TEXTO, c->tam_texto);
+    byte(c, 0x49);              // movabs $endereco, %r11
+    byte(c, 0xbb);
+    qword(c, (long long)(unsigned long long)endereco);
+    byte(c, 0x41);              // jmp *%r11
+    byte(c, 0xff);
+    byte(c, 0xe3);
+}
+
+/*
+ * Código de outra unidade (uma função lida do cache) no fim de 'c': o
+ * texto alinhado como em x86_codificar_funcao, os símbolos do texto e as
+ * referências deslocados. 'outro' não pode ter .bss próprio.
+ */
+void x86_codigo_anexar(CodigoX86 *c, CodigoX86 *outro) {
+    while (c->tam_texto % 16) byte(c, 0xcc);
+    int base = c->tam_texto;
+    for (int k = 0; k < outro->tam_texto; k++) byte(c, outro->texto[k]);
+    for (int s = 0; s < outro->num_simbolos; s++) {
+        SimboloX86 *sim = &outro->simbolos[s];
+        x86_codigo_definir(c, sim->nome, sim->secao, (sim->secao == SECAO_TEXTO ? base : 0) + sim->valor);
+    }
+    for (int r = 0; r < outro->num_relocs; r++) {
+        RelocX86 *rel = &outro->relocs[r];
+        reloc(c, base + rel->pos, rel->simbolo, rel->desloc);
+        c->relocs[c->num_relocs - 1].fim = base + rel->fim;
+    }
+}
+
+/* Cada função sozinha, para o cache: o mesmo código que no módulo */
+static void codificar_com_cache(IrModulo *mod, IrFuncao *f, OpcoesX86 *op, CodigoX86 *c) {
+    CodigoX86 *salvo = cache_x86_buscar(op->cache, f->nome);
+    if (salvo) {
+        x86_codigo_anexar(c, salvo);
+        return;
+    }
+    CodigoX86 sozinha;
+    x86_codigo_iniciar(&sozinha);
+    x86_codificar_funcao(&sozinha, x86_gerar_funcao(mod, f, op));
+    cache_x86_gravar(op->cache, f->nome, &sozinha);
+    x86_codigo_anexar(c, &sozinha);
+    x86_codigo_liberar(&sozinha);
+}
+
+/* Funções e globais do programa (o runtime vem à parte) */
+void x86_codificar_modulo(IrModulo *mod, OpcoesX86 *op, CodigoX86 *c) {
+    for (IrFuncao *f = mod->funcoes; f; f = f->prox) {
+        if (op->cache) codificar_com_cache(mod, f, op, c);
+        else x86_codificar_funcao(c, x86_gerar_funcao(mod, f, op));
+    }
+    for (IrGlobal *g = mod->globais; g; g = g->prox) {
+        char *nome = (char*)malloc(strlen(g->nome) + 4);
+        sprintf(nome, "cm_%s", g->nome);
+        x86_codigo_bss(c, nome, 4 * (g->tamanho > 0 ? g->tamanho : 1));
+    }
+}
+
+/*
+ * Resolve as referências rel32 com o texto carregado em 'base_texto' e o
+ * .bss em 'base_bss'. Retorna 0 se algum símbolo não existe ou está longe
+ * demais.
+ */
+int x86_codigo_ligar(CodigoX86 *c, unsigned long long base_texto, unsigned long long base_bss) {
+    for (int r = 0; r < c->num_relocs; r++) {
+        RelocX86 *rel = &c->relocs[r];
+        SimboloX86 *s = x86_codigo_simbolo(c, rel->simbolo);
+        if (!s) {
+            fprintf(stderr, "ERRO: simbolo indefinido: %s\n", rel->simbolo);
+            return 0;
+        }
+        unsigned long long alvo = (s->secao == SECAO_TEXTO ? base_texto : base_bss) + s->valor;
+        long long dist = (long long)(alvo + rel->desloc - (base_texto + rel->fim));
+        if (!cabe32(dist)) {
+            fprintf(stderr, "ERRO: referencia a %s fora do alcance de 32 bits\n", rel->simbolo);
+            return 0;
+        }
+        escrever_dword(c, rel->pos, dist);
+    }
+    return 1;
+}
@@ -0,0 +1,100 @@
+/***********************************************/
+/* Escrita de executável ELF64 (x86-64 Linux)  */
+/* Executável estático com dois segmentos:     */
+/* texto (R+X) e .bss (R+W), sem montador nem  */
+/* ligador externos                            */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "x86.h"
+
+#define BASE_ELF        0x400000ULL
+#define PAGINA          0x1000ULL
+#define TAM_CABECALHO   64
+#define TAM_PROGRAMA    56
+#define NUM_SEGMENTOS   2
+
+static void le16(unsigned char *p, unsigned v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void le32(unsigned char *p, unsigned long long v) {
+    for (int k = 0; k < 4; k++) p[k] = (v >> (8 * k)) & 0xff;
+}
+
+static void le64(unsigned char *p, unsigned long long v) {
+    for (int k = 0; k < 8; k++) p[k] = (v >> (8 * k)) & 0xff;
+}
+
+/* Cabeçalho de programa PT_LOAD */
+static void segmento(unsigned char *p, unsigned flags, unsigned long long desloc,
+                     unsigned long long endereco, unsigned long long no_arquivo,
+                     unsigned long long na_memoria) {
+    le32(p + 0, 1);                 // PT_LOAD
+    le32(p + 4, flags);
+    le64(p + 8, desloc);
+    le64(p + 16, endereco);
+    le64(p + 24, endereco);
+    le64(p + 32, no_arquivo);
+    le64(p + 40, na_memoria);
+    le64(p + 48, PAGINA);
+}
+
+/*
+ * O arquivo é [cabeçalho ELF][cabeçalhos de programa][texto], carregado
+ * inteiro em BASE_ELF; o .bss fica na página seguinte ao fim do texto e
+ * não ocupa espaço no arquivo.
+ */
+int x86_escrever_elf(CodigoX86 *c, const char *caminho) {
+    unsigned long long desloc_texto = TAM_CABECALHO + NUM_SEGMENTOS * TAM_PROGRAMA;
+    unsigned long long tam_arquivo = desloc_texto + c->tam_texto;
+    unsigned long long base_texto = BASE_ELF + desloc_texto;
+    unsigned long long base_bss = (BASE_ELF + tam_arquivo + PAGINA - 1) & ~(PAGINA - 1);
+
+    if (!x86_codigo_ligar(c, base_texto, base_bss)) return 1;
+    SimboloX86 *inicio = x86_codigo_simbolo(c, "_start");
+    if (!inicio) {
+        fprintf(stderr, "ERRO: simbolo indefinido: _start\n");
+        return 1;
+    }
+
+    unsigned char cab[TAM_CABECALHO + NUM_SEGMENTOS * TAM_PROGRAMA];
+    memset(cab, 0, sizeof(cab));
+    memcpy(cab, "\177ELF", 4);
+    cab[4] = 2;                     // ELFCLASS64
+    cab[5] = 1;                     // little-endian
+    cab[6] = 1;                     // EV_CURRENT
+    le16(cab + 16, 2);              // ET_EXEC
+    le16(cab + 18, 62);             // EM_X86_64
+    le32(cab + 20, 1);
+    le64(cab + 24, base_texto + inicio->valor);
+    le64(cab + 32, TAM_CABECALHO);  // cabeçalhos de programa
+    le64(cab + 40, 0);              // sem tabela de seções
+    le16(cab + 52, TAM_CABECALHO);
+    le16(cab + 54, TAM_PROGRAMA);
+    le16(cab + 56, NUM_SEGMENTOS);
+    le16(cab + 58, 64);
+
+    segmento(cab + TAM_CABECALHO, 5, 0, BASE_ELF, tam_arquivo, tam_arquivo);
+    segmento(cab + TAM_CABECALHO + TAM_PROGRAMA, 6, base_bss - BASE_ELF, base_bss, 0,
+             c->tam_bss > 0 ? c->tam_bss : 8);
+
+    FILE *arq = fopen(caminho, "wb");
+    if (!arq) {
+        perror(caminho);
+        return 1;
+    }
+    int ok = fwrite(cab, 1, sizeof(cab), arq) == sizeof(cab) &&
+             fwrite(c->texto, 1, c->tam_texto, arq) == (size_t)c->tam_texto;
+    if (fclose(arq) != 0) ok = 0;
+    if (!ok) {
+        perror(caminho);
+        return 1;
+    }
+    chmod(caminho, 0755);
+    return 0;
+}
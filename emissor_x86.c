@@ -0,0 +1,243 @@
+/***********************************************/
+/* Emissão de assembly x86-64 (GNU as)         */
+/* Escreve as funções em sintaxe AT&T, os      */
+/* globais em .bss e o runtime                 */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "x86.h"
+
+static const char* sufixo(int tam) {
+    if (tam == 8) return "q";
+    if (tam == 1) return "b";
+    return "l";
+}
+
+static const char* nome_condicao(MCond c) {
+    switch (c) {
+        case CC_B:  return "b";
+        case CC_AE: return "ae";
+        case CC_BE: return "be";
+        case CC_A:  return "a";
+        case CC_E:  return "e";
+        case CC_NE: return "ne";
+        case CC_L:  return "l";
+        case CC_GE: return "ge";
+        case CC_LE: return "le";
+        default:    return "g";
+    }
+}
+
+static void emitir_operando(MFuncao *mf, MOperando *o, int tam, FILE *saida) {
+    switch (o->tipo) {
+        case OPR_REG:
+            fprintf(saida, "%%%s", x86_nome_reg(o->reg, tam));
+            break;
+        case OPR_IMM:
+            fprintf(saida, "$%lld", o->imm);
+            break;
+        case OPR_MEM:
+            if (o->reg < 0) {
+                if (o->imm) fprintf(saida, "%s+%lld(%%rip)", o->simbolo, o->imm);
+                else fprintf(saida, "%s(%%rip)", o->simbolo);
+                break;
+            }
+            if (o->imm) fprintf(saida, "%lld", o->imm);
+            fprintf(saida, "(%%%s", x86_nome_reg(o->reg, 8));
+            if (o->indice >= 0) fprintf(saida, ",%%%s,%d", x86_nome_reg(o->indice, 8), o->escala);
+            fprintf(saida, ")");
+            break;
+        case OPR_BLOCO:
+            fprintf(saida, ".L%s_%d", mf->nome, o->bloco->id);
+            break;
+        case OPR_SIMBOLO:
+            fprintf(saida, "%s", o->simbolo);
+            break;
+        case OPR_TABELA:
+            fprintf(saida, ".L%s_t%d(%%rip)", mf->nome, o->tabela->id);
+            break;
+        case OPR_NENHUM:
+            break;
+    }
+}
+
+/* Instrução com origem e destino: "op origem, destino" */
+static void emitir_dois(MFuncao *mf, const char *nome, MInstr *m, FILE *saida) {
+    fprintf(saida, "\t%s%s\t", nome, sufixo(m->tam));
+    emitir_operando(mf, &m->ops[1], m->tam, saida);
+    fprintf(saida, ", ");
+    emitir_operando(mf, &m->ops[0], m->tam, saida);
+    fprintf(saida, "\n");
+}
+
+static void emitir_instr(MFuncao *mf, MInstr *m, MBloco *seguinte, FILE *saida) {
+    switch (m->op) {
+        case M_MOV:   emitir_dois(mf, "mov", m, saida); break;
+        case M_LEA:   emitir_dois(mf, "lea", m, saida); break;
+        case M_ADD:   emitir_dois(mf, "add", m, saida); break;
+        case M_SUB:   emitir_dois(mf, "sub", m, saida); break;
+        case M_IMUL:  emitir_dois(mf, "imul", m, saida); break;
+        case M_XOR:   emitir_dois(mf, "xor", m, saida); break;
+        case M_AND:   emitir_dois(mf, "and", m, saida); break;
+        case M_SHL:   emitir_dois(mf, "shl", m, saida); break;
+        case M_SAR:   emitir_dois(mf, "sar", m, saida); break;
+        case M_SHR:   emitir_dois(mf, "shr", m, saida); break;
+        case M_CMP:   emitir_dois(mf, "cmp", m, saida); break;
+
+        case M_MOVSX:
+            fprintf(saida, "\tmovslq\t");
+            emitir_operando(mf, &m->ops[1], 4, saida);
+            fprintf(saida, ", ");
+            emitir_operando(mf, &m->ops[0], 8, saida);
+            fprintf(saida, "\n");
+            break;
+
+        case M_MOVZX8:
+            fprintf(saida, "\tmovzbl\t");
+            emitir_operando(mf, &m->ops[1], 1, saida);
+            fprintf(saida, ", ");
+            emitir_operando(mf, &m->ops[0], 4, saida);
+            fprintf(saida, "\n");
+            break;
+
+        case M_SETCC:
+            fprintf(saida, "\tset%s\t", nome_condicao(m->cond));
+            emitir_operando(mf, &m->ops[0], 1, saida);
+            fprintf(saida, "\n");
+            break;
+
+        case M_CMOV:
+            fprintf(saida, "\tcmov%s\t", nome_condicao(m->cond));
+            emitir_operando(mf, &m->ops[1], m->tam, saida);
+            fprintf(saida, ", ");
+            emitir_operando(mf, &m->ops[0], m->tam, saida);
+            fprintf(saida, "\n");
+            break;
+
+        case M_CDQ:
+            fprintf(saida, "\tcltd\n");
+            break;
+
+        case M_IDIV:
+        case M_DIV:
+        case M_NEG:
+            fprintf(saida, "\t%s%s\t", m->op == M_IDIV ? "idiv" : m->op == M_DIV ? "div" : "neg",
+                    sufixo(m->tam));
+            emitir_operando(mf, &m->ops[0], m->tam, saida);
+            fprintf(saida, "\n");
+            break;
+
+        case M_PUSH:
+        case M_POP:
+            fprintf(saida, "\t%s\t", m->op == M_PUSH ? "pushq" : "popq");
+            emitir_operando(mf, &m->ops[0], 8, saida);
+            fprintf(saida, "\n");
+            break;
+
+        case M_JMP:
+            // desvio para o bloco seguinte vira queda
+            if (m->ops[0].tipo == OPR_BLOCO && m->ops[0].bloco == seguinte) break;
+            fprintf(saida, m->ops[0].tipo == OPR_REG ? "\tjmp\t*" : "\tjmp\t");
+            emitir_operando(mf, &m->ops[0], 8, saida);
+            fprintf(saida, "\n");
+            break;
+
+        case M_JCC:
+            fprintf(saida, "\tj%s\t", nome_condicao(m->cond));
+            emitir_operando(mf, &m->ops[0], 8, saida);
+            fprintf(saida, "\n");
+            break;
+
+        case M_CALL:
+            fprintf(saida, "\tcall\t");
+            emitir_operando(mf, &m->ops[0], 8, saida);
+            fprintf(saida, "\n");
+            break;
+
+        case M_LEAVE:
+            fprintf(saida, "\tleave\n");
+            break;
+
+        case M_RET:
+            fprintf(saida, "\tret\n");
+            break;
+
+        case M_REP_STOSQ:
+            fprintf(saida, "\trep stosq\n");
+            break;
+
+        case M_SYSCALL:
+            fprintf(saida, "\tsyscall\n");
+            break;
+
+        case M_RETORNO:
+        case M_CAUDA:
+        case M_ZERAR:
+            fprintf(stderr, "ERRO INTERNO: pseudo-instrucao nao expandida em %s\n", mf->nome);
+            exit(1);
+    }
+}
+
+void x86_emitir_funcao(MFuncao *mf, FILE *saida) {
+    fprintf(saida, "\n\t.p2align 4\n");
+    fprintf(saida, "%s:\n", mf->nome);
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        fprintf(saida, ".L%s_%d:\n", mf->nome, b->id);
+        for (MInstr *m = b->primeiro; m; m = m->prox) emitir_instr(mf, m, b->prox, saida);
+    }
+    for (MTabela *t = mf->tabelas; t; t = t->prox) {
+        fprintf(saida, ".L%s_t%d:\n", mf->nome, t->id);
+        for (int k = 0; k < t->num_alvos; k++) {
+            fprintf(saida, "\t.long\t.L%s_%d-.L%s_t%d\n", mf->nome, t->alvos[k]->id, mf->nome, t->id);
+        }
+    }
+}
+
+void x86_relatorio_alocacao(MFuncao *mf, FILE *saida) {
+    int salvos = 0;
+    for (int r = 0; r < X86_NUM_REGS; r++) salvos += (mf->salvos >> r) & 1;
+    fprintf(saida, "[alocacao] %s: %d intervalos, %d na pilha, %d recargas, %d guardas, "
+            "%d registradores preservados, %d copias unidas, %d rematerializacoes\n",
+            mf->nome, mf->num_intervalos, mf->num_spills, mf->num_recargas, mf->num_guardas,
+            salvos, mf->num_copias_unidas, mf->num_remat);
+}
+
+/*
+ * Cada função passa pela saída do SSA, seleção, alocação e montagem do
+ * quadro; o resultado serve tanto ao emissor de texto quanto ao
+ * codificador.
+ */
+MFuncao* x86_gerar_funcao(IrModulo *mod, IrFuncao *f, OpcoesX86 *op) {
+    ir_sair_ssa(f);
+    MFuncao *mf = x86_selecionar(mod, f);
+    if (op->alocador == ALOCADOR_PILHA) x86_alocar_pilha(mf);
+    else if (op->alocador == ALOCADOR_GRAFO) x86_alocar_grafo(mf);
+    else x86_alocar_linear(mf);
+    x86_reescrever(mf);
+    x86_finalizar_quadro(mf);
+    if (op->relatorio) x86_relatorio_alocacao(mf, op->relatorio);
+    return mf;
+}
+
+/*
+ * Gera o programa inteiro em texto, montável com "as" e ligável com "ld"
+ * sem a biblioteca C.
+ */
+void x86_emitir_modulo(IrModulo *mod, OpcoesX86 *op, FILE *saida) {
+    fprintf(saida, "# gerado pelo compilador C-\n");
+    fprintf(saida, "\t.text\n");
+    for (IrFuncao *f = mod->funcoes; f; f = f->prox) {
+        x86_emitir_funcao(x86_gerar_funcao(mod, f, op), saida);
+    }
+
+    if (mod->globais) fprintf(saida, "\n\t.bss\n");
+    for (IrGlobal *g = mod->globais; g; g = g->prox) {
+        int bytes = 4 * (g->tamanho > 0 ? g->tamanho : 1);
+        fprintf(saida, "\t.p2align 3\ncm_%s:\n\t.zero %d\n", g->nome, bytes);
+    }
+
+    x86_emitir_runtime(saida);
+}
@@ -0,0 +1,33 @@
+#ifndef ENTRADA_SAIDA_H
+#define ENTRADA_SAIDA_H
+
+/*
+ * Runtime de input() e output() dos executores que rodam dentro do
+ * compilador (--run, --vm, --arvore e --fechamentos), com a semântica do
+ * runtime nativo: input() pula espaços, aceita '-' e retorna 0 no fim da
+ * entrada; output() escreve o inteiro e '\n'.
+ *
+ * Quando stdin é um arquivo comum maior que 64 KB ele é mapeado inteiro
+ * com mmap; senão é lido com read() num buffer de 64 KB. Os inteiros são lidos e formatados
+ * à mão, sem scanf/printf, e a saída acumula num buffer descarregado no
+ * fim do processo (atexit), quando enche ou por es_descarregar().
+ */
+int es_input(void);
+void es_output(int v);
+
+/* Escreve a saída pendente (antes, o que estiver no buffer de stdout) */
+void es_descarregar(void);
+
+/* Acesso fora do array com --verificar-indices: descarrega e termina com 1 */
+void es_erro_indice(void);
+
+/* Tratador de sinal: descarrega a saída e morre com o mesmo sinal */
+void es_ao_sinal(int sinal);
+
+/*
+ * Troca o runtime por scanf/printf ingênuos (--es-stdio), para medir a
+ * diferença em bench/es.sh.
+ */
+void es_usar_stdio(int ativo);
+
+#endif // ENTRADA_SAIDA_H
@@ -0,0 +1,131 @@
+/***********************************************/
+/* Escolhas                                    */
+/* Troca o if-else que só decide o valor de    */
+/* variáveis por IR_ESCOLHA, que o gerador de  */
+/* código faz com cmov em vez de desvio        */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+
+/* Contas de cada lado que passam a executar sempre */
+#define MAX_CONTAS_LADO 2
+/* Phis da junção: cada um vira uma escolha */
+#define MAX_ESCOLHAS 3
+
+/* Contas que não falham nem têm efeito, baratas de antecipar */
+static int antecipavel(IrInstr *i) {
+    switch (i->op) {
+        case IR_CONST:
+        case IR_ADD: case IR_SUB: case IR_MUL:
+        case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_EQ: case IR_NE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Junção alcançada pela aresta desvio -> alvo: o próprio alvo, ou, se o
+ * alvo é um lado só do desvio com poucas contas antecipáveis e um salto,
+ * o destino do salto. NULL quando o lado tem outra coisa.
+ */
+static IrBloco* juncao(IrBloco *desvio, IrBloco *alvo) {
+    if (alvo->num_preds != 1 || alvo->preds[0] != desvio) return alvo;
+    IrInstr *t = ir_terminador(alvo);
+    if (!t || t->op != IR_JMP) return NULL;
+    int contas = 0;
+    for (IrInstr *i = alvo->primeiro; i != t; i = i->prox) {
+        if (!antecipavel(i)) return NULL;
+        if (i->op != IR_CONST) contas++;
+    }
+    return contas <= MAX_CONTAS_LADO ? t->alvos[0] : NULL;
+}
+
+static IrInstr* argumento_de(IrInstr *phi, IrBloco *origem) {
+    for (int a = 0; a < phi->num_args; a++) {
+        if (phi->origens[a] == origem) return ir_valor(phi->args[a]);
+    }
+    return NULL;
+}
+
+/* Sobe as contas de um lado para antes do desvio */
+static void antecipar(IrBloco *lado, IrInstr *desvio) {
+    IrInstr *t = ir_terminador(lado);
+    IrInstr *i = lado->primeiro;
+    while (i != t) {
+        IrInstr *prox = i->prox;
+        ir_remover(i);
+        ir_inserir_antes(desvio, i);
+        i = prox;
+    }
+}
+
+/*
+ * Procura desvios cujos dois caminhos chegam à mesma junção (diamante,
+ * ou triângulo quando um deles é a própria junção) sem efeitos, com até
+ * MAX_ESCOLHAS phis inteiros na junção: as contas dos lados sobem, cada
+ * phi vira escolha(condição, valor do lado sim, valor do lado não) e o
+ * desvio vira salto. Retorna quantos desvios trocou.
+ */
+int otimizar_escolhas(IrFuncao *f, int *escolhas) {
+    *escolhas = 0;
+    ir_calcular_cfg(f);
+
+    int trocados = 0;
+    for (int b = 0; b < f->num_blocos; b++) {
+        IrBloco *bloco = f->blocos[b];
+        IrInstr *t = ir_terminador(bloco);
+        if (!t || t->op != IR_BR || t->alvos[0] == t->alvos[1]) continue;
+        IrBloco *sim = t->alvos[0], *nao = t->alvos[1];
+        IrBloco *j = juncao(bloco, sim);
+        if (!j || j != juncao(bloco, nao)) continue;
+        // um laço (junção antes do desvio) fica como está
+        if (j == f->blocos[0] || j->ordem <= bloco->ordem || j->num_preds != 2) continue;
+
+        IrBloco *origem_sim = sim == j ? bloco : sim;
+        IrBloco *origem_nao = nao == j ? bloco : nao;
+        int phis = 0, inteiros = 1;
+        for (IrInstr *p = j->primeiro; p && p->op == IR_PHI; p = p->prox) {
+            phis++;
+            inteiros &= p->tipo == IR_T_INT;
+        }
+        if (phis == 0 || phis > MAX_ESCOLHAS || !inteiros) continue;
+
+        if (sim != j) antecipar(sim, t);
+        if (nao != j) antecipar(nao, t);
+        IrInstr *p = j->primeiro;
+        while (p && p->op == IR_PHI) {
+            IrInstr *prox = p->prox;
+            IrInstr *a = argumento_de(p, origem_sim);
+            IrInstr *c = argumento_de(p, origem_nao);
+            if (a != c) {
+                IrInstr *e = ir_nova_instr(f, IR_ESCOLHA, IR_T_INT);
+                ir_add_arg(e, t->args[0]);
+                ir_add_arg(e, a);
+                ir_add_arg(e, c);
+                ir_inserir_antes(t, e);
+                a = e;
+                (*escolhas)++;
+            }
+            ir_substituir(p, a);
+            p = prox;
+        }
+        t->op = IR_JMP;
+        t->num_args = 0;
+        t->alvos[0] = j;
+        t->num_alvos = 1;
+        trocados++;
+    }
+
+    if (trocados > 0) {
+        ir_resolver_substituicoes(f);
+        ir_calcular_cfg(f);
+        ir_eliminar_codigo_morto(f);
+    }
+    return trocados;
+}
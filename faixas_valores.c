@@ -0,0 +1,477 @@
+/***********************************************/
+/* Faixas de valores                           */
+/* Calcula o intervalo [min, max] de cada      */
+/* valor inteiro da IR, estreitado em cada     */
+/* bloco pelas comparações dos desvios que o   */
+/* dominam, e dobra os desvios e as instruções */
+/* que a faixa decide                          */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "ir.h"
+#include "otimizador.h"
+
+/* Mudanças de um phi de cabeçalho antes de a faixa ir ao infinito */
+#define MUDANCAS_ANTES_DE_ALARGAR 2
+/* Voltas sem convergir depois das quais toda mudança é alargada */
+#define MAX_VOLTAS 64
+/* Passadas de estreitamento depois do ponto fixo */
+#define PASSADAS_ESTREITAMENTO 2
+
+static const FaixaIr TODA = {INT_MIN, INT_MAX};
+static const FaixaIr VAZIA = {INT_MAX, INT_MIN};
+
+static int vazia(FaixaIr r) {
+    return r.min > r.max;
+}
+
+static FaixaIr unitaria(int valor) {
+    FaixaIr r = {valor, valor};
+    return r;
+}
+
+/* Resultado exato em 64 bits; fora de int a operação dá a volta */
+static FaixaIr resultado(long long min, long long max) {
+    if (min < INT_MIN || max > INT_MAX) return TODA;
+    FaixaIr r = {(int)min, (int)max};
+    return r;
+}
+
+static FaixaIr intersecao(FaixaIr r, long long min, long long max) {
+    if (min < r.min) min = r.min;
+    if (max > r.max) max = r.max;
+    if (min > max) return VAZIA;
+    FaixaIr s = {(int)min, (int)max};
+    return s;
+}
+
+static FaixaIr uniao(FaixaIr a, FaixaIr b) {
+    if (vazia(a)) return b;
+    if (vazia(b)) return a;
+    FaixaIr r = {a.min < b.min ? a.min : b.min, a.max > b.max ? a.max : b.max};
+    return r;
+}
+
+static int eh_comparacao(IrOp op) {
+    return op == IR_LT || op == IR_LE || op == IR_GT || op == IR_GE ||
+           op == IR_EQ || op == IR_NE;
+}
+
+/* Comparação que vale quando 'op' é falsa */
+static IrOp negar(IrOp op) {
+    switch (op) {
+        case IR_LT: return IR_GE;
+        case IR_LE: return IR_GT;
+        case IR_GT: return IR_LE;
+        case IR_GE: return IR_LT;
+        case IR_EQ: return IR_NE;
+        default: return IR_EQ;
+    }
+}
+
+/* a op b equivale a b op' a */
+static IrOp trocar_lados(IrOp op) {
+    switch (op) {
+        case IR_LT: return IR_GT;
+        case IR_LE: return IR_GE;
+        case IR_GT: return IR_LT;
+        case IR_GE: return IR_LE;
+        default: return op;
+    }
+}
+
+/* Faixa calculada de v, sem o que os desvios ensinam */
+static FaixaIr faixa_de(FaixasIr *fx, IrInstr *v) {
+    v = ir_valor(v);
+    if (v->op == IR_CONST) return unitaria(v->imm);
+    if (v->tipo != IR_T_INT || v->id >= fx->num) return TODA;
+    return fx->faixas[v->id];
+}
+
+/*
+ * Estreita a faixa 'r' de 'v' sabendo que a condição 'cond' de um desvio
+ * deu 'verdade'. Ensinam alguma coisa a própria condição e as comparações
+ * com v de um lado, contra a faixa do outro.
+ */
+static FaixaIr restringir(FaixasIr *fx, FaixaIr r, IrInstr *v, IrInstr *cond, int verdade) {
+    cond = ir_valor(cond);
+    if (cond == v) {
+        if (!verdade) return intersecao(r, 0, 0);
+        if (r.min == 0) return intersecao(r, 1, INT_MAX);
+        if (r.max == 0) return intersecao(r, INT_MIN, -1);
+        return r;
+    }
+    if (!eh_comparacao(cond->op)) return r;
+
+    IrOp op = verdade ? cond->op : negar(cond->op);
+    FaixaIr o;
+    if (ir_valor(cond->args[0]) == v) {
+        o = faixa_de(fx, cond->args[1]);
+    } else if (ir_valor(cond->args[1]) == v) {
+        o = faixa_de(fx, cond->args[0]);
+        op = trocar_lados(op);
+    } else {
+        return r;
+    }
+    if (vazia(o)) return r;
+
+    switch (op) {
+        case IR_LT: return intersecao(r, INT_MIN, (long long)o.max - 1);
+        case IR_LE: return intersecao(r, INT_MIN, o.max);
+        case IR_GT: return intersecao(r, (long long)o.min + 1, INT_MAX);
+        case IR_GE: return intersecao(r, o.min, INT_MAX);
+        case IR_EQ: return intersecao(r, o.min, o.max);
+        default:
+            // diferente de uma constante só corta as pontas
+            if (o.min != o.max) return r;
+            if (r.min == o.min) return intersecao(r, (long long)r.min + 1, INT_MAX);
+            if (r.max == o.min) return intersecao(r, INT_MIN, (long long)r.max - 1);
+            return r;
+    }
+}
+
+/* Estreitamento pela aresta de -> para, se 'de' termina num desvio condicional */
+static FaixaIr pela_aresta(FaixasIr *fx, FaixaIr r, IrInstr *v, IrBloco *de, IrBloco *para) {
+    IrInstr *t = ir_terminador(de);
+    if (!t || t->op != IR_BR || t->alvos[0] == t->alvos[1]) return r;
+    return restringir(fx, r, v, t->args[0], t->alvos[0] == para);
+}
+
+/*
+ * Faixa de v dentro de 'bloco': a calculada, estreitada pelas arestas da
+ * árvore de dominadores acima do bloco cujo destino só é alcançado por
+ * elas (o destino tem um único predecessor, o dominador imediato).
+ */
+FaixaIr faixas_no_bloco(FaixasIr *fx, IrInstr *v, IrBloco *bloco) {
+    v = ir_valor(v);
+    FaixaIr r = faixa_de(fx, v);
+    for (IrBloco *s = bloco; s->idom && !vazia(r); s = s->idom) {
+        if (s->num_preds == 1 && s->preds[0] == s->idom) {
+            r = pela_aresta(fx, r, v, s->idom, s);
+        }
+    }
+    return r;
+}
+
+/* -1 se as faixas não decidem a comparação */
+static int comparar(IrOp op, FaixaIr a, FaixaIr b) {
+    switch (op) {
+        case IR_LT:
+            if (a.max < b.min) return 1;
+            if (a.min >= b.max) return 0;
+            return -1;
+        case IR_LE:
+            if (a.max <= b.min) return 1;
+            if (a.min > b.max) return 0;
+            return -1;
+        case IR_GT: return comparar(IR_LT, b, a);
+        case IR_GE: return comparar(IR_LE, b, a);
+        case IR_EQ:
+            if (a.min == a.max && b.min == b.max && a.min == b.min) return 1;
+            if (a.max < b.min || b.max < a.min) return 0;
+            return -1;
+        default: {
+            int eq = comparar(IR_EQ, a, b);
+            return eq < 0 ? -1 : !eq;
+        }
+    }
+}
+
+/* Quocientes de a pelos divisores de [lo, hi], todos do mesmo sinal */
+static FaixaIr dividir(FaixaIr a, long long lo, long long hi) {
+    long long q[4] = {a.min / lo, a.min / hi, a.max / lo, a.max / hi};
+    long long min = q[0], max = q[0];
+    for (int k = 1; k < 4; k++) {
+        if (q[k] < min) min = q[k];
+        if (q[k] > max) max = q[k];
+    }
+    return resultado(min, max);
+}
+
+static FaixaIr aritmetica(IrOp op, FaixaIr a, FaixaIr b) {
+    switch (op) {
+        case IR_ADD:
+            return resultado((long long)a.min + b.min, (long long)a.max + b.max);
+        case IR_SUB:
+            return resultado((long long)a.min - b.max, (long long)a.max - b.min);
+        case IR_MUL: {
+            long long p[4] = {(long long)a.min * b.min, (long long)a.min * b.max,
+                              (long long)a.max * b.min, (long long)a.max * b.max};
+            long long min = p[0], max = p[0];
+            for (int k = 1; k < 4; k++) {
+                if (p[k] < min) min = p[k];
+                if (p[k] > max) max = p[k];
+            }
+            return resultado(min, max);
+        }
+        case IR_DIV: {
+            // o divisor zero não produz valor (o programa falha)
+            FaixaIr r = VAZIA;
+            if (b.min < 0) r = uniao(r, dividir(a, b.min, b.max < 0 ? b.max : -1));
+            if (b.max > 0) r = uniao(r, dividir(a, b.min > 0 ? b.min : 1, b.max));
+            return r;
+        }
+        case IR_REM: {
+            // |a % b| < |b| e |a % b| <= |a|, com o sinal de a
+            if (b.min == 0 && b.max == 0) return VAZIA;
+            long long m = b.max;
+            if (-(long long)b.min > m) m = -(long long)b.min;
+            m--;
+            long long min = a.min < -m ? -m : a.min, max = a.max > m ? m : a.max;
+            if (min > 0) min = 0;
+            if (max < 0) max = 0;
+            return resultado(min, max);
+        }
+        default: {
+            int c = comparar(op, a, b);
+            if (c >= 0) return unitaria(c);
+            FaixaIr r = {0, 1};
+            return r;
+        }
+    }
+}
+
+static FaixaIr avaliar(FaixasIr *fx, IrInstr *i) {
+    switch (i->op) {
+        case IR_CONST:
+            return unitaria(i->imm);
+
+        case IR_PHI: {
+            FaixaIr r = VAZIA;
+            for (int a = 0; a < i->num_args; a++) {
+                IrBloco *origem = i->origens[a];
+                FaixaIr arg = faixas_no_bloco(fx, i->args[a], origem);
+                r = uniao(r, pela_aresta(fx, arg, ir_valor(i->args[a]), origem, i->bloco));
+            }
+            return r;
+        }
+
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_REM:
+        case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_EQ: case IR_NE: {
+            FaixaIr a = faixas_no_bloco(fx, i->args[0], i->bloco);
+            FaixaIr b = faixas_no_bloco(fx, i->args[1], i->bloco);
+            if (vazia(a) || vazia(b)) return VAZIA;
+            return aritmetica(i->op, a, b);
+        }
+
+        case IR_ESCOLHA: {
+            // cada lado estreitado pela condição que o escolhe
+            FaixaIr c = faixas_no_bloco(fx, i->args[0], i->bloco);
+            FaixaIr r = VAZIA;
+            if (c.min != 0 || c.max != 0) {
+                FaixaIr a = faixas_no_bloco(fx, i->args[1], i->bloco);
+                r = uniao(r, restringir(fx, a, ir_valor(i->args[1]), i->args[0], 1));
+            }
+            if (c.min <= 0 && c.max >= 0) {
+                FaixaIr b = faixas_no_bloco(fx, i->args[2], i->bloco);
+                r = uniao(r, restringir(fx, b, ir_valor(i->args[2]), i->args[0], 0));
+            }
+            return vazia(c) ? VAZIA : r;
+        }
+
+        default:
+            return TODA;
+    }
+}
+
+/* Cabeçalho de laço: tem um predecessor que não vem antes dele na RPO */
+static int eh_cabecalho(IrBloco *bloco) {
+    for (int p = 0; p < bloco->num_preds; p++) {
+        if (bloco->preds[p]->ordem >= bloco->ordem) return 1;
+    }
+    return 0;
+}
+
+/*
+ * Ponto fixo a partir de faixas vazias (o que nunca executa fica vazio).
+ * Nos phis de cabeçalho, a ponta que continua mudando vai ao infinito
+ * para o laço convergir; as passadas de estreitamento depois recuperam
+ * o limite que a comparação do cabeçalho impõe.
+ */
+void faixas_calcular(FaixasIr *fx, IrFuncao *f) {
+    fx->f = f;
+    fx->num = f->prox_valor;
+    fx->faixas = (FaixaIr*)malloc(sizeof(FaixaIr) * (fx->num + 1));
+    for (int k = 0; k < fx->num; k++) fx->faixas[k] = VAZIA;
+    int *mudancas = (int*)calloc(fx->num + 1, sizeof(int));
+
+    int mudou = 1;
+    for (int volta = 0; mudou; volta++) {
+        mudou = 0;
+        for (int b = 0; b < f->num_blocos; b++) {
+            IrBloco *bloco = f->blocos[b];
+            int cabecalho = eh_cabecalho(bloco);
+            for (IrInstr *i = bloco->primeiro; i; i = i->prox) {
+                if (i->tipo != IR_T_INT) continue;
+                FaixaIr velha = fx->faixas[i->id];
+                FaixaIr nova = uniao(velha, avaliar(fx, i));
+                if (nova.min == velha.min && nova.max == velha.max) continue;
+
+                if (!vazia(velha) && (volta >= MAX_VOLTAS ||
+                    (i->op == IR_PHI && cabecalho &&
+                     ++mudancas[i->id] > MUDANCAS_ANTES_DE_ALARGAR))) {
+                    if (nova.min < velha.min) nova.min = INT_MIN;
+                    if (nova.max > velha.max) nova.max = INT_MAX;
+                }
+                fx->faixas[i->id] = nova;
+                mudou = 1;
+            }
+        }
+    }
+    free(mudancas);
+
+    for (int k = 0; k < PASSADAS_ESTREITAMENTO; k++) {
+        for (int b = 0; b < f->num_blocos; b++) {
+            for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+                if (i->tipo != IR_T_INT) continue;
+                FaixaIr r = avaliar(fx, i);
+                fx->faixas[i->id] = intersecao(fx->faixas[i->id], r.min, r.max);
+            }
+        }
+    }
+}
+
+void faixas_liberar(FaixasIr *fx) {
+    free(fx->faixas);
+}
+
+/* Divisão ou resto que pode falhar: divisor zero ou INT_MIN / -1 */
+int faixas_divisao_pode_falhar(FaixasIr *fx, IrInstr *i, IrBloco *bloco) {
+    FaixaIr a = faixas_no_bloco(fx, i->args[0], bloco);
+    FaixaIr b = faixas_no_bloco(fx, i->args[1], bloco);
+    if (vazia(a) || vazia(b)) return 1;
+    if (b.min <= 0 && b.max >= 0) return 1;
+    return a.min == INT_MIN && b.min <= -1 && b.max >= -1;
+}
+
+/* Primeira posição depois dos phis do bloco */
+static IrInstr* depois_dos_phis(IrBloco *bloco) {
+    IrInstr *i = bloco->primeiro;
+    while (i && i->op == IR_PHI) i = i->prox;
+    return i;
+}
+
+/*
+ * O resto a % b é o próprio a quando |a| < |b| (e o quociente é zero,
+ * que a faixa unitária já pega).
+ */
+static IrInstr* simplificar_resto(FaixasIr *fx, IrInstr *i) {
+    FaixaIr a = faixas_no_bloco(fx, i->args[0], i->bloco);
+    FaixaIr b = faixas_no_bloco(fx, i->args[1], i->bloco);
+    long long m;
+    if (b.min > 0) m = b.min;
+    else if (b.max < 0) m = -(long long)b.max;
+    else return NULL;
+    if (a.min > -m && a.max < m) return ir_valor(i->args[0]);
+    return NULL;
+}
+
+/*
+ * Dobra os desvios cuja condição a faixa decide e troca por constante as
+ * instruções de faixa unitária; marca as divisões e restos de dividendo
+ * não negativo (IR_FLAG_NAO_NEGATIVO). As decisões são todas tomadas antes de
+ * mudar a função, para que uma condição trocada por constante ainda
+ * estreite as faixas dos blocos abaixo dela.
+ */
+int otimizar_faixas(IrFuncao *f, int *simplificadas) {
+    *simplificadas = 0;
+    ir_calcular_cfg(f);
+
+    FaixasIr fx;
+    faixas_calcular(&fx, f);
+
+    int num = 0, cap = 16;
+    IrInstr **trocadas = (IrInstr**)malloc(sizeof(IrInstr*) * cap);
+    IrInstr **por = (IrInstr**)malloc(sizeof(IrInstr*) * cap);
+    int num_desvios = 0;
+    IrInstr **desvios = (IrInstr**)malloc(sizeof(IrInstr*) * (f->num_blocos + 1));
+    int *destinos = (int*)malloc(sizeof(int) * (f->num_blocos + 1));
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        IrBloco *bloco = f->blocos[b];
+        for (IrInstr *i = bloco->primeiro; i; i = i->prox) {
+            if (i->op == IR_BR && i->alvos[0] != i->alvos[1]) {
+                FaixaIr c = faixas_no_bloco(&fx, i->args[0], bloco);
+                if (vazia(c) || (c.min <= 0 && c.max >= 0 && (c.min != 0 || c.max != 0))) continue;
+                desvios[num_desvios] = i;
+                destinos[num_desvios++] = c.min == 0 && c.max == 0;
+                continue;
+            }
+            if (i->op == IR_CASOS) {
+                FaixaIr v = faixas_no_bloco(&fx, i->args[0], bloco);
+                if (vazia(v) || v.min != v.max) continue;
+                int destino = 0;
+                for (int a = 1; a < i->num_args; a++) {
+                    if (ir_valor(i->args[a])->imm == v.min) destino = a;
+                }
+                desvios[num_desvios] = i;
+                destinos[num_desvios++] = destino;
+                continue;
+            }
+
+            if (i->tipo != IR_T_INT || i->op == IR_CONST) continue;
+            if (i->op != IR_PHI && !eh_comparacao(i->op) && i->op != IR_ADD &&
+                i->op != IR_SUB && i->op != IR_MUL && i->op != IR_DIV && i->op != IR_REM &&
+                i->op != IR_ESCOLHA) continue;
+            if ((i->op == IR_DIV || i->op == IR_REM) &&
+                faixas_divisao_pode_falhar(&fx, i, bloco)) continue;
+            // o seletor x86 dispensa a correção de sinal da divisão por constante
+            if ((i->op == IR_DIV || i->op == IR_REM) &&
+                faixas_no_bloco(&fx, i->args[0], bloco).min >= 0) {
+                i->flags |= IR_FLAG_NAO_NEGATIVO;
+            }
+
+            FaixaIr r = faixas_no_bloco(&fx, i, bloco);
+            IrInstr *novo = NULL;
+            if (!vazia(r) && r.min == r.max) {
+                novo = ir_nova_instr(f, IR_CONST, IR_T_INT);
+                novo->imm = r.min;
+            } else if (i->op == IR_REM) {
+                novo = simplificar_resto(&fx, i);
+            }
+            if (!novo) continue;
+
+            if (num == cap) {
+                cap *= 2;
+                trocadas = (IrInstr**)realloc(trocadas, sizeof(IrInstr*) * cap);
+                por = (IrInstr**)realloc(por, sizeof(IrInstr*) * cap);
+            }
+            trocadas[num] = i;
+            por[num++] = novo;
+        }
+    }
+
+    for (int k = 0; k < num; k++) {
+        IrInstr *i = trocadas[k];
+        if (por[k]->op == IR_CONST && !por[k]->bloco) {
+            ir_inserir_antes(depois_dos_phis(i->bloco), por[k]);
+        }
+        ir_substituir(i, por[k]);
+    }
+    for (int k = 0; k < num_desvios; k++) {
+        IrInstr *t = desvios[k];
+        t->op = IR_JMP;
+        t->num_args = 0;
+        t->alvos[0] = t->alvos[destinos[k]];
+        t->num_alvos = 1;
+    }
+    *simplificadas = num;
+
+    faixas_liberar(&fx);
+    free(trocadas);
+    free(por);
+    free(desvios);
+    free(destinos);
+
+    if (num > 0 || num_desvios > 0) {
+        ir_resolver_substituicoes(f);
+        if (num_desvios > 0) ir_calcular_cfg(f);
+        ir_remover_phis_triviais(f);
+        ir_eliminar_codigo_morto(f);
+    }
+    return num_desvios;
+}
@@ -0,0 +1,128 @@
+/***********************************************/
+/* Saída do SSA                                */
+/* Troca os phis por cópias nos predecessores  */
+/* (cópias paralelas sequencializadas), depois */
+/* de dividir as arestas críticas              */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ir.h"
+#include "x86.h"
+
+/*
+ * Aresta de um bloco com vários sucessores para um bloco com phis e vários
+ * predecessores: as cópias não podem ficar em nenhum dos dois extremos.
+ */
+static void dividir_arestas_criticas(IrFuncao *f) {
+    int n = f->num_blocos;
+    int divididas = 0;
+
+    for (int b = 0; b < n; b++) {
+        IrBloco *bloco = f->blocos[b];
+        IrInstr *term = ir_terminador(bloco);
+        if (!term || term->num_alvos < 2) continue;
+
+        for (int k = 0; k < term->num_alvos; k++) {
+            IrBloco *alvo = term->alvos[k];
+            if (alvo->num_preds < 2 || !alvo->primeiro || alvo->primeiro->op != IR_PHI) continue;
+
+            IrBloco *meio = ir_novo_bloco(f);
+            IrInstr *jmp = ir_nova_instr(f, IR_JMP, IR_T_VOID);
+            ir_add_alvo(jmp, alvo);
+            ir_inserir_fim(meio, jmp);
+            term->alvos[k] = meio;
+            ir_trocar_origem_phis(alvo, bloco, meio);
+            divididas++;
+        }
+    }
+    if (divididas > 0) ir_calcular_cfg(f);
+}
+
+/*
+ * Sequencializa as cópias paralelas destinos[i] <- origens[i] no fim de
+ * 'bloco'. Uma cópia pode ser feita quando seu destino não é mais lido por
+ * nenhuma pendente; num ciclo, o destino de uma delas é salvo antes num
+ * valor temporário.
+ */
+static void sequencializar(IrFuncao *f, IrBloco *bloco, IrInstr **destinos,
+                           IrInstr **origens, int num) {
+    while (num > 0) {
+        int livre = -1;
+        for (int c = 0; c < num && livre < 0; c++) {
+            int lido = 0;
+            for (int o = 0; o < num && !lido; o++) {
+                if (o != c && origens[o] == destinos[c]) lido = 1;
+            }
+            if (!lido) livre = c;
+        }
+
+        if (livre < 0) {
+            IrInstr *salvo = destinos[0];
+            IrInstr *temp = ir_nova_instr(f, IR_COPY, salvo->tipo);
+            ir_add_arg(temp, salvo);
+            ir_inserir_antes_terminador(bloco, temp);
+            for (int o = 0; o < num; o++) {
+                if (origens[o] == salvo) origens[o] = temp;
+            }
+            continue;
+        }
+
+        IrInstr *copia = ir_nova_instr(f, IR_COPY, destinos[livre]->tipo);
+        ir_add_arg(copia, origens[livre]);
+        copia->destino = destinos[livre];
+        ir_inserir_antes_terminador(bloco, copia);
+
+        destinos[livre] = destinos[num - 1];
+        origens[livre] = origens[num - 1];
+        num--;
+    }
+}
+
+/*
+ * Tira a função do SSA: cada phi passa a ser uma variável escrita pelas
+ * cópias (IR_COPY com destino) no fim dos predecessores e fica no bloco
+ * sem argumentos. Depois disso nenhum passe de otimização pode rodar.
+ */
+void ir_sair_ssa(IrFuncao *f) {
+    ir_resolver_substituicoes(f);
+    ir_calcular_cfg(f);
+    dividir_arestas_criticas(f);
+
+    int cap = 8;
+    IrInstr **destinos = (IrInstr**)malloc(sizeof(IrInstr*) * cap);
+    IrInstr **origens = (IrInstr**)malloc(sizeof(IrInstr*) * cap);
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        IrBloco *bloco = f->blocos[b];
+        for (int p = 0; p < bloco->num_preds; p++) {
+            IrBloco *pred = bloco->preds[p];
+            int num = 0;
+            for (IrInstr *phi = bloco->primeiro; phi && phi->op == IR_PHI; phi = phi->prox) {
+                for (int a = 0; a < phi->num_args; a++) {
+                    if (phi->origens[a] != pred) continue;
+                    IrInstr *valor = ir_valor(phi->args[a]);
+                    if (valor == phi) continue;
+                    if (num == cap) {
+                        cap *= 2;
+                        destinos = (IrInstr**)realloc(destinos, sizeof(IrInstr*) * cap);
+                        origens = (IrInstr**)realloc(origens, sizeof(IrInstr*) * cap);
+                    }
+                    destinos[num] = phi;
+                    origens[num] = valor;
+                    num++;
+                    break;
+                }
+            }
+            sequencializar(f, pred, destinos, origens, num);
+        }
+    }
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *phi = f->blocos[b]->primeiro; phi && phi->op == IR_PHI; phi = phi->prox) {
+            phi->num_args = 0;
+        }
+    }
+    free(destinos);
+    free(origens);
+}
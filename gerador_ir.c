@@ -0,0 +1,726 @@
+/***********************************************/
+/* Geração da IR a partir da árvore sintática  */
+/* Constrói o SSA diretamente durante a        */
+/* tradução (Braun et al., "Simple and         */
+/* Efficient Construction of SSA Form")        */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+
+// tipos de nome visiveis durante a traducao
+typedef enum {
+    SIMB_VAR,           /* escalar local ou parâmetro (variável SSA) */
+    SIMB_ARRAY_LOCAL,   /* array declarado na função */
+    SIMB_PONTEIRO,      /* parâmetro array (params-lista) */
+    SIMB_GLOBAL,        /* escalar global */
+    SIMB_ARRAY_GLOBAL   /* array global */
+} TipoSimbolo;
+
+typedef struct Simbolo {
+    char *nome;
+    TipoSimbolo tipo;
+    int indice;         /* variável SSA, array local ou tamanho do global */
+    IrInstr *valor;     /* SIMB_PONTEIRO: parâmetro correspondente */
+    IrInstr *tamanho;   /* SIMB_PONTEIRO com verificação: parâmetro escondido */
+    int nivel;
+    struct Simbolo *prox;
+} Simbolo;
+
+typedef struct {
+    IrModulo *mod;
+    IrFuncao *f;
+    IrBloco *atual;
+    Simbolo *simbolos;
+    int nivel;
+    int prox_var;
+    int verificar;      /* IR_VERIFICA antes de cada acesso a array */
+
+    /* ir_gerar_osr: o While de número laco_osr também é alcançado a partir
+     * de entrada_osr, e os arrays locais chegam como parâmetros */
+    IrBloco *entrada_osr;
+    int laco_osr;
+    int num_lacos;
+    IrInstr **arrays_osr;
+    int num_arrays_osr;
+} Gerador;
+
+static IrInstr* gerar_expressao(Gerador *g, TreeNode *node);
+static void gerar_statement(Gerador *g, TreeNode *node);
+
+static void erro_ir(Gerador *g, const char *mensagem, const char *nome) {
+    fprintf(stderr, "ERRO SEMANTICO: %s: %s\n", mensagem, nome);
+    g->mod->erros++;
+}
+
+/* Escopos */
+
+static void declarar(Gerador *g, char *nome, TipoSimbolo tipo, int indice, IrInstr *valor) {
+    Simbolo *s = (Simbolo*)malloc(sizeof(Simbolo));
+    s->nome = nome;
+    s->tipo = tipo;
+    s->indice = indice;
+    s->valor = valor;
+    s->tamanho = NULL;
+    s->nivel = g->nivel;
+    s->prox = g->simbolos;
+    g->simbolos = s;
+}
+
+static Simbolo* buscar(Gerador *g, const char *nome) {
+    for (Simbolo *s = g->simbolos; s; s = s->prox) {
+        if (strcmp(s->nome, nome) == 0) return s;
+    }
+    return NULL;
+}
+
+static void abrir_escopo(Gerador *g) {
+    g->nivel++;
+}
+
+static void fechar_escopo(Gerador *g) {
+    while (g->simbolos && g->simbolos->nivel == g->nivel) {
+        Simbolo *s = g->simbolos;
+        g->simbolos = s->prox;
+        free(s);
+    }
+    g->nivel--;
+}
+
+/* Emissão de instruções */
+
+static IrInstr* emitir(Gerador *g, IrInstr *instr) {
+    ir_inserir_fim(g->atual, instr);
+    return instr;
+}
+
+static IrInstr* emitir_const(Gerador *g, int valor) {
+    IrInstr *c = ir_nova_instr(g->f, IR_CONST, IR_T_INT);
+    c->imm = valor;
+    return emitir(g, c);
+}
+
+static IrInstr* emitir_binaria(Gerador *g, IrOp op, IrInstr *a, IrInstr *b) {
+    IrInstr *i = ir_nova_instr(g->f, op, IR_T_INT);
+    ir_add_arg(i, a);
+    ir_add_arg(i, b);
+    return emitir(g, i);
+}
+
+static void emitir_jmp(Gerador *g, IrBloco *alvo) {
+    IrInstr *j = ir_nova_instr(g->f, IR_JMP, IR_T_VOID);
+    ir_add_alvo(j, alvo);
+    emitir(g, j);
+    ir_add_pred(alvo, g->atual);
+}
+
+static void emitir_br(Gerador *g, IrInstr *cond, IrBloco *sim, IrBloco *nao) {
+    IrInstr *br = ir_nova_instr(g->f, IR_BR, IR_T_VOID);
+    ir_add_arg(br, cond);
+    ir_add_alvo(br, sim);
+    ir_add_alvo(br, nao);
+    emitir(g, br);
+    ir_add_pred(sim, g->atual);
+    ir_add_pred(nao, g->atual);
+}
+
+/* Código após um return vai para um bloco novo, sem predecessores */
+static void garantir_bloco_aberto(Gerador *g) {
+    if (ir_terminador(g->atual)) {
+        g->atual = ir_novo_bloco(g->f);
+        g->atual->selado = 1;
+    }
+}
+
+/* Construção do SSA */
+
+static IrInstr* ler_variavel(Gerador *g, int var, IrBloco *bloco);
+
+static IrInstr** defs_do_bloco(Gerador *g, IrBloco *bloco) {
+    if (!bloco->defs) {
+        bloco->defs = (IrInstr**)calloc(g->f->num_vars + 1, sizeof(IrInstr*));
+        bloco->phis_incompletos = (IrInstr**)calloc(g->f->num_vars + 1, sizeof(IrInstr*));
+    }
+    return bloco->defs;
+}
+
+static void escrever_variavel(Gerador *g, int var, IrBloco *bloco, IrInstr *valor) {
+    defs_do_bloco(g, bloco)[var] = valor;
+}
+
+/* Valor de uma variável nunca atribuída: locais começam com 0 */
+static IrInstr* valor_inicial(Gerador *g) {
+    IrInstr *c = ir_nova_instr(g->f, IR_CONST, IR_T_INT);
+    c->imm = 0;
+    ir_inserir_inicio(g->f->blocos[0], c);
+    return c;
+}
+
+static IrInstr* tentar_remover_phi_trivial(Gerador *g, IrInstr *phi) {
+    IrInstr *igual = NULL;
+    for (int a = 0; a < phi->num_args; a++) {
+        IrInstr *v = ir_valor(phi->args[a]);
+        if (v == igual || v == phi) continue;
+        if (igual) return phi;
+        igual = v;
+    }
+    if (!igual) igual = valor_inicial(g);
+    ir_substituir(phi, igual);
+    return igual;
+}
+
+static IrInstr* adicionar_operandos_phi(Gerador *g, int var, IrInstr *phi) {
+    IrBloco *bloco = phi->bloco;
+    for (int p = 0; p < bloco->num_preds; p++) {
+        ir_add_phi_arg(phi, ler_variavel(g, var, bloco->preds[p]), bloco->preds[p]);
+    }
+    return tentar_remover_phi_trivial(g, phi);
+}
+
+static IrInstr* novo_phi(Gerador *g, IrBloco *bloco) {
+    IrInstr *phi = ir_nova_instr(g->f, IR_PHI, IR_T_INT);
+    ir_inserir_inicio(bloco, phi);
+    return phi;
+}
+
+static IrInstr* ler_variavel_recursivo(Gerador *g, int var, IrBloco *bloco) {
+    IrInstr *valor;
+    if (!bloco->selado) {
+        valor = novo_phi(g, bloco);
+        defs_do_bloco(g, bloco);
+        bloco->phis_incompletos[var] = valor;
+    } else if (bloco->num_preds == 0) {
+        valor = valor_inicial(g);
+    } else if (bloco->num_preds == 1) {
+        valor = ler_variavel(g, var, bloco->preds[0]);
+    } else {
+        IrInstr *phi = novo_phi(g, bloco);
+        escrever_variavel(g, var, bloco, phi);
+        valor = adicionar_operandos_phi(g, var, phi);
+    }
+    escrever_variavel(g, var, bloco, valor);
+    return valor;
+}
+
+static IrInstr* ler_variavel(Gerador *g, int var, IrBloco *bloco) {
+    IrInstr *def = defs_do_bloco(g, bloco)[var];
+    if (def) return ir_valor(def);
+    return ler_variavel_recursivo(g, var, bloco);
+}
+
+static void selar_bloco(Gerador *g, IrBloco *bloco) {
+    defs_do_bloco(g, bloco);
+    for (int v = 0; v < g->f->num_vars; v++) {
+        if (bloco->phis_incompletos[v]) {
+            adicionar_operandos_phi(g, v, bloco->phis_incompletos[v]);
+        }
+    }
+    bloco->selado = 1;
+}
+
+/* Expressões */
+
+static IrInstr* endereco_array(Gerador *g, Simbolo *s) {
+    if (s->tipo == SIMB_PONTEIRO) return s->valor;
+    IrInstr *end = ir_nova_instr(g->f, IR_ENDERECO, IR_T_PTR);
+    if (s->tipo == SIMB_ARRAY_GLOBAL) {
+        end->nome = s->nome;
+        end->imm = s->indice;   /* tamanho do array global */
+    } else {
+        end->imm = s->indice;
+    }
+    return emitir(g, end);
+}
+
+static int eh_array(Simbolo *s) {
+    return s->tipo == SIMB_ARRAY_LOCAL || s->tipo == SIMB_PONTEIRO || s->tipo == SIMB_ARRAY_GLOBAL;
+}
+
+/* Número de elementos do array: constante, ou o parâmetro escondido */
+static IrInstr* tamanho_array(Gerador *g, Simbolo *s) {
+    if (s->tipo == SIMB_PONTEIRO) return s->tamanho;
+    return emitir_const(g, s->tipo == SIMB_ARRAY_GLOBAL ? s->indice : g->f->arrays_locais[s->indice]);
+}
+
+static void emitir_verificacao(Gerador *g, Simbolo *s, IrInstr *indice) {
+    if (!g->verificar) return;
+    IrInstr *v = ir_nova_instr(g->f, IR_VERIFICA, IR_T_VOID);
+    ir_add_arg(v, indice);
+    ir_add_arg(v, tamanho_array(g, s));
+    emitir(g, v);
+}
+
+static IrOp op_do_operador(const char *op) {
+    if (strcmp(op, "+") == 0) return IR_ADD;
+    if (strcmp(op, "-") == 0) return IR_SUB;
+    if (strcmp(op, "*") == 0) return IR_MUL;
+    if (strcmp(op, "/") == 0) return IR_DIV;
+    if (strcmp(op, "<") == 0) return IR_LT;
+    if (strcmp(op, "<=") == 0) return IR_LE;
+    if (strcmp(op, ">") == 0) return IR_GT;
+    if (strcmp(op, ">=") == 0) return IR_GE;
+    if (strcmp(op, "==") == 0) return IR_EQ;
+    return IR_NE;
+}
+
+static IrInstr* gerar_chamada(Gerador *g, TreeNode *node) {
+    IrFuncao *alvo = ir_buscar_funcao(g->mod, node->value);
+    int builtin = ir_eh_builtin(node->value);
+    if (!alvo && !builtin) {
+        erro_ir(g, "Função não declarada", node->value);
+        return emitir_const(g, 0);
+    }
+
+    int retorna_int = builtin ? strcmp(node->value, "input") == 0 : alvo->retorna_int;
+    IrInstr *call = ir_nova_instr(g->f, IR_CALL, retorna_int ? IR_T_INT : IR_T_VOID);
+    call->nome = node->value;
+
+    // Argumentos -> Argument-List -> expressoes, avaliadas da esquerda para a direita
+    TreeNode *args = node->children[0];
+    if (args->num_children > 0) {
+        TreeNode *lista = args->children[0];
+        for (int a = 0; a < lista->num_children; a++) {
+            ir_add_arg(call, gerar_expressao(g, lista->children[a]));
+        }
+        // com verificação, o tamanho de cada array passado vai depois dos argumentos
+        for (int a = 0; g->verificar && alvo && a < lista->num_children && a < alvo->num_params; a++) {
+            if (!alvo->param_array[a]) continue;
+            TreeNode *arg = lista->children[a];
+            Simbolo *s = strcmp(arg->node_type, "Variavel") == 0 ? buscar(g, arg->value) : NULL;
+            ir_add_arg(call, s && eh_array(s) ? tamanho_array(g, s) : emitir_const(g, 0));
+        }
+    }
+
+    int esperados = builtin ? (strcmp(node->value, "output") == 0) : alvo->num_params;
+    if (call->num_args != esperados) {
+        erro_ir(g, "Número incorreto de argumentos", node->value);
+    }
+
+    emitir(g, call);
+    return retorna_int ? call : emitir_const(g, 0);
+}
+
+static void gerar_atribuicao_var(Gerador *g, TreeNode *var, IrInstr *indice, IrInstr *valor) {
+    Simbolo *s = buscar(g, var->value);
+    if (!s) {
+        erro_ir(g, "Variável não declarada", var->value);
+        return;
+    }
+
+    if (strcmp(var->node_type, "Variavel-Array") == 0) {
+        if (!eh_array(s)) {
+            erro_ir(g, "Variável não é array", var->value);
+            return;
+        }
+        IrInstr *base = endereco_array(g, s);
+        emitir_verificacao(g, s, indice);
+        IrInstr *st = ir_nova_instr(g->f, IR_STORE, IR_T_VOID);
+        ir_add_arg(st, base);
+        ir_add_arg(st, indice);
+        ir_add_arg(st, valor);
+        emitir(g, st);
+    } else if (s->tipo == SIMB_VAR) {
+        escrever_variavel(g, s->indice, g->atual, valor);
+    } else if (s->tipo == SIMB_GLOBAL) {
+        IrInstr *st = ir_nova_instr(g->f, IR_STOREG, IR_T_VOID);
+        st->nome = s->nome;
+        ir_add_arg(st, valor);
+        emitir(g, st);
+    } else {
+        erro_ir(g, "Atribuição a array inteiro", var->value);
+    }
+}
+
+static IrInstr* gerar_expressao(Gerador *g, TreeNode *node) {
+    if (strcmp(node->node_type, "Num") == 0) {
+        return emitir_const(g, atoi(node->value));
+    }
+
+    if (strcmp(node->node_type, "Variavel") == 0) {
+        Simbolo *s = buscar(g, node->value);
+        if (!s) {
+            erro_ir(g, "Variável não declarada", node->value);
+            return emitir_const(g, 0);
+        }
+        if (s->tipo == SIMB_VAR) return ler_variavel(g, s->indice, g->atual);
+        if (s->tipo == SIMB_GLOBAL) {
+            IrInstr *ld = ir_nova_instr(g->f, IR_LOADG, IR_T_INT);
+            ld->nome = s->nome;
+            return emitir(g, ld);
+        }
+        return endereco_array(g, s);
+    }
+
+    if (strcmp(node->node_type, "Variavel-Array") == 0) {
+        Simbolo *s = buscar(g, node->value);
+        if (!s || !eh_array(s)) {
+            erro_ir(g, s ? "Variável não é array" : "Variável não declarada", node->value);
+            return emitir_const(g, 0);
+        }
+        IrInstr *base = endereco_array(g, s);
+        IrInstr *indice = gerar_expressao(g, node->children[0]);
+        emitir_verificacao(g, s, indice);
+        IrInstr *ld = ir_nova_instr(g->f, IR_LOAD, IR_T_INT);
+        ir_add_arg(ld, base);
+        ir_add_arg(ld, indice);
+        return emitir(g, ld);
+    }
+
+    if (strcmp(node->node_type, "Assign-Expression") == 0) {
+        // a[i] = v: o indice e avaliado antes do valor
+        TreeNode *var = node->children[0];
+        IrInstr *indice = NULL;
+        if (strcmp(var->node_type, "Variavel-Array") == 0) {
+            indice = gerar_expressao(g, var->children[0]);
+        }
+        IrInstr *valor = gerar_expressao(g, node->children[1]);
+        gerar_atribuicao_var(g, var, indice, valor);
+        return valor;
+    }
+
+    if (strcmp(node->node_type, "Function-Call") == 0) {
+        return gerar_chamada(g, node);
+    }
+
+    // Expressao, soma-Expressao e mult-Expressao: esquerda, operador, direita
+    if (node->num_children == 3) {
+        IrInstr *a = gerar_expressao(g, node->children[0]);
+        IrInstr *b = gerar_expressao(g, node->children[2]);
+        return emitir_binaria(g, op_do_operador(node->children[1]->value), a, b);
+    }
+
+    erro_ir(g, "Expressão inválida", node->node_type);
+    return emitir_const(g, 0);
+}
+
+/* Comandos */
+
+static void gerar_declaracao_local(Gerador *g, TreeNode *decl) {
+    if (decl->num_children > 1 && g->entrada_osr) {
+        declarar(g, decl->value, SIMB_PONTEIRO, 0, g->arrays_osr[g->num_arrays_osr++]);
+    } else if (decl->num_children > 1) {
+        IrFuncao *f = g->f;
+        f->arrays_locais = (int*)realloc(f->arrays_locais, sizeof(int) * (f->num_arrays_locais + 1));
+        f->arrays_locais[f->num_arrays_locais] = atoi(decl->children[1]->value);
+        declarar(g, decl->value, SIMB_ARRAY_LOCAL, f->num_arrays_locais++, NULL);
+    } else {
+        declarar(g, decl->value, SIMB_VAR, g->prox_var++, NULL);
+    }
+}
+
+static void gerar_composto(Gerador *g, TreeNode *node) {
+    abrir_escopo(g);
+    TreeNode *locais = node->children[0];
+    for (int i = 0; i < locais->num_children; i++) {
+        gerar_declaracao_local(g, locais->children[i]);
+    }
+    TreeNode *comandos = node->children[1];
+    for (int i = 0; i < comandos->num_children; i++) {
+        gerar_statement(g, comandos->children[i]);
+    }
+    fechar_escopo(g);
+}
+
+static void gerar_statement(Gerador *g, TreeNode *node) {
+    garantir_bloco_aberto(g);
+
+    if (strcmp(node->node_type, "Expressao-declaracao") == 0) {
+        gerar_expressao(g, node->children[0]);
+    }
+    else if (strcmp(node->node_type, "Composto-declaracao") == 0) {
+        gerar_composto(g, node);
+    }
+    else if (strcmp(node->node_type, "If-Statement") == 0 ||
+             strcmp(node->node_type, "If-Else-Statement") == 0) {
+        int tem_else = node->num_children > 2;
+        IrInstr *cond = gerar_expressao(g, node->children[0]);
+        IrBloco *entao = ir_novo_bloco(g->f);
+        IrBloco *senao = tem_else ? ir_novo_bloco(g->f) : NULL;
+        IrBloco *fim = ir_novo_bloco(g->f);
+
+        emitir_br(g, cond, entao, tem_else ? senao : fim);
+        selar_bloco(g, entao);
+        g->atual = entao;
+        gerar_statement(g, node->children[1]);
+        if (!ir_terminador(g->atual)) emitir_jmp(g, fim);
+
+        if (tem_else) {
+            selar_bloco(g, senao);
+            g->atual = senao;
+            gerar_statement(g, node->children[2]);
+            if (!ir_terminador(g->atual)) emitir_jmp(g, fim);
+        }
+
+        selar_bloco(g, fim);
+        g->atual = fim;
+    }
+    else if (strcmp(node->node_type, "While-Statement") == 0) {
+        IrBloco *cabecalho = ir_novo_bloco(g->f);
+        IrBloco *corpo = ir_novo_bloco(g->f);
+        IrBloco *saida = ir_novo_bloco(g->f);
+
+        emitir_jmp(g, cabecalho);
+        if (g->entrada_osr && g->num_lacos == g->laco_osr) {
+            IrBloco *atual = g->atual;
+            g->atual = g->entrada_osr;
+            emitir_jmp(g, cabecalho);
+            g->atual = atual;
+        }
+        g->num_lacos++;
+        g->atual = cabecalho;
+        IrInstr *cond = gerar_expressao(g, node->children[0]);
+        emitir_br(g, cond, corpo, saida);
+
+        selar_bloco(g, corpo);
+        g->atual = corpo;
+        gerar_statement(g, node->children[1]);
+        if (!ir_terminador(g->atual)) emitir_jmp(g, cabecalho);
+
+        // O cabecalho so conhece todos os predecessores depois do corpo
+        selar_bloco(g, cabecalho);
+        selar_bloco(g, saida);
+        g->atual = saida;
+    }
+    else if (strcmp(node->node_type, "Return-Statement") == 0) {
+        IrInstr *ret = ir_nova_instr(g->f, IR_RET, IR_T_VOID);
+        if (node->num_children > 0) {
+            IrInstr *valor = gerar_expressao(g, node->children[0]);
+            if (g->f->retorna_int) ir_add_arg(ret, valor);
+        } else if (g->f->retorna_int) {
+            ir_add_arg(ret, emitir_const(g, 0));
+        }
+        emitir(g, ret);
+    }
+    // statement-vazio: nada a gerar
+}
+
+/* Declarações */
+
+/* Escalares declarados em qualquer bloco do corpo */
+static int contar_escalares(TreeNode *node) {
+    if (strcmp(node->node_type, "Var-declaracao") == 0) return node->num_children == 1;
+    int total = 0;
+    for (int i = 0; i < node->num_children; i++) total += contar_escalares(node->children[i]);
+    return total;
+}
+
+static void terminar_funcao(Gerador *g);
+
+/* Arrays declarados em qualquer bloco do corpo */
+static int contar_arrays(TreeNode *node) {
+    if (strcmp(node->node_type, "Var-declaracao") == 0) return node->num_children > 1;
+    int total = 0;
+    for (int i = 0; i < node->num_children; i++) total += contar_arrays(node->children[i]);
+    return total;
+}
+
+static void acrescentar_funcao(IrModulo *mod, IrFuncao *f) {
+    IrFuncao **fim = &mod->funcoes;
+    while (*fim) fim = &(*fim)->prox;
+    *fim = f;
+}
+
+static void gerar_funcao(Gerador *g, TreeNode *node) {
+    IrFuncao *f = ir_nova_funcao(node->value);
+    f->retorna_int = strcmp(node->children[0]->value, "int") == 0;
+
+    // params -> Param-lista -> params/params-lista
+    TreeNode *params = node->children[1];
+    TreeNode *lista = params->num_children > 0 ? params->children[0] : NULL;
+    int declarados = lista ? lista->num_children : 0;
+    int escondidos = 0;
+    for (int p = 0; g->verificar && p < declarados; p++) {
+        escondidos += strcmp(lista->children[p]->node_type, "params-lista") == 0;
+    }
+    f->num_params = declarados + escondidos;
+    f->param_array = (int*)calloc(f->num_params + 1, sizeof(int));
+    f->num_vars = declarados + contar_escalares(node->children[2]);
+    g->prox_var = 0;
+
+    // A funcao e visivel no proprio corpo (recursao)
+    acrescentar_funcao(g->mod, f);
+
+    g->f = f;
+    g->atual = ir_novo_bloco(f);
+    g->atual->selado = 1;
+    abrir_escopo(g);
+
+    int prox_escondido = declarados;
+    for (int p = 0; p < declarados; p++) {
+        TreeNode *param = lista->children[p];
+        int array = strcmp(param->node_type, "params-lista") == 0;
+        IrInstr *valor = ir_nova_instr(f, IR_PARAM, array ? IR_T_PTR : IR_T_INT);
+        valor->imm = p;
+        emitir(g, valor);
+        f->param_array[p] = array;
+        if (array) {
+            declarar(g, param->value, SIMB_PONTEIRO, 0, valor);
+            if (g->verificar) {
+                IrInstr *tamanho = ir_nova_instr(f, IR_PARAM, IR_T_INT);
+                tamanho->imm = prox_escondido++;
+                g->simbolos->tamanho = emitir(g, tamanho);
+            }
+        } else {
+            declarar(g, param->value, SIMB_VAR, g->prox_var, NULL);
+            escrever_variavel(g, g->prox_var++, g->atual, valor);
+        }
+    }
+
+    gerar_composto(g, node->children[2]);
+    terminar_funcao(g);
+}
+
+/* Retorno implícito, fim do escopo dos parâmetros e limpeza do SSA */
+static void terminar_funcao(Gerador *g) {
+    IrFuncao *f = g->f;
+    if (!ir_terminador(g->atual)) {
+        IrInstr *ret = ir_nova_instr(f, IR_RET, IR_T_VOID);
+        if (f->retorna_int) ir_add_arg(ret, emitir_const(g, 0));
+        emitir(g, ret);
+    }
+    fechar_escopo(g);
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        free(f->blocos[b]->defs);
+        free(f->blocos[b]->phis_incompletos);
+        f->blocos[b]->defs = NULL;
+        f->blocos[b]->phis_incompletos = NULL;
+    }
+    ir_resolver_substituicoes(f);
+    ir_calcular_cfg(f);
+    ir_remover_phis_triviais(f);
+}
+
+static void declarar_global(Gerador *g, TreeNode *node) {
+    int tamanho = node->num_children > 1 ? atoi(node->children[1]->value) : 0;
+    declarar(g, node->value, tamanho > 0 ? SIMB_ARRAY_GLOBAL : SIMB_GLOBAL, tamanho, NULL);
+}
+
+static void gerar_global(Gerador *g, TreeNode *node) {
+    IrGlobal *global = (IrGlobal*)calloc(1, sizeof(IrGlobal));
+    global->nome = node->value;
+    global->tamanho = node->num_children > 1 ? atoi(node->children[1]->value) : 0;
+
+    IrGlobal **fim = &g->mod->globais;
+    while (*fim) fim = &(*fim)->prox;
+    *fim = global;
+
+    declarar_global(g, node);
+}
+
+/*
+ * Traduz o programa inteiro (nó "Programa") para a IR. Erros de nomes são
+ * contados em mod->erros; nesse caso o módulo não deve ser usado.
+ */
+IrModulo* ir_gerar(TreeNode *raiz, int verificar_indices) {
+    Gerador g;
+    memset(&g, 0, sizeof(g));
+    g.mod = (IrModulo*)calloc(1, sizeof(IrModulo));
+    g.verificar = verificar_indices;
+
+    TreeNode *declaracoes = raiz->children[0];
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        TreeNode *decl = declaracoes->children[i];
+        if (strcmp(decl->node_type, "Fun-declaracao") == 0) gerar_funcao(&g, decl);
+        else gerar_global(&g, decl);
+    }
+
+    while (g.simbolos) {
+        Simbolo *s = g.simbolos;
+        g.simbolos = s->prox;
+        free(s);
+    }
+    return g.mod;
+}
+
+/*
+ * A variante começa num bloco de entrada que lê as variáveis do estado e
+ * salta para o cabeçalho do laço; o corpo da função é gerado como sempre a
+ * partir de um bloco sem predecessores, e o que só ele alcança some em
+ * ir_calcular_cfg().
+ */
+IrFuncao* ir_gerar_osr(IrModulo *mod, TreeNode *raiz, const char *funcao, int laco,
+                       const int *posicoes, const char *nome) {
+    Gerador g;
+    memset(&g, 0, sizeof(g));
+    g.mod = mod;
+
+    // só os globais declarados antes da função são visíveis nela
+    TreeNode *declaracoes = raiz->children[0];
+    TreeNode *node = NULL;
+    for (int i = 0; i < declaracoes->num_children && !node; i++) {
+        TreeNode *decl = declaracoes->children[i];
+        if (strcmp(decl->node_type, "Fun-declaracao") != 0) declarar_global(&g, decl);
+        else if (strcmp(decl->value, funcao) == 0) node = decl;
+    }
+    if (!node) {
+        fprintf(stderr, "ERRO INTERNO: funcao %s inexistente\n", funcao);
+        exit(1);
+    }
+
+    IrFuncao *f = ir_nova_funcao(nome);
+    f->retorna_int = strcmp(node->children[0]->value, "int") == 0;
+    TreeNode *params = node->children[1];
+    TreeNode *lista = params->num_children > 0 ? params->children[0] : NULL;
+    int num_params = lista ? lista->num_children : 0;
+    int num_arrays = contar_arrays(node->children[2]);
+    int escalares = 0;
+    for (int p = 0; p < num_params; p++) {
+        escalares += strcmp(lista->children[p]->node_type, "params-lista") != 0;
+    }
+    f->num_params = 1 + (num_params - escalares) + num_arrays;
+    f->param_array = (int*)calloc(f->num_params + 1, sizeof(int));
+    for (int p = 0; p < f->num_params; p++) f->param_array[p] = 1;
+    f->num_vars = escalares + contar_escalares(node->children[2]);
+    acrescentar_funcao(mod, f);
+
+    g.f = f;
+    g.atual = ir_novo_bloco(f);
+    g.atual->selado = 1;
+    g.entrada_osr = g.atual;
+    g.laco_osr = laco;
+    abrir_escopo(&g);
+
+    IrInstr **ponteiros = (IrInstr**)malloc(sizeof(IrInstr*) * f->num_params);
+    for (int p = 0; p < f->num_params; p++) {
+        ponteiros[p] = ir_nova_instr(f, IR_PARAM, IR_T_PTR);
+        ponteiros[p]->imm = p;
+        emitir(&g, ponteiros[p]);
+    }
+    for (int v = 0; v < f->num_vars; v++) {
+        IrInstr *ld = ir_nova_instr(f, IR_LOAD, IR_T_INT);
+        ir_add_arg(ld, ponteiros[0]);
+        ir_add_arg(ld, emitir_const(&g, posicoes[v]));
+        escrever_variavel(&g, v, g.entrada_osr, emitir(&g, ld));
+    }
+    g.arrays_osr = ponteiros + 1 + (num_params - escalares);
+
+    g.atual = ir_novo_bloco(f);
+    g.atual->selado = 1;
+    int prox_ponteiro = 1;
+    for (int p = 0; p < num_params; p++) {
+        TreeNode *param = lista->children[p];
+        if (strcmp(param->node_type, "params-lista") == 0) {
+            declarar(&g, param->value, SIMB_PONTEIRO, 0, ponteiros[prox_ponteiro++]);
+        } else {
+            declarar(&g, param->value, SIMB_VAR, g.prox_var++, NULL);
+        }
+    }
+
+    gerar_composto(&g, node->children[2]);
+    if (!ir_terminador(g.entrada_osr)) {
+        fprintf(stderr, "ERRO INTERNO: laco %d inexistente em %s\n", laco, funcao);
+        exit(1);
+    }
+    terminar_funcao(&g);
+
+    free(ponteiros);
+    while (g.simbolos) {
+        Simbolo *s = g.simbolos;
+        g.simbolos = s->prox;
+        free(s);
+    }
+    return f;
+}
@@ -0,0 +1,157 @@
+/***********************************************/
+/* Grafo de chamadas                           */
+/* Construído a partir dos nós Function-Call   */
+/* de cada Fun-declaracao e dos registros de   */
+/* função da tabela de símbolos                */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tree.h"
+#include "semantico.h"
+#include "ir.h"
+#include "otimizador.h"
+
+static NoChamadas* buscar_no(GrafoChamadas *g, const char *nome) {
+    for (int i = 0; i < g->num; i++) {
+        if (strcmp(g->nos[i]->nome, nome) == 0) return g->nos[i];
+    }
+    return NULL;
+}
+
+static void add_chamado(NoChamadas *no, NoChamadas *chamado) {
+    for (int i = 0; i < no->num_chamados; i++) {
+        if (no->chamados[i] == chamado) return;
+    }
+    no->chamados = (NoChamadas**)realloc(no->chamados, sizeof(NoChamadas*) * (no->num_chamados + 1));
+    no->chamados[no->num_chamados++] = chamado;
+}
+
+/* Percorre o corpo procurando chamadas a funções do programa */
+static void coletar_chamadas(GrafoChamadas *g, NoChamadas *no, TreeNode *node) {
+    if (strcmp(node->node_type, "Function-Call") == 0) {
+        NoChamadas *chamado = buscar_no(g, node->value);
+        if (chamado) {
+            add_chamado(no, chamado);
+            chamado->num_sites++;
+        } else {
+            // input/output nao sao nos do grafo
+            no->chama_builtin = 1;
+        }
+    }
+    for (int i = 0; i < node->num_children; i++) {
+        coletar_chamadas(g, no, node->children[i]);
+    }
+}
+
+/* Componentes fortemente conexas (Tarjan): saem de baixo para cima */
+typedef struct {
+    GrafoChamadas *g;
+    NoChamadas **pilha;
+    int topo;
+    int indice;
+    int num_ordem;
+    int num_scc;
+} Tarjan;
+
+static void visitar(Tarjan *t, NoChamadas *no) {
+    no->indice = no->menor = t->indice++;
+    no->na_pilha = 1;
+    t->pilha[t->topo++] = no;
+
+    for (int i = 0; i < no->num_chamados; i++) {
+        NoChamadas *w = no->chamados[i];
+        if (w->indice < 0) {
+            visitar(t, w);
+            if (w->menor < no->menor) no->menor = w->menor;
+        } else if (w->na_pilha && w->indice < no->menor) {
+            no->menor = w->indice;
+        }
+    }
+
+    if (no->menor == no->indice) {
+        NoChamadas *w;
+        do {
+            w = t->pilha[--t->topo];
+            w->na_pilha = 0;
+            w->scc = t->num_scc;
+            t->g->ordem[t->num_ordem++] = w;
+        } while (w != no);
+        t->num_scc++;
+    }
+}
+
+/*
+ * Monta o grafo de chamadas do programa (depois da análise semântica). A
+ * ordem de baixo para cima coloca cada função depois de todas as que ela
+ * chama, exceto dentro de um ciclo de recursão.
+ */
+GrafoChamadas* grafo_chamadas_construir(TreeNode *raiz) {
+    GrafoChamadas *g = (GrafoChamadas*)calloc(1, sizeof(GrafoChamadas));
+    TreeNode *declaracoes = raiz->children[0];
+
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        TreeNode *decl = declaracoes->children[i];
+        if (strcmp(decl->node_type, "Fun-declaracao") != 0) continue;
+
+        NoChamadas *no = (NoChamadas*)calloc(1, sizeof(NoChamadas));
+        no->nome = decl->value;
+        no->declaracao = decl;
+        no->simbolo = lookup_symbol(decl->value, 0);
+        no->indice = -1;
+
+        // params -> Param-lista -> params/params-lista
+        TreeNode *params = decl->children[1];
+        TreeNode *lista = params->num_children > 0 ? params->children[0] : NULL;
+        for (int p = 0; lista && p < lista->num_children; p++) {
+            if (strcmp(lista->children[p]->node_type, "params-lista") == 0) no->num_params_array++;
+        }
+
+        g->nos = (NoChamadas**)realloc(g->nos, sizeof(NoChamadas*) * (g->num + 1));
+        g->nos[g->num++] = no;
+    }
+
+    for (int i = 0; i < g->num; i++) {
+        coletar_chamadas(g, g->nos[i], g->nos[i]->declaracao->children[2]);
+    }
+
+    Tarjan t;
+    memset(&t, 0, sizeof(t));
+    t.g = g;
+    t.pilha = (NoChamadas**)malloc(sizeof(NoChamadas*) * (g->num + 1));
+    g->ordem = (NoChamadas**)malloc(sizeof(NoChamadas*) * (g->num + 1));
+    for (int i = 0; i < g->num; i++) {
+        if (g->nos[i]->indice < 0) visitar(&t, g->nos[i]);
+    }
+    free(t.pilha);
+
+    for (int i = 0; i < g->num; i++) {
+        NoChamadas *no = g->nos[i];
+        for (int k = 0; k < no->num_chamados; k++) {
+            if (no->chamados[k]->scc == no->scc) no->recursiva = 1;
+        }
+    }
+    return g;
+}
+
+NoChamadas* grafo_chamadas_buscar(GrafoChamadas *g, const char *nome) {
+    return buscar_no(g, nome);
+}
+
+/* Função que não chama nenhuma outra do programa (só input/output) */
+int grafo_chamadas_eh_folha(NoChamadas *no) {
+    return no->num_chamados == 0;
+}
+
+void grafo_chamadas_imprimir(GrafoChamadas *g, FILE *saida) {
+    for (int i = 0; i < g->num; i++) {
+        NoChamadas *no = g->ordem[i];
+        fprintf(saida, "[grafo] %s (%d parametros, %d arrays%s%s):", no->nome,
+                no->simbolo ? no->simbolo->num_params : 0, no->num_params_array,
+                no->recursiva ? ", recursiva" : "",
+                grafo_chamadas_eh_folha(no) ? ", folha" : "");
+        for (int k = 0; k < no->num_chamados; k++) fprintf(saida, " %s", no->chamados[k]->nome);
+        fprintf(saida, "\n");
+    }
+}
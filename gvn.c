@@ -0,0 +1,433 @@
+/***********************************************/
+/* Numeração global de valores (GVN)           */
+/* Elimina cálculos redundantes percorrendo a  */
+/* árvore de dominadores com uma tabela hash   */
+/* com escopo, incluindo loads de arrays e     */
+/* globais sem escrita no caminho              */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "ir.h"
+#include "otimizador.h"
+
+#define TAM_TABELA 1024
+
+typedef struct Entrada {
+    IrOp op;
+    int imm;
+    const char *nome;
+    int a, b;
+    int versao;
+    IrInstr *valor;
+    struct Entrada *prox;
+} Entrada;
+
+typedef struct {
+    IrFuncao *f;
+    MemoriaIr mem;
+    char *escritas;
+    int contador_versao;
+    int **versao_fim;       /* estado da memória no fim de cada bloco */
+    char **mata;            /* classes escritas por cada bloco */
+    IrBloco ***filhos;      /* árvore de dominadores */
+    int *num_filhos;
+
+    Entrada *tabela[TAM_TABELA];
+    Entrada **pilha;
+    int topo;
+    int cap_pilha;
+} Gvn;
+
+/*
+ * Aplica o efeito de uma instrução sobre as versões da memória: cada classe
+ * escrita recebe uma versão nova.
+ */
+static void aplicar_efeito(Gvn *g, IrInstr *i, int *versao) {
+    if (!memoria_escritas(&g->mem, i, g->escritas)) return;
+    for (int c = 0; c < g->mem.num_classes; c++) {
+        if (g->escritas[c]) versao[c] = ++g->contador_versao;
+    }
+}
+
+/* Tabela hash com escopo */
+
+static unsigned hash_chave(IrOp op, int imm, const char *nome, int a, int b, int versao) {
+    unsigned h = (unsigned)op * 31u + (unsigned)imm;
+    h = h * 31u + (unsigned)a;
+    h = h * 31u + (unsigned)b;
+    h = h * 31u + (unsigned)versao;
+    if (nome) {
+        for (const char *c = nome; *c; c++) h = h * 31u + (unsigned char)*c;
+    }
+    return h % TAM_TABELA;
+}
+
+static IrInstr* buscar_chave(Gvn *g, IrOp op, int imm, const char *nome, int a, int b, int versao) {
+    unsigned h = hash_chave(op, imm, nome, a, b, versao);
+    for (Entrada *e = g->tabela[h]; e; e = e->prox) {
+        if (e->op == op && e->imm == imm && e->a == a && e->b == b && e->versao == versao &&
+            (e->nome == nome || (e->nome && nome && strcmp(e->nome, nome) == 0))) {
+            return e->valor;
+        }
+    }
+    return NULL;
+}
+
+static void inserir_chave(Gvn *g, IrOp op, int imm, const char *nome, int a, int b, int versao,
+                          IrInstr *valor) {
+    unsigned h = hash_chave(op, imm, nome, a, b, versao);
+    Entrada *e = (Entrada*)malloc(sizeof(Entrada));
+    e->op = op;
+    e->imm = imm;
+    e->nome = nome;
+    e->a = a;
+    e->b = b;
+    e->versao = versao;
+    e->valor = valor;
+    e->prox = g->tabela[h];
+    g->tabela[h] = e;
+
+    if (g->topo == g->cap_pilha) {
+        g->cap_pilha = g->cap_pilha ? g->cap_pilha * 2 : 64;
+        g->pilha = (Entrada**)realloc(g->pilha, sizeof(Entrada*) * g->cap_pilha);
+    }
+    g->pilha[g->topo++] = e;
+}
+
+/* Entradas são removidas na ordem inversa, sempre da cabeça da lista */
+static void fechar_escopo(Gvn *g, int topo) {
+    while (g->topo > topo) {
+        Entrada *e = g->pilha[--g->topo];
+        unsigned h = hash_chave(e->op, e->imm, e->nome, e->a, e->b, e->versao);
+        g->tabela[h] = e->prox;
+        free(e);
+    }
+}
+
+/* Simplificações algébricas e dobramento de constantes */
+
+static int eh_comutativa(IrOp op) {
+    return op == IR_ADD || op == IR_MUL || op == IR_EQ || op == IR_NE;
+}
+
+int ir_dobrar_constantes(IrOp op, int a, int b, int *resultado) {
+    switch (op) {
+        case IR_ADD: *resultado = (int)((unsigned)a + (unsigned)b); return 1;
+        case IR_SUB: *resultado = (int)((unsigned)a - (unsigned)b); return 1;
+        case IR_MUL: *resultado = (int)((unsigned)a * (unsigned)b); return 1;
+        case IR_DIV:
+            if (b == 0 || (a == INT_MIN && b == -1)) return 0;
+            *resultado = a / b;
+            return 1;
+        case IR_REM:
+            if (b == 0 || (a == INT_MIN && b == -1)) return 0;
+            *resultado = a % b;
+            return 1;
+        case IR_LT: *resultado = a < b; return 1;
+        case IR_LE: *resultado = a <= b; return 1;
+        case IR_GT: *resultado = a > b; return 1;
+        case IR_GE: *resultado = a >= b; return 1;
+        case IR_EQ: *resultado = a == b; return 1;
+        case IR_NE: *resultado = a != b; return 1;
+        default: return 0;
+    }
+}
+
+/* Constante já numerada ou nova, inserida antes de 'pos' */
+static IrInstr* constante(Gvn *g, IrInstr *pos, int valor) {
+    IrInstr *c = buscar_chave(g, IR_CONST, valor, NULL, 0, 0, 0);
+    if (c) return c;
+    c = ir_nova_instr(g->f, IR_CONST, IR_T_INT);
+    c->imm = valor;
+    ir_inserir_antes(pos, c);
+    inserir_chave(g, IR_CONST, valor, NULL, 0, 0, 0, c);
+    return c;
+}
+
+/*
+ * Tenta reduzir uma operação binária a um valor já existente ou a uma
+ * constante. Retorna NULL se não houver simplificação.
+ */
+static IrInstr* simplificar(Gvn *g, IrInstr *i) {
+    IrInstr *a = i->args[0], *b = i->args[1];
+    int r;
+
+    if (a->op == IR_CONST && b->op == IR_CONST && ir_dobrar_constantes(i->op, a->imm, b->imm, &r)) {
+        return constante(g, i, r);
+    }
+    switch (i->op) {
+        case IR_ADD:
+            if (ir_eh_const(b, 0)) return a;
+            if (ir_eh_const(a, 0)) return b;
+            break;
+        case IR_SUB:
+            if (ir_eh_const(b, 0)) return a;
+            if (a == b) return constante(g, i, 0);
+            break;
+        case IR_MUL:
+            if (ir_eh_const(b, 1)) return a;
+            if (ir_eh_const(a, 1)) return b;
+            if (ir_eh_const(a, 0) || ir_eh_const(b, 0)) return constante(g, i, 0);
+            break;
+        case IR_DIV:
+            if (ir_eh_const(b, 1)) return a;
+            break;
+        case IR_REM:
+            if (ir_eh_const(b, 1)) return constante(g, i, 0);
+            break;
+        case IR_EQ: case IR_LE: case IR_GE:
+            if (a == b) return constante(g, i, 1);
+            break;
+        case IR_NE: case IR_LT: case IR_GT:
+            if (a == b) return constante(g, i, 0);
+            break;
+        default:
+            break;
+    }
+    return NULL;
+}
+
+/*
+ * Processa as instruções de um bloco. 'versao' é o estado da memória na
+ * entrada e é atualizado até o fim do bloco.
+ */
+static void numerar_bloco(Gvn *g, IrBloco *bloco, int *versao) {
+    IrInstr *i = bloco->primeiro;
+    while (i) {
+        IrInstr *prox = i->prox;
+        for (int a = 0; a < i->num_args; a++) i->args[a] = ir_valor(i->args[a]);
+
+        IrInstr *igual = NULL;
+        switch (i->op) {
+            case IR_CONST:
+                igual = buscar_chave(g, IR_CONST, i->imm, NULL, 0, 0, 0);
+                if (!igual) inserir_chave(g, IR_CONST, i->imm, NULL, 0, 0, 0, i);
+                break;
+
+            case IR_ENDERECO:
+                igual = buscar_chave(g, IR_ENDERECO, i->imm, i->nome, 0, 0, 0);
+                if (!igual) inserir_chave(g, IR_ENDERECO, i->imm, i->nome, 0, 0, 0, i);
+                break;
+
+            case IR_PHI: {
+                // phi com todos os argumentos iguais, ou igual a outro phi do bloco
+                int trivial = 1;
+                IrInstr *unico = NULL;
+                for (int a = 0; a < i->num_args; a++) {
+                    if (i->args[a] == i || i->args[a] == unico) continue;
+                    if (unico) trivial = 0;
+                    unico = i->args[a];
+                }
+                if (trivial && unico) {
+                    igual = unico;
+                    break;
+                }
+                for (IrInstr *p = bloco->primeiro; p != i; p = p->prox) {
+                    if (p->num_args != i->num_args) continue;
+                    int mesmo = 1;
+                    for (int a = 0; a < i->num_args && mesmo; a++) {
+                        mesmo = ir_valor(p->args[a]) == i->args[a] && p->origens[a] == i->origens[a];
+                    }
+                    if (mesmo) {
+                        igual = p;
+                        break;
+                    }
+                }
+                break;
+            }
+
+            case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_REM:
+            case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+            case IR_EQ: case IR_NE: {
+                igual = simplificar(g, i);
+                if (igual) break;
+                IrOp op = i->op;
+                int a = i->args[0]->id, b = i->args[1]->id;
+                if (eh_comutativa(op) && a > b) {
+                    int t = a; a = b; b = t;
+                }
+                // a > b equivale a b < a
+                if (op == IR_GT || op == IR_GE) {
+                    int t = a; a = b; b = t;
+                    op = op == IR_GT ? IR_LT : IR_LE;
+                }
+                igual = buscar_chave(g, op, 0, NULL, a, b, 0);
+                if (!igual) inserir_chave(g, op, 0, NULL, a, b, 0, i);
+                break;
+            }
+
+            case IR_ESCOLHA:
+                // condição constante ou os dois lados iguais
+                if (i->args[0]->op == IR_CONST) igual = i->args[0]->imm ? i->args[1] : i->args[2];
+                else if (i->args[1] == i->args[2]) igual = i->args[1];
+                break;
+
+            case IR_LOAD: {
+                int v = versao[memoria_classe_base(&g->mem, i->args[0])];
+                igual = buscar_chave(g, IR_LOAD, 0, NULL, i->args[0]->id, i->args[1]->id, v);
+                if (!igual) inserir_chave(g, IR_LOAD, 0, NULL, i->args[0]->id, i->args[1]->id, v, i);
+                break;
+            }
+
+            case IR_LOADG: {
+                int v = versao[memoria_classe_global(&g->mem, i->nome, 0)];
+                igual = buscar_chave(g, IR_LOADG, 0, i->nome, 0, 0, v);
+                if (!igual) inserir_chave(g, IR_LOADG, 0, i->nome, 0, 0, v, i);
+                break;
+            }
+
+            case IR_STORE: {
+                // um load seguinte do mesmo elemento recebe o valor escrito
+                aplicar_efeito(g, i, versao);
+                int v = versao[memoria_classe_base(&g->mem, i->args[0])];
+                inserir_chave(g, IR_LOAD, 0, NULL, i->args[0]->id, i->args[1]->id, v, i->args[2]);
+                break;
+            }
+
+            case IR_STOREG: {
+                aplicar_efeito(g, i, versao);
+                int v = versao[memoria_classe_global(&g->mem, i->nome, 0)];
+                inserir_chave(g, IR_LOADG, 0, i->nome, 0, 0, v, i->args[0]);
+                break;
+            }
+
+            case IR_CALL:
+                aplicar_efeito(g, i, versao);
+                break;
+
+            default:
+                break;
+        }
+
+        if (igual && igual != i) ir_substituir(i, igual);
+        i = prox;
+    }
+}
+
+/*
+ * Marca os blocos que podem executar entre o fim do dominador imediato e a
+ * entrada de 'bloco': busca para trás a partir dos predecessores, parando
+ * no dominador.
+ */
+static void marcar_regiao(Gvn *g, IrBloco *bloco, char *na_regiao) {
+    IrFuncao *f = g->f;
+    IrBloco **pilha = (IrBloco**)malloc(sizeof(IrBloco*) * (f->num_blocos + 1));
+    int topo = 0;
+
+    memset(na_regiao, 0, f->num_blocos);
+    for (int p = 0; p < bloco->num_preds; p++) {
+        IrBloco *pred = bloco->preds[p];
+        if (pred != bloco->idom && !na_regiao[pred->ordem]) {
+            na_regiao[pred->ordem] = 1;
+            pilha[topo++] = pred;
+        }
+    }
+    while (topo > 0) {
+        IrBloco *b = pilha[--topo];
+        for (int p = 0; p < b->num_preds; p++) {
+            IrBloco *pred = b->preds[p];
+            if (pred != bloco->idom && !na_regiao[pred->ordem]) {
+                na_regiao[pred->ordem] = 1;
+                pilha[topo++] = pred;
+            }
+        }
+    }
+    free(pilha);
+}
+
+static void estado_entrada(Gvn *g, IrBloco *bloco, int *versao) {
+    MemoriaIr *mem = &g->mem;
+    IrFuncao *f = g->f;
+
+    if (!bloco->idom) {
+        for (int c = 0; c < mem->num_classes; c++) versao[c] = ++g->contador_versao;
+        return;
+    }
+    memcpy(versao, g->versao_fim[bloco->idom->ordem], sizeof(int) * mem->num_classes);
+    if (bloco->num_preds == 1 && bloco->preds[0] == bloco->idom) return;
+
+    char *na_regiao = (char*)malloc(f->num_blocos + 1);
+    marcar_regiao(g, bloco, na_regiao);
+    for (int b = 0; b < f->num_blocos; b++) {
+        if (!na_regiao[b]) continue;
+        for (int c = 0; c < mem->num_classes; c++) {
+            if (g->mata[b][c]) versao[c] = ++g->contador_versao;
+        }
+    }
+    free(na_regiao);
+}
+
+static void percorrer(Gvn *g, IrBloco *bloco) {
+    int topo = g->topo;
+    int *versao = g->versao_fim[bloco->ordem];
+
+    estado_entrada(g, bloco, versao);
+    numerar_bloco(g, bloco, versao);
+    for (int k = 0; k < g->num_filhos[bloco->ordem]; k++) {
+        percorrer(g, g->filhos[bloco->ordem][k]);
+    }
+    fechar_escopo(g, topo);
+}
+
+/*
+ * Numeração global de valores sobre uma função. Retorna quantas instruções
+ * a função perdeu (redundâncias eliminadas e código que ficou morto).
+ */
+int otimizar_gvn(IrFuncao *f) {
+    Gvn g;
+    memset(&g, 0, sizeof(g));
+    g.f = f;
+
+    ir_calcular_cfg(f);
+    int antes = ir_num_instrucoes(f);
+    memoria_preparar(&g.mem, f);
+    g.escritas = (char*)malloc(g.mem.num_classes + 1);
+
+    int n = f->num_blocos;
+    g.versao_fim = (int**)malloc(sizeof(int*) * n);
+    g.mata = (char**)malloc(sizeof(char*) * n);
+    g.filhos = (IrBloco***)calloc(n, sizeof(IrBloco**));
+    g.num_filhos = (int*)calloc(n, sizeof(int));
+
+    int *tmp = (int*)calloc(g.mem.num_classes, sizeof(int));
+    for (int b = 0; b < n; b++) {
+        IrBloco *bloco = f->blocos[b];
+        g.versao_fim[b] = (int*)calloc(g.mem.num_classes, sizeof(int));
+        g.mata[b] = (char*)calloc(g.mem.num_classes, 1);
+
+        memset(tmp, 0, sizeof(int) * g.mem.num_classes);
+        for (IrInstr *i = bloco->primeiro; i; i = i->prox) aplicar_efeito(&g, i, tmp);
+        for (int c = 0; c < g.mem.num_classes; c++) g.mata[b][c] = tmp[c] != 0;
+
+        if (bloco->idom) {
+            int p = bloco->idom->ordem;
+            g.filhos[p] = (IrBloco**)realloc(g.filhos[p], sizeof(IrBloco*) * (g.num_filhos[p] + 1));
+            g.filhos[p][g.num_filhos[p]++] = bloco;
+        }
+    }
+    free(tmp);
+
+    percorrer(&g, f->blocos[0]);
+
+    ir_resolver_substituicoes(f);
+    ir_remover_phis_triviais(f);
+    ir_eliminar_codigo_morto(f);
+
+    for (int b = 0; b < n; b++) {
+        free(g.versao_fim[b]);
+        free(g.mata[b]);
+        free(g.filhos[b]);
+    }
+    free(g.versao_fim);
+    free(g.mata);
+    free(g.filhos);
+    free(g.num_filhos);
+    free(g.pilha);
+    free(g.escritas);
+    memoria_liberar(&g.mem);
+
+    return antes - ir_num_instrucoes(f);
+}
@@ -0,0 +1,89 @@
+/***********************************************/
+/* Reconhecimento de idiomas                   */
+/* C- não tem operador de resto: programas     */
+/* escrevem a - a/b*b. O passe troca a divisão,*/
+/* a multiplicação e a subtração por um único  */
+/* IR_REM, que o gerador de código associa à   */
+/* mesma divisão de hardware do quociente      */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+
+/* Profundidade máxima na comparação estrutural de expressões */
+#define PROFUNDIDADE_MAXIMA 8
+
+static int eh_comutativa(IrOp op) {
+    return op == IR_ADD || op == IR_MUL || op == IR_EQ || op == IR_NE;
+}
+
+/*
+ * Duas expressões puras calculam o mesmo valor: mesmo valor SSA, ou mesma
+ * operação aritmética sobre operandos iguais. Loads e chamadas só são
+ * iguais quando são a mesma instrução.
+ */
+static int mesma_expressao(IrInstr *a, IrInstr *b, int profundidade) {
+    a = ir_valor(a);
+    b = ir_valor(b);
+    if (a == b) return 1;
+    if (profundidade == 0 || a->op != b->op) return 0;
+
+    switch (a->op) {
+        case IR_CONST:
+            return a->imm == b->imm;
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_REM:
+        case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_EQ: case IR_NE:
+            if (mesma_expressao(a->args[0], b->args[0], profundidade - 1) &&
+                mesma_expressao(a->args[1], b->args[1], profundidade - 1)) {
+                return 1;
+            }
+            return eh_comutativa(a->op) &&
+                   mesma_expressao(a->args[0], b->args[1], profundidade - 1) &&
+                   mesma_expressao(a->args[1], b->args[0], profundidade - 1);
+        default:
+            return 0;
+    }
+}
+
+/*
+ * Se 'sub' tem a forma a - (a/b)*b ou a - b*(a/b), transforma a subtração
+ * em a % b usando os operandos da própria divisão.
+ */
+static int reescrever_resto(IrInstr *sub) {
+    IrInstr *a = ir_valor(sub->args[0]);
+    IrInstr *mul = ir_valor(sub->args[1]);
+    if (mul->op != IR_MUL) return 0;
+
+    for (int k = 0; k < 2; k++) {
+        IrInstr *div = ir_valor(mul->args[k]);
+        IrInstr *b = mul->args[1 - k];
+        if (div->op != IR_DIV) continue;
+        if (!mesma_expressao(div->args[0], a, PROFUNDIDADE_MAXIMA)) continue;
+        if (!mesma_expressao(div->args[1], b, PROFUNDIDADE_MAXIMA)) continue;
+
+        sub->op = IR_REM;
+        sub->args[0] = ir_valor(div->args[0]);
+        sub->args[1] = ir_valor(div->args[1]);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Reescreve todos os restos da função. A divisão e a multiplicação somem
+ * quando não têm outros usos. Retorna quantos restos foram reconhecidos.
+ */
+int otimizar_idiomas(IrFuncao *f) {
+    int restos = 0;
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            if (i->op == IR_SUB) restos += reescrever_resto(i);
+        }
+    }
+    if (restos > 0) ir_eliminar_codigo_morto(f);
+    return restos;
+}
@@ -0,0 +1,199 @@
+/***********************************************/
+/* Expansão de chamadas (inline)               */
+/* Copia o corpo do chamado para o chamador    */
+/* quando o modelo de custo aceita; as funções */
+/* são visitadas de baixo para cima no grafo   */
+/* de chamadas                                 */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+
+/* Ainda chama alguma função da própria componente do grafo */
+static int ainda_recursiva(IrFuncao *g, GrafoChamadas *grafo) {
+    NoChamadas *no = grafo_chamadas_buscar(grafo, g->nome);
+    for (int b = 0; b < g->num_blocos; b++) {
+        for (IrInstr *i = g->blocos[b]->primeiro; i; i = i->prox) {
+            if (i->op != IR_CALL || ir_eh_builtin(i->nome)) continue;
+            NoChamadas *chamado = grafo_chamadas_buscar(grafo, i->nome);
+            if (!chamado || !no || chamado->scc == no->scc) return 1;
+        }
+    }
+    return 0;
+}
+
+/* Depois das próprias expansões, não chama nenhuma função do programa */
+static int eh_folha(IrFuncao *g) {
+    for (int b = 0; b < g->num_blocos; b++) {
+        for (IrInstr *i = g->blocos[b]->primeiro; i; i = i->prox) {
+            if (i->op == IR_CALL && !ir_eh_builtin(i->nome)) return 0;
+        }
+    }
+    return 1;
+}
+
+static int custo_chamada(IrInstr *call, IrFuncao *g, NoChamadas *no, CustoInline *c) {
+    int custo = ir_num_instrucoes(g) - c->bonus_chamada;
+    for (int a = 0; a < call->num_args && a < g->num_params; a++) {
+        IrInstr *arg = ir_valor(call->args[a]);
+        if (arg->op == IR_CONST) custo -= c->bonus_constante;
+        if (no->num_params_array > 0 && g->param_array[a] && arg->op == IR_ENDERECO) {
+            custo -= c->bonus_array;
+        }
+    }
+    return custo;
+}
+
+/*
+ * Copia o corpo de g no lugar da chamada. O bloco da chamada é dividido: o
+ * que vem depois dela vai para um bloco de continuação, os parâmetros viram
+ * os argumentos e cada ret vira um desvio para a continuação (com um phi
+ * juntando os valores de retorno). g não tem arrays locais.
+ */
+static void expandir(IrFuncao *f, IrInstr *call, IrFuncao *g) {
+    IrBloco *bloco = call->bloco;
+    IrBloco *cont = ir_novo_bloco(f);
+
+    IrInstr *i = call->prox;
+    while (i) {
+        IrInstr *prox = i->prox;
+        ir_remover(i);
+        ir_inserir_fim(cont, i);
+        i = prox;
+    }
+    IrInstr *term = ir_terminador(cont);
+    for (int k = 0; term && k < term->num_alvos; k++) {
+        ir_trocar_origem_phis(term->alvos[k], bloco, cont);
+    }
+
+    IrBloco **blocos = (IrBloco**)malloc(sizeof(IrBloco*) * (g->num_blocos + 1));
+    IrInstr **mapa = (IrInstr**)calloc(g->prox_valor + 1, sizeof(IrInstr*));
+    for (int b = 0; b < g->num_blocos; b++) {
+        g->blocos[b]->aux = b;
+        blocos[b] = ir_novo_bloco(f);
+    }
+
+    IrInstr *retorno = NULL;
+    int num_rets = 0;
+    if (g->retorna_int) {
+        retorno = ir_nova_instr(f, IR_PHI, IR_T_INT);
+        ir_inserir_inicio(cont, retorno);
+    }
+
+    // primeira passada: cria as cópias (phis podem usar valores de adiante)
+    for (int b = 0; b < g->num_blocos; b++) {
+        for (i = g->blocos[b]->primeiro; i; i = i->prox) {
+            if (i->op == IR_PARAM) {
+                mapa[i->id] = ir_valor(call->args[i->imm]);
+                continue;
+            }
+            IrInstr *novo;
+            if (i->op == IR_RET) {
+                novo = ir_nova_instr(f, IR_JMP, IR_T_VOID);
+                ir_add_alvo(novo, cont);
+                num_rets++;
+            } else {
+                novo = ir_nova_instr(f, i->op, i->tipo);
+                novo->imm = i->imm;
+                novo->nome = i->nome;
+                novo->flags = i->flags & ~IR_FLAG_CAUDA;
+                for (int k = 0; k < i->num_alvos; k++) {
+                    ir_add_alvo(novo, blocos[i->alvos[k]->aux]);
+                }
+            }
+            ir_inserir_fim(blocos[b], novo);
+            mapa[i->id] = novo;
+        }
+    }
+
+    // segunda passada: operandos
+    for (int b = 0; b < g->num_blocos; b++) {
+        for (i = g->blocos[b]->primeiro; i; i = i->prox) {
+            if (i->op == IR_PARAM) continue;
+            if (i->op == IR_RET) {
+                if (retorno && i->num_args > 0) {
+                    ir_add_phi_arg(retorno, mapa[ir_valor(i->args[0])->id], blocos[b]);
+                }
+                continue;
+            }
+            IrInstr *novo = mapa[i->id];
+            for (int a = 0; a < i->num_args; a++) {
+                IrInstr *arg = mapa[ir_valor(i->args[a])->id];
+                if (i->op == IR_PHI) ir_add_phi_arg(novo, arg, blocos[i->origens[a]->aux]);
+                else ir_add_arg(novo, arg);
+            }
+        }
+    }
+
+    ir_remover(call);
+    IrInstr *jmp = ir_nova_instr(f, IR_JMP, IR_T_VOID);
+    ir_add_alvo(jmp, blocos[0]);
+    ir_inserir_fim(bloco, jmp);
+
+    // uma função void usada como valor já produz a própria constante 0
+    if (retorno && retorno->num_args == 1 && num_rets == 1) {
+        ir_substituir(retorno, retorno->args[0]);
+        ir_substituir(call, retorno->args[0]);
+    } else if (retorno) {
+        ir_substituir(call, retorno);
+    }
+
+    free(blocos);
+    free(mapa);
+}
+
+/*
+ * Expande as chamadas de f aceitas pelo modelo de custo. Os chamados já
+ * foram otimizados (ordem de baixo para cima), então o tamanho usado é o
+ * final. Não expande chamadas que ainda são recursivas nem funções com
+ * arrays locais (que começam zerados a cada chamada).
+ */
+int otimizar_inline(IrModulo *mod, GrafoChamadas *grafo, IrFuncao *f,
+                    CustoInline *custo, FILE *relatorio) {
+    NoChamadas *no_f = grafo_chamadas_buscar(grafo, f->nome);
+    IrInstr **chamadas = NULL;
+    int num = 0, expandidas = 0;
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            if (i->op != IR_CALL || ir_eh_builtin(i->nome)) continue;
+            chamadas = (IrInstr**)realloc(chamadas, sizeof(IrInstr*) * (num + 1));
+            chamadas[num++] = i;
+        }
+    }
+
+    int tamanho = ir_num_instrucoes(f);
+    for (int c = 0; c < num; c++) {
+        IrInstr *call = chamadas[c];
+        IrFuncao *g = ir_buscar_funcao(mod, call->nome);
+        NoChamadas *no = grafo_chamadas_buscar(grafo, call->nome);
+        if (!g || !no || g == f || g->num_arrays_locais > 0) continue;
+        if (no_f && no->scc == no_f->scc) continue;
+        if (call->num_args != g->num_params || ainda_recursiva(g, grafo)) continue;
+
+        int tamanho_g = ir_num_instrucoes(g);
+        int valor = custo_chamada(call, g, no, custo);
+        int folha = eh_folha(g) && tamanho_g <= custo->limite_folha;
+        if (!folha && valor > custo->limite) continue;
+        if (tamanho + tamanho_g > custo->tamanho_maximo) continue;
+
+        expandir(f, call, g);
+        tamanho += tamanho_g;
+        expandidas++;
+        if (relatorio) {
+            fprintf(relatorio, "[inline] %s: chamada a %s expandida (custo %d%s)\n",
+                    f->nome, g->nome, valor, folha ? ", folha" : "");
+        }
+    }
+    free(chamadas);
+
+    if (expandidas > 0) {
+        ir_resolver_substituicoes(f);
+        ir_calcular_cfg(f);
+        ir_remover_phis_triviais(f);
+    }
+    return expandidas;
+}
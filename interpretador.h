@@ -0,0 +1,53 @@
+#ifndef INTERPRETADOR_H
+#define INTERPRETADOR_H
+
+#include <stdio.h>
+#include "tree.h"
+
+/*
+ * Interpretador de referência: executa o programa direto sobre a árvore
+ * sintática, já verificada pela análise semântica, sem IR nem bytecode.
+ * Serve de oráculo para comparar a saída dos outros executores e de linha
+ * de base para as medidas de desempenho.
+ *
+ * A semântica é a dos outros backends: globais, locais e arrays começam
+ * em zero (um escalar declarado dentro de um laço mantém o valor entre as
+ * iterações), aritmética de 32 bits com volta, avaliação da esquerda para
+ * a direita. Divisão por zero e índice fora do array encerram com erro.
+ *
+ * Com 'contagens' imprime no fim quantos nós de cada tipo foram
+ * executados. Retorna o código de saída (0, ou 1 em erro de execução).
+ */
+int arvore_executar(TreeNode *raiz, FILE *contagens);
+
+/*
+ * Interpretador por fechamentos: compila cada subárvore uma vez num
+ * fechamento (ponteiro para uma função especializada e seus operandos),
+ * com as variáveis já resolvidas para posições do quadro ou endereços
+ * globais. A execução não compara strings nem procura nomes. Mesma
+ * semântica do interpretador de referência, sem a verificação de índices.
+ */
+int fechamentos_executar(TreeNode *raiz);
+
+/*
+ * Interpretador em faixas: executa o programa com cada diretorio/<nome>.in
+ * como nos fechamentos, mas com até 16 entradas de uma vez. Cada int é um
+ * vetor com um valor por entrada (faixa); if e while com condições
+ * diferentes entre as faixas executam os dois lados ou repetem o laço com
+ * uma máscara das faixas ativas. Cada faixa tem a sua entrada e a sua
+ * saída, gravada em <nome>.saida e comparada com <nome>.out se existir.
+ * Um erro de execução encerra só a sua faixa. O limite de CPU vale para o
+ * grupo: ao estourar, as faixas que ainda repetem um laço terminam com
+ * "tempo". Retorna 0 se todas terminaram sem erro e sem diferença.
+ */
+int faixas_executar_lote(TreeNode *raiz, const char *diretorio, int cpu_segundos);
+
+/*
+ * Executa corpo(arg) numa pilha própria de 1 GiB (reservada, as páginas só
+ * são alocadas quando usadas), para que a recursão do programa interpretado
+ * não esgote a pilha do processo. *limite recebe o endereço abaixo do qual
+ * a pilha está perto do fim. Retorna 1 se a pilha não pôde ser criada.
+ */
+int executar_em_pilha_propria(void (*corpo)(void *), void *arg, char **limite);
+
+#endif // INTERPRETADOR_H
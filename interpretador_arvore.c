@@ -0,0 +1,406 @@
+/***********************************************/
+/* Interpretador de referência sobre a árvore  */
+/* sintática: simples de propósito, procura    */
+/* nomes e compara strings a cada nó           */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "interpretador.h"
+#include "entrada_saida.h"
+
+/* Pilha própria: a recursão do programa vira recursão do interpretador */
+#define TAM_PILHA_C     ((size_t)1 << 30)
+#define MARGEM_PILHA    ((size_t)1 << 20)
+
+static void (*corpo_pendente)(void *);
+static void *arg_pendente;
+
+static void trampolim(void) {
+    corpo_pendente(arg_pendente);
+}
+
+int executar_em_pilha_propria(void (*corpo)(void *), void *arg, char **limite) {
+    // só as páginas usadas da pilha de 1 GiB chegam a ser alocadas
+    char *pilha = (char*)mmap(NULL, TAM_PILHA_C, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (pilha == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    *limite = pilha + MARGEM_PILHA;
+
+    ucontext_t principal, programa;
+    getcontext(&programa);
+    programa.uc_stack.ss_sp = pilha;
+    programa.uc_stack.ss_size = TAM_PILHA_C;
+    programa.uc_link = &principal;
+    makecontext(&programa, trampolim, 0);
+    corpo_pendente = corpo;
+    arg_pendente = arg;
+    swapcontext(&principal, &programa);
+
+    munmap(pilha, TAM_PILHA_C);
+    return 0;
+}
+
+typedef enum {
+    NO_COMPOSTO,
+    NO_EXPRESSAO_DECL,
+    NO_VAZIO,
+    NO_IF,
+    NO_IF_ELSE,
+    NO_WHILE,
+    NO_RETURN,
+    NO_ATRIBUICAO,
+    NO_VARIAVEL,
+    NO_VARIAVEL_ARRAY,
+    NO_NUM,
+    NO_CHAMADA,
+    NO_RELACIONAL,
+    NO_SOMA,
+    NO_MULT,
+    NUM_TIPOS_NO
+} TipoNo;
+
+static const char *nomes_tipos[NUM_TIPOS_NO] = {
+    "Composto-declaracao", "Expressao-declaracao", "statement-vazio",
+    "If-Statement", "If-Else-Statement", "While-Statement", "Return-Statement",
+    "Assign-Expression", "Variavel", "Variavel-Array", "Num", "Function-Call",
+    "Expressao", "soma-Expressao", "mult-Expressao"
+};
+
+/* Nome visível: escalar (tamanho < 0) ou array de 'tamanho' ints */
+typedef struct Vinculo {
+    const char *nome;
+    int *dados;
+    int tamanho;
+    struct Vinculo *prox;
+} Vinculo;
+
+/*
+ * Memória de uma declaração local numa ativação, criada (zerada) na
+ * primeira vez que o bloco executa e reaproveitada nas seguintes.
+ */
+typedef struct Armazem {
+    TreeNode *decl;
+    Vinculo vinculo;
+    struct Armazem *prox;
+} Armazem;
+
+typedef struct {
+    TreeNode *raiz;
+    Vinculo *globais;
+    Vinculo *ambiente;      /* escopo atual, encadeado até os globais */
+    Armazem *armazem;       /* locais da ativação atual */
+    const char *funcao;     /* nome da função em execução */
+    int retornando;
+    int valor_retorno;
+    unsigned long long contagens[NUM_TIPOS_NO];
+    char *limite_pilha;
+    jmp_buf erro;
+    int status;
+} Interpretador;
+
+static void executar(Interpretador *it, TreeNode *node);
+static int avaliar(Interpretador *it, TreeNode *node);
+
+static void erro_execucao(Interpretador *it, const char *mensagem, const char *nome) {
+    es_descarregar();
+    if (nome) fprintf(stderr, "ERRO DE EXECUCAO: %s: %s em %s\n", mensagem, nome, it->funcao);
+    else fprintf(stderr, "ERRO DE EXECUCAO: %s em %s\n", mensagem, it->funcao);
+    it->status = 1;
+    longjmp(it->erro, 1);
+}
+
+static TipoNo tipo_no(Interpretador *it, TreeNode *node) {
+    for (int t = 0; t < NUM_TIPOS_NO; t++) {
+        if (strcmp(node->node_type, nomes_tipos[t]) == 0) {
+            it->contagens[t]++;
+            return (TipoNo)t;
+        }
+    }
+    erro_execucao(it, "no desconhecido", node->node_type);
+    return NUM_TIPOS_NO;
+}
+
+static Vinculo* buscar(Interpretador *it, const char *nome) {
+    for (Vinculo *v = it->ambiente; v; v = v->prox) {
+        if (strcmp(v->nome, nome) == 0) return v;
+    }
+    erro_execucao(it, "variavel nao declarada", nome);
+    return NULL;
+}
+
+static TreeNode* buscar_funcao(Interpretador *it, const char *nome) {
+    TreeNode *declaracoes = it->raiz->children[0];
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        TreeNode *d = declaracoes->children[i];
+        if (strcmp(d->node_type, "Fun-declaracao") == 0 && strcmp(d->value, nome) == 0) return d;
+    }
+    erro_execucao(it, "funcao nao declarada", nome);
+    return NULL;
+}
+
+/* Memória zerada para a variável declarada em 'decl' */
+static void iniciar_vinculo(Vinculo *v, TreeNode *decl) {
+    v->nome = decl->value;
+    v->tamanho = decl->num_children > 1 ? atoi(decl->children[1]->value) : -1;
+    v->dados = (int*)calloc(v->tamanho > 0 ? v->tamanho : 1, sizeof(int));
+    v->prox = NULL;
+}
+
+static int* elemento(Interpretador *it, Vinculo *v, int indice) {
+    if (v->tamanho < 0) erro_execucao(it, "variavel nao e array", v->nome);
+    if (indice < 0 || indice >= v->tamanho) erro_execucao(it, "indice fora do array", v->nome);
+    return &v->dados[indice];
+}
+
+/* Expressões */
+
+static int operar(Interpretador *it, const char *op, int a, int b) {
+    unsigned x = (unsigned)a, y = (unsigned)b;
+    if (strcmp(op, "+") == 0) return (int)(x + y);
+    if (strcmp(op, "-") == 0) return (int)(x - y);
+    if (strcmp(op, "*") == 0) return (int)(x * y);
+    if (strcmp(op, "/") == 0) {
+        if (b == 0 || (b == -1 && a == (int)0x80000000)) erro_execucao(it, "divisao por zero", NULL);
+        return a / b;
+    }
+    if (strcmp(op, "<") == 0) return a < b;
+    if (strcmp(op, "<=") == 0) return a <= b;
+    if (strcmp(op, ">") == 0) return a > b;
+    if (strcmp(op, ">=") == 0) return a >= b;
+    if (strcmp(op, "==") == 0) return a == b;
+    return a != b;
+}
+
+static int atribuir(Interpretador *it, TreeNode *node) {
+    TreeNode *var = node->children[0];
+    Vinculo *v = buscar(it, var->value);
+    if (tipo_no(it, var) == NO_VARIAVEL_ARRAY) {
+        // o índice é avaliado antes do valor
+        int indice = avaliar(it, var->children[0]);
+        int valor = avaliar(it, node->children[1]);
+        *elemento(it, v, indice) = valor;
+        return valor;
+    }
+    if (v->tamanho >= 0) erro_execucao(it, "atribuicao a array inteiro", v->nome);
+    v->dados[0] = avaliar(it, node->children[1]);
+    return v->dados[0];
+}
+
+static int chamar(Interpretador *it, TreeNode *node) {
+    TreeNode *args = node->children[0];
+    TreeNode *lista = args->num_children > 0 ? args->children[0] : NULL;
+    int num_args = lista ? lista->num_children : 0;
+
+    if (strcmp(node->value, "input") == 0) return es_input();
+    if (strcmp(node->value, "output") == 0) {
+        es_output(avaliar(it, lista->children[0]));
+        return 0;
+    }
+
+    TreeNode *f = buscar_funcao(it, node->value);
+    TreeNode *params = f->children[1];
+    TreeNode *formais = params->num_children > 0 ? params->children[0] : NULL;
+    if ((formais ? formais->num_children : 0) != num_args) {
+        erro_execucao(it, "numero incorreto de argumentos", node->value);
+    }
+
+    // argumentos da esquerda para a direita; arrays passam por referência
+    Vinculo *vinculos = (Vinculo*)calloc(num_args ? num_args : 1, sizeof(Vinculo));
+    int *valores = (int*)calloc(num_args ? num_args : 1, sizeof(int));
+    for (int a = 0; a < num_args; a++) {
+        TreeNode *formal = formais->children[a];
+        TreeNode *arg = lista->children[a];
+        vinculos[a].nome = formal->value;
+        if (strcmp(formal->node_type, "params-lista") == 0) {
+            Vinculo *v = NULL;
+            if (tipo_no(it, arg) == NO_VARIAVEL) v = buscar(it, arg->value);
+            if (!v || v->tamanho < 0) erro_execucao(it, "argumento nao e array", formal->value);
+            vinculos[a].dados = v->dados;
+            vinculos[a].tamanho = v->tamanho;
+        } else {
+            valores[a] = avaliar(it, arg);
+            vinculos[a].dados = &valores[a];
+            vinculos[a].tamanho = -1;
+        }
+        vinculos[a].prox = a + 1 < num_args ? &vinculos[a + 1] : it->globais;
+    }
+
+    char marca;
+    if (&marca < it->limite_pilha) erro_execucao(it, "estouro da pilha", NULL);
+
+    Vinculo *ambiente = it->ambiente;
+    Armazem *armazem = it->armazem;
+    const char *funcao = it->funcao;
+    it->ambiente = num_args ? vinculos : it->globais;
+    it->armazem = NULL;
+    it->funcao = f->value;
+
+    executar(it, f->children[2]);
+    int resultado = it->retornando ? it->valor_retorno : 0;
+    it->retornando = 0;
+
+    while (it->armazem) {
+        Armazem *m = it->armazem;
+        it->armazem = m->prox;
+        free(m->vinculo.dados);
+        free(m);
+    }
+    it->ambiente = ambiente;
+    it->armazem = armazem;
+    it->funcao = funcao;
+    free(vinculos);
+    free(valores);
+    return resultado;
+}
+
+static int avaliar(Interpretador *it, TreeNode *node) {
+    switch (tipo_no(it, node)) {
+        case NO_NUM:
+            return atoi(node->value);
+        case NO_VARIAVEL: {
+            Vinculo *v = buscar(it, node->value);
+            if (v->tamanho >= 0) erro_execucao(it, "array usado como valor", v->nome);
+            return v->dados[0];
+        }
+        case NO_VARIAVEL_ARRAY: {
+            Vinculo *v = buscar(it, node->value);
+            return *elemento(it, v, avaliar(it, node->children[0]));
+        }
+        case NO_ATRIBUICAO:
+            return atribuir(it, node);
+        case NO_CHAMADA:
+            return chamar(it, node);
+        case NO_RELACIONAL:
+        case NO_SOMA:
+        case NO_MULT: {
+            int a = avaliar(it, node->children[0]);
+            int b = avaliar(it, node->children[2]);
+            return operar(it, node->children[1]->value, a, b);
+        }
+        default:
+            erro_execucao(it, "expressao invalida", node->node_type);
+            return 0;
+    }
+}
+
+/* Comandos */
+
+static Armazem* local(Interpretador *it, TreeNode *decl) {
+    for (Armazem *m = it->armazem; m; m = m->prox) {
+        if (m->decl == decl) return m;
+    }
+    Armazem *m = (Armazem*)malloc(sizeof(Armazem));
+    m->decl = decl;
+    iniciar_vinculo(&m->vinculo, decl);
+    m->prox = it->armazem;
+    it->armazem = m;
+    return m;
+}
+
+static void executar(Interpretador *it, TreeNode *node) {
+    switch (tipo_no(it, node)) {
+        case NO_COMPOSTO: {
+            Vinculo *ambiente = it->ambiente;
+            TreeNode *locais = node->children[0];
+            for (int i = 0; i < locais->num_children; i++) {
+                Armazem *m = local(it, locais->children[i]);
+                m->vinculo.prox = it->ambiente;
+                it->ambiente = &m->vinculo;
+            }
+            TreeNode *comandos = node->children[1];
+            for (int i = 0; i < comandos->num_children && !it->retornando; i++) {
+                executar(it, comandos->children[i]);
+            }
+            it->ambiente = ambiente;
+            break;
+        }
+        case NO_EXPRESSAO_DECL:
+            avaliar(it, node->children[0]);
+            break;
+        case NO_VAZIO:
+            break;
+        case NO_IF:
+        case NO_IF_ELSE:
+            if (avaliar(it, node->children[0])) executar(it, node->children[1]);
+            else if (node->num_children > 2) executar(it, node->children[2]);
+            break;
+        case NO_WHILE:
+            while (!it->retornando && avaliar(it, node->children[0])) {
+                executar(it, node->children[1]);
+            }
+            break;
+        case NO_RETURN:
+            it->valor_retorno = node->num_children > 0 ? avaliar(it, node->children[0]) : 0;
+            it->retornando = 1;
+            break;
+        default:
+            erro_execucao(it, "comando invalido", node->node_type);
+    }
+}
+
+/* Execução */
+
+static void executar_programa(void *arg) {
+    Interpretador *it = (Interpretador*)arg;
+    if (setjmp(it->erro) != 0) return;
+
+    TreeNode *declaracoes = it->raiz->children[0];
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        TreeNode *d = declaracoes->children[i];
+        if (strcmp(d->node_type, "Fun-declaracao") == 0) continue;
+        Vinculo *v = (Vinculo*)malloc(sizeof(Vinculo));
+        iniciar_vinculo(v, d);
+        v->prox = it->globais;
+        it->globais = v;
+    }
+    it->ambiente = it->globais;
+
+    TreeNode chamada_main = { "Function-Call", "main", 0, 0, NULL };
+    TreeNode sem_argumentos = { "Argumentos", "void", 0, 0, NULL };
+    TreeNode *filhos[1] = { &sem_argumentos };
+    chamada_main.children = filhos;
+    chamada_main.num_children = 1;
+    chamar(it, &chamada_main);
+}
+
+static void imprimir_contagens(Interpretador *it, FILE *saida) {
+    unsigned long long total = 0;
+    for (int t = 0; t < NUM_TIPOS_NO; t++) total += it->contagens[t];
+    fprintf(saida, "nos executados: %llu\n", total);
+    for (int t = 0; t < NUM_TIPOS_NO; t++) {
+        if (it->contagens[t] == 0) continue;
+        fprintf(saida, "  %-21s %12llu  %5.1f%%\n", nomes_tipos[t], it->contagens[t],
+                100.0 * it->contagens[t] / total);
+    }
+}
+
+int arvore_executar(TreeNode *raiz, FILE *contagens) {
+    Interpretador *it = (Interpretador*)calloc(1, sizeof(Interpretador));
+    it->raiz = raiz;
+    it->funcao = "main";
+
+    if (executar_em_pilha_propria(executar_programa, it, &it->limite_pilha) != 0) {
+        free(it);
+        return 1;
+    }
+    es_descarregar();
+
+    if (contagens) imprimir_contagens(it, contagens);
+    int status = it->status;
+    while (it->globais) {
+        Vinculo *v = it->globais;
+        it->globais = v->prox;
+        free(v->dados);
+        free(v);
+    }
+    free(it);
+    return status;
+}
@@ -0,0 +1,1001 @@
+/***********************************************/
+/* Interpretador em faixas: o mesmo programa   */
+/* executado com várias entradas de uma vez,   */
+/* cada int um vetor com um valor por entrada  */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/time.h>
+#include "interpretador.h"
+
+#ifndef FX_LARGURA
+#define FX_LARGURA      16          /* faixas por vetor: 16 ints = um registrador AVX-512 */
+#endif
+#define FX_MAX_SLOTS    (1 << 20)   /* pilha de quadros, em vetores */
+#define FX_MAX_ARRAYS   (1 << 26)   /* pilha dos arrays locais, em ints de todas as faixas */
+
+// os vetores devolvidos são todos de funções static: a diferença de ABI sem AVX não importa
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+/*
+ * Um valor do programa é um vetor com o valor de cada faixa. Máscaras são
+ * vetores com -1 nas faixas ativas e 0 nas outras, como os resultados das
+ * comparações entre vetores. O compilador escolhe as instruções conforme
+ * o alvo: com -mavx512f um vetor é um registrador, com SSE são quatro.
+ */
+typedef int Vetor __attribute__((vector_size(FX_LARGURA * sizeof(int))));
+typedef unsigned VetorU __attribute__((vector_size(FX_LARGURA * sizeof(int))));
+typedef double VetorD __attribute__((vector_size(FX_LARGURA * sizeof(double))));
+
+#define SELECIONAR(m, a, b) (((a) & (m)) | ((b) & ~(m)))
+
+/*
+ * Posição de um quadro: escalar (um valor por faixa) ou endereço de array.
+ * O endereço é o mesmo em todas as faixas, que chamam as mesmas funções ao
+ * mesmo tempo; o elemento i da faixa l fica em p[i * FX_LARGURA + l].
+ */
+typedef union {
+    Vetor v;
+    int *p;
+} Slot;
+
+typedef struct Fechamento Fechamento;
+typedef struct Funcao Funcao;
+
+/*
+ * Expressões recebem as faixas ativas e devolvem o valor (qualquer coisa
+ * nas inativas). Comandos devolvem as faixas que seguem para o comando
+ * seguinte: as que executaram return saem da máscara. Vetores entram por
+ * ponteiro: por valor, sem AVX-512, iriam pela pilha alinhada a 64 bytes,
+ * o que muda de ABI entre versões do gcc.
+ */
+typedef Vetor (*Codigo)(Fechamento *f, Slot *q, const Vetor *ativas);
+
+struct Fechamento {
+    Codigo codigo;
+    int *(*endereco)(Fechamento *f, Slot *q);   /* argumento para parâmetro array */
+    int k;                  /* constante ou posição no quadro */
+    Vetor *escalar;         /* escalar global */
+    int *array;             /* array global */
+    Fechamento *a, *b, *c;
+    Fechamento **filhos;    /* comandos do bloco ou argumentos */
+    int num_filhos;
+    Funcao *funcao;         /* função chamada */
+    Fechamento *alocado;    /* lista de tudo o que foi alocado, para liberar */
+};
+
+struct Funcao {
+    char *nome;
+    int num_params;
+    int slot_retorno;       /* valor de retorno de cada faixa, logo após os parâmetros */
+    int num_slots;
+    int tam_arrays;         /* em elementos de uma faixa */
+    int num_arrays;
+    int *slot_array;
+    int *desloc_array;
+    Fechamento *corpo;
+};
+
+/* Entrada e saída de uma faixa, e como ela terminou */
+typedef struct {
+    char *nome;                 /* <nome>.in */
+    unsigned char *entrada;
+    size_t tam_entrada, pos_entrada;
+    char *saida;
+    size_t tam_saida, cap_saida;
+    const char *erro;           /* erro de execução, ou NULL */
+    const char *erro_funcao;
+    int tempo;                  /* estourou o limite de CPU */
+} Faixa;
+
+/* Estado da execução de um grupo de faixas */
+static struct {
+    Slot *topo;
+    Slot *fim;
+    int *topo_arrays;
+    int *fim_arrays;
+    Funcao *funcao;
+    char *limite_pilha;
+    Vetor vivas;                /* faixas que não terminaram com erro */
+    Faixa faixas[FX_LARGURA];
+    volatile sig_atomic_t estourou;
+} ex;
+
+static int alguma(const Vetor *m) {
+    unsigned long long partes[sizeof(Vetor) / 8], r = 0;
+    memcpy(partes, m, sizeof(partes));
+    for (size_t i = 0; i < sizeof(partes) / 8; i++) r |= partes[i];
+    return r != 0;
+}
+
+static Vetor difundir(int k) {
+    return (Vetor){ 0 } + k;
+}
+
+/* Tira as faixas de m da execução; as outras continuam */
+static void encerrar(const Vetor *m, const char *erro, int tempo) {
+    for (int l = 0; l < FX_LARGURA; l++) {
+        if (!(*m)[l] || !ex.vivas[l]) continue;
+        ex.faixas[l].erro = erro;
+        ex.faixas[l].erro_funcao = ex.funcao->nome;
+        ex.faixas[l].tempo = tempo;
+    }
+    ex.vivas &= ~*m;
+}
+
+#define AVALIAR(f, q, m) ((f)->codigo((f), (q), &(m)))
+
+/* Folhas */
+
+static Vetor c_num(Fechamento *f, Slot *q, const Vetor *ativas)    { (void)q; (void)ativas; return difundir(f->k); }
+static Vetor c_local(Fechamento *f, Slot *q, const Vetor *ativas)  { (void)ativas; return q[f->k].v; }
+static Vetor c_global(Fechamento *f, Slot *q, const Vetor *ativas) { (void)q; (void)ativas; return *f->escalar; }
+
+// cada faixa lê com o seu índice; as inativas podem ter índices quaisquer
+static Vetor ler_elementos(const int *base, const Vetor *i, const Vetor *m) {
+    Vetor r = { 0 };
+    for (int l = 0; l < FX_LARGURA; l++) {
+        if ((*m)[l]) r[l] = base[(long)(*i)[l] * FX_LARGURA + l];
+    }
+    return r;
+}
+
+static void escrever_elementos(int *base, const Vetor *i, const Vetor *v, const Vetor *m) {
+    for (int l = 0; l < FX_LARGURA; l++) {
+        if ((*m)[l]) base[(long)(*i)[l] * FX_LARGURA + l] = (*v)[l];
+    }
+}
+
+static Vetor c_elem_local(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor i = AVALIAR(f->a, q, m);
+    return ler_elementos(q[f->k].p, &i, &m);
+}
+
+static Vetor c_elem_global(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor i = AVALIAR(f->a, q, m);
+    return ler_elementos(f->array, &i, &m);
+}
+
+static int *e_local(Fechamento *f, Slot *q)     { return q[f->k].p; }
+static int *e_global(Fechamento *f, Slot *q)    { (void)q; return f->array; }
+
+static Vetor c_atrib_local(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor v = AVALIAR(f->a, q, m);
+    q[f->k].v = SELECIONAR(m, v, q[f->k].v);
+    return v;
+}
+
+static Vetor c_atrib_global(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor v = AVALIAR(f->a, q, m);
+    *f->escalar = SELECIONAR(m, v, *f->escalar);
+    return v;
+}
+
+// o índice é avaliado antes do valor
+static Vetor c_atrib_elem_local(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor i = AVALIAR(f->a, q, m);
+    Vetor v = AVALIAR(f->b, q, m);
+    escrever_elementos(q[f->k].p, &i, &v, &m);
+    return v;
+}
+
+static Vetor c_atrib_elem_global(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor i = AVALIAR(f->a, q, m);
+    Vetor v = AVALIAR(f->b, q, m);
+    escrever_elementos(f->array, &i, &v, &m);
+    return v;
+}
+
+/* Operações binárias: operandos quaisquer, ou constante à direita */
+#define BINARIO(nome, expr)                                                         \
+    static Vetor nome(Fechamento *f, Slot *q, const Vetor *ativas) {                \
+        Vetor m = *ativas;                                                          \
+        Vetor x = AVALIAR(f->a, q, m), y = AVALIAR(f->b, q, m);                     \
+        return expr;                                                                \
+    }                                                                               \
+    static Vetor nome##_k(Fechamento *f, Slot *q, const Vetor *ativas) {            \
+        Vetor m = *ativas;                                                          \
+        Vetor x = AVALIAR(f->a, q, m), y = difundir(f->k);                          \
+        return expr;                                                                \
+    }
+
+// comparações entre vetores dão -1 ou 0; o valor em C- é 1 ou 0
+BINARIO(c_add, (Vetor)((VetorU)x + (VetorU)y))
+BINARIO(c_sub, (Vetor)((VetorU)x - (VetorU)y))
+BINARIO(c_mul, (Vetor)((VetorU)x * (VetorU)y))
+BINARIO(c_lt, -(x < y))
+BINARIO(c_le, -(x <= y))
+BINARIO(c_gt, -(x > y))
+BINARIO(c_ge, -(x >= y))
+BINARIO(c_eq, -(x == y))
+BINARIO(c_ne, -(x != y))
+
+/*
+ * Não há divisão inteira em SIMD: divide em double e trunca. É exata para
+ * 32 bits: o quociente arredondado erra menos de |x/y| * 2^-53, menos que
+ * a distância 1/|y| até o inteiro seguinte.
+ */
+static Vetor dividir(const Vetor *x, const Vetor *y) {
+    VetorD q = __builtin_convertvector(*x, VetorD) / __builtin_convertvector(*y, VetorD);
+    return __builtin_convertvector(q, Vetor);
+}
+
+static Vetor c_div(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor x = AVALIAR(f->a, q, m), y = AVALIAR(f->b, q, m);
+    Vetor invalido = (y == 0) | ((y == -1) & (x == (int)0x80000000));
+    Vetor erro = invalido & m;
+    if (alguma(&erro)) encerrar(&erro, "divisao por zero", 0);
+    // as faixas inativas ou encerradas dividem por 1
+    Vetor divisor = SELECIONAR(m & ~invalido, y, difundir(1));
+    return dividir(&x, &divisor);
+}
+
+// divisor constante diferente de 0 e -1: sem verificação
+static Vetor c_div_k(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor x = AVALIAR(f->a, q, m), y = difundir(f->k);
+    return dividir(&x, &y);
+}
+
+/* Tabela das formas: [operador][genérica, _k] */
+static const struct {
+    const char *op;
+    Codigo formas[2];
+} binarios[] = {
+    { "+",  { c_add, c_add_k } },
+    { "-",  { c_sub, c_sub_k } },
+    { "*",  { c_mul, c_mul_k } },
+    { "<",  { c_lt, c_lt_k } },
+    { "<=", { c_le, c_le_k } },
+    { ">",  { c_gt, c_gt_k } },
+    { ">=", { c_ge, c_ge_k } },
+    { "==", { c_eq, c_eq_k } },
+    { "!=", { c_ne, c_ne_k } },
+};
+
+/* E/S: cada faixa lê a sua entrada e escreve na sua saída */
+
+static int proximo(Faixa *fx) {
+    return fx->pos_entrada < fx->tam_entrada ? fx->entrada[fx->pos_entrada++] : -1;
+}
+
+// mesma leitura de es_input: o caractere depois do número é consumido
+static int ler_inteiro(Faixa *fx) {
+    int c;
+    do {
+        c = proximo(fx);
+        if (c < 0) return 0;
+    } while (c <= ' ');
+    int negativo = 0;
+    if (c == '-') {
+        negativo = 1;
+        c = proximo(fx);
+    }
+    unsigned valor = 0;
+    while (c >= '0' && c <= '9') {
+        valor = valor * 10 + (unsigned)(c - '0');
+        c = proximo(fx);
+    }
+    return (int)(negativo ? 0u - valor : valor);
+}
+
+static void escrever_inteiro(Faixa *fx, int v) {
+    if (fx->tam_saida + 12 > fx->cap_saida) {
+        fx->cap_saida = fx->cap_saida ? 2 * fx->cap_saida : 4096;
+        fx->saida = (char*)realloc(fx->saida, fx->cap_saida);
+    }
+    char tmp[12];
+    char *p = tmp + sizeof(tmp);
+    unsigned abs = v < 0 ? 0u - (unsigned)v : (unsigned)v;
+    do {
+        *--p = (char)('0' + abs % 10);
+        abs /= 10;
+    } while (abs);
+    if (v < 0) *--p = '-';
+    size_t n = (size_t)(tmp + sizeof(tmp) - p);
+    memcpy(fx->saida + fx->tam_saida, p, n);
+    fx->tam_saida += n;
+    fx->saida[fx->tam_saida++] = '\n';
+}
+
+static Vetor c_input(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    (void)f;
+    (void)q;
+    Vetor r = { 0 };
+    for (int l = 0; l < FX_LARGURA; l++) {
+        if (m[l]) r[l] = ler_inteiro(&ex.faixas[l]);
+    }
+    return r;
+}
+
+static Vetor c_output(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor v = AVALIAR(f->a, q, m);
+    // uma divisão por zero no argumento já encerrou a faixa
+    m &= ex.vivas;
+    for (int l = 0; l < FX_LARGURA; l++) {
+        if (m[l]) escrever_inteiro(&ex.faixas[l], v[l]);
+    }
+    return (Vetor){ 0 };
+}
+
+static Vetor c_chamada(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Funcao *fn = f->funcao;
+    m &= ex.vivas;
+    if (!alguma(&m)) return (Vetor){ 0 };
+    Slot *novo = ex.topo;
+    char marca;
+    if (novo + fn->num_slots > ex.fim || &marca < ex.limite_pilha ||
+        ex.topo_arrays + (long)fn->tam_arrays * FX_LARGURA > ex.fim_arrays) {
+        encerrar(&m, "estouro da pilha", 0);
+        return (Vetor){ 0 };
+    }
+
+    // os argumentos vão direto para o quadro novo, já reservado
+    ex.topo = novo + fn->num_params;
+    for (int i = 0; i < f->num_filhos; i++) {
+        Fechamento *arg = f->filhos[i];
+        if (arg->endereco) novo[i].p = arg->endereco(arg, q);
+        else novo[i].v = AVALIAR(arg, q, m);
+    }
+    m &= ex.vivas;
+    ex.topo = novo + fn->num_slots;
+    memset(novo + fn->num_params, 0, sizeof(Slot) * (fn->num_slots - fn->num_params));
+
+    int *arrays = ex.topo_arrays;
+    if (fn->tam_arrays) {
+        memset(arrays, 0, sizeof(int) * fn->tam_arrays * FX_LARGURA);
+        for (int i = 0; i < fn->num_arrays; i++) {
+            novo[fn->slot_array[i]].p = arrays + (long)fn->desloc_array[i] * FX_LARGURA;
+        }
+        ex.topo_arrays += (long)fn->tam_arrays * FX_LARGURA;
+    }
+
+    Funcao *chamador = ex.funcao;
+    ex.funcao = fn;
+    AVALIAR(fn->corpo, novo, m);
+    ex.funcao = chamador;
+    ex.topo = novo;
+    ex.topo_arrays = arrays;
+    // faixas que chegaram ao fim sem return ficam com 0
+    return novo[fn->slot_retorno].v;
+}
+
+/* Comandos */
+
+static Vetor c_bloco(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    for (int i = 0; i < f->num_filhos && alguma(&m); i++) {
+        m = AVALIAR(f->filhos[i], q, m) & ex.vivas;
+    }
+    return m;
+}
+
+static Vetor c_expressao(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    AVALIAR(f->a, q, m);
+    return m;
+}
+
+static Vetor c_vazio(Fechamento *f, Slot *q, const Vetor *ativas) {
+    (void)f;
+    (void)q;
+    return *ativas;
+}
+
+// cada lado executa só com as suas faixas, e só se tiver alguma
+static Vetor c_if(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor c = AVALIAR(f->a, q, m);
+    Vetor sim = m & (c != 0), nao = m & (c == 0);
+    Vetor seguem = nao;
+    if (alguma(&sim)) seguem |= AVALIAR(f->b, q, sim);
+    return seguem;
+}
+
+static Vetor c_if_else(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor c = AVALIAR(f->a, q, m);
+    Vetor sim = m & (c != 0), nao = m & (c == 0);
+    Vetor seguem = { 0 };
+    if (alguma(&sim)) seguem |= AVALIAR(f->b, q, sim);
+    if (alguma(&nao)) seguem |= AVALIAR(f->c, q, nao);
+    return seguem;
+}
+
+// o laço repete enquanto alguma faixa continua; as que saem esperam as outras
+static Vetor c_while(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor saem = { 0 };
+    while (alguma(&m)) {
+        // estourou o limite: encerra as faixas que ainda repetem algum laço
+        if (ex.estourou) {
+            encerrar(&m, NULL, 1);
+            return saem & ex.vivas;
+        }
+        Vetor c = AVALIAR(f->a, q, m);
+        saem |= m & (c == 0);
+        m &= (c != 0);
+        if (alguma(&m)) m = AVALIAR(f->b, q, m) & ex.vivas;
+    }
+    return saem & ex.vivas;
+}
+
+static Vetor c_return(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    Vetor v = AVALIAR(f->a, q, m);
+    q[f->k].v = SELECIONAR(m, v, q[f->k].v);
+    return (Vetor){ 0 };
+}
+
+static Vetor c_return0(Fechamento *f, Slot *q, const Vetor *ativas) {
+    Vetor m = *ativas;
+    q[f->k].v &= ~m;
+    return (Vetor){ 0 };
+}
+
+/* Compilação */
+
+typedef enum {
+    NOME_LOCAL,         /* escalar no quadro */
+    NOME_ARRAY_LOCAL,   /* endereço de array no quadro (parâmetro ou local) */
+    NOME_GLOBAL,
+    NOME_ARRAY_GLOBAL
+} TipoNome;
+
+typedef struct Nome {
+    char *nome;
+    TipoNome tipo;
+    int slot;
+    Vetor *escalar;
+    int *array;
+    int nivel;
+    struct Nome *prox;
+} Nome;
+
+/* Memória global de uma faixa a zerar antes de cada grupo */
+typedef struct {
+    void *dados;
+    size_t bytes;
+} Global;
+
+typedef struct {
+    Nome *nomes;
+    int nivel;
+    Funcao **funcoes;
+    int num_funcoes;
+    Funcao *f;
+    Global *globais;
+    int num_globais;
+    Fechamento *alocados;
+    int erros;
+} Compilador;
+
+static Fechamento* compilar_expressao(Compilador *c, TreeNode *node);
+static Fechamento* compilar_statement(Compilador *c, TreeNode *node);
+
+static void erro_fx(Compilador *c, const char *mensagem, const char *nome) {
+    fprintf(stderr, "ERRO SEMANTICO: %s: %s\n", mensagem, nome);
+    c->erros++;
+}
+
+static Fechamento* novo(Compilador *c, Codigo codigo) {
+    Fechamento *f = (Fechamento*)calloc(1, sizeof(Fechamento));
+    f->codigo = codigo;
+    f->alocado = c->alocados;
+    c->alocados = f;
+    return f;
+}
+
+static Nome* declarar(Compilador *c, char *nome, TipoNome tipo, int slot) {
+    Nome *n = (Nome*)calloc(1, sizeof(Nome));
+    n->nome = nome;
+    n->tipo = tipo;
+    n->slot = slot;
+    n->nivel = c->nivel;
+    n->prox = c->nomes;
+    c->nomes = n;
+    return n;
+}
+
+static Nome* buscar(Compilador *c, const char *nome) {
+    for (Nome *n = c->nomes; n; n = n->prox) {
+        if (strcmp(n->nome, nome) == 0) return n;
+    }
+    erro_fx(c, "Variável não declarada", nome);
+    return NULL;
+}
+
+static void fechar_escopo(Compilador *c) {
+    while (c->nomes && c->nomes->nivel == c->nivel) {
+        Nome *n = c->nomes;
+        c->nomes = n->prox;
+        free(n);
+    }
+    c->nivel--;
+}
+
+static int eh_array(Nome *n) {
+    return n->tipo == NOME_ARRAY_LOCAL || n->tipo == NOME_ARRAY_GLOBAL;
+}
+
+static Fechamento* referencia(Compilador *c, Codigo codigo, Nome *n) {
+    Fechamento *f = novo(c, codigo);
+    f->k = n->slot;
+    f->escalar = n->escalar;
+    f->array = n->array;
+    return f;
+}
+
+static Fechamento* compilar_variavel(Compilador *c, TreeNode *node) {
+    Nome *n = buscar(c, node->value);
+    if (!n) return novo(c, c_num);
+    if (eh_array(n)) {
+        erro_fx(c, "Array usado como valor", node->value);
+        return novo(c, c_num);
+    }
+    return referencia(c, n->tipo == NOME_LOCAL ? c_local : c_global, n);
+}
+
+static Fechamento* compilar_atribuicao(Compilador *c, TreeNode *node) {
+    TreeNode *var = node->children[0];
+    Nome *n = buscar(c, var->value);
+    if (!n) return novo(c, c_num);
+
+    Fechamento *f;
+    if (strcmp(var->node_type, "Variavel-Array") == 0) {
+        if (!eh_array(n)) {
+            erro_fx(c, "Variável não é array", var->value);
+            return novo(c, c_num);
+        }
+        f = referencia(c, n->tipo == NOME_ARRAY_LOCAL ? c_atrib_elem_local : c_atrib_elem_global, n);
+        f->a = compilar_expressao(c, var->children[0]);
+        f->b = compilar_expressao(c, node->children[1]);
+    } else {
+        if (eh_array(n)) {
+            erro_fx(c, "Atribuição a array inteiro", var->value);
+            return novo(c, c_num);
+        }
+        f = referencia(c, n->tipo == NOME_LOCAL ? c_atrib_local : c_atrib_global, n);
+        f->a = compilar_expressao(c, node->children[1]);
+    }
+    return f;
+}
+
+static Funcao* buscar_funcao(Compilador *c, const char *nome) {
+    for (int i = 0; i < c->num_funcoes; i++) {
+        if (strcmp(c->funcoes[i]->nome, nome) == 0) return c->funcoes[i];
+    }
+    return NULL;
+}
+
+static Fechamento* compilar_chamada(Compilador *c, TreeNode *node) {
+    TreeNode *args = node->children[0];
+    TreeNode *lista = args->num_children > 0 ? args->children[0] : NULL;
+    int num_args = lista ? lista->num_children : 0;
+
+    if (strcmp(node->value, "input") == 0) return novo(c, c_input);
+    if (strcmp(node->value, "output") == 0) {
+        if (num_args != 1) {
+            erro_fx(c, "Número incorreto de argumentos", node->value);
+            return novo(c, c_num);
+        }
+        Fechamento *f = novo(c, c_output);
+        f->a = compilar_expressao(c, lista->children[0]);
+        return f;
+    }
+
+    Funcao *fn = buscar_funcao(c, node->value);
+    if (!fn) {
+        erro_fx(c, "Função não declarada", node->value);
+        return novo(c, c_num);
+    }
+    if (num_args != fn->num_params) {
+        erro_fx(c, "Número incorreto de argumentos", node->value);
+        return novo(c, c_num);
+    }
+
+    Fechamento *f = novo(c, c_chamada);
+    f->funcao = fn;
+    f->num_filhos = num_args;
+    f->filhos = (Fechamento**)calloc(num_args ? num_args : 1, sizeof(Fechamento*));
+    for (int i = 0; i < num_args; i++) {
+        TreeNode *arg = lista->children[i];
+        Nome *n = NULL;
+        if (strcmp(arg->node_type, "Variavel") == 0) n = buscar(c, arg->value);
+        if (n && eh_array(n)) {
+            // array: passa o endereço, o mesmo em todas as faixas
+            Fechamento *e = referencia(c, NULL, n);
+            e->endereco = n->tipo == NOME_ARRAY_LOCAL ? e_local : e_global;
+            f->filhos[i] = e;
+        } else {
+            f->filhos[i] = compilar_expressao(c, arg);
+        }
+    }
+    return f;
+}
+
+static Fechamento* compilar_binario(Compilador *c, TreeNode *node) {
+    const char *op = node->children[1]->value;
+    Fechamento *f = novo(c, NULL);
+    f->a = compilar_expressao(c, node->children[0]);
+    f->b = compilar_expressao(c, node->children[2]);
+
+    if (strcmp(op, "/") == 0) {
+        int k = f->b->codigo == c_num ? f->b->k : 0;
+        if (k != 0 && k != -1) {
+            f->codigo = c_div_k;
+            f->k = k;
+        } else {
+            f->codigo = c_div;
+        }
+        return f;
+    }
+
+    for (size_t i = 0; i < sizeof(binarios) / sizeof(binarios[0]); i++) {
+        if (strcmp(op, binarios[i].op) != 0) continue;
+        if (f->b->codigo == c_num) {
+            f->k = f->b->k;
+            f->codigo = binarios[i].formas[1];
+        } else {
+            f->codigo = binarios[i].formas[0];
+        }
+        return f;
+    }
+    erro_fx(c, "Operador inválido", op);
+    f->codigo = c_num;
+    return f;
+}
+
+static Fechamento* compilar_expressao(Compilador *c, TreeNode *node) {
+    if (strcmp(node->node_type, "Num") == 0) {
+        Fechamento *f = novo(c, c_num);
+        f->k = atoi(node->value);
+        return f;
+    }
+    if (strcmp(node->node_type, "Variavel") == 0) return compilar_variavel(c, node);
+    if (strcmp(node->node_type, "Variavel-Array") == 0) {
+        Nome *n = buscar(c, node->value);
+        if (!n) return novo(c, c_num);
+        if (!eh_array(n)) {
+            erro_fx(c, "Variável não é array", node->value);
+            return novo(c, c_num);
+        }
+        Fechamento *f = referencia(c, n->tipo == NOME_ARRAY_LOCAL ? c_elem_local : c_elem_global, n);
+        f->a = compilar_expressao(c, node->children[0]);
+        return f;
+    }
+    if (strcmp(node->node_type, "Assign-Expression") == 0) return compilar_atribuicao(c, node);
+    if (strcmp(node->node_type, "Function-Call") == 0) return compilar_chamada(c, node);
+    if (node->num_children == 3) return compilar_binario(c, node);
+
+    erro_fx(c, "Expressão inválida", node->node_type);
+    return novo(c, c_num);
+}
+
+static Fechamento* compilar_composto(Compilador *c, TreeNode *node) {
+    c->nivel++;
+    TreeNode *locais = node->children[0];
+    for (int i = 0; i < locais->num_children; i++) {
+        TreeNode *decl = locais->children[i];
+        Funcao *fn = c->f;
+        int slot = fn->num_slots++;
+        if (decl->num_children > 1) {
+            fn->slot_array = (int*)realloc(fn->slot_array, sizeof(int) * (fn->num_arrays + 1));
+            fn->desloc_array = (int*)realloc(fn->desloc_array, sizeof(int) * (fn->num_arrays + 1));
+            fn->slot_array[fn->num_arrays] = slot;
+            fn->desloc_array[fn->num_arrays] = fn->tam_arrays;
+            fn->num_arrays++;
+            fn->tam_arrays += atoi(decl->children[1]->value);
+            declarar(c, decl->value, NOME_ARRAY_LOCAL, slot);
+        } else {
+            declarar(c, decl->value, NOME_LOCAL, slot);
+        }
+    }
+
+    TreeNode *comandos = node->children[1];
+    Fechamento *f = novo(c, c_bloco);
+    f->num_filhos = comandos->num_children;
+    f->filhos = (Fechamento**)calloc(f->num_filhos ? f->num_filhos : 1, sizeof(Fechamento*));
+    for (int i = 0; i < comandos->num_children; i++) {
+        f->filhos[i] = compilar_statement(c, comandos->children[i]);
+    }
+    fechar_escopo(c);
+    return f;
+}
+
+static Fechamento* compilar_statement(Compilador *c, TreeNode *node) {
+    const char *tipo = node->node_type;
+    Fechamento *f;
+    if (strcmp(tipo, "Expressao-declaracao") == 0) {
+        f = novo(c, c_expressao);
+        f->a = compilar_expressao(c, node->children[0]);
+    } else if (strcmp(tipo, "Composto-declaracao") == 0) {
+        f = compilar_composto(c, node);
+    } else if (strcmp(tipo, "If-Statement") == 0 || strcmp(tipo, "If-Else-Statement") == 0) {
+        f = novo(c, node->num_children > 2 ? c_if_else : c_if);
+        f->a = compilar_expressao(c, node->children[0]);
+        f->b = compilar_statement(c, node->children[1]);
+        if (node->num_children > 2) f->c = compilar_statement(c, node->children[2]);
+    } else if (strcmp(tipo, "While-Statement") == 0) {
+        f = novo(c, c_while);
+        f->a = compilar_expressao(c, node->children[0]);
+        f->b = compilar_statement(c, node->children[1]);
+    } else if (strcmp(tipo, "Return-Statement") == 0) {
+        if (node->num_children > 0) {
+            f = novo(c, c_return);
+            f->a = compilar_expressao(c, node->children[0]);
+        } else {
+            f = novo(c, c_return0);
+        }
+        f->k = c->f->slot_retorno;
+    } else {
+        f = novo(c, c_vazio);
+    }
+    return f;
+}
+
+static void compilar_funcao(Compilador *c, TreeNode *node) {
+    Funcao *fn = (Funcao*)calloc(1, sizeof(Funcao));
+    fn->nome = node->value;
+    TreeNode *params = node->children[1];
+    TreeNode *lista = params->num_children > 0 ? params->children[0] : NULL;
+    fn->num_params = lista ? lista->num_children : 0;
+    fn->slot_retorno = fn->num_params;
+    fn->num_slots = fn->num_params + 1;
+
+    // visível no próprio corpo (recursão)
+    c->funcoes = (Funcao**)realloc(c->funcoes, sizeof(Funcao*) * (c->num_funcoes + 1));
+    c->funcoes[c->num_funcoes++] = fn;
+    c->f = fn;
+
+    c->nivel++;
+    for (int i = 0; i < fn->num_params; i++) {
+        TreeNode *param = lista->children[i];
+        int array = strcmp(param->node_type, "params-lista") == 0;
+        declarar(c, param->value, array ? NOME_ARRAY_LOCAL : NOME_LOCAL, i);
+    }
+    fn->corpo = compilar_composto(c, node->children[2]);
+    fechar_escopo(c);
+}
+
+static void* alocar_global(Compilador *c, size_t bytes) {
+    bytes = (bytes + sizeof(Vetor) - 1) / sizeof(Vetor) * sizeof(Vetor);
+    void *dados = aligned_alloc(sizeof(Vetor), bytes);
+    c->globais = (Global*)realloc(c->globais, sizeof(Global) * (c->num_globais + 1));
+    c->globais[c->num_globais].dados = dados;
+    c->globais[c->num_globais].bytes = bytes;
+    c->num_globais++;
+    return dados;
+}
+
+/* Execução em lote */
+
+typedef enum {
+    FX_OK,              /* saída igual a <nome>.out */
+    FX_EXECUTOU,        /* terminou normalmente, sem .out para comparar */
+    FX_DIFERENTE,
+    FX_TEMPO,           /* o grupo estourou o limite de CPU */
+    FX_ERRO             /* erro de execução ou de arquivo */
+} SituacaoFaixa;
+
+static const char *nomes_situacao[] = { "ok", "executou", "diferente", "tempo", "erro" };
+
+typedef struct {
+    Compilador *c;
+    Funcao *principal;
+    const char *diretorio;
+    struct dirent **entradas;
+    int num;
+    int cpu_segundos;
+    Slot *quadros;
+    int *arrays;
+    int contagem[FX_ERRO + 1];
+} Lote;
+
+static int eh_entrada(const struct dirent *d) {
+    size_t n = strlen(d->d_name);
+    return n > 3 && strcmp(d->d_name + n - 3, ".in") == 0;
+}
+
+static char* ler_arquivo(const char *caminho, size_t *tamanho) {
+    FILE *arq = fopen(caminho, "rb");
+    if (!arq) return NULL;
+    size_t cap = 4096, n = 0, lidos;
+    char *dados = (char*)malloc(cap);
+    while ((lidos = fread(dados + n, 1, cap - n, arq)) > 0) {
+        n += lidos;
+        if (n == cap) dados = (char*)realloc(dados, cap *= 2);
+    }
+    fclose(arq);
+    *tamanho = n;
+    return dados;
+}
+
+static void ao_estourar(int sinal) {
+    (void)sinal;
+    ex.estourou = 1;
+}
+
+static void limitar_cpu(int segundos) {
+    struct itimerval t = { { 0, 0 }, { segundos, 0 } };
+    ex.estourou = 0;
+    setitimer(ITIMER_VIRTUAL, &t, NULL);
+}
+
+// grava a saída da faixa, compara com <nome>.out e informa o resultado
+static SituacaoFaixa concluir_faixa(Lote *lote, Faixa *fx) {
+    size_t n = strlen(lote->diretorio) + strlen(fx->nome) + 16;
+    char *saida = (char*)malloc(n), *esperada = (char*)malloc(n);
+    int base = (int)(strlen(fx->nome) - 3);
+    snprintf(saida, n, "%s/%.*s.saida", lote->diretorio, base, fx->nome);
+    snprintf(esperada, n, "%s/%.*s.out", lote->diretorio, base, fx->nome);
+
+    SituacaoFaixa situacao = FX_ERRO;
+    FILE *arq = fopen(saida, "wb");
+    if (!arq) {
+        perror(saida);
+    } else {
+        fwrite(fx->saida, 1, fx->tam_saida, arq);
+        fclose(arq);
+        size_t tam;
+        char *conteudo;
+        if (fx->tempo) {
+            situacao = FX_TEMPO;
+        } else if (fx->erro) {
+            fprintf(stderr, "ERRO DE EXECUCAO: %s em %s (%s)\n", fx->erro, fx->erro_funcao, fx->nome);
+        } else if (!(conteudo = ler_arquivo(esperada, &tam))) {
+            situacao = FX_EXECUTOU;
+        } else {
+            int igual = tam == fx->tam_saida && memcmp(conteudo, fx->saida, tam) == 0;
+            situacao = igual ? FX_OK : FX_DIFERENTE;
+            free(conteudo);
+        }
+    }
+    free(saida);
+    free(esperada);
+    return situacao;
+}
+
+// um grupo de até FX_LARGURA entradas a partir de 'primeira'
+static void executar_grupo(Lote *lote, int primeira) {
+    int n = lote->num - primeira < FX_LARGURA ? lote->num - primeira : FX_LARGURA;
+    memset(ex.faixas, 0, sizeof(ex.faixas));
+    ex.vivas = (Vetor){ 0 };
+    for (int l = 0; l < n; l++) {
+        Faixa *fx = &ex.faixas[l];
+        fx->nome = lote->entradas[primeira + l]->d_name;
+        size_t tam = strlen(lote->diretorio) + strlen(fx->nome) + 2;
+        char *caminho = (char*)malloc(tam);
+        snprintf(caminho, tam, "%s/%s", lote->diretorio, fx->nome);
+        fx->entrada = (unsigned char*)ler_arquivo(caminho, &fx->tam_entrada);
+        if (fx->entrada) ex.vivas[l] = -1;
+        else perror(caminho);
+        free(caminho);
+    }
+    for (int i = 0; i < lote->c->num_globais; i++) {
+        memset(lote->c->globais[i].dados, 0, lote->c->globais[i].bytes);
+    }
+
+    Fechamento chamada;
+    memset(&chamada, 0, sizeof(chamada));
+    chamada.funcao = lote->principal;
+    ex.topo = lote->quadros;
+    ex.topo_arrays = lote->arrays;
+    ex.funcao = lote->principal;
+    limitar_cpu(lote->cpu_segundos);
+    c_chamada(&chamada, NULL, &ex.vivas);
+    limitar_cpu(0);
+
+    for (int l = 0; l < n; l++) {
+        Faixa *fx = &ex.faixas[l];
+        SituacaoFaixa s = fx->entrada ? concluir_faixa(lote, fx) : FX_ERRO;
+        lote->contagem[s]++;
+        printf("%-24s %s\n", fx->nome, nomes_situacao[s]);
+        free(fx->entrada);
+        free(fx->saida);
+    }
+}
+
+static void executar_lote(void *arg) {
+    Lote *lote = (Lote*)arg;
+    for (int i = 0; i < lote->num; i += FX_LARGURA) executar_grupo(lote, i);
+}
+
+int faixas_executar_lote(TreeNode *raiz, const char *diretorio, int cpu_segundos) {
+    Compilador c;
+    memset(&c, 0, sizeof(c));
+
+    TreeNode *declaracoes = raiz->children[0];
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        TreeNode *decl = declaracoes->children[i];
+        if (strcmp(decl->node_type, "Fun-declaracao") == 0) {
+            compilar_funcao(&c, decl);
+            continue;
+        }
+        if (decl->num_children > 1) {
+            int tamanho = atoi(decl->children[1]->value);
+            Nome *n = declarar(&c, decl->value, NOME_ARRAY_GLOBAL, 0);
+            n->array = (int*)alocar_global(&c, sizeof(int) * (tamanho > 0 ? tamanho : 1) * FX_LARGURA);
+        } else {
+            Nome *n = declarar(&c, decl->value, NOME_GLOBAL, 0);
+            n->escalar = (Vetor*)alocar_global(&c, sizeof(Vetor));
+        }
+    }
+
+    Lote lote;
+    memset(&lote, 0, sizeof(lote));
+    lote.c = &c;
+    lote.diretorio = diretorio;
+    lote.cpu_segundos = cpu_segundos;
+    lote.principal = buscar_funcao(&c, "main");
+    if (!lote.principal) {
+        fprintf(stderr, "ERRO: programa sem main\n");
+        c.erros++;
+    }
+
+    int status = 1;
+    if (c.erros == 0) {
+        lote.num = scandir(diretorio, &lote.entradas, eh_entrada, alphasort);
+        if (lote.num < 0) perror(diretorio);
+    }
+    if (c.erros == 0 && lote.num >= 0) {
+        lote.quadros = (Slot*)aligned_alloc(sizeof(Vetor), sizeof(Slot) * FX_MAX_SLOTS);
+        lote.arrays = (int*)malloc(sizeof(int) * FX_MAX_ARRAYS);
+        ex.fim = lote.quadros + FX_MAX_SLOTS;
+        ex.fim_arrays = lote.arrays + FX_MAX_ARRAYS;
+        signal(SIGVTALRM, ao_estourar);
+
+        struct timespec inicio, fim;
+        clock_gettime(CLOCK_MONOTONIC, &inicio);
+        if (executar_em_pilha_propria(executar_lote, &lote, &ex.limite_pilha) == 0) {
+            clock_gettime(CLOCK_MONOTONIC, &fim);
+            double total = (double)(fim.tv_sec - inicio.tv_sec) + (double)(fim.tv_nsec - inicio.tv_nsec) / 1e9;
+            printf("%d execucoes em %d faixas: %d ok, %d executou, %d diferente, %d tempo, %d erro\n",
+                   lote.num, FX_LARGURA, lote.contagem[FX_OK], lote.contagem[FX_EXECUTOU],
+                   lote.contagem[FX_DIFERENTE], lote.contagem[FX_TEMPO], lote.contagem[FX_ERRO]);
+            printf("tempo total %.3fs, %.0f execucoes/s\n", total, total > 0 ? lote.num / total : 0.0);
+            status = lote.contagem[FX_OK] + lote.contagem[FX_EXECUTOU] == lote.num ? 0 : 1;
+        }
+        signal(SIGVTALRM, SIG_DFL);
+        free(lote.quadros);
+        free(lote.arrays);
+        for (int i = 0; i < lote.num; i++) free(lote.entradas[i]);
+        free(lote.entradas);
+    }
+
+    while (c.alocados) {
+        Fechamento *f = c.alocados;
+        c.alocados = f->alocado;
+        free(f->filhos);
+        free(f);
+    }
+    for (int i = 0; i < c.num_funcoes; i++) {
+        free(c.funcoes[i]->slot_array);
+        free(c.funcoes[i]->desloc_array);
+        free(c.funcoes[i]);
+    }
+    free(c.funcoes);
+    for (int i = 0; i < c.num_globais; i++) free(c.globais[i].dados);
+    free(c.globais);
+    while (c.nomes) {
+        Nome *n = c.nomes;
+        c.nomes = n->prox;
+        free(n);
+    }
+    return status;
+}
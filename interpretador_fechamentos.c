@@ -0,0 +1,667 @@
+/***********************************************/
+/* Interpretador por fechamentos: a árvore é   */
+/* compilada uma vez numa árvore de funções    */
+/* especializadas, com variáveis já resolvidas */
+/* para posições do quadro ou da memória       */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "interpretador.h"
+#include "entrada_saida.h"
+
+#define FC_MAX_SLOTS    (1 << 24)   /* pilha de quadros */
+#define FC_MAX_ARRAYS   (1 << 24)   /* pilha dos arrays locais, em ints */
+
+/* Posição de um quadro: escalar, ou endereço de array (parâmetro ou local) */
+typedef union {
+    int i;
+    int *p;
+} Slot;
+
+typedef struct Fechamento Fechamento;
+typedef struct Funcao Funcao;
+
+/*
+ * Expressões devolvem o valor; comandos devolvem 1 quando executaram um
+ * return (o valor fica em 'ex.retorno') e 0 caso contrário.
+ */
+typedef int (*Codigo)(Fechamento *f, Slot *q);
+
+struct Fechamento {
+    Codigo codigo;
+    int *(*endereco)(Fechamento *f, Slot *q);   /* argumento para parâmetro array */
+    int k;                  /* constante ou posição no quadro */
+    int *global;            /* escalar ou array global */
+    Fechamento *a, *b, *c;
+    Fechamento **filhos;    /* comandos do bloco ou argumentos */
+    int num_filhos;
+    Funcao *funcao;         /* função chamada */
+    Fechamento *alocado;    /* lista de tudo o que foi alocado, para liberar */
+};
+
+struct Funcao {
+    char *nome;
+    int num_params;
+    int num_slots;          /* parâmetros, escalares locais e arrays locais */
+    int tam_arrays;
+    int num_arrays;         /* arrays locais: posição no quadro e deslocamento */
+    int *slot_array;
+    int *desloc_array;
+    Fechamento *corpo;
+};
+
+/* Estado da execução, único: os fechamentos só recebem o nó e o quadro */
+static struct {
+    Slot *topo;
+    Slot *fim;
+    int *topo_arrays;
+    int *fim_arrays;
+    int retorno;
+    Funcao *funcao;
+    char *limite_pilha;
+    jmp_buf erro;
+    int status;
+} ex;
+
+static void erro_execucao(const char *mensagem) {
+    es_descarregar();
+    fprintf(stderr, "ERRO DE EXECUCAO: %s em %s\n", mensagem, ex.funcao->nome);
+    ex.status = 1;
+    longjmp(ex.erro, 1);
+}
+
+#define AVALIAR(f, q) ((f)->codigo((f), (q)))
+
+/* Folhas */
+
+static int c_num(Fechamento *f, Slot *q)        { (void)q; return f->k; }
+static int c_local(Fechamento *f, Slot *q)      { return q[f->k].i; }
+static int c_global(Fechamento *f, Slot *q)     { (void)q; return *f->global; }
+static int c_elem_local(Fechamento *f, Slot *q) { return q[f->k].p[AVALIAR(f->a, q)]; }
+static int c_elem_global(Fechamento *f, Slot *q) { return f->global[AVALIAR(f->a, q)]; }
+
+static int *e_local(Fechamento *f, Slot *q)     { return q[f->k].p; }
+static int *e_global(Fechamento *f, Slot *q)    { (void)q; return f->global; }
+
+static int c_atrib_local(Fechamento *f, Slot *q)  { return q[f->k].i = AVALIAR(f->a, q); }
+static int c_atrib_global(Fechamento *f, Slot *q) { return *f->global = AVALIAR(f->a, q); }
+
+// o índice é avaliado antes do valor
+static int c_atrib_elem_local(Fechamento *f, Slot *q) {
+    int i = AVALIAR(f->a, q);
+    int v = AVALIAR(f->b, q);
+    return q[f->k].p[i] = v;
+}
+
+static int c_atrib_elem_global(Fechamento *f, Slot *q) {
+    int i = AVALIAR(f->a, q);
+    int v = AVALIAR(f->b, q);
+    return f->global[i] = v;
+}
+
+/*
+ * Operações binárias em quatro formas: operandos quaisquer, constante à
+ * direita, variável local e constante, duas variáveis locais.
+ */
+#define BINARIO(nome, expr)                                                         \
+    static int nome(Fechamento *f, Slot *q) {                                       \
+        int x = AVALIAR(f->a, q), y = AVALIAR(f->b, q);                             \
+        return expr;                                                                \
+    }                                                                               \
+    static int nome##_k(Fechamento *f, Slot *q) {                                   \
+        int x = AVALIAR(f->a, q), y = f->k;                                         \
+        return expr;                                                                \
+    }                                                                               \
+    static int nome##_lk(Fechamento *f, Slot *q) {                                  \
+        int x = q[f->a->k].i, y = f->k;                                             \
+        return expr;                                                                \
+    }                                                                               \
+    static int nome##_ll(Fechamento *f, Slot *q) {                                  \
+        int x = q[f->a->k].i, y = q[f->b->k].i;                                     \
+        return expr;                                                                \
+    }
+
+BINARIO(c_add, (int)((unsigned)x + (unsigned)y))
+BINARIO(c_sub, (int)((unsigned)x - (unsigned)y))
+BINARIO(c_mul, (int)((unsigned)x * (unsigned)y))
+BINARIO(c_lt, x < y)
+BINARIO(c_le, x <= y)
+BINARIO(c_gt, x > y)
+BINARIO(c_ge, x >= y)
+BINARIO(c_eq, x == y)
+BINARIO(c_ne, x != y)
+
+static int c_div(Fechamento *f, Slot *q) {
+    int x = AVALIAR(f->a, q), y = AVALIAR(f->b, q);
+    if (y == 0 || (y == -1 && x == (int)0x80000000)) erro_execucao("divisao por zero");
+    return x / y;
+}
+
+// divisor constante diferente de 0 e -1: sem verificação
+static int c_div_k(Fechamento *f, Slot *q) {
+    return AVALIAR(f->a, q) / f->k;
+}
+
+/* Tabela das formas: [operador][genérica, _k, _lk, _ll] */
+static const struct {
+    const char *op;
+    Codigo formas[4];
+} binarios[] = {
+    { "+",  { c_add, c_add_k, c_add_lk, c_add_ll } },
+    { "-",  { c_sub, c_sub_k, c_sub_lk, c_sub_ll } },
+    { "*",  { c_mul, c_mul_k, c_mul_lk, c_mul_ll } },
+    { "<",  { c_lt, c_lt_k, c_lt_lk, c_lt_ll } },
+    { "<=", { c_le, c_le_k, c_le_lk, c_le_ll } },
+    { ">",  { c_gt, c_gt_k, c_gt_lk, c_gt_ll } },
+    { ">=", { c_ge, c_ge_k, c_ge_lk, c_ge_ll } },
+    { "==", { c_eq, c_eq_k, c_eq_lk, c_eq_ll } },
+    { "!=", { c_ne, c_ne_k, c_ne_lk, c_ne_ll } },
+};
+
+/* E/S pelo runtime comum dos executores */
+static int c_input(Fechamento *f, Slot *q) {
+    (void)f;
+    (void)q;
+    return es_input();
+}
+
+static int c_output(Fechamento *f, Slot *q) {
+    es_output(AVALIAR(f->a, q));
+    return 0;
+}
+
+static int c_chamada(Fechamento *f, Slot *q) {
+    Funcao *fn = f->funcao;
+    Slot *novo = ex.topo;
+    if (novo + fn->num_slots > ex.fim || ex.topo_arrays + fn->tam_arrays > ex.fim_arrays) {
+        erro_execucao("estouro da pilha");
+    }
+    char marca;
+    if (&marca < ex.limite_pilha) erro_execucao("estouro da pilha");
+
+    // os argumentos vão direto para o quadro novo, já reservado
+    ex.topo = novo + fn->num_params;
+    for (int i = 0; i < f->num_filhos; i++) {
+        Fechamento *arg = f->filhos[i];
+        if (arg->endereco) novo[i].p = arg->endereco(arg, q);
+        else novo[i].i = AVALIAR(arg, q);
+    }
+    ex.topo = novo + fn->num_slots;
+    memset(novo + fn->num_params, 0, sizeof(Slot) * (fn->num_slots - fn->num_params));
+
+    int *arrays = ex.topo_arrays;
+    if (fn->tam_arrays) {
+        memset(arrays, 0, sizeof(int) * fn->tam_arrays);
+        for (int i = 0; i < fn->num_arrays; i++) novo[fn->slot_array[i]].p = arrays + fn->desloc_array[i];
+        ex.topo_arrays += fn->tam_arrays;
+    }
+
+    Funcao *chamador = ex.funcao;
+    ex.funcao = fn;
+    int resultado = AVALIAR(fn->corpo, novo) ? ex.retorno : 0;
+    ex.funcao = chamador;
+    ex.topo = novo;
+    ex.topo_arrays = arrays;
+    return resultado;
+}
+
+/* Comandos */
+
+static int c_bloco(Fechamento *f, Slot *q) {
+    for (int i = 0; i < f->num_filhos; i++) {
+        Fechamento *c = f->filhos[i];
+        if (AVALIAR(c, q)) return 1;
+    }
+    return 0;
+}
+
+static int c_expressao(Fechamento *f, Slot *q) {
+    AVALIAR(f->a, q);
+    return 0;
+}
+
+static int c_vazio(Fechamento *f, Slot *q) {
+    (void)f;
+    (void)q;
+    return 0;
+}
+
+static int c_if(Fechamento *f, Slot *q) {
+    if (AVALIAR(f->a, q)) return AVALIAR(f->b, q);
+    return 0;
+}
+
+static int c_if_else(Fechamento *f, Slot *q) {
+    if (AVALIAR(f->a, q)) return AVALIAR(f->b, q);
+    return AVALIAR(f->c, q);
+}
+
+static int c_while(Fechamento *f, Slot *q) {
+    while (AVALIAR(f->a, q)) {
+        if (AVALIAR(f->b, q)) return 1;
+    }
+    return 0;
+}
+
+static int c_return(Fechamento *f, Slot *q) {
+    ex.retorno = AVALIAR(f->a, q);
+    return 1;
+}
+
+static int c_return0(Fechamento *f, Slot *q) {
+    (void)f;
+    (void)q;
+    ex.retorno = 0;
+    return 1;
+}
+
+/* Compilação */
+
+typedef enum {
+    NOME_LOCAL,         /* escalar no quadro */
+    NOME_ARRAY_LOCAL,   /* endereço de array no quadro (parâmetro ou local) */
+    NOME_GLOBAL,
+    NOME_ARRAY_GLOBAL
+} TipoNome;
+
+typedef struct Nome {
+    char *nome;
+    TipoNome tipo;
+    int slot;
+    int *global;
+    int nivel;
+    struct Nome *prox;
+} Nome;
+
+typedef struct {
+    Nome *nomes;
+    int nivel;
+    Funcao **funcoes;
+    int num_funcoes;
+    Funcao *f;
+    Fechamento *alocados;
+    int erros;
+} Compilador;
+
+static Fechamento* compilar_expressao(Compilador *c, TreeNode *node);
+static Fechamento* compilar_statement(Compilador *c, TreeNode *node);
+
+static void erro_fc(Compilador *c, const char *mensagem, const char *nome) {
+    fprintf(stderr, "ERRO SEMANTICO: %s: %s\n", mensagem, nome);
+    c->erros++;
+}
+
+static Fechamento* novo(Compilador *c, Codigo codigo) {
+    Fechamento *f = (Fechamento*)calloc(1, sizeof(Fechamento));
+    f->codigo = codigo;
+    f->alocado = c->alocados;
+    c->alocados = f;
+    return f;
+}
+
+static void declarar(Compilador *c, char *nome, TipoNome tipo, int slot, int *global) {
+    Nome *n = (Nome*)malloc(sizeof(Nome));
+    n->nome = nome;
+    n->tipo = tipo;
+    n->slot = slot;
+    n->global = global;
+    n->nivel = c->nivel;
+    n->prox = c->nomes;
+    c->nomes = n;
+}
+
+static Nome* buscar(Compilador *c, const char *nome) {
+    for (Nome *n = c->nomes; n; n = n->prox) {
+        if (strcmp(n->nome, nome) == 0) return n;
+    }
+    erro_fc(c, "Variável não declarada", nome);
+    return NULL;
+}
+
+static void fechar_escopo(Compilador *c) {
+    while (c->nomes && c->nomes->nivel == c->nivel) {
+        Nome *n = c->nomes;
+        c->nomes = n->prox;
+        free(n);
+    }
+    c->nivel--;
+}
+
+static int eh_array(Nome *n) {
+    return n->tipo == NOME_ARRAY_LOCAL || n->tipo == NOME_ARRAY_GLOBAL;
+}
+
+static Fechamento* compilar_variavel(Compilador *c, TreeNode *node) {
+    Nome *n = buscar(c, node->value);
+    if (!n) return novo(c, c_num);
+    if (eh_array(n)) {
+        erro_fc(c, "Array usado como valor", node->value);
+        return novo(c, c_num);
+    }
+    Fechamento *f = novo(c, n->tipo == NOME_LOCAL ? c_local : c_global);
+    f->k = n->slot;
+    f->global = n->global;
+    return f;
+}
+
+static Fechamento* compilar_atribuicao(Compilador *c, TreeNode *node) {
+    TreeNode *var = node->children[0];
+    Nome *n = buscar(c, var->value);
+    if (!n) return novo(c, c_num);
+
+    Fechamento *f;
+    if (strcmp(var->node_type, "Variavel-Array") == 0) {
+        if (!eh_array(n)) {
+            erro_fc(c, "Variável não é array", var->value);
+            return novo(c, c_num);
+        }
+        f = novo(c, n->tipo == NOME_ARRAY_LOCAL ? c_atrib_elem_local : c_atrib_elem_global);
+        f->a = compilar_expressao(c, var->children[0]);
+        f->b = compilar_expressao(c, node->children[1]);
+    } else {
+        if (eh_array(n)) {
+            erro_fc(c, "Atribuição a array inteiro", var->value);
+            return novo(c, c_num);
+        }
+        f = novo(c, n->tipo == NOME_LOCAL ? c_atrib_local : c_atrib_global);
+        f->a = compilar_expressao(c, node->children[1]);
+    }
+    f->k = n->slot;
+    f->global = n->global;
+    return f;
+}
+
+static Funcao* buscar_funcao(Compilador *c, const char *nome) {
+    for (int i = 0; i < c->num_funcoes; i++) {
+        if (strcmp(c->funcoes[i]->nome, nome) == 0) return c->funcoes[i];
+    }
+    return NULL;
+}
+
+static Fechamento* compilar_chamada(Compilador *c, TreeNode *node) {
+    TreeNode *args = node->children[0];
+    TreeNode *lista = args->num_children > 0 ? args->children[0] : NULL;
+    int num_args = lista ? lista->num_children : 0;
+
+    if (strcmp(node->value, "input") == 0) return novo(c, c_input);
+    if (strcmp(node->value, "output") == 0) {
+        if (num_args != 1) {
+            erro_fc(c, "Número incorreto de argumentos", node->value);
+            return novo(c, c_num);
+        }
+        Fechamento *f = novo(c, c_output);
+        f->a = compilar_expressao(c, lista->children[0]);
+        return f;
+    }
+
+    Funcao *fn = buscar_funcao(c, node->value);
+    if (!fn) {
+        erro_fc(c, "Função não declarada", node->value);
+        return novo(c, c_num);
+    }
+    if (num_args != fn->num_params) {
+        erro_fc(c, "Número incorreto de argumentos", node->value);
+        return novo(c, c_num);
+    }
+
+    Fechamento *f = novo(c, c_chamada);
+    f->funcao = fn;
+    f->num_filhos = num_args;
+    f->filhos = (Fechamento**)calloc(num_args ? num_args : 1, sizeof(Fechamento*));
+    for (int i = 0; i < num_args; i++) {
+        TreeNode *arg = lista->children[i];
+        Nome *n = NULL;
+        if (strcmp(arg->node_type, "Variavel") == 0) n = buscar(c, arg->value);
+        if (n && eh_array(n)) {
+            // array: passa o endereço
+            Fechamento *e = novo(c, NULL);
+            e->endereco = n->tipo == NOME_ARRAY_LOCAL ? e_local : e_global;
+            e->k = n->slot;
+            e->global = n->global;
+            f->filhos[i] = e;
+        } else {
+            f->filhos[i] = compilar_expressao(c, arg);
+        }
+    }
+    return f;
+}
+
+static int eh_local(Fechamento *f) {
+    return f->codigo == c_local;
+}
+
+static Fechamento* compilar_binario(Compilador *c, TreeNode *node) {
+    const char *op = node->children[1]->value;
+    Fechamento *f = novo(c, NULL);
+    f->a = compilar_expressao(c, node->children[0]);
+    f->b = compilar_expressao(c, node->children[2]);
+
+    if (strcmp(op, "/") == 0) {
+        int k = f->b->codigo == c_num ? f->b->k : 0;
+        if (k != 0 && k != -1) {
+            f->codigo = c_div_k;
+            f->k = k;
+        } else {
+            f->codigo = c_div;
+        }
+        return f;
+    }
+
+    for (size_t i = 0; i < sizeof(binarios) / sizeof(binarios[0]); i++) {
+        if (strcmp(op, binarios[i].op) != 0) continue;
+        if (f->b->codigo == c_num) {
+            f->k = f->b->k;
+            f->codigo = binarios[i].formas[eh_local(f->a) ? 2 : 1];
+        } else if (eh_local(f->a) && eh_local(f->b)) {
+            f->codigo = binarios[i].formas[3];
+        } else {
+            f->codigo = binarios[i].formas[0];
+        }
+        return f;
+    }
+    erro_fc(c, "Operador inválido", op);
+    f->codigo = c_num;
+    return f;
+}
+
+static Fechamento* compilar_expressao(Compilador *c, TreeNode *node) {
+    if (strcmp(node->node_type, "Num") == 0) {
+        Fechamento *f = novo(c, c_num);
+        f->k = atoi(node->value);
+        return f;
+    }
+    if (strcmp(node->node_type, "Variavel") == 0) return compilar_variavel(c, node);
+    if (strcmp(node->node_type, "Variavel-Array") == 0) {
+        Nome *n = buscar(c, node->value);
+        if (!n) return novo(c, c_num);
+        if (!eh_array(n)) {
+            erro_fc(c, "Variável não é array", node->value);
+            return novo(c, c_num);
+        }
+        Fechamento *f = novo(c, n->tipo == NOME_ARRAY_LOCAL ? c_elem_local : c_elem_global);
+        f->k = n->slot;
+        f->global = n->global;
+        f->a = compilar_expressao(c, node->children[0]);
+        return f;
+    }
+    if (strcmp(node->node_type, "Assign-Expression") == 0) return compilar_atribuicao(c, node);
+    if (strcmp(node->node_type, "Function-Call") == 0) return compilar_chamada(c, node);
+    if (node->num_children == 3) return compilar_binario(c, node);
+
+    erro_fc(c, "Expressão inválida", node->node_type);
+    return novo(c, c_num);
+}
+
+static Fechamento* compilar_composto(Compilador *c, TreeNode *node) {
+    c->nivel++;
+    // cada declaração tem a sua posição no quadro: um escalar mantém o valor
+    // entre iterações do laço em que foi declarado, como na IR
+    TreeNode *locais = node->children[0];
+    for (int i = 0; i < locais->num_children; i++) {
+        TreeNode *decl = locais->children[i];
+        Funcao *fn = c->f;
+        int slot = fn->num_slots++;
+        if (decl->num_children > 1) {
+            fn->slot_array = (int*)realloc(fn->slot_array, sizeof(int) * (fn->num_arrays + 1));
+            fn->desloc_array = (int*)realloc(fn->desloc_array, sizeof(int) * (fn->num_arrays + 1));
+            fn->slot_array[fn->num_arrays] = slot;
+            fn->desloc_array[fn->num_arrays] = fn->tam_arrays;
+            fn->num_arrays++;
+            fn->tam_arrays += atoi(decl->children[1]->value);
+            declarar(c, decl->value, NOME_ARRAY_LOCAL, slot, NULL);
+        } else {
+            declarar(c, decl->value, NOME_LOCAL, slot, NULL);
+        }
+    }
+
+    TreeNode *comandos = node->children[1];
+    Fechamento *f = novo(c, c_bloco);
+    f->num_filhos = comandos->num_children;
+    f->filhos = (Fechamento**)calloc(f->num_filhos ? f->num_filhos : 1, sizeof(Fechamento*));
+    for (int i = 0; i < comandos->num_children; i++) {
+        f->filhos[i] = compilar_statement(c, comandos->children[i]);
+    }
+    fechar_escopo(c);
+    return f;
+}
+
+static Fechamento* compilar_statement(Compilador *c, TreeNode *node) {
+    const char *tipo = node->node_type;
+    Fechamento *f;
+    if (strcmp(tipo, "Expressao-declaracao") == 0) {
+        f = novo(c, c_expressao);
+        f->a = compilar_expressao(c, node->children[0]);
+    } else if (strcmp(tipo, "Composto-declaracao") == 0) {
+        f = compilar_composto(c, node);
+    } else if (strcmp(tipo, "If-Statement") == 0 || strcmp(tipo, "If-Else-Statement") == 0) {
+        f = novo(c, node->num_children > 2 ? c_if_else : c_if);
+        f->a = compilar_expressao(c, node->children[0]);
+        f->b = compilar_statement(c, node->children[1]);
+        if (node->num_children > 2) f->c = compilar_statement(c, node->children[2]);
+    } else if (strcmp(tipo, "While-Statement") == 0) {
+        f = novo(c, c_while);
+        f->a = compilar_expressao(c, node->children[0]);
+        f->b = compilar_statement(c, node->children[1]);
+    } else if (strcmp(tipo, "Return-Statement") == 0) {
+        if (node->num_children > 0) {
+            f = novo(c, c_return);
+            f->a = compilar_expressao(c, node->children[0]);
+        } else {
+            f = novo(c, c_return0);
+        }
+    } else {
+        f = novo(c, c_vazio);
+    }
+    return f;
+}
+
+static void compilar_funcao(Compilador *c, TreeNode *node) {
+    Funcao *fn = (Funcao*)calloc(1, sizeof(Funcao));
+    fn->nome = node->value;
+    TreeNode *params = node->children[1];
+    TreeNode *lista = params->num_children > 0 ? params->children[0] : NULL;
+    fn->num_params = lista ? lista->num_children : 0;
+    fn->num_slots = fn->num_params;
+
+    // visível no próprio corpo (recursão)
+    c->funcoes = (Funcao**)realloc(c->funcoes, sizeof(Funcao*) * (c->num_funcoes + 1));
+    c->funcoes[c->num_funcoes++] = fn;
+    c->f = fn;
+
+    c->nivel++;
+    for (int i = 0; i < fn->num_params; i++) {
+        TreeNode *param = lista->children[i];
+        int array = strcmp(param->node_type, "params-lista") == 0;
+        declarar(c, param->value, array ? NOME_ARRAY_LOCAL : NOME_LOCAL, i, NULL);
+    }
+    fn->corpo = compilar_composto(c, node->children[2]);
+    fechar_escopo(c);
+}
+
+/* Execução */
+
+typedef struct {
+    Funcao *principal;
+    Slot *quadros;
+    int *arrays;
+} Programa;
+
+static void executar_programa(void *arg) {
+    Programa *prog = (Programa*)arg;
+    if (setjmp(ex.erro) != 0) return;
+
+    Fechamento chamada;
+    memset(&chamada, 0, sizeof(chamada));
+    chamada.funcao = prog->principal;
+    ex.topo = prog->quadros;
+    ex.topo_arrays = prog->arrays;
+    ex.funcao = prog->principal;
+    c_chamada(&chamada, NULL);
+}
+
+int fechamentos_executar(TreeNode *raiz) {
+    Compilador c;
+    memset(&c, 0, sizeof(c));
+
+    int **globais = NULL;
+    int num_globais = 0;
+    TreeNode *declaracoes = raiz->children[0];
+    for (int i = 0; i < declaracoes->num_children; i++) {
+        TreeNode *decl = declaracoes->children[i];
+        if (strcmp(decl->node_type, "Fun-declaracao") == 0) {
+            compilar_funcao(&c, decl);
+            continue;
+        }
+        int tamanho = decl->num_children > 1 ? atoi(decl->children[1]->value) : 1;
+        int *memoria = (int*)calloc(tamanho > 0 ? tamanho : 1, sizeof(int));
+        globais = (int**)realloc(globais, sizeof(int*) * (num_globais + 1));
+        globais[num_globais++] = memoria;
+        declarar(&c, decl->value, decl->num_children > 1 ? NOME_ARRAY_GLOBAL : NOME_GLOBAL, 0, memoria);
+    }
+
+    Programa prog;
+    prog.principal = buscar_funcao(&c, "main");
+    if (!prog.principal) {
+        fprintf(stderr, "ERRO: programa sem main\n");
+        c.erros++;
+    }
+
+    int status = 1;
+    if (c.erros == 0) {
+        prog.quadros = (Slot*)malloc(sizeof(Slot) * FC_MAX_SLOTS);
+        prog.arrays = (int*)malloc(sizeof(int) * FC_MAX_ARRAYS);
+        ex.fim = prog.quadros + FC_MAX_SLOTS;
+        ex.fim_arrays = prog.arrays + FC_MAX_ARRAYS;
+        ex.status = 0;
+        if (executar_em_pilha_propria(executar_programa, &prog, &ex.limite_pilha) == 0) {
+            status = ex.status;
+        }
+        es_descarregar();
+        free(prog.quadros);
+        free(prog.arrays);
+    }
+
+    while (c.alocados) {
+        Fechamento *f = c.alocados;
+        c.alocados = f->alocado;
+        free(f->filhos);
+        free(f);
+    }
+    for (int i = 0; i < c.num_funcoes; i++) {
+        free(c.funcoes[i]->slot_array);
+        free(c.funcoes[i]->desloc_array);
+        free(c.funcoes[i]);
+    }
+    free(c.funcoes);
+    for (int i = 0; i < num_globais; i++) free(globais[i]);
+    free(globais);
+    while (c.nomes) {
+        Nome *n = c.nomes;
+        c.nomes = n->prox;
+        free(n);
+    }
+    return status;
+}
@@ -0,0 +1,564 @@
+/***********************************************/
+/* Representação intermediária em forma SSA    */
+/* Construção, análises do CFG, limpeza e      */
+/* impressão das funções                       */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+
+/*
+ * Cria uma função vazia, sem blocos.
+ */
+IrFuncao* ir_nova_funcao(const char *nome) {
+    IrFuncao *f = (IrFuncao*)calloc(1, sizeof(IrFuncao));
+    f->nome = strdup(nome);
+    return f;
+}
+
+/*
+ * Cria um bloco básico e o acrescenta à lista de blocos da função.
+ */
+IrBloco* ir_novo_bloco(IrFuncao *f) {
+    IrBloco *b = (IrBloco*)calloc(1, sizeof(IrBloco));
+    b->id = f->prox_bloco++;
+
+    if (f->num_blocos == f->cap_blocos) {
+        f->cap_blocos = f->cap_blocos ? f->cap_blocos * 2 : 8;
+        f->blocos = (IrBloco**)realloc(f->blocos, sizeof(IrBloco*) * f->cap_blocos);
+    }
+    f->blocos[f->num_blocos++] = b;
+    return b;
+}
+
+/*
+ * Cria uma instrução fora de qualquer bloco. Toda instrução recebe um número
+ * único, usado tanto na impressão quanto como chave pelos passes.
+ */
+IrInstr* ir_nova_instr(IrFuncao *f, IrOp op, IrTipo tipo) {
+    IrInstr *i = (IrInstr*)calloc(1, sizeof(IrInstr));
+    i->op = op;
+    i->tipo = tipo;
+    i->id = f->prox_valor++;
+    return i;
+}
+
+static void reservar_args(IrInstr *instr) {
+    if (instr->num_args == instr->cap_args) {
+        instr->cap_args = instr->cap_args ? instr->cap_args * 2 : 2;
+        instr->args = (IrInstr**)realloc(instr->args, sizeof(IrInstr*) * instr->cap_args);
+        if (instr->op == IR_PHI) {
+            instr->origens = (IrBloco**)realloc(instr->origens,
+                                                sizeof(IrBloco*) * instr->cap_args);
+        }
+    }
+}
+
+void ir_add_arg(IrInstr *instr, IrInstr *arg) {
+    reservar_args(instr);
+    instr->args[instr->num_args++] = arg;
+}
+
+void ir_add_phi_arg(IrInstr *phi, IrInstr *arg, IrBloco *origem) {
+    reservar_args(phi);
+    phi->origens[phi->num_args] = origem;
+    phi->args[phi->num_args++] = arg;
+}
+
+void ir_remover_arg(IrInstr *instr, int pos) {
+    for (int i = pos; i + 1 < instr->num_args; i++) {
+        instr->args[i] = instr->args[i + 1];
+        if (instr->origens) instr->origens[i] = instr->origens[i + 1];
+    }
+    instr->num_args--;
+}
+
+void ir_add_alvo(IrInstr *instr, IrBloco *alvo) {
+    instr->alvos = (IrBloco**)realloc(instr->alvos, sizeof(IrBloco*) * (instr->num_alvos + 1));
+    instr->alvos[instr->num_alvos++] = alvo;
+}
+
+void ir_add_pred(IrBloco *bloco, IrBloco *pred) {
+    for (int i = 0; i < bloco->num_preds; i++) {
+        if (bloco->preds[i] == pred) return;
+    }
+    if (bloco->num_preds == bloco->cap_preds) {
+        bloco->cap_preds = bloco->cap_preds ? bloco->cap_preds * 2 : 2;
+        bloco->preds = (IrBloco**)realloc(bloco->preds, sizeof(IrBloco*) * bloco->cap_preds);
+    }
+    bloco->preds[bloco->num_preds++] = pred;
+}
+
+void ir_inserir_fim(IrBloco *bloco, IrInstr *instr) {
+    instr->bloco = bloco;
+    instr->prox = NULL;
+    instr->ant = bloco->ultimo;
+    if (bloco->ultimo) bloco->ultimo->prox = instr;
+    else bloco->primeiro = instr;
+    bloco->ultimo = instr;
+}
+
+void ir_inserir_antes(IrInstr *pos, IrInstr *instr) {
+    IrBloco *bloco = pos->bloco;
+    instr->bloco = bloco;
+    instr->prox = pos;
+    instr->ant = pos->ant;
+    if (pos->ant) pos->ant->prox = instr;
+    else bloco->primeiro = instr;
+    pos->ant = instr;
+}
+
+void ir_inserir_inicio(IrBloco *bloco, IrInstr *instr) {
+    if (bloco->primeiro) ir_inserir_antes(bloco->primeiro, instr);
+    else ir_inserir_fim(bloco, instr);
+}
+
+void ir_inserir_antes_terminador(IrBloco *bloco, IrInstr *instr) {
+    IrInstr *term = ir_terminador(bloco);
+    if (term) ir_inserir_antes(term, instr);
+    else ir_inserir_fim(bloco, instr);
+}
+
+/*
+ * Retira a instrução do seu bloco (a instrução continua válida).
+ */
+void ir_remover(IrInstr *instr) {
+    IrBloco *bloco = instr->bloco;
+    if (!bloco) return;
+    if (instr->ant) instr->ant->prox = instr->prox;
+    else bloco->primeiro = instr->prox;
+    if (instr->prox) instr->prox->ant = instr->ant;
+    else bloco->ultimo = instr->ant;
+    instr->ant = instr->prox = NULL;
+    instr->bloco = NULL;
+}
+
+IrFuncao* ir_buscar_funcao(IrModulo *mod, const char *nome) {
+    for (IrFuncao *f = mod->funcoes; f; f = f->prox) {
+        if (strcmp(f->nome, nome) == 0) return f;
+    }
+    return NULL;
+}
+
+int ir_eh_terminador(IrInstr *instr) {
+    return instr && (instr->op == IR_JMP || instr->op == IR_BR || instr->op == IR_CASOS ||
+                     instr->op == IR_RET);
+}
+
+IrInstr* ir_terminador(IrBloco *bloco) {
+    return ir_eh_terminador(bloco->ultimo) ? bloco->ultimo : NULL;
+}
+
+/*
+ * Instruções que não podem ser removidas mesmo sem usos. Divisão e resto
+ * só são puros com divisor constante que não é 0 nem -1: nos outros casos
+ * podem falhar, e a falha tem que acontecer mesmo sem uso do resultado.
+ */
+int ir_tem_efeito(IrInstr *instr) {
+    switch (instr->op) {
+        case IR_DIV:
+        case IR_REM: {
+            IrInstr *d = ir_valor(instr->args[1]);
+            return d->op != IR_CONST || d->imm == 0 || d->imm == -1;
+        }
+        case IR_STORE:
+        case IR_STOREG:
+        case IR_CALL:
+        case IR_VERIFICA:
+        case IR_JMP:
+        case IR_BR:
+        case IR_CASOS:
+        case IR_RET:
+            return 1;
+        case IR_COPY:
+            return instr->destino != NULL;
+        default:
+            return 0;
+    }
+}
+
+/* Funções pré-definidas registradas por add_built_in_functions() */
+int ir_eh_builtin(const char *nome) {
+    return strcmp(nome, "input") == 0 || strcmp(nome, "output") == 0;
+}
+
+int ir_eh_const(IrInstr *instr, int valor) {
+    instr = ir_valor(instr);
+    return instr->op == IR_CONST && instr->imm == valor;
+}
+
+int ir_num_instrucoes(IrFuncao *f) {
+    int total = 0;
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) total++;
+    }
+    return total;
+}
+
+/*
+ * Número de elementos do array de um IR_ENDERECO.
+ */
+int ir_tamanho_array(IrFuncao *f, IrInstr *endereco) {
+    if (endereco->nome) return endereco->imm;
+    return f->arrays_locais[endereco->imm];
+}
+
+/*
+ * Verifica se o bloco a domina o bloco b (exige ir_calcular_cfg).
+ */
+int ir_domina(IrBloco *a, IrBloco *b) {
+    while (b) {
+        if (a == b) return 1;
+        b = b->idom;
+    }
+    return 0;
+}
+
+const char* ir_nome_op(IrOp op) {
+    static const char *nomes[] = {
+        "const", "param", "add", "sub", "mul", "div", "rem",
+        "lt", "le", "gt", "ge", "eq", "ne", "escolha",
+        "endereco", "load", "store", "loadg", "storeg",
+        "call", "verifica", "phi", "copy", "jmp", "br", "casos", "ret"
+    };
+    return nomes[op];
+}
+
+/*
+ * Segue a cadeia de substituições até o valor atual.
+ */
+IrInstr* ir_valor(IrInstr *instr) {
+    IrInstr *v = instr;
+    while (v->subst) v = v->subst;
+    /* Compressão de caminho */
+    while (instr->subst && instr->subst != v) {
+        IrInstr *prox = instr->subst;
+        instr->subst = v;
+        instr = prox;
+    }
+    return v;
+}
+
+/*
+ * Registra que todos os usos de 'antigo' passam a usar 'novo' e retira
+ * 'antigo' do bloco. Os operandos são reescritos por ir_valor() sob demanda
+ * e de uma vez em ir_resolver_substituicoes().
+ */
+void ir_substituir(IrInstr *antigo, IrInstr *novo) {
+    novo = ir_valor(novo);
+    if (antigo == novo) return;
+    antigo->subst = novo;
+    ir_remover(antigo);
+}
+
+void ir_resolver_substituicoes(IrFuncao *f) {
+    for (int b = 0; b < f->num_blocos; b++) {
+        IrInstr *i = f->blocos[b]->primeiro;
+        while (i) {
+            IrInstr *prox = i->prox;
+            if (i->subst) {
+                ir_remover(i);
+            } else {
+                for (int a = 0; a < i->num_args; a++) i->args[a] = ir_valor(i->args[a]);
+                if (i->destino) i->destino = ir_valor(i->destino);
+            }
+            i = prox;
+        }
+    }
+}
+
+/*
+ * Troca a origem dos argumentos dos phis de 'bloco' que chegam por 'antigo'.
+ */
+void ir_trocar_origem_phis(IrBloco *bloco, IrBloco *antigo, IrBloco *novo) {
+    for (IrInstr *i = bloco->primeiro; i && i->op == IR_PHI; i = i->prox) {
+        for (int a = 0; a < i->num_args; a++) {
+            if (i->origens[a] == antigo) i->origens[a] = novo;
+        }
+    }
+}
+
+/* Interseção do algoritmo de Cooper, Harvey e Kennedy */
+static IrBloco* intersectar(IrBloco *a, IrBloco *b) {
+    while (a != b) {
+        while (a->ordem > b->ordem) a = a->idom;
+        while (b->ordem > a->ordem) b = b->idom;
+    }
+    return a;
+}
+
+/*
+ * Recalcula o CFG da função: remove blocos inalcançáveis, simplifica desvios
+ * condicionais com alvos iguais, refaz as listas de predecessores, ordena os
+ * blocos em pós-ordem reversa e calcula os dominadores imediatos.
+ */
+void ir_calcular_cfg(IrFuncao *f) {
+    int n = f->num_blocos;
+    IrBloco **pos_ordem = (IrBloco**)malloc(sizeof(IrBloco*) * (n + 1));
+    IrBloco **pilha = (IrBloco**)malloc(sizeof(IrBloco*) * (n + 1));
+    int *proximo = (int*)calloc(n + 1, sizeof(int));
+    int num_pos = 0, topo = 0;
+
+    for (int b = 0; b < n; b++) {
+        IrBloco *bloco = f->blocos[b];
+        bloco->aux = -1;
+        bloco->num_preds = 0;
+        bloco->idom = NULL;
+
+        IrInstr *term = ir_terminador(bloco);
+        if (term && term->op == IR_BR && term->alvos[0] == term->alvos[1]) {
+            term->op = IR_JMP;
+            term->num_args = 0;
+            term->num_alvos = 1;
+        }
+    }
+
+    /* Busca em profundidade iterativa a partir da entrada */
+    f->blocos[0]->aux = topo;
+    proximo[topo] = 0;
+    pilha[topo++] = f->blocos[0];
+    while (topo > 0) {
+        IrBloco *bloco = pilha[topo - 1];
+        IrInstr *term = ir_terminador(bloco);
+        int k = proximo[topo - 1]++;
+        if (term && k < term->num_alvos) {
+            IrBloco *alvo = term->alvos[k];
+            if (alvo->aux == -1) {
+                alvo->aux = 0;
+                proximo[topo] = 0;
+                pilha[topo++] = alvo;
+            }
+        } else {
+            pos_ordem[num_pos++] = bloco;
+            topo--;
+        }
+    }
+
+    /* Pós-ordem reversa */
+    for (int i = 0; i < num_pos; i++) {
+        f->blocos[i] = pos_ordem[num_pos - 1 - i];
+        f->blocos[i]->ordem = i;
+    }
+    f->num_blocos = num_pos;
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        IrInstr *term = ir_terminador(f->blocos[b]);
+        for (int k = 0; term && k < term->num_alvos; k++) {
+            ir_add_pred(term->alvos[k], f->blocos[b]);
+        }
+    }
+
+    /* Phis perdem argumentos de predecessores removidos */
+    for (int b = 0; b < f->num_blocos; b++) {
+        IrBloco *bloco = f->blocos[b];
+        for (IrInstr *i = bloco->primeiro; i && i->op == IR_PHI; i = i->prox) {
+            for (int a = 0; a < i->num_args; a++) {
+                int achou = 0;
+                for (int p = 0; p < bloco->num_preds; p++) {
+                    if (bloco->preds[p] == i->origens[a]) achou = 1;
+                }
+                if (!achou) ir_remover_arg(i, a--);
+            }
+        }
+    }
+
+    /* Dominadores (Cooper, Harvey e Kennedy) */
+    IrBloco *entrada = f->blocos[0];
+    entrada->idom = entrada;
+    int mudou = 1;
+    while (mudou) {
+        mudou = 0;
+        for (int b = 1; b < f->num_blocos; b++) {
+            IrBloco *bloco = f->blocos[b];
+            IrBloco *novo = NULL;
+            for (int p = 0; p < bloco->num_preds; p++) {
+                IrBloco *pred = bloco->preds[p];
+                if (!pred->idom) continue;
+                novo = novo ? intersectar(pred, novo) : pred;
+            }
+            if (novo != bloco->idom) {
+                bloco->idom = novo;
+                mudou = 1;
+            }
+        }
+    }
+    entrada->idom = NULL;
+
+    free(pos_ordem);
+    free(pilha);
+    free(proximo);
+}
+
+/*
+ * Remove phis cujos argumentos são todos o mesmo valor (ou o próprio phi).
+ */
+int ir_remover_phis_triviais(IrFuncao *f) {
+    int removidos = 0;
+    int mudou = 1;
+    while (mudou) {
+        mudou = 0;
+        for (int b = 0; b < f->num_blocos; b++) {
+            IrInstr *i = f->blocos[b]->primeiro;
+            while (i && i->op == IR_PHI) {
+                IrInstr *prox = i->prox;
+                IrInstr *igual = NULL;
+                int trivial = 1;
+                for (int a = 0; a < i->num_args; a++) {
+                    IrInstr *v = ir_valor(i->args[a]);
+                    if (v == i || v == igual) continue;
+                    if (igual) {
+                        trivial = 0;
+                        break;
+                    }
+                    igual = v;
+                }
+                if (trivial && igual) {
+                    ir_substituir(i, igual);
+                    removidos++;
+                    mudou = 1;
+                }
+                i = prox;
+            }
+        }
+    }
+    ir_resolver_substituicoes(f);
+    return removidos;
+}
+
+/*
+ * Elimina instruções sem efeito cujo valor não é usado. Retorna quantas
+ * instruções foram removidas.
+ */
+int ir_eliminar_codigo_morto(IrFuncao *f) {
+    int total = ir_num_instrucoes(f);
+    IrInstr **pilha = (IrInstr**)malloc(sizeof(IrInstr*) * (total + 1));
+    int topo = 0, removidos = 0;
+
+    ir_resolver_substituicoes(f);
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            i->aux = ir_tem_efeito(i);
+            if (i->aux) pilha[topo++] = i;
+        }
+    }
+
+    while (topo > 0) {
+        IrInstr *i = pilha[--topo];
+        for (int a = 0; a < i->num_args; a++) {
+            if (i->args[a]->bloco && !i->args[a]->aux) {
+                i->args[a]->aux = 1;
+                pilha[topo++] = i->args[a];
+            }
+        }
+        if (i->destino && i->destino->bloco && !i->destino->aux) {
+            i->destino->aux = 1;
+            pilha[topo++] = i->destino;
+        }
+    }
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        IrInstr *i = f->blocos[b]->primeiro;
+        while (i) {
+            IrInstr *prox = i->prox;
+            if (!i->aux) {
+                ir_remover(i);
+                removidos++;
+            }
+            i = prox;
+        }
+    }
+
+    free(pilha);
+    return removidos;
+}
+
+/* Impressão */
+
+static void imprimir_instr(IrInstr *i, FILE *saida) {
+    fprintf(saida, "    ");
+    if (i->op == IR_COPY && i->destino) {
+        fprintf(saida, "%%%d := %%%d\n", i->destino->id, i->args[0]->id);
+        return;
+    }
+    if (i->tipo != IR_T_VOID) fprintf(saida, "%%%d = ", i->id);
+    fprintf(saida, "%s", ir_nome_op(i->op));
+
+    switch (i->op) {
+        case IR_CONST:
+        case IR_PARAM:
+            fprintf(saida, " %d", i->imm);
+            break;
+        case IR_ENDERECO:
+            if (i->nome) fprintf(saida, " @%s", i->nome);
+            else fprintf(saida, " local#%d", i->imm);
+            break;
+        case IR_LOAD:
+            fprintf(saida, " %%%d[%%%d]", i->args[0]->id, i->args[1]->id);
+            break;
+        case IR_STORE:
+            fprintf(saida, " %%%d[%%%d], %%%d", i->args[0]->id, i->args[1]->id, i->args[2]->id);
+            break;
+        case IR_LOADG:
+            fprintf(saida, " @%s", i->nome);
+            break;
+        case IR_STOREG:
+            fprintf(saida, " @%s, %%%d", i->nome, i->args[0]->id);
+            break;
+        case IR_CALL:
+            fprintf(saida, " %s(", i->nome);
+            for (int a = 0; a < i->num_args; a++) {
+                fprintf(saida, "%s%%%d", a ? ", " : "", i->args[a]->id);
+            }
+            fprintf(saida, ")");
+            if (i->flags & IR_FLAG_CAUDA) fprintf(saida, " cauda");
+            break;
+        case IR_PHI:
+            for (int a = 0; a < i->num_args; a++) {
+                fprintf(saida, "%s [%%%d, B%d]", a ? "," : "", i->args[a]->id, i->origens[a]->id);
+            }
+            break;
+        default:
+            for (int a = 0; a < i->num_args; a++) {
+                fprintf(saida, "%s %%%d", a ? "," : "", i->args[a]->id);
+            }
+            for (int k = 0; k < i->num_alvos; k++) {
+                fprintf(saida, "%s B%d", (k || i->num_args) ? "," : "", i->alvos[k]->id);
+            }
+            if (i->flags & IR_FLAG_NAO_NEGATIVO) fprintf(saida, " naoneg");
+            break;
+    }
+    fprintf(saida, "\n");
+}
+
+void ir_imprimir_funcao(IrFuncao *f, FILE *saida) {
+    fprintf(saida, "funcao %s(", f->nome);
+    for (int p = 0; p < f->num_params; p++) {
+        fprintf(saida, "%s%s", p ? ", " : "", f->param_array[p] ? "int[]" : "int");
+    }
+    fprintf(saida, ") -> %s\n", f->retorna_int ? "int" : "void");
+    for (int a = 0; a < f->num_arrays_locais; a++) {
+        fprintf(saida, "  local#%d[%d]\n", a, f->arrays_locais[a]);
+    }
+    for (int b = 0; b < f->num_blocos; b++) {
+        IrBloco *bloco = f->blocos[b];
+        fprintf(saida, "  B%d:", bloco->id);
+        if (bloco->num_preds > 0) {
+            fprintf(saida, "  ; preds");
+            for (int p = 0; p < bloco->num_preds; p++) fprintf(saida, " B%d", bloco->preds[p]->id);
+        }
+        fprintf(saida, "\n");
+        for (IrInstr *i = bloco->primeiro; i; i = i->prox) imprimir_instr(i, saida);
+    }
+    fprintf(saida, "\n");
+}
+
+void ir_imprimir_modulo(IrModulo *mod, FILE *saida) {
+    for (IrGlobal *g = mod->globais; g; g = g->prox) {
+        if (g->tamanho > 0) fprintf(saida, "global @%s[%d]\n", g->nome, g->tamanho);
+        else fprintf(saida, "global @%s\n", g->nome);
+    }
+    if (mod->globais) fprintf(saida, "\n");
+    for (IrFuncao *f = mod->funcoes; f; f = f->prox) ir_imprimir_funcao(f, saida);
+}
@@ -0,0 +1,199 @@
+#ifndef IR_H
+#define IR_H
+
+#include <stdio.h>
+#include "tree.h"
+
+/*
+ * Representação intermediária (IR) do compilador.
+ *
+ * Cada função é um grafo de fluxo de controle (CFG) de blocos básicos com
+ * instruções de três endereços em forma SSA: toda instrução que produz um
+ * valor é o próprio valor, e os operandos apontam para as instruções que
+ * os definem. Variáveis locais escalares e parâmetros viram valores SSA;
+ * globais e arrays ficam em memória e são acessados por load/store.
+ */
+
+typedef enum {
+    IR_CONST,       /* constante inteira (imm) */
+    IR_PARAM,       /* parâmetro da função (imm = posição) */
+    IR_ADD,
+    IR_SUB,
+    IR_MUL,
+    IR_DIV,
+    IR_REM,         /* resto de a / b (sem operador próprio em C-) */
+    IR_LT,
+    IR_LE,
+    IR_GT,
+    IR_GE,
+    IR_EQ,
+    IR_NE,
+    IR_ESCOLHA,     /* args: condição, a, b; a se condição != 0, senão b */
+    IR_ENDERECO,    /* array global (nome, imm = tamanho) ou local (imm) */
+    IR_LOAD,        /* args: base, índice */
+    IR_STORE,       /* args: base, índice, valor */
+    IR_LOADG,       /* lê global escalar (nome) */
+    IR_STOREG,      /* escreve global escalar (nome); args: valor */
+    IR_CALL,        /* chamada da função (nome); args: argumentos */
+    IR_VERIFICA,    /* args: índice, tamanho; erro de execução fora de [0, tamanho) */
+    IR_PHI,         /* args[i] chega pelo bloco origens[i] */
+    IR_COPY,        /* cópia; fora do SSA escreve em destino */
+    IR_JMP,         /* desvio para alvos[0] */
+    IR_BR,          /* args: condição; alvos[0] se != 0, senão alvos[1] */
+    IR_CASOS,       /* args: valor, casos constantes; alvos[k] se valor == args[k], senão alvos[0] */
+    IR_RET          /* args: valor de retorno opcional */
+} IrOp;
+
+typedef enum {
+    IR_T_VOID,      /* instrução sem valor */
+    IR_T_INT,       /* inteiro de 32 bits */
+    IR_T_PTR        /* endereço de array */
+} IrTipo;
+
+struct IrBloco;
+
+typedef struct IrInstr {
+    IrOp op;
+    IrTipo tipo;
+    int id;                     /* número do valor (%id) */
+    int imm;                    /* constante, parâmetro ou array */
+    char *nome;                 /* global ou função chamada */
+
+    int num_args;
+    int cap_args;
+    struct IrInstr **args;
+    struct IrBloco **origens;   /* PHI: bloco de origem de cada argumento */
+
+    int num_alvos;
+    struct IrBloco **alvos;     /* sucessores (terminadores) */
+
+    struct IrInstr *destino;    /* COPY: valor sobrescrito (fora do SSA) */
+    struct IrInstr *subst;      /* valor que substitui esta instrução */
+
+    struct IrBloco *bloco;
+    struct IrInstr *ant;
+    struct IrInstr *prox;
+
+    int flags;                  /* IR_FLAG_* */
+    int aux;                    /* uso livre dos passes */
+} IrInstr;
+
+/* Chamada em posição de cauda que o gerador de código faz como salto */
+#define IR_FLAG_CAUDA 1
+/* DIV/REM cujo dividendo nunca é negativo ali (passe de faixas) */
+#define IR_FLAG_NAO_NEGATIVO 2
+
+typedef struct IrBloco {
+    int id;
+    IrInstr *primeiro;
+    IrInstr *ultimo;
+
+    int num_preds;
+    int cap_preds;
+    struct IrBloco **preds;
+
+    struct IrBloco *idom;       /* dominador imediato */
+    int ordem;                  /* posição na pós-ordem reversa */
+    int aux;                    /* uso livre dos passes */
+
+    /* Construção do SSA */
+    int selado;
+    IrInstr **defs;             /* definição corrente de cada variável */
+    IrInstr **phis_incompletos;
+} IrBloco;
+
+typedef struct IrFuncao {
+    char *nome;
+    int retorna_int;
+    int num_params;
+    int *param_array;           /* 1 se o parâmetro é array */
+
+    int num_blocos;
+    int cap_blocos;
+    IrBloco **blocos;           /* blocos[0] é a entrada */
+
+    int num_arrays_locais;
+    int *arrays_locais;         /* tamanho de cada array local */
+
+    int num_vars;               /* variáveis escalares (construção SSA) */
+    int prox_valor;
+    int prox_bloco;
+    struct IrFuncao *prox;
+} IrFuncao;
+
+typedef struct IrGlobal {
+    char *nome;
+    int tamanho;                /* 0 para escalar */
+    struct IrGlobal *prox;
+} IrGlobal;
+
+typedef struct IrModulo {
+    IrFuncao *funcoes;
+    IrGlobal *globais;
+    int erros;
+} IrModulo;
+
+/* Construção */
+IrFuncao* ir_nova_funcao(const char *nome);
+IrBloco* ir_novo_bloco(IrFuncao *f);
+IrInstr* ir_nova_instr(IrFuncao *f, IrOp op, IrTipo tipo);
+void ir_add_arg(IrInstr *instr, IrInstr *arg);
+void ir_add_phi_arg(IrInstr *phi, IrInstr *arg, IrBloco *origem);
+void ir_remover_arg(IrInstr *instr, int pos);
+void ir_add_alvo(IrInstr *instr, IrBloco *alvo);
+void ir_add_pred(IrBloco *bloco, IrBloco *pred);
+void ir_inserir_fim(IrBloco *bloco, IrInstr *instr);
+void ir_inserir_antes(IrInstr *pos, IrInstr *instr);
+void ir_inserir_inicio(IrBloco *bloco, IrInstr *instr);
+void ir_inserir_antes_terminador(IrBloco *bloco, IrInstr *instr);
+void ir_remover(IrInstr *instr);
+IrFuncao* ir_buscar_funcao(IrModulo *mod, const char *nome);
+
+/* Consultas */
+IrInstr* ir_terminador(IrBloco *bloco);
+int ir_eh_terminador(IrInstr *instr);
+int ir_tem_efeito(IrInstr *instr);
+int ir_eh_builtin(const char *nome);
+int ir_eh_const(IrInstr *instr, int valor);
+int ir_num_instrucoes(IrFuncao *f);
+int ir_tamanho_array(IrFuncao *f, IrInstr *endereco);
+int ir_domina(IrBloco *a, IrBloco *b);
+const char* ir_nome_op(IrOp op);
+
+/* Substituição de valores */
+IrInstr* ir_valor(IrInstr *instr);
+void ir_substituir(IrInstr *antigo, IrInstr *novo);
+void ir_resolver_substituicoes(IrFuncao *f);
+
+/* Análises e limpeza do CFG */
+void ir_calcular_cfg(IrFuncao *f);
+void ir_trocar_origem_phis(IrBloco *bloco, IrBloco *antigo, IrBloco *novo);
+int ir_remover_phis_triviais(IrFuncao *f);
+int ir_eliminar_codigo_morto(IrFuncao *f);
+
+/*
+ * Geração a partir da árvore sintática (gerador_ir.c). Com
+ * 'verificar_indices', cada acesso a array é precedido de IR_VERIFICA e
+ * cada parâmetro array ganha um parâmetro int escondido com o tamanho do
+ * array recebido, depois dos declarados e na mesma ordem; as chamadas
+ * passam esses tamanhos.
+ */
+IrModulo* ir_gerar(TreeNode *raiz, int verificar_indices);
+
+/*
+ * Variante de 'funcao' que começa no cabeçalho do While de número 'laco'
+ * (ordem em que aparecem no corpo), para continuar no código nativo uma
+ * execução iniciada em outro executor (on-stack replacement). Os
+ * parâmetros são todos ponteiros: o estado, de onde a variável escalar v
+ * (parâmetros escalares e depois locais, na ordem de declaração) é lida em
+ * estado[posicoes[v]], depois os parâmetros array e por fim os arrays
+ * locais, na ordem de declaração. A variante entra em mod com o nome dado.
+ */
+IrFuncao* ir_gerar_osr(IrModulo *mod, TreeNode *raiz, const char *funcao, int laco,
+                       const int *posicoes, const char *nome);
+
+/* Impressão */
+void ir_imprimir_funcao(IrFuncao *f, FILE *saida);
+void ir_imprimir_modulo(IrModulo *mod, FILE *saida);
+
+#endif // IR_H
@@ -0,0 +1,81 @@
+/***********************************************/
+/* Execução em memória (--run)                 */
+/* O código de máquina vai para uma região     */
+/* mapeada como executável e main é chamada    */
+/* direto, sem arquivos nem processos          */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "x86.h"
+#include "entrada_saida.h"
+
+int x86_carregar(IrModulo *mod, OpcoesX86 *op, ProgramaX86 *prog) {
+    CodigoX86 codigo;
+    x86_codigo_iniciar(&codigo);
+    x86_codificar_modulo(mod, op, &codigo);
+    // E/S pelo runtime comum, com a mesma semântica do runtime nativo
+    x86_codigo_externo(&codigo, "rt_input", (void*)es_input);
+    x86_codigo_externo(&codigo, "rt_output", (void*)es_output);
+    x86_codigo_externo(&codigo, "rt_indice", (void*)es_erro_indice);
+
+    // texto e .bss na mesma região, ao alcance das referências rel32
+    size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+    size_t tam_texto = ((size_t)codigo.tam_texto + pagina - 1) & ~(pagina - 1);
+    size_t tam_bss = ((size_t)codigo.tam_bss + pagina - 1) & ~(pagina - 1);
+    size_t total = tam_texto + (tam_bss ? tam_bss : pagina);
+    unsigned char *regiao = (unsigned char*)mmap(NULL, total, PROT_READ | PROT_WRITE,
+                                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (regiao == MAP_FAILED) {
+        perror("mmap");
+        x86_codigo_liberar(&codigo);
+        return 0;
+    }
+
+    unsigned long long base = (unsigned long long)(size_t)regiao;
+    SimboloX86 *principal = x86_codigo_simbolo(&codigo, "cm_main");
+    if (!principal || !x86_codigo_ligar(&codigo, base, base + tam_texto)) {
+        if (!principal) fprintf(stderr, "ERRO: simbolo indefinido: cm_main\n");
+        munmap(regiao, total);
+        x86_codigo_liberar(&codigo);
+        return 0;
+    }
+    memcpy(regiao, codigo.texto, codigo.tam_texto);
+    if (mprotect(regiao, tam_texto, PROT_READ | PROT_EXEC) != 0) {
+        perror("mprotect");
+        munmap(regiao, total);
+        x86_codigo_liberar(&codigo);
+        return 0;
+    }
+
+    prog->regiao = regiao;
+    prog->tamanho = total;
+    prog->principal = (void (*)(void))(void*)(regiao + principal->valor);
+    x86_codigo_liberar(&codigo);
+    return 1;
+}
+
+void x86_descarregar(ProgramaX86 *prog) {
+    munmap(prog->regiao, prog->tamanho);
+}
+
+int x86_executar(IrModulo *mod, OpcoesX86 *op) {
+    ProgramaX86 prog;
+    if (!x86_carregar(mod, op, &prog)) return 1;
+
+    // divisão por zero e afins: a saída já produzida não se perde
+    fflush(stdout);
+    signal(SIGFPE, es_ao_sinal);
+    signal(SIGSEGV, es_ao_sinal);
+    prog.principal();
+    es_descarregar();
+    signal(SIGFPE, SIG_DFL);
+    signal(SIGSEGV, SIG_DFL);
+
+    x86_descarregar(&prog);
+    return 0;
+}
@@ -0,0 +1,180 @@
+/***********************************************/
+/* Laços naturais do CFG                       */
+/* Detecção a partir das arestas de retorno e  */
+/* criação de preheaders                       */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+
+static int comparar_tamanho(const void *a, const void *b) {
+    const IrLaco *la = *(IrLaco* const*)a;
+    const IrLaco *lb = *(IrLaco* const*)b;
+    return la->num_blocos - lb->num_blocos;
+}
+
+/*
+ * Acrescenta ao corpo do laço tudo o que alcança 'fim' sem passar pelo
+ * cabeçalho (busca para trás).
+ */
+static void coletar_corpo(IrFuncao *f, IrLaco *laco, IrBloco *fim) {
+    IrBloco **pilha = (IrBloco**)malloc(sizeof(IrBloco*) * (f->num_blocos + 1));
+    int topo = 0;
+
+    if (!laco->contem[fim->ordem]) {
+        laco->contem[fim->ordem] = 1;
+        laco->num_blocos++;
+        pilha[topo++] = fim;
+    }
+    while (topo > 0) {
+        IrBloco *b = pilha[--topo];
+        for (int p = 0; p < b->num_preds; p++) {
+            IrBloco *pred = b->preds[p];
+            if (!laco->contem[pred->ordem]) {
+                laco->contem[pred->ordem] = 1;
+                laco->num_blocos++;
+                pilha[topo++] = pred;
+            }
+        }
+    }
+    free(pilha);
+}
+
+/*
+ * Encontra os laços naturais da função (exige ir_calcular_cfg). Arestas de
+ * retorno para o mesmo cabeçalho formam um único laço. O vetor devolvido
+ * vem ordenado do laço mais interno para o mais externo.
+ */
+int ir_encontrar_lacos(IrFuncao *f, IrLaco ***saida) {
+    IrLaco **lacos = NULL;
+    int num = 0;
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        IrBloco *cabecalho = f->blocos[b];
+        IrLaco *laco = NULL;
+        for (int p = 0; p < cabecalho->num_preds; p++) {
+            IrBloco *fim = cabecalho->preds[p];
+            if (!ir_domina(cabecalho, fim)) continue;
+            if (!laco) {
+                laco = (IrLaco*)calloc(1, sizeof(IrLaco));
+                laco->cabecalho = cabecalho;
+                laco->contem = (char*)calloc(f->num_blocos, 1);
+                laco->contem[cabecalho->ordem] = 1;
+                laco->num_blocos = 1;
+            }
+            coletar_corpo(f, laco, fim);
+        }
+        if (!laco) continue;
+
+        // preheader: unico predecessor de fora que so desvia para o cabecalho
+        IrBloco *fora = NULL;
+        int num_fora = 0;
+        for (int p = 0; p < cabecalho->num_preds; p++) {
+            if (!laco->contem[cabecalho->preds[p]->ordem]) {
+                fora = cabecalho->preds[p];
+                num_fora++;
+            }
+        }
+        if (num_fora == 1 && ir_terminador(fora)->op == IR_JMP) laco->preheader = fora;
+
+        lacos = (IrLaco**)realloc(lacos, sizeof(IrLaco*) * (num + 1));
+        lacos[num++] = laco;
+    }
+
+    qsort(lacos, num, sizeof(IrLaco*), comparar_tamanho);
+
+    // aninhamento: o pai e o menor laco que contem o cabecalho
+    for (int i = 0; i < num; i++) {
+        for (int j = i + 1; j < num && !lacos[i]->pai; j++) {
+            if (lacos[j]->contem[lacos[i]->cabecalho->ordem]) lacos[i]->pai = lacos[j];
+        }
+    }
+    for (int i = 0; i < num; i++) {
+        for (IrLaco *l = lacos[i]; l; l = l->pai) lacos[i]->profundidade++;
+    }
+
+    *saida = lacos;
+    return num;
+}
+
+void ir_liberar_lacos(IrLaco **lacos, int num) {
+    for (int i = 0; i < num; i++) {
+        free(lacos[i]->contem);
+        free(lacos[i]);
+    }
+    free(lacos);
+}
+
+/*
+ * Cria um bloco entre os predecessores de fora do laço e o cabeçalho, de
+ * modo que o laço tenha um único ponto de entrada onde código invariante
+ * pode ser colocado.
+ */
+static void criar_preheader(IrFuncao *f, IrLaco *laco) {
+    IrBloco *cabecalho = laco->cabecalho;
+    IrBloco *pre = ir_novo_bloco(f);
+    IrInstr *jmp = ir_nova_instr(f, IR_JMP, IR_T_VOID);
+    ir_add_alvo(jmp, cabecalho);
+    ir_inserir_fim(pre, jmp);
+
+    // a entrada da funcao nao tem predecessores: o preheader passa a ser a entrada
+    if (cabecalho == f->blocos[0]) {
+        f->blocos[f->num_blocos - 1] = cabecalho;
+        f->blocos[0] = pre;
+    }
+
+    int num_fora = 0;
+    for (int p = 0; p < cabecalho->num_preds; p++) {
+        IrBloco *pred = cabecalho->preds[p];
+        if (laco->contem[pred->ordem]) continue;
+        IrInstr *term = ir_terminador(pred);
+        for (int k = 0; k < term->num_alvos; k++) {
+            if (term->alvos[k] == cabecalho) term->alvos[k] = pre;
+        }
+        num_fora++;
+    }
+
+    // argumentos dos phis que vinham de fora passam a chegar pelo preheader
+    for (IrInstr *phi = cabecalho->primeiro; phi && phi->op == IR_PHI; phi = phi->prox) {
+        IrInstr *novo = NULL;
+        if (num_fora > 1) {
+            novo = ir_nova_instr(f, IR_PHI, phi->tipo);
+            ir_inserir_inicio(pre, novo);
+        }
+        for (int a = 0; a < phi->num_args; a++) {
+            if (laco->contem[phi->origens[a]->ordem]) continue;
+            if (novo) {
+                ir_add_phi_arg(novo, phi->args[a], phi->origens[a]);
+                ir_remover_arg(phi, a--);
+            } else {
+                phi->origens[a] = pre;
+            }
+        }
+        if (novo) ir_add_phi_arg(phi, novo, pre);
+    }
+}
+
+/*
+ * Garante que todo laço tenha preheader. Recalcula o CFG quando cria blocos
+ * e retorna quantos preheaders foram criados.
+ */
+int ir_inserir_preheaders(IrFuncao *f) {
+    IrLaco **lacos;
+    int criados = 0;
+
+    ir_calcular_cfg(f);
+    int num = ir_encontrar_lacos(f, &lacos);
+    for (int i = 0; i < num; i++) {
+        if (!lacos[i]->preheader) {
+            criar_preheader(f, lacos[i]);
+            criados++;
+        }
+    }
+    ir_liberar_lacos(lacos, num);
+
+    if (criados > 0) ir_calcular_cfg(f);
+    return criados;
+}
@@ -0,0 +1,150 @@
+/***********************************************/
+/* Movimentação de código invariante de laço   */
+/* (LICM): cálculos e loads que não mudam      */
+/* entre iterações vão para o preheader        */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+
+static int eh_invariante(IrLaco *laco, IrInstr *i) {
+    for (int a = 0; a < i->num_args; a++) {
+        if (laco->contem[i->args[a]->bloco->ordem]) return 0;
+    }
+    return 1;
+}
+
+/*
+ * A faixa do operando no preheader ainda vale: ele não foi movido (o
+ * estreitamento do bloco de onde saiu não vale no preheader).
+ */
+static int faixa_valida(IrInstr *v, char *movida) {
+    v = ir_valor(v);
+    return v->op == IR_CONST || !movida[v->id];
+}
+
+/* Nada antes de i no seu bloco tem efeito (chamada, store, falha) */
+static int primeiro_efeito(IrInstr *i) {
+    for (IrInstr *a = i->bloco->primeiro; a != i; a = a->prox) {
+        if (ir_tem_efeito(a)) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Verifica se a instrução pode executar no preheader mesmo quando o laço
+ * não executaria. O cabeçalho sempre executa depois do preheader, mas uma
+ * falha só sobe se nenhum efeito vem antes dela no cabeçalho (uma chamada
+ * que escreve a saída, por exemplo); nos demais blocos só sobe o que não
+ * pode falhar.
+ */
+static int pode_mover(IrFuncao *f, IrLaco *laco, IrInstr *i, MemoriaIr *mem, char *escritas,
+                      FaixasIr *fx, char *movida) {
+    int antecipavel = i->bloco == laco->cabecalho && primeiro_efeito(i);
+
+    switch (i->op) {
+        case IR_CONST:
+        case IR_ENDERECO:
+        case IR_ADD: case IR_SUB: case IR_MUL:
+        case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_EQ: case IR_NE: case IR_ESCOLHA:
+            return 1;
+
+        case IR_DIV:
+        case IR_REM: {
+            // divisao por zero (ou INT_MIN / -1) nao pode ser antecipada
+            IrInstr *d = i->args[1];
+            if (antecipavel || (d->op == IR_CONST && d->imm != 0 && d->imm != -1)) return 1;
+            // a menos que as faixas no preheader mostrem que ela nao falha
+            return faixa_valida(i->args[0], movida) && faixa_valida(d, movida) &&
+                   !faixas_divisao_pode_falhar(fx, i, laco->preheader);
+        }
+
+        case IR_VERIFICA:
+            // sobe antes do load que ela protege, que vem logo depois
+            return antecipavel;
+
+        case IR_LOADG:
+            return !escritas[memoria_classe_lida(mem, i)];
+
+        case IR_LOAD: {
+            if (escritas[memoria_classe_lida(mem, i)]) return 0;
+            if (antecipavel) return 1;
+            // fora do cabecalho, so elemento constante dentro de array conhecido
+            IrInstr *base = i->args[0], *indice = i->args[1];
+            return base->op == IR_ENDERECO && indice->op == IR_CONST &&
+                   indice->imm >= 0 && indice->imm < ir_tamanho_array(f, base);
+        }
+
+        default:
+            return 0;
+    }
+}
+
+/* Classes de memória escritas em algum bloco do laço */
+static void escritas_do_laco(IrFuncao *f, IrLaco *laco, MemoriaIr *mem, char *escritas) {
+    char *tmp = (char*)malloc(mem->num_classes + 1);
+    memset(escritas, 0, mem->num_classes);
+    for (int b = 0; b < f->num_blocos; b++) {
+        if (!laco->contem[b]) continue;
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            if (!memoria_escritas(mem, i, tmp)) continue;
+            for (int c = 0; c < mem->num_classes; c++) escritas[c] |= tmp[c];
+        }
+    }
+    free(tmp);
+}
+
+/*
+ * LICM sobre todos os laços da função, do mais interno para o mais externo,
+ * para que o que sobe de um laço interno possa continuar subindo. Retorna
+ * quantas instruções foram movidas.
+ */
+int otimizar_licm(IrFuncao *f) {
+    IrLaco **lacos;
+    MemoriaIr mem;
+    FaixasIr fx;
+    int movidas = 0;
+
+    ir_inserir_preheaders(f);
+    int num = ir_encontrar_lacos(f, &lacos);
+    memoria_preparar(&mem, f);
+    faixas_calcular(&fx, f);
+    char *escritas = (char*)malloc(mem.num_classes + 1);
+    char *movida = (char*)calloc(f->prox_valor + 1, 1);
+
+    for (int l = 0; l < num; l++) {
+        IrLaco *laco = lacos[l];
+        if (!laco->preheader) continue;
+        escritas_do_laco(f, laco, &mem, escritas);
+
+        // ordem reversa de pos-ordem: definicoes antes dos usos
+        for (int b = 0; b < f->num_blocos; b++) {
+            if (!laco->contem[b]) continue;
+            IrInstr *i = f->blocos[b]->primeiro;
+            while (i) {
+                IrInstr *prox = i->prox;
+                if (eh_invariante(laco, i) &&
+                    pode_mover(f, laco, i, &mem, escritas, &fx, movida)) {
+                    ir_remover(i);
+                    ir_inserir_antes_terminador(laco->preheader, i);
+                    movida[i->id] = 1;
+                    // no preheader o dividendo pode ser negativo
+                    i->flags &= ~IR_FLAG_NAO_NEGATIVO;
+                    movidas++;
+                }
+                i = prox;
+            }
+        }
+    }
+
+    free(escritas);
+    free(movida);
+    faixas_liberar(&fx);
+    memoria_liberar(&mem);
+    ir_liberar_lacos(lacos, num);
+    return movidas;
+}
@@ -0,0 +1,184 @@
+/***********************************************/
+/* Execução em lote (--lote)                   */
+/* O programa é carregado uma vez em memória e */
+/* cada entrada roda num filho criado com fork */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "x86.h"
+#include "entrada_saida.h"
+
+typedef enum {
+    LOTE_OK,            /* saída igual a <nome>.out */
+    LOTE_EXECUTOU,      /* terminou normalmente, sem .out para comparar */
+    LOTE_DIFERENTE,
+    LOTE_TEMPO,         /* estourou o limite de CPU */
+    LOTE_SINAL,         /* morreu por outro sinal */
+    LOTE_FALHOU,        /* erro de execução: terminou com status diferente de 0 */
+    LOTE_ERRO           /* não criou o filho ou os arquivos */
+} SituacaoLote;
+
+static const char *nomes_situacao[] = {
+    "ok", "executou", "diferente", "tempo", "sinal", "falhou", "erro"
+};
+
+static int eh_entrada(const struct dirent *d) {
+    size_t n = strlen(d->d_name);
+    return n > 3 && strcmp(d->d_name + n - 3, ".in") == 0;
+}
+
+/* Páginas já mapeadas no processo: o limite de memória vem além delas */
+static rlim_t memoria_mapeada(void) {
+    FILE *arq = fopen("/proc/self/statm", "r");
+    unsigned long paginas = 0;
+    if (arq) {
+        if (fscanf(arq, "%lu", &paginas) != 1) paginas = 0;
+        fclose(arq);
+    }
+    return (rlim_t)paginas * (rlim_t)sysconf(_SC_PAGESIZE);
+}
+
+static double segundos(struct timeval t) {
+    return (double)t.tv_sec + (double)t.tv_usec / 1e6;
+}
+
+/* Os dois arquivos têm o mesmo conteúdo? */
+static int mesmo_conteudo(const char *a, const char *b) {
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    int igual = fa && fb;
+    char ba[65536], bb[65536];
+    while (igual) {
+        size_t na = fread(ba, 1, sizeof(ba), fa);
+        size_t nb = fread(bb, 1, sizeof(bb), fb);
+        if (na != nb || memcmp(ba, bb, na) != 0) igual = 0;
+        if (na == 0) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return igual;
+}
+
+/* No filho: redireciona, limita e executa main; não retorna */
+static void executar_filho(ProgramaX86 *prog, int entrada, int saida,
+                           LimitesLote *limites, rlim_t base_memoria) {
+    dup2(entrada, 0);
+    dup2(saida, 1);
+    close(entrada);
+    close(saida);
+
+    struct rlimit cpu = { (rlim_t)limites->cpu_segundos, (rlim_t)limites->cpu_segundos + 1 };
+    struct rlimit memoria = { base_memoria + ((rlim_t)limites->memoria_mb << 20),
+                              base_memoria + ((rlim_t)limites->memoria_mb << 20) };
+    setrlimit(RLIMIT_CPU, &cpu);
+    setrlimit(RLIMIT_AS, &memoria);
+
+    signal(SIGFPE, es_ao_sinal);
+    signal(SIGSEGV, es_ao_sinal);
+    prog->principal();
+    es_descarregar();
+    _exit(0);
+}
+
+static SituacaoLote executar_entrada(ProgramaX86 *prog, const char *dir, const char *nome,
+                                     LimitesLote *limites, rlim_t base_memoria,
+                                     double *real, double *cpu, int *sinal, int *codigo) {
+    size_t n = strlen(dir) + strlen(nome) + 16;
+    char *entrada = (char*)malloc(n), *saida = (char*)malloc(n), *esperada = (char*)malloc(n);
+    int base = (int)(strlen(nome) - 3);
+    snprintf(entrada, n, "%s/%s", dir, nome);
+    snprintf(saida, n, "%s/%.*s.saida", dir, base, nome);
+    snprintf(esperada, n, "%s/%.*s.out", dir, base, nome);
+
+    SituacaoLote situacao = LOTE_ERRO;
+    int fd_entrada = open(entrada, O_RDONLY);
+    int fd_saida = open(saida, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    struct timespec inicio, fim;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    pid_t pid = fd_entrada >= 0 && fd_saida >= 0 ? fork() : -1;
+    if (pid == 0) executar_filho(prog, fd_entrada, fd_saida, limites, base_memoria);
+    if (fd_entrada >= 0) close(fd_entrada);
+    if (fd_saida >= 0) close(fd_saida);
+
+    int status;
+    struct rusage uso;
+    if (pid > 0 && wait4(pid, &status, 0, &uso) == pid) {
+        clock_gettime(CLOCK_MONOTONIC, &fim);
+        *real = (double)(fim.tv_sec - inicio.tv_sec) + (double)(fim.tv_nsec - inicio.tv_nsec) / 1e9;
+        *cpu = segundos(uso.ru_utime) + segundos(uso.ru_stime);
+        if (WIFSIGNALED(status)) {
+            *sinal = WTERMSIG(status);
+            situacao = *sinal == SIGXCPU || *sinal == SIGKILL ? LOTE_TEMPO : LOTE_SINAL;
+        } else if (WEXITSTATUS(status) != 0) {
+            *codigo = WEXITSTATUS(status);
+            situacao = LOTE_FALHOU;
+        } else if (access(esperada, R_OK) != 0) {
+            situacao = LOTE_EXECUTOU;
+        } else {
+            situacao = mesmo_conteudo(saida, esperada) ? LOTE_OK : LOTE_DIFERENTE;
+        }
+    } else {
+        perror(pid < 0 && fd_entrada >= 0 && fd_saida >= 0 ? "fork" : entrada);
+    }
+    free(entrada);
+    free(saida);
+    free(esperada);
+    return situacao;
+}
+
+int x86_executar_lote(IrModulo *mod, OpcoesX86 *op, const char *diretorio, LimitesLote *limites) {
+    struct dirent **entradas;
+    int num = scandir(diretorio, &entradas, eh_entrada, alphasort);
+    if (num < 0) {
+        perror(diretorio);
+        return 1;
+    }
+
+    ProgramaX86 prog;
+    if (!x86_carregar(mod, op, &prog)) return 1;
+
+    // os filhos herdam os buffers: nada pendente antes do fork
+    fflush(stdout);
+    fflush(stderr);
+    rlim_t base_memoria = memoria_mapeada();
+
+    int contagem[LOTE_ERRO + 1] = { 0 };
+    double total_cpu = 0;
+    struct timespec inicio, fim;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (int i = 0; i < num; i++) {
+        double real = 0, cpu = 0;
+        int sinal = 0, codigo = 0;
+        SituacaoLote s = executar_entrada(&prog, diretorio, entradas[i]->d_name, limites,
+                                          base_memoria, &real, &cpu, &sinal, &codigo);
+        contagem[s]++;
+        total_cpu += cpu;
+        char rotulo[32];
+        if (s == LOTE_SINAL) snprintf(rotulo, sizeof(rotulo), "sinal %d", sinal);
+        else if (s == LOTE_FALHOU) snprintf(rotulo, sizeof(rotulo), "falhou %d", codigo);
+        else snprintf(rotulo, sizeof(rotulo), "%s", nomes_situacao[s]);
+        printf("%-24s %-10s %9.3fms %9.3fms cpu\n", entradas[i]->d_name, rotulo, real * 1e3, cpu * 1e3);
+        fflush(stdout);
+        free(entradas[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    free(entradas);
+    x86_descarregar(&prog);
+
+    double total = (double)(fim.tv_sec - inicio.tv_sec) + (double)(fim.tv_nsec - inicio.tv_nsec) / 1e9;
+    printf("%d execucoes: %d ok, %d executou, %d diferente, %d tempo, %d sinal, %d falhou, %d erro\n",
+           num, contagem[LOTE_OK], contagem[LOTE_EXECUTOU], contagem[LOTE_DIFERENTE],
+           contagem[LOTE_TEMPO], contagem[LOTE_SINAL], contagem[LOTE_FALHOU], contagem[LOTE_ERRO]);
+    printf("tempo total %.3fs (%.3fs de CPU nos filhos), %.0f execucoes/s\n",
+           total, total_cpu, total > 0 ? num / total : 0.0);
+    return contagem[LOTE_OK] + contagem[LOTE_EXECUTOU] == num ? 0 : 1;
+}
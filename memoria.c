@@ -0,0 +1,114 @@
+/***********************************************/
+/* Classes de localização de memória da IR     */
+/* Usadas pelos passes para saber quais loads  */
+/* podem ser afetados por stores e chamadas    */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+
+int memoria_classe_global(MemoriaIr *mem, const char *nome, int eh_array) {
+    for (int i = 0; i < mem->num_globais; i++) {
+        if (strcmp(mem->globais[i], nome) == 0) return i;
+    }
+    mem->globais = (char**)realloc(mem->globais, sizeof(char*) * (mem->num_globais + 1));
+    mem->global_eh_array = (int*)realloc(mem->global_eh_array, sizeof(int) * (mem->num_globais + 1));
+    mem->globais[mem->num_globais] = (char*)nome;
+    mem->global_eh_array[mem->num_globais] = eh_array;
+    return mem->num_globais++;
+}
+
+/*
+ * Enumera as classes da função: cada global citada, cada array local e a
+ * classe "desconhecida" dos parâmetros array. Arrays locais passados como
+ * argumento escapam e podem ser alterados por quem os recebe.
+ */
+void memoria_preparar(MemoriaIr *mem, IrFuncao *f) {
+    memset(mem, 0, sizeof(MemoriaIr));
+
+    mem->num_locais = f->num_arrays_locais;
+    mem->local_escapa = (int*)calloc(mem->num_locais + 1, sizeof(int));
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            if (i->op == IR_ENDERECO && i->nome) memoria_classe_global(mem, i->nome, 1);
+            if (i->op == IR_LOADG || i->op == IR_STOREG) memoria_classe_global(mem, i->nome, 0);
+            if (i->op == IR_CALL) {
+                for (int a = 0; a < i->num_args; a++) {
+                    IrInstr *arg = ir_valor(i->args[a]);
+                    if (arg->op == IR_ENDERECO && !arg->nome) mem->local_escapa[arg->imm] = 1;
+                }
+            }
+        }
+    }
+    mem->desconhecida = mem->num_globais + mem->num_locais;
+    mem->num_classes = mem->desconhecida + 1;
+}
+
+void memoria_liberar(MemoriaIr *mem) {
+    free(mem->globais);
+    free(mem->global_eh_array);
+    free(mem->local_escapa);
+}
+
+/* Classe de memória apontada por um endereço */
+int memoria_classe_base(MemoriaIr *mem, IrInstr *base) {
+    base = ir_valor(base);
+    if (base->op == IR_ENDERECO) {
+        if (base->nome) return memoria_classe_global(mem, base->nome, 1);
+        return mem->num_globais + base->imm;
+    }
+    return mem->desconhecida;
+}
+
+/* Classe lida por um LOAD ou LOADG */
+int memoria_classe_lida(MemoriaIr *mem, IrInstr *i) {
+    if (i->op == IR_LOADG) return memoria_classe_global(mem, i->nome, 0);
+    return memoria_classe_base(mem, i->args[0]);
+}
+
+static int eh_local(MemoriaIr *mem, int classe) {
+    return classe >= mem->num_globais && classe < mem->desconhecida;
+}
+
+static int pode_ser_apontada(MemoriaIr *mem, int classe) {
+    if (classe < mem->num_globais) return mem->global_eh_array[classe];
+    if (eh_local(mem, classe)) return mem->local_escapa[classe - mem->num_globais];
+    return 1;
+}
+
+/*
+ * Marca em 'escritas' (num_classes posições) as classes que a instrução pode
+ * modificar. Retorna 0, sem tocar em 'escritas', se ela não escreve memória.
+ */
+int memoria_escritas(MemoriaIr *mem, IrInstr *i, char *escritas) {
+    if (i->op == IR_STOREG) {
+        memset(escritas, 0, mem->num_classes);
+        escritas[memoria_classe_global(mem, i->nome, 0)] = 1;
+        return 1;
+    }
+    if (i->op == IR_STORE) {
+        int c = memoria_classe_base(mem, i->args[0]);
+        memset(escritas, 0, mem->num_classes);
+        escritas[c] = 1;
+        if (c == mem->desconhecida) {
+            // pode ser qualquer array global ou local que escapou
+            for (int k = 0; k < mem->num_classes; k++) {
+                if (pode_ser_apontada(mem, k)) escritas[k] = 1;
+            }
+        } else if (pode_ser_apontada(mem, c)) {
+            escritas[mem->desconhecida] = 1;
+        }
+        return 1;
+    }
+    if (i->op == IR_CALL && !ir_eh_builtin(i->nome)) {
+        // a função chamada pode escrever em globais e no que recebeu
+        for (int k = 0; k < mem->num_classes; k++) {
+            escritas[k] = !eh_local(mem, k) || mem->local_escapa[k - mem->num_globais];
+        }
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+/***********************************************/
+/* Pipeline de otimização da IR                */
+/* Executa os passes em ordem sobre cada       */
+/* função e imprime o relatório por função     */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ir.h"
+#include "otimizador.h"
+
+void opcoes_otimizacao_padrao(OpcoesOtimizacao *op) {
+    op->inline_ativo = 1;
+    op->faixas_ativo = 1;
+    op->custo_inline.limite = 30;
+    op->custo_inline.limite_folha = 120;
+    op->custo_inline.bonus_chamada = 10;
+    op->custo_inline.bonus_constante = 5;
+    op->custo_inline.bonus_array = 8;
+    op->custo_inline.tamanho_maximo = 2000;
+}
+
+void otimizar_funcao(IrModulo *mod, IrFuncao *f, GrafoChamadas *grafo,
+                     OpcoesOtimizacao *op, FILE *relatorio) {
+    int expandidas = 0;
+    if (grafo && op->inline_ativo) {
+        expandidas = otimizar_inline(mod, grafo, f, &op->custo_inline, relatorio);
+    }
+    otimizar_chamadas_cauda(f, relatorio);
+    int gvn = otimizar_gvn(f);
+    int restos = otimizar_idiomas(f);
+    int desvios = 0, simplificadas = 0;
+    if (op->faixas_ativo) desvios = otimizar_faixas(f, &simplificadas);
+    // o que as faixas trocaram por constante ainda simplifica as contas
+    if (desvios > 0 || simplificadas > 0) gvn += otimizar_gvn(f);
+    int tabelas, desvios_busca;
+    int cadeias = otimizar_casos(f, &tabelas, &desvios_busca);
+    int escolhas;
+    int trocados = otimizar_escolhas(f, &escolhas);
+    int licm = otimizar_licm(f);
+    int icadas;
+    int verificacoes = otimizar_verificacoes(f, &icadas);
+
+    if (relatorio) {
+        fprintf(relatorio, "[inline] %s: %d chamadas expandidas\n", f->nome, expandidas);
+        fprintf(relatorio, "[gvn] %s: %d instrucoes eliminadas\n", f->nome, gvn);
+        fprintf(relatorio, "[idiomas] %s: %d restos reconhecidos\n", f->nome, restos);
+        fprintf(relatorio, "[faixas] %s: %d desvios dobrados, %d instrucoes simplificadas\n",
+                f->nome, desvios, simplificadas);
+        fprintf(relatorio, "[casos] %s: %d cadeias trocadas por %d tabelas e %d desvios\n",
+                f->nome, cadeias, tabelas, desvios_busca);
+        fprintf(relatorio, "[escolhas] %s: %d desvios trocados por %d escolhas\n",
+                f->nome, trocados, escolhas);
+        fprintf(relatorio, "[licm] %s: %d instrucoes movidas para fora de lacos\n",
+                f->nome, licm);
+        fprintf(relatorio, "[verificacoes] %s: %d removidas, %d icadas para fora de lacos\n",
+                f->nome, verificacoes, icadas);
+    }
+}
+
+void otimizar_modulo(IrModulo *mod, GrafoChamadas *grafo, OpcoesOtimizacao *op,
+                     FILE *relatorio) {
+    OpcoesOtimizacao padrao;
+    if (!op) {
+        opcoes_otimizacao_padrao(&padrao);
+        op = &padrao;
+    }
+
+    if (!grafo) {
+        for (IrFuncao *f = mod->funcoes; f; f = f->prox) {
+            otimizar_funcao(mod, f, NULL, op, relatorio);
+        }
+        return;
+    }
+
+    // de baixo para cima: quem é expandido já chega otimizado
+    if (relatorio) grafo_chamadas_imprimir(grafo, relatorio);
+    for (int i = 0; i < grafo->num; i++) {
+        IrFuncao *f = ir_buscar_funcao(mod, grafo->ordem[i]->nome);
+        if (f) otimizar_funcao(mod, f, grafo, op, relatorio);
+    }
+}
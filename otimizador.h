@@ -0,0 +1,206 @@
+#ifndef OTIMIZADOR_H
+#define OTIMIZADOR_H
+
+#include <stdio.h>
+#include "ir.h"
+#include "semantico.h"
+
+/*
+ * Passes de otimização sobre a IR. Cada passe trabalha sobre uma função e
+ * retorna quantas instruções (ou construções) foram eliminadas/alteradas,
+ * valor usado nos relatórios por função.
+ */
+
+/*
+ * Memória: cada global (escalar ou array) e cada array local é uma classe
+ * de localização. Parâmetros array podem apontar para qualquer array e
+ * ficam na classe "desconhecida".
+ */
+typedef struct {
+    int num_classes;
+    int num_globais;
+    char **globais;
+    int *global_eh_array;
+    int num_locais;
+    int *local_escapa;      /* array local passado para outra função */
+    int desconhecida;
+} MemoriaIr;
+
+void memoria_preparar(MemoriaIr *mem, IrFuncao *f);
+void memoria_liberar(MemoriaIr *mem);
+int memoria_classe_global(MemoriaIr *mem, const char *nome, int eh_array);
+int memoria_classe_base(MemoriaIr *mem, IrInstr *base);
+int memoria_classe_lida(MemoriaIr *mem, IrInstr *i);
+int memoria_escritas(MemoriaIr *mem, IrInstr *i, char *escritas);
+
+/*
+ * Laço natural: cabeçalho mais os blocos que alcançam uma aresta de retorno
+ * sem passar por ele. 'contem' é indexado por IrBloco.ordem e só vale até o
+ * próximo ir_calcular_cfg.
+ */
+typedef struct IrLaco {
+    IrBloco *cabecalho;
+    IrBloco *preheader;     /* único predecessor de fora, se existir */
+    char *contem;
+    int num_blocos;
+    int profundidade;       /* 1 para laços mais externos */
+    struct IrLaco *pai;
+} IrLaco;
+
+int ir_encontrar_lacos(IrFuncao *f, IrLaco ***lacos);
+void ir_liberar_lacos(IrLaco **lacos, int num);
+int ir_inserir_preheaders(IrFuncao *f);
+
+/* Chamadas com mais argumentos passam parte deles na pilha e não podem
+ * virar salto (a área de argumentos do chamador pode ser menor) */
+#define MAX_ARGS_CAUDA 6
+
+// Elimina chamadas de cauda; lista cada chamada convertida em 'relatorio'
+int otimizar_chamadas_cauda(IrFuncao *f, FILE *relatorio);
+
+// Numeração global de valores e eliminação de subexpressões comuns
+int otimizar_gvn(IrFuncao *f);
+
+// Reconhece a - a/b*b e reescreve como resto (IR_REM)
+int otimizar_idiomas(IrFuncao *f);
+
+// Move computações e loads invariantes para o preheader dos laços
+int otimizar_licm(IrFuncao *f);
+
+/*
+ * Faixas de valores: o intervalo [min, max] de cada valor inteiro da IR
+ * (vazio, min > max, no código que nunca executa). Exige ir_calcular_cfg
+ * e vale até a próxima mudança no CFG; uma instrução movida de bloco
+ * perde o estreitamento dos desvios acima do bloco original, e sua faixa
+ * não deve mais ser consultada.
+ */
+typedef struct {
+    int min, max;
+} FaixaIr;
+
+typedef struct {
+    IrFuncao *f;
+    int num;                    /* valores existentes no cálculo */
+    FaixaIr *faixas;            /* por id do valor */
+} FaixasIr;
+
+void faixas_calcular(FaixasIr *fx, IrFuncao *f);
+void faixas_liberar(FaixasIr *fx);
+// Faixa de v dentro do bloco, estreitada pelos desvios que o dominam
+FaixaIr faixas_no_bloco(FaixasIr *fx, IrInstr *v, IrBloco *bloco);
+// Divisão/resto que pode falhar no bloco (divisor zero ou INT_MIN / -1)
+int faixas_divisao_pode_falhar(FaixasIr *fx, IrInstr *i, IrBloco *bloco);
+
+/*
+ * Dobra os desvios cuja condição a faixa decide e troca por constante as
+ * instruções de faixa unitária (e a % b por a quando |a| < |b|). Retorna
+ * quantos desvios dobrou; 'simplificadas' recebe quantas instruções trocou.
+ */
+int otimizar_faixas(IrFuncao *f, int *simplificadas);
+
+/*
+ * Refaz cadeias de if-else-if que comparam um mesmo valor com constantes
+ * como busca binária, com IR_CASOS (tabela de saltos) nos trechos densos.
+ * Retorna quantas cadeias trocou; 'tabelas' e 'desvios' recebem quantas
+ * tabelas e desvios criou.
+ */
+int otimizar_casos(IrFuncao *f, int *tabelas, int *desvios);
+
+/*
+ * Troca por IR_ESCOLHA os phis de um if-else (ou if sem else) cujos lados
+ * só calculam valores, sem efeitos nem divisões, e o desvio por salto.
+ * Retorna quantos desvios trocou; 'escolhas' recebe quantas escolhas criou.
+ */
+int otimizar_escolhas(IrFuncao *f, int *escolhas);
+
+/*
+ * Remove as verificações de índice (IR_VERIFICA) provadas pelas faixas ou
+ * repetidas e troca as de índice linear na indução pelas dos extremos
+ * antes do laço, que desviam para uma cópia verificada do laço quando
+ * algum extremo sai do array. Retorna quantas removeu; 'icadas' recebe
+ * quantas saíram dos laços.
+ */
+int otimizar_verificacoes(IrFuncao *f, int *icadas);
+
+/*
+ * Grafo de chamadas montado da árvore sintática (nós Function-Call) e dos
+ * registros de função da tabela de símbolos. 'ordem' lista as funções de
+ * baixo para cima: cada uma aparece depois das que ela chama, exceto entre
+ * funções da mesma componente fortemente conexa (recursão).
+ */
+typedef struct NoChamadas {
+    char *nome;
+    SymbolEntry *simbolo;       /* registro da função na tabela de símbolos */
+    TreeNode *declaracao;
+    int num_params_array;       /* parâmetros params-lista */
+
+    int num_chamados;
+    struct NoChamadas **chamados;
+    int num_sites;              /* chamadas a esta função no programa */
+    int chama_builtin;
+    int recursiva;              /* está num ciclo do grafo */
+
+    int scc;
+    int indice, menor, na_pilha;    /* Tarjan */
+} NoChamadas;
+
+typedef struct {
+    int num;
+    NoChamadas **nos;           /* ordem de declaração */
+    NoChamadas **ordem;         /* de baixo para cima */
+} GrafoChamadas;
+
+GrafoChamadas* grafo_chamadas_construir(TreeNode *raiz);
+NoChamadas* grafo_chamadas_buscar(GrafoChamadas *g, const char *nome);
+int grafo_chamadas_eh_folha(NoChamadas *no);
+void grafo_chamadas_imprimir(GrafoChamadas *g, FILE *saida);
+
+/*
+ * Modelo de custo da expansão de chamadas (inline). Para cada chamada:
+ *
+ *   custo = tamanho do chamado (instruções da IR já otimizada)
+ *         - bonus_chamada
+ *         - bonus_constante * argumentos constantes
+ *         - bonus_array * parâmetros array que recebem um array conhecido
+ *
+ * A chamada é expandida se custo <= limite ou se o chamado é folha com até
+ * limite_folha instruções, desde que o chamador não passe de
+ * tamanho_maximo instruções.
+ */
+typedef struct {
+    int limite;
+    int limite_folha;
+    int bonus_chamada;
+    int bonus_constante;
+    int bonus_array;
+    int tamanho_maximo;
+} CustoInline;
+
+typedef struct {
+    int inline_ativo;
+    int faixas_ativo;           /* passe faixas (os demais ainda usam as faixas) */
+    CustoInline custo_inline;
+} OpcoesOtimizacao;
+
+void opcoes_otimizacao_padrao(OpcoesOtimizacao *op);
+
+// Expande as chamadas de f que o modelo de custo aceita; retorna quantas
+int otimizar_inline(IrModulo *mod, GrafoChamadas *grafo, IrFuncao *f,
+                    CustoInline *custo, FILE *relatorio);
+
+// Dobramento de uma operação binária sobre constantes (0 se não é possível)
+int ir_dobrar_constantes(IrOp op, int a, int b, int *resultado);
+
+/*
+ * Executa o pipeline sobre todas as funções, de baixo para cima no grafo de
+ * chamadas. grafo, op e relatorio podem ser NULL (sem inline, opções
+ * padrão e sem relatório).
+ */
+void otimizar_modulo(IrModulo *mod, GrafoChamadas *grafo, OpcoesOtimizacao *op,
+                     FILE *relatorio);
+
+// O mesmo pipeline numa só função (sem inline quando grafo é NULL)
+void otimizar_funcao(IrModulo *mod, IrFuncao *f, GrafoChamadas *grafo,
+                     OpcoesOtimizacao *op, FILE *relatorio);
+
+#endif // OTIMIZADOR_H
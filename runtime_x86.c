@@ -0,0 +1,488 @@
+/***********************************************/
+/* Runtime mínimo do backend x86-64            */
+/* Ponto de entrada e funções pré-definidas    */
+/* input() e output() com chamadas diretas ao  */
+/* sistema (sem biblioteca C)                  */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "x86.h"
+
+/*
+ * O runtime é escrito com as mesmas instruções de máquina do backend
+ * (registradores físicos, sem alocação), de modo que o emissor de texto e
+ * o codificador produzem exatamente o mesmo código.
+ *
+ * _start chama rt_iniciar e main, descarrega a saída e termina com exit(0).
+ *
+ * rt_iniciar: se stdin é um arquivo comum maior que o buffer de entrada,
+ * mapeia-o inteiro com mmap (a partir da posição atual); instala rt_sinal para SIGFPE e SIGSEGV, numa
+ * pilha alternativa para que o estouro da pilha também seja tratado.
+ *
+ * rt_getc: caractere seguinte de stdin em eax, -1 no fim. Sem o mapa, a
+ * leitura usa um buffer de 64 KB.
+ *
+ * rt_input: lê um inteiro (com sinal opcional) de stdin, pulando espaços;
+ * retorna 0 no fim da entrada.
+ *
+ * rt_output: escreve o inteiro seguido de '\n' num buffer de 64 KB, que
+ * rt_descarregar escreve em stdout quando enche e no fim.
+ *
+ * rt_indice: destino das verificações de --verificar-indices; descarrega a
+ * saída, escreve a mensagem de erro em stderr e termina com exit(1).
+ *
+ * rt_sinal: descarrega a saída e retorna; com SA_RESETHAND a instrução
+ * que falhou executa de novo e o processo morre com o sinal original.
+ * rt_restaurar é o sa_restorer exigido pelo kernel (rt_sigreturn).
+ */
+
+#define TAM_ENTRADA     65536
+#define TAM_SAIDA       65536
+#define TAM_PILHA_SINAL 16384
+
+/* Dados do runtime no .bss */
+static const struct {
+    const char *nome;
+    int bytes;
+} dados[] = {
+    { "rt_ent_base", 8 },       /* início do buffer ou do mapa */
+    { "rt_ent_pos", 8 },
+    { "rt_ent_fim", 8 },
+    { "rt_ent_mapa", 8 },       /* 1 com stdin mapeado */
+    { "rt_stat", 144 },         /* struct stat de stdin */
+    { "rt_sai_pos", 8 },
+    { "rt_acao", 32 },          /* struct sigaction do kernel */
+    { "rt_pilha_sinal", 24 },   /* stack_t */
+    { "rt_ent_buf", TAM_ENTRADA },
+    { "rt_sai_buf", TAM_SAIDA },
+    { "rt_pilha_alt", TAM_PILHA_SINAL },
+};
+#define NUM_DADOS ((int)(sizeof(dados) / sizeof(dados[0])))
+
+static MFuncao* nova_funcao(const char *nome, MFuncao **lista) {
+    MFuncao *mf = (MFuncao*)calloc(1, sizeof(MFuncao));
+    mf->nome = (char*)nome;
+    while (*lista) lista = &(*lista)->prox;
+    *lista = mf;
+    return mf;
+}
+
+static MBloco* novo_bloco(MFuncao *mf) {
+    MBloco *b = (MBloco*)calloc(1, sizeof(MBloco));
+    b->id = mf->num_blocos;
+    b->ordem = mf->num_blocos++;
+    MBloco **p = &mf->blocos;
+    while (*p) p = &(*p)->prox;
+    *p = b;
+    return b;
+}
+
+static MInstr* instr(MBloco *b, MOp op, int tam, MOperando destino, MOperando origem) {
+    MInstr *m = x86_nova(op, tam);
+    m->ops[0] = destino;
+    m->ops[1] = origem;
+    x86_inserir_fim(b, m);
+    return m;
+}
+
+static MOperando nada(void) {
+    MOperando o = x86_imm(0);
+    o.tipo = OPR_NENHUM;
+    return o;
+}
+
+static MOperando reg(int r) {
+    return x86_reg(r);
+}
+
+static MOperando imm(long long v) {
+    return x86_imm(v);
+}
+
+static MOperando dado(const char *nome) {
+    MOperando o = x86_mem(-1, -1, 1, 0);
+    o.simbolo = nome;
+    return o;
+}
+
+/* Campo 'desloc' bytes depois do início do dado */
+static MOperando dado_em(const char *nome, long long desloc) {
+    MOperando o = dado(nome);
+    o.imm = desloc;
+    return o;
+}
+
+static MOperando simbolo(const char *nome) {
+    MOperando o = nada();
+    o.tipo = OPR_SIMBOLO;
+    o.simbolo = nome;
+    return o;
+}
+
+static void desvio(MBloco *b, MCond cond, MBloco *alvo) {
+    MInstr *m = instr(b, cond ? M_JCC : M_JMP, 8, nada(), nada());
+    m->cond = cond;
+    m->ops[0].tipo = OPR_BLOCO;
+    m->ops[0].bloco = alvo;
+}
+
+static void saltar(MBloco *b, MBloco *alvo) {
+    desvio(b, (MCond)0, alvo);
+}
+
+static void chamar(MBloco *b, const char *nome) {
+    instr(b, M_CALL, 8, simbolo(nome), nada());
+}
+
+static void construir_start(MFuncao **lista) {
+    MBloco *b = novo_bloco(nova_funcao("_start", lista));
+    instr(b, M_XOR, 4, reg(X86_RBP), reg(X86_RBP));
+    chamar(b, "rt_iniciar");
+    chamar(b, "cm_main");
+    chamar(b, "rt_descarregar");
+    instr(b, M_MOV, 4, reg(X86_RAX), imm(60));
+    instr(b, M_XOR, 4, reg(X86_RDI), reg(X86_RDI));
+    instr(b, M_SYSCALL, 8, nada(), nada());
+}
+
+/* rt_sigaction(sinal, &rt_acao, NULL, 8) */
+static void instalar_sinal(MBloco *b, int sinal) {
+    instr(b, M_MOV, 4, reg(X86_RAX), imm(13));
+    instr(b, M_MOV, 4, reg(X86_RDI), imm(sinal));
+    instr(b, M_LEA, 8, reg(X86_RSI), dado("rt_acao"));
+    instr(b, M_XOR, 4, reg(X86_RDX), reg(X86_RDX));
+    instr(b, M_MOV, 4, reg(X86_R10), imm(8));
+    instr(b, M_SYSCALL, 8, nada(), nada());
+}
+
+static void construir_iniciar(MFuncao **lista) {
+    MFuncao *mf = nova_funcao("rt_iniciar", lista);
+    MBloco *inicio = novo_bloco(mf);
+    MBloco *comum = novo_bloco(mf);
+    MBloco *tamanho = novo_bloco(mf);
+    MBloco *posicao = novo_bloco(mf);
+    MBloco *mapear = novo_bloco(mf);
+    MBloco *mapeado = novo_bloco(mf);
+    MBloco *sinais = novo_bloco(mf);
+
+    instr(inicio, M_PUSH, 8, reg(X86_RBX), nada());
+    instr(inicio, M_LEA, 8, reg(X86_RAX), dado("rt_ent_buf"));
+    instr(inicio, M_MOV, 8, dado("rt_ent_base"), reg(X86_RAX));
+    // fstat(0, &rt_stat)
+    instr(inicio, M_MOV, 4, reg(X86_RAX), imm(5));
+    instr(inicio, M_XOR, 4, reg(X86_RDI), reg(X86_RDI));
+    instr(inicio, M_LEA, 8, reg(X86_RSI), dado("rt_stat"));
+    instr(inicio, M_SYSCALL, 8, nada(), nada());
+    instr(inicio, M_CMP, 8, reg(X86_RAX), imm(0));
+    desvio(inicio, CC_NE, sinais);
+
+    // arquivo comum: st_mode & S_IFMT == S_IFREG, isto é, 0x8000 <= st_mode < 0x9000
+    instr(comum, M_MOV, 4, reg(X86_RAX), dado_em("rt_stat", 24));
+    instr(comum, M_CMP, 4, reg(X86_RAX), imm(0x8000));
+    desvio(comum, CC_B, sinais);
+    instr(comum, M_CMP, 4, reg(X86_RAX), imm(0x9000));
+    desvio(comum, CC_AE, sinais);
+
+    instr(tamanho, M_MOV, 8, reg(X86_RSI), dado_em("rt_stat", 48));
+    // até TAM_ENTRADA bytes uma leitura basta e sai mais barata que o mapa
+    instr(tamanho, M_CMP, 8, reg(X86_RSI), imm(TAM_ENTRADA));
+    desvio(tamanho, CC_LE, sinais);
+
+    // lseek(0, 0, SEEK_CUR): a leitura continua de onde stdin está
+    instr(posicao, M_MOV, 4, reg(X86_RAX), imm(8));
+    instr(posicao, M_XOR, 4, reg(X86_RDI), reg(X86_RDI));
+    instr(posicao, M_XOR, 4, reg(X86_RSI), reg(X86_RSI));
+    instr(posicao, M_MOV, 4, reg(X86_RDX), imm(1));
+    instr(posicao, M_SYSCALL, 8, nada(), nada());
+    instr(posicao, M_MOV, 8, reg(X86_RBX), reg(X86_RAX));
+    instr(posicao, M_CMP, 8, reg(X86_RAX), imm(0));
+    desvio(posicao, CC_L, sinais);
+
+    // mmap(NULL, st_size, PROT_READ, MAP_PRIVATE, 0, 0)
+    instr(mapear, M_MOV, 4, reg(X86_RAX), imm(9));
+    instr(mapear, M_XOR, 4, reg(X86_RDI), reg(X86_RDI));
+    instr(mapear, M_MOV, 8, reg(X86_RSI), dado_em("rt_stat", 48));
+    instr(mapear, M_MOV, 4, reg(X86_RDX), imm(1));
+    instr(mapear, M_MOV, 4, reg(X86_R10), imm(2));
+    instr(mapear, M_XOR, 4, reg(X86_R8), reg(X86_R8));
+    instr(mapear, M_XOR, 4, reg(X86_R9), reg(X86_R9));
+    instr(mapear, M_SYSCALL, 8, nada(), nada());
+    instr(mapear, M_CMP, 8, reg(X86_RAX), imm(-4096));
+    desvio(mapear, CC_A, sinais);
+
+    instr(mapeado, M_MOV, 8, dado("rt_ent_base"), reg(X86_RAX));
+    instr(mapeado, M_MOV, 8, dado("rt_ent_pos"), reg(X86_RBX));
+    instr(mapeado, M_MOV, 8, dado("rt_ent_fim"), reg(X86_RSI));
+    instr(mapeado, M_MOV, 8, dado("rt_ent_mapa"), imm(1));
+
+    // sigaltstack(&rt_pilha_sinal, NULL)
+    instr(sinais, M_LEA, 8, reg(X86_RAX), dado("rt_pilha_alt"));
+    instr(sinais, M_MOV, 8, dado("rt_pilha_sinal"), reg(X86_RAX));
+    instr(sinais, M_MOV, 8, dado_em("rt_pilha_sinal", 16), imm(TAM_PILHA_SINAL));
+    instr(sinais, M_MOV, 4, reg(X86_RAX), imm(131));
+    instr(sinais, M_LEA, 8, reg(X86_RDI), dado("rt_pilha_sinal"));
+    instr(sinais, M_XOR, 4, reg(X86_RSI), reg(X86_RSI));
+    instr(sinais, M_SYSCALL, 8, nada(), nada());
+
+    // SA_RESTORER | SA_ONSTACK | SA_RESETHAND = 0x8c000000
+    instr(sinais, M_LEA, 8, reg(X86_RAX), dado("rt_sinal"));
+    instr(sinais, M_MOV, 8, dado("rt_acao"), reg(X86_RAX));
+    instr(sinais, M_MOV, 4, dado_em("rt_acao", 8), imm((int)0x8c000000));
+    instr(sinais, M_LEA, 8, reg(X86_RAX), dado("rt_restaurar"));
+    instr(sinais, M_MOV, 8, dado_em("rt_acao", 16), reg(X86_RAX));
+    instalar_sinal(sinais, 8);      // SIGFPE
+    instalar_sinal(sinais, 11);     // SIGSEGV
+    instr(sinais, M_POP, 8, reg(X86_RBX), nada());
+    instr(sinais, M_RET, 8, nada(), nada());
+}
+
+static void construir_getc(MFuncao **lista) {
+    MFuncao *mf = nova_funcao("rt_getc", lista);
+    MBloco *inicio = novo_bloco(mf);
+    MBloco *mapa = novo_bloco(mf);
+    MBloco *ler = novo_bloco(mf);
+    MBloco *pegar = novo_bloco(mf);
+    MBloco *fim = novo_bloco(mf);
+
+    instr(inicio, M_MOV, 8, reg(X86_RAX), dado("rt_ent_pos"));
+    instr(inicio, M_CMP, 8, reg(X86_RAX), dado("rt_ent_fim"));
+    desvio(inicio, CC_B, pegar);
+
+    // o mapa tem o arquivo inteiro: acabou
+    instr(mapa, M_MOV, 8, reg(X86_RAX), dado("rt_ent_mapa"));
+    instr(mapa, M_CMP, 8, reg(X86_RAX), imm(0));
+    desvio(mapa, CC_NE, fim);
+
+    // read(0, buf, TAM_ENTRADA)
+    instr(ler, M_XOR, 4, reg(X86_RAX), reg(X86_RAX));
+    instr(ler, M_XOR, 4, reg(X86_RDI), reg(X86_RDI));
+    instr(ler, M_LEA, 8, reg(X86_RSI), dado("rt_ent_buf"));
+    instr(ler, M_MOV, 4, reg(X86_RDX), imm(TAM_ENTRADA));
+    instr(ler, M_SYSCALL, 8, nada(), nada());
+    instr(ler, M_CMP, 8, reg(X86_RAX), imm(0));
+    desvio(ler, CC_LE, fim);
+    instr(ler, M_MOV, 8, dado("rt_ent_fim"), reg(X86_RAX));
+    instr(ler, M_XOR, 4, reg(X86_RAX), reg(X86_RAX));
+
+    instr(pegar, M_MOV, 8, reg(X86_RCX), dado("rt_ent_base"));
+    instr(pegar, M_MOVZX8, 4, reg(X86_RDX), x86_mem(X86_RCX, X86_RAX, 1, 0));
+    instr(pegar, M_ADD, 8, reg(X86_RAX), imm(1));
+    instr(pegar, M_MOV, 8, dado("rt_ent_pos"), reg(X86_RAX));
+    instr(pegar, M_MOV, 4, reg(X86_RAX), reg(X86_RDX));
+    instr(pegar, M_RET, 8, nada(), nada());
+
+    instr(fim, M_MOV, 8, dado("rt_ent_pos"), imm(0));
+    instr(fim, M_MOV, 8, dado("rt_ent_fim"), imm(0));
+    instr(fim, M_MOV, 4, reg(X86_RAX), imm(-1));
+    instr(fim, M_RET, 8, nada(), nada());
+}
+
+static void construir_input(MFuncao **lista) {
+    MFuncao *mf = nova_funcao("rt_input", lista);
+    MBloco *inicio = novo_bloco(mf);
+    MBloco *espacos = novo_bloco(mf);
+    MBloco *sinal = novo_bloco(mf);
+    MBloco *menos = novo_bloco(mf);
+    MBloco *numero = novo_bloco(mf);
+    MBloco *digito = novo_bloco(mf);
+    MBloco *pronto = novo_bloco(mf);
+    MBloco *negar = novo_bloco(mf);
+    MBloco *sair = novo_bloco(mf);
+    MBloco *vazio = novo_bloco(mf);
+
+    instr(inicio, M_PUSH, 8, reg(X86_RBX), nada());
+    instr(inicio, M_PUSH, 8, reg(X86_R12), nada());
+
+    chamar(espacos, "rt_getc");
+    instr(espacos, M_CMP, 4, reg(X86_RAX), imm(-1));
+    desvio(espacos, CC_E, vazio);
+    instr(espacos, M_CMP, 4, reg(X86_RAX), imm(' '));
+    desvio(espacos, CC_BE, espacos);
+
+    instr(sinal, M_XOR, 4, reg(X86_R12), reg(X86_R12));
+    instr(sinal, M_CMP, 4, reg(X86_RAX), imm('-'));
+    desvio(sinal, CC_NE, numero);
+
+    instr(menos, M_MOV, 4, reg(X86_R12), imm(1));
+    chamar(menos, "rt_getc");
+
+    instr(numero, M_XOR, 4, reg(X86_RBX), reg(X86_RBX));
+
+    instr(digito, M_SUB, 4, reg(X86_RAX), imm('0'));
+    instr(digito, M_CMP, 4, reg(X86_RAX), imm(9));
+    desvio(digito, CC_A, pronto);
+    instr(digito, M_IMUL, 4, reg(X86_RBX), imm(10));
+    instr(digito, M_ADD, 4, reg(X86_RBX), reg(X86_RAX));
+    chamar(digito, "rt_getc");
+    saltar(digito, digito);
+
+    instr(pronto, M_MOV, 4, reg(X86_RAX), reg(X86_RBX));
+    instr(pronto, M_CMP, 4, reg(X86_R12), imm(0));
+    desvio(pronto, CC_E, sair);
+
+    instr(negar, M_NEG, 4, reg(X86_RAX), nada());
+
+    instr(sair, M_POP, 8, reg(X86_R12), nada());
+    instr(sair, M_POP, 8, reg(X86_RBX), nada());
+    instr(sair, M_RET, 8, nada(), nada());
+
+    instr(vazio, M_XOR, 4, reg(X86_RAX), reg(X86_RAX));
+    saltar(vazio, sair);
+}
+
+static void construir_output(MFuncao **lista) {
+    MFuncao *mf = nova_funcao("rt_output", lista);
+    MBloco *inicio = novo_bloco(mf);
+    MBloco *negar = novo_bloco(mf);
+    MBloco *base = novo_bloco(mf);
+    MBloco *digito = novo_bloco(mf);
+    MBloco *sinal = novo_bloco(mf);
+    MBloco *escrever = novo_bloco(mf);
+    MBloco *cheio = novo_bloco(mf);
+    MBloco *copiar_inicio = novo_bloco(mf);
+    MBloco *copiar = novo_bloco(mf);
+    MBloco *fim = novo_bloco(mf);
+
+    // os dígitos vão de trás para frente em 32(%rsp), terminados em '\n'
+    instr(inicio, M_SUB, 8, reg(X86_RSP), imm(40));
+    instr(inicio, M_LEA, 8, reg(X86_RSI), x86_mem(X86_RSP, -1, 1, 32));
+    instr(inicio, M_MOV, 1, x86_mem(X86_RSI, -1, 1, 0), imm('\n'));
+    instr(inicio, M_MOV, 4, reg(X86_RAX), reg(X86_RDI));
+    instr(inicio, M_CMP, 4, reg(X86_RAX), imm(0));
+    desvio(inicio, CC_GE, base);
+
+    instr(negar, M_NEG, 4, reg(X86_RAX), nada());
+
+    instr(base, M_MOV, 4, reg(X86_RCX), imm(10));
+
+    // sem sinal: o valor absoluto de INT_MIN continua correto
+    instr(digito, M_XOR, 4, reg(X86_RDX), reg(X86_RDX));
+    instr(digito, M_DIV, 4, reg(X86_RCX), nada());
+    instr(digito, M_ADD, 4, reg(X86_RDX), imm('0'));
+    instr(digito, M_SUB, 8, reg(X86_RSI), imm(1));
+    instr(digito, M_MOV, 1, x86_mem(X86_RSI, -1, 1, 0), reg(X86_RDX));
+    instr(digito, M_CMP, 4, reg(X86_RAX), imm(0));
+    desvio(digito, CC_NE, digito);
+
+    instr(sinal, M_CMP, 4, reg(X86_RDI), imm(0));
+    desvio(sinal, CC_GE, escrever);
+    instr(sinal, M_SUB, 8, reg(X86_RSI), imm(1));
+    instr(sinal, M_MOV, 1, x86_mem(X86_RSI, -1, 1, 0), imm('-'));
+
+    // cabe no buffer? senão descarrega antes (rsi guardado em 8(%rsp))
+    instr(escrever, M_MOV, 8, reg(X86_RAX), dado("rt_sai_pos"));
+    instr(escrever, M_CMP, 8, reg(X86_RAX), imm(TAM_SAIDA - 16));
+    desvio(escrever, CC_BE, copiar_inicio);
+    instr(cheio, M_MOV, 8, x86_mem(X86_RSP, -1, 1, 8), reg(X86_RSI));
+    chamar(cheio, "rt_descarregar");
+    instr(cheio, M_MOV, 8, reg(X86_RSI), x86_mem(X86_RSP, -1, 1, 8));
+
+    instr(copiar_inicio, M_LEA, 8, reg(X86_RDI), dado("rt_sai_buf"));
+    instr(copiar_inicio, M_MOV, 8, reg(X86_RCX), dado("rt_sai_pos"));
+    instr(copiar_inicio, M_LEA, 8, reg(X86_RDX), x86_mem(X86_RSP, -1, 1, 33));
+
+    instr(copiar, M_MOVZX8, 4, reg(X86_RAX), x86_mem(X86_RSI, -1, 1, 0));
+    instr(copiar, M_MOV, 1, x86_mem(X86_RDI, X86_RCX, 1, 0), reg(X86_RAX));
+    instr(copiar, M_ADD, 8, reg(X86_RSI), imm(1));
+    instr(copiar, M_ADD, 8, reg(X86_RCX), imm(1));
+    instr(copiar, M_CMP, 8, reg(X86_RSI), reg(X86_RDX));
+    desvio(copiar, CC_NE, copiar);
+
+    instr(fim, M_MOV, 8, dado("rt_sai_pos"), reg(X86_RCX));
+    instr(fim, M_ADD, 8, reg(X86_RSP), imm(40));
+    instr(fim, M_RET, 8, nada(), nada());
+}
+
+static void construir_descarregar(MFuncao **lista) {
+    MFuncao *mf = nova_funcao("rt_descarregar", lista);
+    MBloco *inicio = novo_bloco(mf);
+    MBloco *laco = novo_bloco(mf);
+    MBloco *escrito = novo_bloco(mf);
+    MBloco *fim = novo_bloco(mf);
+
+    instr(inicio, M_LEA, 8, reg(X86_RSI), dado("rt_sai_buf"));
+    instr(inicio, M_MOV, 8, reg(X86_RDX), dado("rt_sai_pos"));
+
+    // write(1, rsi, rdx) até escrever tudo
+    instr(laco, M_CMP, 8, reg(X86_RDX), imm(0));
+    desvio(laco, CC_LE, fim);
+    instr(laco, M_MOV, 4, reg(X86_RAX), imm(1));
+    instr(laco, M_MOV, 4, reg(X86_RDI), imm(1));
+    instr(laco, M_SYSCALL, 8, nada(), nada());
+    instr(laco, M_CMP, 8, reg(X86_RAX), imm(0));
+    desvio(laco, CC_LE, fim);
+
+    instr(escrito, M_ADD, 8, reg(X86_RSI), reg(X86_RAX));
+    instr(escrito, M_SUB, 8, reg(X86_RDX), reg(X86_RAX));
+    saltar(escrito, laco);
+
+    instr(fim, M_MOV, 8, dado("rt_sai_pos"), imm(0));
+    instr(fim, M_RET, 8, nada(), nada());
+}
+
+#define MENSAGEM_INDICE "ERRO DE EXECUCAO: indice fora do array\n"
+
+static void construir_indice(MFuncao **lista) {
+    MBloco *b = novo_bloco(nova_funcao("rt_indice", lista));
+    chamar(b, "rt_descarregar");
+
+    // a mensagem vai para o buffer de saída, já vazio, de 4 em 4 bytes
+    static const char mensagem[] = MENSAGEM_INDICE;
+    int tam = (int)sizeof(mensagem) - 1;
+    for (int k = 0; k < tam; k += 4) {
+        unsigned palavra = 0;
+        for (int j = 0; j < 4 && k + j < tam; j++) palavra |= (unsigned)(unsigned char)mensagem[k + j] << (8 * j);
+        instr(b, M_MOV, 4, dado_em("rt_sai_buf", k), imm((int)palavra));
+    }
+    instr(b, M_MOV, 4, reg(X86_RAX), imm(1));
+    instr(b, M_MOV, 4, reg(X86_RDI), imm(2));
+    instr(b, M_LEA, 8, reg(X86_RSI), dado("rt_sai_buf"));
+    instr(b, M_MOV, 4, reg(X86_RDX), imm(tam));
+    instr(b, M_SYSCALL, 8, nada(), nada());
+
+    instr(b, M_MOV, 4, reg(X86_RAX), imm(60));
+    instr(b, M_MOV, 4, reg(X86_RDI), imm(1));
+    instr(b, M_SYSCALL, 8, nada(), nada());
+}
+
+static void construir_sinal(MFuncao **lista) {
+    MBloco *b = novo_bloco(nova_funcao("rt_sinal", lista));
+    chamar(b, "rt_descarregar");
+    instr(b, M_RET, 8, nada(), nada());
+
+    MBloco *r = novo_bloco(nova_funcao("rt_restaurar", lista));
+    instr(r, M_MOV, 4, reg(X86_RAX), imm(15));
+    instr(r, M_SYSCALL, 8, nada(), nada());
+}
+
+MFuncao* x86_runtime(void) {
+    static MFuncao *runtime = NULL;
+    if (!runtime) {
+        construir_start(&runtime);
+        construir_iniciar(&runtime);
+        construir_getc(&runtime);
+        construir_input(&runtime);
+        construir_output(&runtime);
+        construir_descarregar(&runtime);
+        construir_indice(&runtime);
+        construir_sinal(&runtime);
+    }
+    return runtime;
+}
+
+void x86_emitir_runtime(FILE *saida) {
+    fprintf(saida, "\n\t.text\n");
+    fprintf(saida, "\t.globl _start\n");
+    for (MFuncao *mf = x86_runtime(); mf; mf = mf->prox) x86_emitir_funcao(mf, saida);
+
+    fprintf(saida, "\n\t.bss\n\t.p2align 3\n");
+    for (int d = 0; d < NUM_DADOS; d++) {
+        fprintf(saida, "%s:\n\t.zero %d\n", dados[d].nome, dados[d].bytes);
+    }
+}
+
+void x86_codificar_runtime(CodigoX86 *c) {
+    for (MFuncao *mf = x86_runtime(); mf; mf = mf->prox) x86_codificar_funcao(c, mf);
+    for (int d = 0; d < NUM_DADOS; d++) x86_codigo_bss(c, dados[d].nome, dados[d].bytes);
+}
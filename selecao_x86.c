@@ -0,0 +1,676 @@
+/***********************************************/
+/* Seleção de instruções x86-64                */
+/* Traduz a IR fora do SSA para instruções de  */
+/* máquina sobre registradores virtuais        */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+#include "x86.h"
+
+typedef struct {
+    IrFuncao *f;
+    MFuncao *mf;
+    MBloco **blocos;            /* indexado pela posição do bloco na IR */
+    MBloco *atual;
+    MBloco *erro_indice;        /* call rt_indice, no fim da função (ou NULL) */
+    int *desloc_arrays;         /* array local k em rbp - desloc_arrays[k] */
+    char *fundida;              /* comparação refeita em cada desvio/escolha (por id) */
+} Selecao;
+
+/* Funções e globais do programa ganham prefixo; o runtime usa rt_ */
+static const char* simbolo(const char *nome) {
+    if (strcmp(nome, "input") == 0) return "rt_input";
+    if (strcmp(nome, "output") == 0) return "rt_output";
+    char *s = (char*)malloc(strlen(nome) + 4);
+    sprintf(s, "cm_%s", nome);
+    return s;
+}
+
+static int vreg(IrInstr *v) {
+    return X86_NUM_REGS + ir_valor(v)->id;
+}
+
+static int novo_vreg(Selecao *s) {
+    return X86_NUM_REGS + s->mf->num_vregs++;
+}
+
+static int tamanho(IrInstr *v) {
+    return ir_valor(v)->tipo == IR_T_PTR ? 8 : 4;
+}
+
+static MInstr* emitir(Selecao *s, MOp op, int tam, MOperando destino, MOperando origem) {
+    MInstr *m = x86_nova(op, tam);
+    m->ops[0] = destino;
+    m->ops[1] = origem;
+    x86_inserir_fim(s->atual, m);
+    return m;
+}
+
+static MOperando nenhum(void) {
+    MOperando o;
+    memset(&o, 0, sizeof(o));
+    return o;
+}
+
+/* Constantes entram como imediatos; os demais valores no seu virtual */
+static MOperando operando(IrInstr *v) {
+    v = ir_valor(v);
+    if (v->op == IR_CONST) return x86_imm(v->imm);
+    return x86_reg(vreg(v));
+}
+
+/* Valor num registrador (constantes são materializadas no uso) */
+static int em_registrador(Selecao *s, IrInstr *v) {
+    v = ir_valor(v);
+    if (v->op != IR_CONST) return vreg(v);
+    int t = novo_vreg(s);
+    emitir(s, M_MOV, 4, x86_reg(t), x86_imm(v->imm));
+    return t;
+}
+
+static MOperando global(const char *nome) {
+    MOperando o = x86_mem(-1, -1, 1, 0);
+    o.simbolo = simbolo(nome);
+    return o;
+}
+
+/*
+ * Produto por constante sem imul: potência de dois vira shl; 3, 5 e 9
+ * (vezes potência de dois) viram lea (e shl); 2^k + 1 e 2^k - 1 viram shl
+ * e add/sub; fator negativo acrescenta neg. Os 32 bits de baixo são os
+ * mesmos do imul. Retorna 0 quando o imul é melhor.
+ */
+static int multiplicar_constante(Selecao *s, int d, int a, long long c) {
+    long long p = c < 0 ? -c : c, m = p;
+    int k = 0;
+    while (m > 1 && !(m & 1)) {
+        m >>= 1;
+        k++;
+    }
+    if (c == 0) {
+        emitir(s, M_MOV, 4, x86_reg(d), x86_imm(0));
+        return 1;
+    }
+    if (m == 1) {
+        emitir(s, M_MOV, 4, x86_reg(d), x86_reg(a));
+        if (k > 0) emitir(s, M_SHL, 4, x86_reg(d), x86_imm(k));
+    } else if (m == 3 || m == 5 || m == 9) {
+        emitir(s, M_LEA, 4, x86_reg(d), x86_mem(a, a, (int)m - 1, 0));
+        if (k > 0) emitir(s, M_SHL, 4, x86_reg(d), x86_imm(k));
+    } else {
+        int n = 0;
+        while ((1LL << n) < p) n++;
+        if (n > 31) return 0;
+        if ((1LL << (n - 1)) + 1 == p) n--;
+        else if ((1LL << n) - 1 != p) return 0;
+        emitir(s, M_MOV, 4, x86_reg(d), x86_reg(a));
+        emitir(s, M_SHL, 4, x86_reg(d), x86_imm(n));
+        emitir(s, (1LL << n) < p ? M_ADD : M_SUB, 4, x86_reg(d), x86_reg(a));
+    }
+    if (c < 0) emitir(s, M_NEG, 4, x86_reg(d), nenhum());
+    return 1;
+}
+
+static void selecionar_aritmetica(Selecao *s, IrInstr *i) {
+    static const MOp ops[] = { [IR_ADD] = M_ADD, [IR_SUB] = M_SUB, [IR_MUL] = M_IMUL };
+    IrInstr *a = ir_valor(i->args[0]);
+    IrInstr *b = ir_valor(i->args[1]);
+    if (a->op == IR_CONST && i->op != IR_SUB) {
+        IrInstr *t = a;
+        a = b;
+        b = t;
+    }
+    int d = vreg(i);
+    if (i->op == IR_MUL && a->op != IR_CONST && b->op == IR_CONST &&
+        multiplicar_constante(s, d, vreg(a), b->imm)) {
+        return;
+    }
+    emitir(s, M_MOV, 4, x86_reg(d), operando(a));
+    emitir(s, ops[i->op], 4, x86_reg(d), operando(b));
+}
+
+/* Procura no resto do bloco a divisão/resto com os mesmos operandos */
+static IrInstr* parceiro_divisao(IrInstr *i) {
+    IrOp outro = i->op == IR_DIV ? IR_REM : IR_DIV;
+    for (IrInstr *j = i->prox; j; j = j->prox) {
+        if (j->op == outro && !j->aux && ir_valor(j->args[0]) == ir_valor(i->args[0]) &&
+            ir_valor(j->args[1]) == ir_valor(i->args[1])) {
+            return j;
+        }
+    }
+    return NULL;
+}
+
+/* idiv deixa o quociente em eax e o resto em edx: um par usa uma só */
+static void selecionar_divisao(Selecao *s, IrInstr *i) {
+    IrInstr *parceiro = parceiro_divisao(i);
+    int divisor = em_registrador(s, i->args[1]);
+    emitir(s, M_MOV, 4, x86_reg(X86_RAX), operando(i->args[0]));
+    emitir(s, M_CDQ, 4, nenhum(), nenhum());
+    emitir(s, M_IDIV, 4, x86_reg(divisor), nenhum());
+
+    IrInstr *div = i->op == IR_DIV ? i : parceiro;
+    IrInstr *rem = i->op == IR_REM ? i : parceiro;
+    if (div) emitir(s, M_MOV, 4, x86_reg(vreg(div)), x86_reg(X86_RAX));
+    if (rem) emitir(s, M_MOV, 4, x86_reg(vreg(rem)), x86_reg(X86_RDX));
+    if (parceiro) parceiro->aux = 1;
+}
+
+/*
+ * Quociente truncado de x por m > 1 constante no virtual q. Potência de
+ * dois: deslocamento aritmético, somando antes 2^k - 1 aos negativos.
+ * Demais: multiplicação de 64 bits pelo inverso M = teto(2^L / m) e
+ * deslocamento, o menor L em que o erro M*m - 2^L não passa de 2^(L-31):
+ * para todo x de 32 bits, x*M / 2^L fica a menos de 1/m de x/m (acima nos
+ * positivos, abaixo nos negativos), então o deslocamento dá o quociente
+ * dos positivos e, somando 1, o dos negativos. Com M acima de 2^31 - 1 (não cabe
+ * no imediato) multiplica por M - 2^32 e soma x depois do deslocamento de
+ * 32. Sem sinal (dividendo não negativo) a correção sai.
+ */
+static void quociente_constante(Selecao *s, int q, int x, long long m, int sem_sinal) {
+    int k = 0;
+    while ((1LL << k) < m) k++;
+    if ((1LL << k) == m) {
+        emitir(s, M_MOV, 4, x86_reg(q), x86_reg(x));
+        if (!sem_sinal) {
+            if (k > 1) emitir(s, M_SAR, 4, x86_reg(q), x86_imm(31));
+            emitir(s, M_SHR, 4, x86_reg(q), x86_imm(32 - k));
+            emitir(s, M_ADD, 4, x86_reg(q), x86_reg(x));
+        }
+        emitir(s, M_SAR, 4, x86_reg(q), x86_imm(k));
+        return;
+    }
+
+    int l = 32;
+    long long mult;
+    for (;; l++) {
+        mult = ((1LL << l) + m - 1) / m;
+        if (mult * m - (1LL << l) <= (1LL << (l - 31))) break;
+    }
+    emitir(s, M_MOVSX, 8, x86_reg(q), x86_reg(x));
+    if (mult <= 0x7fffffffLL) {
+        emitir(s, M_IMUL, 8, x86_reg(q), x86_imm(mult));
+        emitir(s, M_SAR, 8, x86_reg(q), x86_imm(l));
+    } else {
+        emitir(s, M_IMUL, 8, x86_reg(q), x86_imm(mult - (1LL << 32)));
+        emitir(s, M_SAR, 8, x86_reg(q), x86_imm(32));
+        emitir(s, M_ADD, 4, x86_reg(q), x86_reg(x));
+        if (l > 32) emitir(s, M_SAR, 4, x86_reg(q), x86_imm(l - 32));
+    }
+    if (!sem_sinal) {
+        int sinal = novo_vreg(s);
+        emitir(s, M_MOV, 4, x86_reg(sinal), x86_reg(x));
+        emitir(s, M_SAR, 4, x86_reg(sinal), x86_imm(31));
+        emitir(s, M_SUB, 4, x86_reg(q), x86_reg(sinal));
+    }
+}
+
+/*
+ * Divisão e resto por constante sem idiv (0, -1 e INT_MIN ficam com o
+ * idiv, que trata a falha e o estouro). O resto é x - q*|d| com o
+ * quociente do par, se houver; com dividendo não negativo e potência de
+ * dois é um and. Retorna 0 quando o idiv é necessário.
+ */
+static int selecionar_divisao_constante(Selecao *s, IrInstr *i) {
+    IrInstr *a = ir_valor(i->args[0]);
+    IrInstr *b = ir_valor(i->args[1]);
+    if (a->op == IR_CONST || b->op != IR_CONST) return 0;
+    long long d = b->imm;
+    if (d == 0 || d == -1 || d == INT_MIN) return 0;
+
+    IrInstr *parceiro = parceiro_divisao(i);
+    IrInstr *div = i->op == IR_DIV ? i : parceiro;
+    IrInstr *rem = i->op == IR_REM ? i : parceiro;
+    if (parceiro) parceiro->aux = 1;
+    int x = vreg(a);
+    long long m = d < 0 ? -d : d;
+    int sem_sinal = (i->flags & IR_FLAG_NAO_NEGATIVO) != 0;
+
+    if (m == 1) {
+        if (div) emitir(s, M_MOV, 4, x86_reg(vreg(div)), x86_reg(x));
+        if (rem) emitir(s, M_MOV, 4, x86_reg(vreg(rem)), x86_imm(0));
+        return 1;
+    }
+    if (rem && !div && sem_sinal && (m & (m - 1)) == 0) {
+        emitir(s, M_MOV, 4, x86_reg(vreg(rem)), x86_reg(x));
+        emitir(s, M_AND, 4, x86_reg(vreg(rem)), x86_imm(m - 1));
+        return 1;
+    }
+
+    int q = div ? vreg(div) : novo_vreg(s);
+    quociente_constante(s, q, x, m, sem_sinal);
+    if (rem) {
+        int produto = novo_vreg(s);
+        if (!multiplicar_constante(s, produto, q, m)) {
+            emitir(s, M_MOV, 4, x86_reg(produto), x86_reg(q));
+            emitir(s, M_IMUL, 4, x86_reg(produto), x86_imm(m));
+        }
+        emitir(s, M_MOV, 4, x86_reg(vreg(rem)), x86_reg(x));
+        emitir(s, M_SUB, 4, x86_reg(vreg(rem)), x86_reg(produto));
+    }
+    if (div && d < 0) emitir(s, M_NEG, 4, x86_reg(q), nenhum());
+    return 1;
+}
+
+static MCond condicao(IrOp op) {
+    switch (op) {
+        case IR_LT: return CC_L;
+        case IR_LE: return CC_LE;
+        case IR_GT: return CC_G;
+        case IR_GE: return CC_GE;
+        case IR_EQ: return CC_E;
+        default:    return CC_NE;
+    }
+}
+
+static MCond trocar_lados(MCond c) {
+    switch (c) {
+        case CC_L:  return CC_G;
+        case CC_LE: return CC_GE;
+        case CC_G:  return CC_L;
+        case CC_GE: return CC_LE;
+        default:    return c;
+    }
+}
+
+/* Na codificação do hardware a condição oposta só difere no bit 0 */
+static MCond negar(MCond c) {
+    return (MCond)(c ^ 1);
+}
+
+/* cmp dos operandos; retorna a condição em que a comparação vale 1 */
+static MCond emitir_comparacao(Selecao *s, IrInstr *i) {
+    IrInstr *a = ir_valor(i->args[0]);
+    IrInstr *b = ir_valor(i->args[1]);
+    MCond c = condicao(i->op);
+    if (a->op == IR_CONST && b->op != IR_CONST) {
+        IrInstr *t = a;
+        a = b;
+        b = t;
+        c = trocar_lados(c);
+    }
+    emitir(s, M_CMP, 4, x86_reg(em_registrador(s, a)), operando(b));
+    return c;
+}
+
+static void selecionar_comparacao(Selecao *s, IrInstr *i) {
+    MCond c = emitir_comparacao(s, i);
+    int d = vreg(i);
+    emitir(s, M_SETCC, 1, x86_reg(d), nenhum())->cond = c;
+    emitir(s, M_MOVZX8, 4, x86_reg(d), x86_reg(d));
+}
+
+/* Flags para testar v != 0: o cmp da comparação fundida, ou v contra 0 */
+static MCond testar(Selecao *s, IrInstr *v) {
+    v = ir_valor(v);
+    if (v->op != IR_CONST && s->fundida[v->id]) return emitir_comparacao(s, v);
+    emitir(s, M_CMP, 4, x86_reg(em_registrador(s, v)), x86_imm(0));
+    return CC_NE;
+}
+
+/* d = condição ? a : b com cmov (o mov de b não muda as flags) */
+static void selecionar_escolha(Selecao *s, IrInstr *i) {
+    int d = vreg(i);
+    int a = em_registrador(s, i->args[1]);
+    emitir(s, M_MOV, 4, x86_reg(d), operando(i->args[2]));
+    MCond c = testar(s, i->args[0]);
+    emitir(s, M_CMOV, 4, x86_reg(d), x86_reg(a))->cond = c;
+}
+
+static int eh_comparacao(IrOp op) {
+    return op == IR_LT || op == IR_LE || op == IR_GT || op == IR_GE ||
+           op == IR_EQ || op == IR_NE;
+}
+
+/*
+ * Comparações usadas só como condição de desvios e escolhas do próprio
+ * bloco não viram 0/1: cada uso refaz o cmp. Fora do SSA, uma cópia entre
+ * a comparação e um uso pode sobrescrever um operando; nesse caso o valor
+ * é calculado onde está.
+ */
+static void marcar_fundidas(Selecao *s) {
+    IrFuncao *f = s->f;
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            if (eh_comparacao(i->op)) s->fundida[i->id] = 1;
+        }
+    }
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *u = f->blocos[b]->primeiro; u; u = u->prox) {
+            for (int k = 0; k < u->num_args; k++) {
+                IrInstr *v = ir_valor(u->args[k]);
+                if (k != 0 || (u->op != IR_BR && u->op != IR_ESCOLHA) || v->bloco != u->bloco) {
+                    s->fundida[v->id] = 0;
+                }
+            }
+        }
+    }
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            if (!eh_comparacao(i->op) || !s->fundida[i->id]) continue;
+            int sobrescrito = 0;
+            for (IrInstr *j = i->prox; j; j = j->prox) {
+                if (sobrescrito && j->num_args > 0 && ir_valor(j->args[0]) == i) s->fundida[i->id] = 0;
+                if (j->op != IR_COPY || !j->destino) continue;
+                IrInstr *d = ir_valor(j->destino);
+                if (d == ir_valor(i->args[0]) || d == ir_valor(i->args[1])) sobrescrito = 1;
+            }
+        }
+    }
+}
+
+/* Endereço do elemento: desloc(base) com índice constante, senão (base,t,4) */
+static MOperando elemento(Selecao *s, IrInstr *base, IrInstr *indice) {
+    indice = ir_valor(indice);
+    if (indice->op == IR_CONST) return x86_mem(vreg(base), -1, 1, 4LL * indice->imm);
+    int t = novo_vreg(s);
+    emitir(s, M_MOVSX, 8, x86_reg(t), x86_reg(vreg(indice)));
+    return x86_mem(vreg(base), t, 4, 0);
+}
+
+/*
+ * Índice sem sinal >= tamanho cobre também o negativo. O desvio sai do
+ * meio do bloco para um bloco frio no fim da função, que não volta: não é
+ * sucessor de ninguém e nada está vivo nele.
+ */
+static void selecionar_verificacao(Selecao *s, IrInstr *i) {
+    if (!s->erro_indice) {
+        MBloco *b = (MBloco*)calloc(1, sizeof(MBloco));
+        b->id = s->f->prox_bloco;
+        b->ordem = s->mf->num_blocos++;
+        MBloco **fim = &s->mf->blocos;
+        while (*fim) fim = &(*fim)->prox;
+        *fim = b;
+        MBloco *atual = s->atual;
+        s->atual = b;
+        MOperando alvo = nenhum();
+        alvo.tipo = OPR_SIMBOLO;
+        alvo.simbolo = "rt_indice";
+        emitir(s, M_CALL, 8, alvo, nenhum());
+        s->atual = atual;
+        s->erro_indice = b;
+    }
+    MOperando erro = nenhum();
+    erro.tipo = OPR_BLOCO;
+    erro.bloco = s->erro_indice;
+    emitir(s, M_CMP, 4, x86_reg(em_registrador(s, i->args[0])), operando(i->args[1]));
+    emitir(s, M_JCC, 8, erro, nenhum())->cond = CC_AE;
+}
+
+static void selecionar_chamada(Selecao *s, IrInstr *i) {
+    int num = i->num_args;
+    int na_pilha = num > 6 ? num - 6 : 0;
+    int ajuste = (na_pilha % 2) * 8;
+
+    if (ajuste) emitir(s, M_SUB, 8, x86_reg(X86_RSP), x86_imm(ajuste));
+    for (int a = num - 1; a >= 6; a--) {
+        IrInstr *arg = ir_valor(i->args[a]);
+        MOperando o = arg->op == IR_CONST ? x86_imm(arg->imm) : x86_reg(vreg(arg));
+        emitir(s, M_PUSH, 8, o, nenhum());
+    }
+    for (int a = 0; a < num && a < 6; a++) {
+        emitir(s, M_MOV, tamanho(i->args[a]), x86_reg(x86_regs_args[a]), operando(i->args[a]));
+    }
+
+    MOperando alvo = nenhum();
+    alvo.tipo = OPR_SIMBOLO;
+    alvo.simbolo = simbolo(i->nome);
+    MInstr *call = emitir(s, (i->flags & IR_FLAG_CAUDA) ? M_CAUDA : M_CALL, 8, alvo, nenhum());
+    call->num_args_reg = num < 6 ? num : 6;
+    if (call->op == M_CAUDA) return;
+
+    if (na_pilha + ajuste / 8 > 0) {
+        emitir(s, M_ADD, 8, x86_reg(X86_RSP), x86_imm(8LL * na_pilha + ajuste));
+    }
+    if (i->tipo != IR_T_VOID) emitir(s, M_MOV, 4, x86_reg(vreg(i)), x86_reg(X86_RAX));
+}
+
+static void sucessores(Selecao *s, int num) {
+    s->atual->num_suc = num;
+    s->atual->suc = (MBloco**)malloc(sizeof(MBloco*) * num);
+}
+
+/*
+ * Tabela de saltos do menor ao maior caso, com as lacunas no padrão. O
+ * valor menos o menor caso, comparado sem sinal, cobre os dois lados do
+ * intervalo; dentro dele, o destino é o início da tabela mais a distância
+ * guardada na posição.
+ */
+static void selecionar_casos(Selecao *s, IrInstr *i) {
+    long long menor = ir_valor(i->args[1])->imm, maior = menor;
+    for (int a = 2; a < i->num_args; a++) {
+        long long v = ir_valor(i->args[a])->imm;
+        if (v < menor) menor = v;
+        if (v > maior) maior = v;
+    }
+    MBloco *padrao = s->blocos[i->alvos[0]->aux];
+    MTabela *tab = (MTabela*)calloc(1, sizeof(MTabela));
+    tab->id = s->mf->num_tabelas++;
+    tab->num_alvos = (int)(maior - menor + 1);
+    tab->alvos = (MBloco**)malloc(sizeof(MBloco*) * tab->num_alvos);
+    for (int k = 0; k < tab->num_alvos; k++) tab->alvos[k] = padrao;
+    for (int a = 1; a < i->num_args; a++) {
+        tab->alvos[ir_valor(i->args[a])->imm - menor] = s->blocos[i->alvos[a]->aux];
+    }
+    MTabela **fim = &s->mf->tabelas;
+    while (*fim) fim = &(*fim)->prox;
+    *fim = tab;
+
+    int t = novo_vreg(s);
+    emitir(s, M_MOV, 4, x86_reg(t), operando(i->args[0]));
+    if (menor != 0) emitir(s, M_SUB, 4, x86_reg(t), x86_imm(menor));
+    emitir(s, M_CMP, 4, x86_reg(t), x86_imm(tab->num_alvos - 1));
+    MOperando fora = nenhum();
+    fora.tipo = OPR_BLOCO;
+    fora.bloco = padrao;
+    emitir(s, M_JCC, 8, fora, nenhum())->cond = CC_A;
+
+    // o índice já cabe em 31 bits: movslq estende como sem sinal
+    int indice = novo_vreg(s), base = novo_vreg(s), destino = novo_vreg(s);
+    MOperando endereco = nenhum();
+    endereco.tipo = OPR_TABELA;
+    endereco.tabela = tab;
+    emitir(s, M_MOVSX, 8, x86_reg(indice), x86_reg(t));
+    emitir(s, M_LEA, 8, x86_reg(base), endereco);
+    emitir(s, M_MOVSX, 8, x86_reg(destino), x86_mem(base, indice, 4, 0));
+    emitir(s, M_ADD, 8, x86_reg(destino), x86_reg(base));
+    emitir(s, M_JMP, 8, x86_reg(destino), nenhum());
+
+    sucessores(s, i->num_alvos);
+    for (int k = 0; k < i->num_alvos; k++) s->atual->suc[k] = s->blocos[i->alvos[k]->aux];
+}
+
+/* Retorna 0 quando o resto do bloco não precisa ser traduzido */
+static int selecionar_instr(Selecao *s, IrInstr *i) {
+    switch (i->op) {
+        case IR_CONST:
+        case IR_PARAM:
+        case IR_PHI:
+            break;
+
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+            selecionar_aritmetica(s, i);
+            break;
+
+        case IR_DIV:
+        case IR_REM:
+            if (!i->aux && !selecionar_divisao_constante(s, i)) selecionar_divisao(s, i);
+            break;
+
+        case IR_LT: case IR_LE: case IR_GT: case IR_GE: case IR_EQ: case IR_NE:
+            if (!s->fundida[i->id]) selecionar_comparacao(s, i);
+            break;
+
+        case IR_ESCOLHA:
+            selecionar_escolha(s, i);
+            break;
+
+        case IR_ENDERECO:
+            if (i->nome) emitir(s, M_LEA, 8, x86_reg(vreg(i)), global(i->nome));
+            else emitir(s, M_LEA, 8, x86_reg(vreg(i)),
+                        x86_mem(X86_RBP, -1, 1, -s->desloc_arrays[i->imm]));
+            break;
+
+        case IR_LOAD:
+            emitir(s, M_MOV, 4, x86_reg(vreg(i)), elemento(s, i->args[0], i->args[1]));
+            break;
+
+        case IR_STORE: {
+            MOperando destino = elemento(s, i->args[0], i->args[1]);
+            if (destino.indice >= 0) {
+                // base, indice e valor nao cabem juntos no reescritor
+                int endereco = novo_vreg(s);
+                emitir(s, M_LEA, 8, x86_reg(endereco), destino);
+                destino = x86_mem(endereco, -1, 1, 0);
+            }
+            emitir(s, M_MOV, 4, destino, operando(i->args[2]));
+            break;
+        }
+
+        case IR_LOADG:
+            emitir(s, M_MOV, 4, x86_reg(vreg(i)), global(i->nome));
+            break;
+
+        case IR_STOREG:
+            emitir(s, M_MOV, 4, global(i->nome), operando(i->args[0]));
+            break;
+
+        case IR_CALL:
+            selecionar_chamada(s, i);
+            if (i->flags & IR_FLAG_CAUDA) return 0;
+            break;
+
+        case IR_VERIFICA:
+            selecionar_verificacao(s, i);
+            break;
+
+        case IR_COPY: {
+            int d = i->destino ? vreg(i->destino) : vreg(i);
+            emitir(s, M_MOV, tamanho(i->args[0]), x86_reg(d), operando(i->args[0]));
+            break;
+        }
+
+        case IR_JMP: {
+            MOperando alvo = nenhum();
+            alvo.tipo = OPR_BLOCO;
+            alvo.bloco = s->blocos[i->alvos[0]->aux];
+            emitir(s, M_JMP, 8, alvo, nenhum());
+            sucessores(s, 1);
+            s->atual->suc[0] = alvo.bloco;
+            break;
+        }
+
+        case IR_BR: {
+            MOperando sim = nenhum(), nao = nenhum();
+            sim.tipo = nao.tipo = OPR_BLOCO;
+            sim.bloco = s->blocos[i->alvos[0]->aux];
+            nao.bloco = s->blocos[i->alvos[1]->aux];
+            MCond c = testar(s, i->args[0]);
+            if (sim.bloco == s->atual->prox) {
+                // o sim é o bloco seguinte: só o não precisa de desvio
+                emitir(s, M_JCC, 8, nao, nenhum())->cond = negar(c);
+                emitir(s, M_JMP, 8, sim, nenhum());
+            } else {
+                emitir(s, M_JCC, 8, sim, nenhum())->cond = c;
+                emitir(s, M_JMP, 8, nao, nenhum());
+            }
+            sucessores(s, 2);
+            s->atual->suc[0] = sim.bloco;
+            s->atual->suc[1] = nao.bloco;
+            break;
+        }
+
+        case IR_CASOS:
+            selecionar_casos(s, i);
+            break;
+
+        case IR_RET:
+            if (i->num_args > 0) emitir(s, M_MOV, 4, x86_reg(X86_RAX), operando(i->args[0]));
+            emitir(s, M_RETORNO, 8, nenhum(), nenhum());
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * Traduz uma função já fora do SSA (ir_sair_ssa). Os parâmetros são
+ * copiados dos registradores de argumento (ou da pilha, a partir do
+ * sétimo) no início da entrada, antes da zeragem dos arrays locais.
+ */
+MFuncao* x86_selecionar(IrModulo *mod, IrFuncao *f) {
+    (void)mod;
+    Selecao s;
+    memset(&s, 0, sizeof(s));
+    s.f = f;
+    s.mf = (MFuncao*)calloc(1, sizeof(MFuncao));
+    s.mf->nome = (char*)simbolo(f->nome);
+    s.mf->num_vregs = f->prox_valor;
+
+    s.desloc_arrays = (int*)calloc(f->num_arrays_locais + 1, sizeof(int));
+    int bytes = 0;
+    for (int a = 0; a < f->num_arrays_locais; a++) {
+        bytes += 4 * f->arrays_locais[a];
+        s.desloc_arrays[a] = bytes;
+    }
+    s.mf->bytes_arrays = (bytes + 7) & ~7;
+    s.fundida = (char*)calloc(f->prox_valor + 1, 1);
+    marcar_fundidas(&s);
+
+    s.blocos = (MBloco**)malloc(sizeof(MBloco*) * (f->num_blocos + 1));
+    MBloco **fim = &s.mf->blocos;
+    for (int b = 0; b < f->num_blocos; b++) {
+        f->blocos[b]->aux = b;
+        s.blocos[b] = (MBloco*)calloc(1, sizeof(MBloco));
+        s.blocos[b]->id = f->blocos[b]->id;
+        s.blocos[b]->ordem = b;
+        *fim = s.blocos[b];
+        fim = &s.blocos[b]->prox;
+    }
+    s.mf->num_blocos = f->num_blocos;
+
+    // profundidade de laço de cada bloco (custo de spill dos alocadores)
+    IrLaco **lacos;
+    int num_lacos = ir_encontrar_lacos(f, &lacos);
+    for (int l = 0; l < num_lacos; l++) {
+        for (int b = 0; b < f->num_blocos; b++) {
+            if (lacos[l]->contem[b] && lacos[l]->profundidade > s.blocos[b]->profundidade) {
+                s.blocos[b]->profundidade = lacos[l]->profundidade;
+            }
+        }
+    }
+    ir_liberar_lacos(lacos, num_lacos);
+
+    s.atual = s.blocos[0];
+    for (int b = 0; b < f->num_blocos; b++) {
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            i->aux = 0;
+            if (i->op != IR_PARAM) continue;
+            if (i->imm < 6) {
+                emitir(&s, M_MOV, tamanho(i), x86_reg(vreg(i)), x86_reg(x86_regs_args[i->imm]));
+            } else {
+                emitir(&s, M_MOV, tamanho(i), x86_reg(vreg(i)),
+                       x86_mem(X86_RBP, -1, 1, 16 + 8 * (i->imm - 6)));
+            }
+        }
+    }
+    if (s.mf->bytes_arrays > 0) emitir(&s, M_ZERAR, 8, nenhum(), nenhum());
+
+    for (int b = 0; b < f->num_blocos; b++) {
+        s.atual = s.blocos[b];
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            if (!selecionar_instr(&s, i)) break;
+        }
+    }
+
+    free(s.blocos);
+    free(s.desloc_arrays);
+    free(s.fundida);
+    return s.mf;
+}
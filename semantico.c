@@ -3,47 +3,12 @@
 #include <string.h>
 #include <stdbool.h>
 #include "tree.h"
+#include "semantico.h"
 extern int line_num;  
 extern FILE* yyin;
 
-// tipos de simbolo
-typedef enum {
-    SYMBOL_VARIABLE,   
-    SYMBOL_ARRAY,       
-    SYMBOL_FUNCTION    
-} SymbolType;
-
-// tipos de dados
-typedef enum {
-    TYPE_INT,          
-    TYPE_VOID      
-} DataType;
-
-typedef struct SymbolEntry {
-    char *name;             
-    SymbolType symbol_type;  
-    DataType data_type;      
-    int array_size;          
-    int num_params;        
-    DataType *param_types;   
-    int scope_level;     
-    struct SymbolEntry *next;
-} SymbolEntry;
-
-typedef struct {
-    SymbolEntry *entries;   
-    int current_scope;    
-} SymbolTable;
-
 SymbolTable *symbol_table;
-
-// declarações de funcao
-SymbolEntry* create_symbol(char *name, SymbolType sym_type, DataType data_type, int scope);
-bool insert_symbol(SymbolEntry *entry);
-SymbolEntry* lookup_symbol(char *name, int scope);
-void semantic_error(const char *message, int line_num);
-void analyze_node(TreeNode *node, int scope);
-bool is_type_compatible(DataType type1, DataType type2);
+int semantic_error_count = 0;
 
 SymbolEntry* create_symbol(char *name, SymbolType sym_type, DataType data_type, int scope) {
     SymbolEntry *entry = (SymbolEntry*)malloc(sizeof(SymbolEntry));
@@ -54,6 +19,7 @@ SymbolEntry* create_symbol(char *name, SymbolType sym_type, DataType data_type,
     entry->num_params = 0;
     entry->param_types = NULL;
     entry->scope_level = scope;
+    entry->hidden = false;
     entry->next = NULL;
     return entry;
 }
@@ -83,7 +49,7 @@ SymbolTable* init_symbol_table() {
 SymbolEntry* lookup_symbol(char *name, int scope) {
     SymbolEntry *current = symbol_table->entries;
     while (current != NULL) {
-        if (strcmp(current->name, name) == 0 && current->scope_level <= scope) {
+        if (!current->hidden && strcmp(current->name, name) == 0 && current->scope_level <= scope) {
             return current;
         }
         current = current->next;
@@ -106,6 +72,7 @@ bool insert_symbol(SymbolEntry *entry) {
 
 // Relatório de erro semântico
 void semantic_error(const char *message, int line_num) {
+    semantic_error_count++;
     fprintf(stderr, "ERRO SEMANTICO: %s LINHA: %d \n", message, line_num);
 }
 
@@ -124,8 +91,8 @@ void analyze_var_declaration(TreeNode *node, int scope) {
     DataType type = (strcmp(node->children[0]->value, "int") == 0) ? TYPE_INT : TYPE_VOID;
     SymbolType sym_type = SYMBOL_VARIABLE;
     
-    //e array?
-    if (node->num_children > 2) {
+    //e array? (Tipo + Size)
+    if (node->num_children > 1) {
         sym_type = SYMBOL_ARRAY;
     }
 
@@ -149,14 +116,15 @@ void analyze_function_declaration(TreeNode *node, int scope) {
 
     SymbolEntry *entry = create_symbol(node->value, SYMBOL_FUNCTION, return_type, scope);
     
-    // Analisa params
+    // Analisa params (params -> Param-lista -> params/params-lista)
     TreeNode *params = node->children[1];
-    if (params && params->num_children > 0) {
-        entry->param_types = (DataType*)malloc(sizeof(DataType) * params->num_children);
-        entry->num_params = params->num_children;
+    TreeNode *lista = (params && params->num_children > 0) ? params->children[0] : NULL;
+    if (lista && lista->num_children > 0) {
+        entry->param_types = (DataType*)malloc(sizeof(DataType) * lista->num_children);
+        entry->num_params = lista->num_children;
         
-        for (int i = 0; i < params->num_children; i++) {
-            TreeNode *param = params->children[i];
+        for (int i = 0; i < lista->num_children; i++) {
+            TreeNode *param = lista->children[i];
             entry->param_types[i] = (strcmp(param->children[0]->value, "int") == 0) ? TYPE_INT : TYPE_VOID;
         }
     }
@@ -167,7 +135,26 @@ void analyze_function_declaration(TreeNode *node, int scope) {
 
 
     symbol_table->current_scope++;
+
+    // Parametros ficam visiveis no escopo do corpo da funcao
+    for (int i = 0; lista && i < lista->num_children; i++) {
+        TreeNode *param = lista->children[i];
+        SymbolType sym_type = strcmp(param->node_type, "params-lista") == 0 ? SYMBOL_ARRAY : SYMBOL_VARIABLE;
+        SymbolEntry *p = create_symbol(param->value, sym_type, entry->param_types[i],
+                                       symbol_table->current_scope);
+        if (!insert_symbol(p)) {
+            semantic_error("Parâmetro já declarado", line_num);
+        }
+    }
+
     analyze_node(node->children[2], symbol_table->current_scope);
+
+    // Encerra o escopo: locais e parametros deixam de ser visiveis
+    for (SymbolEntry *e = symbol_table->entries; e != NULL; e = e->next) {
+        if (e->scope_level == symbol_table->current_scope) {
+            e->hidden = true;
+        }
+    }
     symbol_table->current_scope--;
 }
 
@@ -195,8 +182,10 @@ DataType analyze_expression(TreeNode *node, int scope) {
             return TYPE_VOID;
         }
         
+        // Argumentos -> Argument-List -> expressoes
         TreeNode *args = node->children[0];
-        if (args && entry->num_params != (args->num_children > 0 ? args->num_children : 0)) {
+        int num_args = (args && args->num_children > 0) ? args->children[0]->num_children : 0;
+        if (args && entry->num_params != num_args) {
             semantic_error("Número incorreto de argumentos", line_num);
         }
         
@@ -227,7 +216,9 @@ void analyze_node(TreeNode *node, int scope) {
         analyze_var_declaration(node, scope);
     }
     else if (strcmp(node->node_type, "Fun-declaracao") == 0) {
+        // O corpo ja foi analisado no escopo da funcao
         analyze_function_declaration(node, scope);
+        return;
     }
     else if (strcmp(node->node_type, "Assign-Expression") == 0) {
         DataType left_type = analyze_expression(node->children[0], scope);
@@ -0,0 +1,55 @@
+#ifndef SEMANTICO_H
+#define SEMANTICO_H
+
+#include <stdbool.h>
+#include "tree.h"
+
+// tipos de simbolo
+typedef enum {
+    SYMBOL_VARIABLE,   
+    SYMBOL_ARRAY,       
+    SYMBOL_FUNCTION    
+} SymbolType;
+
+// tipos de dados
+typedef enum {
+    TYPE_INT,          
+    TYPE_VOID      
+} DataType;
+
+typedef struct SymbolEntry {
+    char *name;             
+    SymbolType symbol_type;  
+    DataType data_type;      
+    int array_size;          
+    int num_params;        
+    DataType *param_types;   
+    int scope_level;     
+    bool hidden;             // escopo ja encerrado (fim da funcao)
+    struct SymbolEntry *next;
+} SymbolEntry;
+
+typedef struct {
+    SymbolEntry *entries;   
+    int current_scope;    
+} SymbolTable;
+
+extern SymbolTable *symbol_table;
+
+// Quantidade de erros semânticos encontrados na última análise
+extern int semantic_error_count;
+
+// declarações de funcao
+SymbolEntry* create_symbol(char *name, SymbolType sym_type, DataType data_type, int scope);
+bool insert_symbol(SymbolEntry *entry);
+SymbolEntry* lookup_symbol(char *name, int scope);
+void semantic_error(const char *message, int line_num);
+void analyze_node(TreeNode *node, int scope);
+bool is_type_compatible(DataType type1, DataType type2);
+
+// Análise completa sem impressão (usada pelos geradores de código)
+void start_semantic_analysis(TreeNode *root);
+// Análise completa com impressão da tabela de símbolos e da árvore
+void execute_semantic_analysis(TreeNode *root);
+
+#endif // SEMANTICO_H
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Regressões de --verificar-indices: cada testes/verificacoes/<nome>.cm
+# roda com a entrada <nome>.in no interpretador de referência e no x86,
+# com e sem -O. A saída, seguida de uma linha "indice fora do array"
+# quando a execução acusa o erro, tem que ser igual a <nome>.esperado.
+#
+# uso: sh testes/verificacoes.sh   (CC aponta para o compilador, padrão
+#      ./cminus_compiler; o código de saída é o número de falhas)
+
+CC=${CC:-./cminus_compiler}
+DIR=$(dirname "$0")/verificacoes
+TMP=${TMPDIR:-/tmp}/cminus_testes.$$
+mkdir -p "$TMP"
+
+falhas=0
+for prog in "$DIR"/*.cm; do
+    nome=$(basename "$prog" .cm)
+    for modo in "--arvore" "--verificar-indices --run" "--verificar-indices -O --run" \
+                "--verificar-indices -O --alocador=grafo --run" "--verificar-indices -O -o exe"; do
+        rm -f "$TMP/exe"
+        case "$modo" in
+            *"-o "*) $CC ${modo%exe}"$TMP/exe" "$prog" && "$TMP/exe" ;;
+            *) $CC $modo "$prog" ;;
+        esac < "$DIR/$nome.in" > "$TMP/saida" 2> "$TMP/erro"
+        grep -q "indice fora do array" "$TMP/erro" && echo "indice fora do array" >> "$TMP/saida"
+        if cmp -s "$TMP/saida" "$DIR/$nome.esperado"; then
+            echo "ok     $nome ($modo)"
+        else
+            echo "FALHA  $nome ($modo)"
+            falhas=$((falhas + 1))
+        fi
+    done
+done
+rm -rf "$TMP"
+echo "$falhas falhas"
+exit "$falhas"
@@ -0,0 +1,717 @@
+/***********************************************/
+/* Backend C: tradução da árvore sintática     */
+/* para C, compilado pelo compilador do        */
+/* sistema, com cache dos executáveis          */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "transpilador_c.h"
+#include "cache.h"
+
+typedef enum {
+    NOME_LOCAL,         /* escalar local ou parâmetro */
+    NOME_ARRAY,         /* array local ou global */
+    NOME_PONTEIRO,      /* parâmetro array */
+    NOME_GLOBAL         /* escalar global */
+} TipoNome;
+
+typedef struct Nome {
+    char *nome;
+    TipoNome tipo;
+    char *c_nome;
+    int nivel;
+    struct Nome *prox;
+} Nome;
+
+typedef struct {
+    Nome *nomes;
+    int nivel;
+    FILE *locais;           /* declarações da função atual */
+    FILE *corpo;            /* comandos da função atual */
+    char **usados;          /* nomes C dos locais da função atual */
+    int num_usados;
+    int num_temporarios;
+    TreeNode *declaracoes;
+    int erros;
+} EmissorC;
+
+/*
+ * Runtime do programa gerado, o mesmo de entrada_saida.c: stdin mapeado
+ * com mmap quando é um arquivo comum grande (senão lido em blocos),
+ * saída formatada em pares de dígitos num buffer, divisão que morre com
+ * SIGFPE como o idiv, aritmética de 32 bits com volta e a saída
+ * descarregada também quando o programa morre por um sinal.
+ */
+static const char *runtime_c[] = {
+    "#include <limits.h>",
+    "#include <signal.h>",
+    "#include <string.h>",
+    "#include <unistd.h>",
+    "#include <sys/mman.h>",
+    "#include <sys/stat.h>",
+    "",
+    "static const unsigned char *cm_ent, *cm_ent_fim;",
+    "static unsigned char cm_ent_buf[65536];",
+    "static int cm_ent_mapeada;",
+    "static char cm_sai[65536];",
+    "static int cm_sai_pos;",
+    "static const char cm_pares[] =",
+    "    \"00010203040506070809101112131415161718192021222324252627282930313233343536373839\"",
+    "    \"40414243444546474849505152535455565758596061626364656667686970717273747576777879\"",
+    "    \"8081828384858687888990919293949596979899\";",
+    "",
+    "static void cm_descarregar(void) {",
+    "    int feito = 0;",
+    "    while (feito < cm_sai_pos) {",
+    "        ssize_t n = write(1, cm_sai + feito, cm_sai_pos - feito);",
+    "        if (n <= 0) break;",
+    "        feito += (int)n;",
+    "    }",
+    "    cm_sai_pos = 0;",
+    "}",
+    "",
+    "static void cm_ao_sinal(int sinal) {",
+    "    cm_descarregar();",
+    "    signal(sinal, SIG_DFL);",
+    "    raise(sinal);",
+    "}",
+    "",
+    "static void cm_iniciar_entrada(void) {",
+    "    struct stat st;",
+    "    cm_ent = cm_ent_fim = cm_ent_buf;",
+    "    if (fstat(0, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= (off_t)sizeof(cm_ent_buf)) return;",
+    "    off_t pos = lseek(0, 0, SEEK_CUR);",
+    "    if (pos < 0 || pos >= st.st_size) return;",
+    "    void *mapa = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, 0, 0);",
+    "    if (mapa == MAP_FAILED) return;",
+    "    cm_ent = (const unsigned char *)mapa + pos;",
+    "    cm_ent_fim = (const unsigned char *)mapa + st.st_size;",
+    "    cm_ent_mapeada = 1;",
+    "}",
+    "",
+    "static inline int cm_ler(void) {",
+    "    if (cm_ent == cm_ent_fim) {",
+    "        if (cm_ent_mapeada) return -1;",
+    "        ssize_t n = read(0, cm_ent_buf, sizeof(cm_ent_buf));",
+    "        if (n <= 0) return -1;",
+    "        cm_ent = cm_ent_buf;",
+    "        cm_ent_fim = cm_ent_buf + n;",
+    "    }",
+    "    return *cm_ent++;",
+    "}",
+    "",
+    "static inline int cm_input(void) {",
+    "    int c;",
+    "    do {",
+    "        c = cm_ler();",
+    "        if (c < 0) return 0;",
+    "    } while (c <= ' ');",
+    "    int negativo = c == '-';",
+    "    if (negativo) c = cm_ler();",
+    "    unsigned valor = 0;",
+    "    while (c >= '0' && c <= '9') {",
+    "        valor = valor * 10 + (unsigned)(c - '0');",
+    "        c = cm_ler();",
+    "    }",
+    "    return (int)(negativo ? 0u - valor : valor);",
+    "}",
+    "",
+    "static inline int cm_output(int v) {",
+    "    if (cm_sai_pos > (int)sizeof(cm_sai) - 16) cm_descarregar();",
+    "    char tmp[12];",
+    "    char *p = tmp + sizeof(tmp);",
+    "    unsigned abs = v < 0 ? 0u - (unsigned)v : (unsigned)v;",
+    "    while (abs >= 100) {",
+    "        p -= 2;",
+    "        memcpy(p, cm_pares + 2 * (abs % 100), 2);",
+    "        abs /= 100;",
+    "    }",
+    "    if (abs >= 10) {",
+    "        p -= 2;",
+    "        memcpy(p, cm_pares + 2 * abs, 2);",
+    "    } else {",
+    "        *--p = (char)('0' + abs);",
+    "    }",
+    "    if (v < 0) cm_sai[cm_sai_pos++] = '-';",
+    "    int n = (int)(tmp + sizeof(tmp) - p);",
+    "    memcpy(cm_sai + cm_sai_pos, p, n);",
+    "    cm_sai_pos += n;",
+    "    cm_sai[cm_sai_pos++] = '\\n';",
+    "    return 0;",
+    "}",
+    "",
+    "static inline int cm_soma(int a, int b) { return (int)((unsigned)a + (unsigned)b); }",
+    "static inline int cm_sub(int a, int b) { return (int)((unsigned)a - (unsigned)b); }",
+    "static inline int cm_mul(int a, int b) { return (int)((unsigned)a * (unsigned)b); }",
+    "",
+    "static inline int cm_div(int a, int b) {",
+    "    if (b == 0 || (b == -1 && a == INT_MIN)) cm_ao_sinal(SIGFPE);",
+    "    return a / b;",
+    "}",
+    NULL
+};
+
+static void emitir_expressao(EmissorC *e, TreeNode *node);
+static void emitir_statement(EmissorC *e, TreeNode *node, int indent);
+
+static void erro_c(EmissorC *e, const char *mensagem, const char *nome) {
+    fprintf(stderr, "ERRO SEMANTICO: %s: %s\n", mensagem, nome);
+    e->erros++;
+}
+
+/* Escopos */
+
+static Nome* declarar(EmissorC *e, char *nome, TipoNome tipo, char *c_nome) {
+    Nome *n = (Nome*)malloc(sizeof(Nome));
+    n->nome = nome;
+    n->tipo = tipo;
+    n->c_nome = c_nome;
+    n->nivel = e->nivel;
+    n->prox = e->nomes;
+    e->nomes = n;
+    return n;
+}
+
+static Nome* buscar(EmissorC *e, const char *nome) {
+    for (Nome *n = e->nomes; n; n = n->prox) {
+        if (strcmp(n->nome, nome) == 0) return n;
+    }
+    erro_c(e, "Variável não declarada", nome);
+    return NULL;
+}
+
+static void fechar_escopo(EmissorC *e) {
+    while (e->nomes && e->nomes->nivel == e->nivel) {
+        Nome *n = e->nomes;
+        e->nomes = n->prox;
+        free(n->c_nome);
+        free(n);
+    }
+    e->nivel--;
+}
+
+/* Nome C com prefixo; locais ganham sufixo se o nome já foi usado na função */
+static char* nome_c(EmissorC *e, const char *prefixo, const char *nome) {
+    char *c = (char*)malloc(strlen(prefixo) + strlen(nome) + 16);
+    sprintf(c, "%s%s", prefixo, nome);
+    if (strcmp(prefixo, "l_") == 0) {
+        for (int sufixo = 2;; sufixo++) {
+            int usado = 0;
+            for (int i = 0; i < e->num_usados && !usado; i++) usado = strcmp(e->usados[i], c) == 0;
+            if (!usado) break;
+            sprintf(c, "%s%s_%d", prefixo, nome, sufixo);
+        }
+        e->usados = (char**)realloc(e->usados, sizeof(char*) * (e->num_usados + 1));
+        e->usados[e->num_usados++] = strdup(c);
+    }
+    return c;
+}
+
+static TreeNode* buscar_funcao(EmissorC *e, const char *nome) {
+    for (int i = 0; i < e->declaracoes->num_children; i++) {
+        TreeNode *d = e->declaracoes->children[i];
+        if (strcmp(d->node_type, "Fun-declaracao") == 0 && strcmp(d->value, nome) == 0) return d;
+    }
+    return NULL;
+}
+
+/* Expressões */
+
+static int eh_num(TreeNode *node) {
+    return strcmp(node->node_type, "Num") == 0;
+}
+
+/* Atribui ou chama alguma função (que pode escrever globais ou ler stdin)? */
+static int tem_efeito(TreeNode *node) {
+    if (strcmp(node->node_type, "Assign-Expression") == 0 ||
+        strcmp(node->node_type, "Function-Call") == 0) return 1;
+    for (int i = 0; i < node->num_children; i++) {
+        if (tem_efeito(node->children[i])) return 1;
+    }
+    return 0;
+}
+
+/*
+ * O C não ordena os operandos de um operador nem os argumentos de uma
+ * chamada: quando um lado tem efeito e o outro não é constante, o da
+ * esquerda vai antes para um temporário, separado pelo operador vírgula.
+ */
+static int precisa_temporario(TreeNode *esq, TreeNode *dir) {
+    return (tem_efeito(esq) && !eh_num(dir)) || (tem_efeito(dir) && !eh_num(esq));
+}
+
+static int novo_temporario(EmissorC *e) {
+    int t = e->num_temporarios++;
+    fprintf(e->locais, "    int cm_t%d;\n", t);
+    return t;
+}
+
+static void emitir_operando(EmissorC *e, TreeNode *node, int temporario) {
+    if (temporario >= 0) fprintf(e->corpo, "cm_t%d", temporario);
+    else emitir_expressao(e, node);
+}
+
+static void emitir_binario(EmissorC *e, TreeNode *node) {
+    TreeNode *esq = node->children[0];
+    TreeNode *dir = node->children[2];
+    const char *op = node->children[1]->value;
+    const char *funcao = NULL;
+    if (strcmp(op, "+") == 0) funcao = "cm_soma";
+    else if (strcmp(op, "-") == 0) funcao = "cm_sub";
+    else if (strcmp(op, "*") == 0) funcao = "cm_mul";
+    else if (strcmp(op, "/") == 0) funcao = "cm_div";
+
+    int t = -1;
+    if (precisa_temporario(esq, dir)) {
+        t = novo_temporario(e);
+        fprintf(e->corpo, "(cm_t%d = ", t);
+        emitir_expressao(e, esq);
+        fprintf(e->corpo, ", ");
+    }
+    if (funcao) {
+        fprintf(e->corpo, "%s(", funcao);
+        emitir_operando(e, esq, t);
+        fprintf(e->corpo, ", ");
+        emitir_expressao(e, dir);
+        fprintf(e->corpo, ")");
+    } else {
+        fprintf(e->corpo, "(");
+        emitir_operando(e, esq, t);
+        fprintf(e->corpo, " %s ", op);
+        emitir_expressao(e, dir);
+        fprintf(e->corpo, ")");
+    }
+    if (t >= 0) fprintf(e->corpo, ")");
+}
+
+static void emitir_atribuicao(EmissorC *e, TreeNode *node) {
+    TreeNode *var = node->children[0];
+    TreeNode *valor = node->children[1];
+    Nome *n = buscar(e, var->value);
+    if (!n) return;
+
+    if (strcmp(var->node_type, "Variavel-Array") == 0) {
+        if (n->tipo != NOME_ARRAY && n->tipo != NOME_PONTEIRO) {
+            erro_c(e, "Variável não é array", var->value);
+            return;
+        }
+        // o índice é avaliado antes do valor
+        TreeNode *indice = var->children[0];
+        int t = precisa_temporario(indice, valor) ? novo_temporario(e) : -1;
+        if (t >= 0) {
+            fprintf(e->corpo, "(cm_t%d = ", t);
+            emitir_expressao(e, indice);
+            fprintf(e->corpo, ", ");
+        }
+        fprintf(e->corpo, "(%s[", n->c_nome);
+        emitir_operando(e, indice, t);
+        fprintf(e->corpo, "] = ");
+        emitir_expressao(e, valor);
+        fprintf(e->corpo, ")");
+        if (t >= 0) fprintf(e->corpo, ")");
+        return;
+    }
+    if (n->tipo != NOME_LOCAL && n->tipo != NOME_GLOBAL) {
+        erro_c(e, "Atribuição a array inteiro", var->value);
+        return;
+    }
+    fprintf(e->corpo, "(%s = ", n->c_nome);
+    emitir_expressao(e, valor);
+    fprintf(e->corpo, ")");
+}
+
+static void emitir_chamada(EmissorC *e, TreeNode *node) {
+    TreeNode *args = node->children[0];
+    TreeNode *lista = args->num_children > 0 ? args->children[0] : NULL;
+    int num_args = lista ? lista->num_children : 0;
+
+    if (strcmp(node->value, "input") == 0) {
+        fprintf(e->corpo, "cm_input()");
+        return;
+    }
+    if (strcmp(node->value, "output") == 0) {
+        if (num_args != 1) {
+            erro_c(e, "Número incorreto de argumentos", node->value);
+            return;
+        }
+        fprintf(e->corpo, "cm_output(");
+        emitir_expressao(e, lista->children[0]);
+        fprintf(e->corpo, ")");
+        return;
+    }
+
+    TreeNode *f = buscar_funcao(e, node->value);
+    TreeNode *formais = f && f->children[1]->num_children > 0 ? f->children[1]->children[0] : NULL;
+    if (!f) {
+        erro_c(e, "Função não declarada", node->value);
+        return;
+    }
+    if ((formais ? formais->num_children : 0) != num_args) {
+        erro_c(e, "Número incorreto de argumentos", node->value);
+        return;
+    }
+
+    // com algum efeito nos argumentos, todos menos o último vão antes para temporários
+    int ordenar = 0;
+    for (int i = 0; i < num_args; i++) ordenar |= tem_efeito(lista->children[i]);
+    size_t num_temporarios = num_args > 0 ? (size_t)num_args : 1;
+    int *temporarios = (int*)malloc(sizeof(int) * num_temporarios);
+    int abertos = 0;
+    for (int i = 0; i < num_args; i++) {
+        TreeNode *arg = lista->children[i];
+        int array = strcmp(formais->children[i]->node_type, "params-lista") == 0;
+        temporarios[i] = -1;
+        if (ordenar && !array && i < num_args - 1 && !eh_num(arg)) {
+            temporarios[i] = novo_temporario(e);
+            fprintf(e->corpo, "(cm_t%d = ", temporarios[i]);
+            emitir_expressao(e, arg);
+            fprintf(e->corpo, ", ");
+            abertos++;
+        }
+    }
+
+    fprintf(e->corpo, "f_%s(", node->value);
+    for (int i = 0; i < num_args; i++) {
+        TreeNode *arg = lista->children[i];
+        if (i > 0) fprintf(e->corpo, ", ");
+        if (strcmp(formais->children[i]->node_type, "params-lista") == 0) {
+            // array: passa o endereço
+            Nome *n = strcmp(arg->node_type, "Variavel") == 0 ? buscar(e, arg->value) : NULL;
+            if (!n || (n->tipo != NOME_ARRAY && n->tipo != NOME_PONTEIRO)) {
+                erro_c(e, "Argumento não é array", node->value);
+                continue;
+            }
+            fprintf(e->corpo, "%s", n->c_nome);
+        } else {
+            emitir_operando(e, arg, temporarios[i]);
+        }
+    }
+    fprintf(e->corpo, ")");
+    while (abertos-- > 0) fprintf(e->corpo, ")");
+    free(temporarios);
+}
+
+static void emitir_expressao(EmissorC *e, TreeNode *node) {
+    if (eh_num(node)) {
+        fprintf(e->corpo, "%d", atoi(node->value));
+    } else if (strcmp(node->node_type, "Variavel") == 0) {
+        Nome *n = buscar(e, node->value);
+        if (!n) return;
+        if (n->tipo != NOME_LOCAL && n->tipo != NOME_GLOBAL) {
+            erro_c(e, "Array usado como valor", node->value);
+            return;
+        }
+        fprintf(e->corpo, "%s", n->c_nome);
+    } else if (strcmp(node->node_type, "Variavel-Array") == 0) {
+        Nome *n = buscar(e, node->value);
+        if (!n) return;
+        if (n->tipo != NOME_ARRAY && n->tipo != NOME_PONTEIRO) {
+            erro_c(e, "Variável não é array", node->value);
+            return;
+        }
+        fprintf(e->corpo, "%s[", n->c_nome);
+        emitir_expressao(e, node->children[0]);
+        fprintf(e->corpo, "]");
+    } else if (strcmp(node->node_type, "Assign-Expression") == 0) {
+        emitir_atribuicao(e, node);
+    } else if (strcmp(node->node_type, "Function-Call") == 0) {
+        emitir_chamada(e, node);
+    } else if (node->num_children == 3) {
+        emitir_binario(e, node);
+    } else {
+        erro_c(e, "Expressão inválida", node->node_type);
+    }
+}
+
+/* Comandos */
+
+static void recuar(EmissorC *e, int indent) {
+    fprintf(e->corpo, "%*s", 4 * indent, "");
+}
+
+/* Declarações locais sobem para o início da função, zeradas na entrada */
+static void declarar_locais(EmissorC *e, TreeNode *locais) {
+    for (int i = 0; i < locais->num_children; i++) {
+        TreeNode *decl = locais->children[i];
+        char *c = nome_c(e, "l_", decl->value);
+        if (decl->num_children > 1) {
+            fprintf(e->locais, "    int %s[%d];\n", c, atoi(decl->children[1]->value));
+            fprintf(e->locais, "    memset(%s, 0, sizeof(%s));\n", c, c);
+            declarar(e, decl->value, NOME_ARRAY, c);
+        } else {
+            fprintf(e->locais, "    int %s = 0;\n", c);
+            declarar(e, decl->value, NOME_LOCAL, c);
+        }
+    }
+}
+
+/* Comandos de 'node' (o bloco, se for composto) um nível abaixo */
+static void emitir_corpo(EmissorC *e, TreeNode *node, int indent) {
+    if (strcmp(node->node_type, "Composto-declaracao") != 0) {
+        emitir_statement(e, node, indent + 1);
+        return;
+    }
+    e->nivel++;
+    declarar_locais(e, node->children[0]);
+    TreeNode *comandos = node->children[1];
+    for (int i = 0; i < comandos->num_children; i++) {
+        emitir_statement(e, comandos->children[i], indent + 1);
+    }
+    fechar_escopo(e);
+}
+
+static void emitir_statement(EmissorC *e, TreeNode *node, int indent) {
+    const char *tipo = node->node_type;
+    if (strcmp(tipo, "Expressao-declaracao") == 0) {
+        recuar(e, indent);
+        emitir_expressao(e, node->children[0]);
+        fprintf(e->corpo, ";\n");
+    } else if (strcmp(tipo, "Composto-declaracao") == 0) {
+        recuar(e, indent);
+        fprintf(e->corpo, "{\n");
+        emitir_corpo(e, node, indent);
+        recuar(e, indent);
+        fprintf(e->corpo, "}\n");
+    } else if (strcmp(tipo, "If-Statement") == 0 || strcmp(tipo, "If-Else-Statement") == 0) {
+        recuar(e, indent);
+        fprintf(e->corpo, "if (");
+        emitir_expressao(e, node->children[0]);
+        fprintf(e->corpo, ") {\n");
+        emitir_corpo(e, node->children[1], indent);
+        if (node->num_children > 2) {
+            recuar(e, indent);
+            fprintf(e->corpo, "} else {\n");
+            emitir_corpo(e, node->children[2], indent);
+        }
+        recuar(e, indent);
+        fprintf(e->corpo, "}\n");
+    } else if (strcmp(tipo, "While-Statement") == 0) {
+        recuar(e, indent);
+        fprintf(e->corpo, "while (");
+        emitir_expressao(e, node->children[0]);
+        fprintf(e->corpo, ") {\n");
+        emitir_corpo(e, node->children[1], indent);
+        recuar(e, indent);
+        fprintf(e->corpo, "}\n");
+    } else if (strcmp(tipo, "Return-Statement") == 0) {
+        recuar(e, indent);
+        fprintf(e->corpo, "return ");
+        if (node->num_children > 0) emitir_expressao(e, node->children[0]);
+        else fprintf(e->corpo, "0");
+        fprintf(e->corpo, ";\n");
+    }
+}
+
+/* Declarações */
+
+static void emitir_assinatura(TreeNode *node, FILE *saida) {
+    TreeNode *params = node->children[1];
+    TreeNode *lista = params->num_children > 0 ? params->children[0] : NULL;
+    // toda função devolve int: o valor de uma função void usado numa expressão é 0
+    fprintf(saida, "static int f_%s(", node->value);
+    if (!lista) fprintf(saida, "void");
+    for (int i = 0; lista && i < lista->num_children; i++) {
+        TreeNode *p = lista->children[i];
+        int array = strcmp(p->node_type, "params-lista") == 0;
+        fprintf(saida, "%sint %sp_%s", i > 0 ? ", " : "", array ? "*" : "", p->value);
+    }
+    fprintf(saida, ")");
+}
+
+static void emitir_funcao(EmissorC *e, TreeNode *node, FILE *saida) {
+    char *locais = NULL, *corpo = NULL;
+    size_t tam_locais = 0, tam_corpo = 0;
+    e->locais = open_memstream(&locais, &tam_locais);
+    e->corpo = open_memstream(&corpo, &tam_corpo);
+    e->num_temporarios = 0;
+
+    e->nivel++;
+    TreeNode *params = node->children[1];
+    TreeNode *lista = params->num_children > 0 ? params->children[0] : NULL;
+    for (int i = 0; lista && i < lista->num_children; i++) {
+        TreeNode *p = lista->children[i];
+        int array = strcmp(p->node_type, "params-lista") == 0;
+        declarar(e, p->value, array ? NOME_PONTEIRO : NOME_LOCAL, nome_c(e, "p_", p->value));
+    }
+    emitir_corpo(e, node->children[2], 0);
+    fechar_escopo(e);
+    fclose(e->locais);
+    fclose(e->corpo);
+
+    fprintf(saida, "\n");
+    emitir_assinatura(node, saida);
+    fprintf(saida, " {\n%s%s    return 0;\n}\n", locais, corpo);
+    free(locais);
+    free(corpo);
+    for (int i = 0; i < e->num_usados; i++) free(e->usados[i]);
+    free(e->usados);
+    e->usados = NULL;
+    e->num_usados = 0;
+}
+
+int c_emitir_programa(TreeNode *raiz, FILE *saida) {
+    EmissorC e;
+    memset(&e, 0, sizeof(e));
+    e.declaracoes = raiz->children[0];
+
+    fprintf(saida, "/* gerado pelo compilador C- */\n");
+    for (int i = 0; runtime_c[i]; i++) fprintf(saida, "%s\n", runtime_c[i]);
+    fprintf(saida, "\n");
+
+    // globais e protótipos antes dos corpos: a ordem das funções não importa
+    int tem_main = 0;
+    for (int i = 0; i < e.declaracoes->num_children; i++) {
+        TreeNode *d = e.declaracoes->children[i];
+        if (strcmp(d->node_type, "Fun-declaracao") == 0) {
+            emitir_assinatura(d, saida);
+            fprintf(saida, ";\n");
+            tem_main |= strcmp(d->value, "main") == 0;
+        } else if (d->num_children > 1) {
+            fprintf(saida, "static int g_%s[%d];\n", d->value, atoi(d->children[1]->value));
+        } else {
+            fprintf(saida, "static int g_%s;\n", d->value);
+        }
+    }
+
+    for (int i = 0; i < e.declaracoes->num_children; i++) {
+        TreeNode *d = e.declaracoes->children[i];
+        if (strcmp(d->node_type, "Fun-declaracao") == 0) {
+            emitir_funcao(&e, d, saida);
+        } else {
+            declarar(&e, d->value, d->num_children > 1 ? NOME_ARRAY : NOME_GLOBAL,
+                     nome_c(&e, "g_", d->value));
+        }
+    }
+    if (!tem_main) erro_c(&e, "Função não declarada", "main");
+
+    fprintf(saida,
+            "\n"
+            "int main(void) {\n"
+            "    static char pilha_sinal[65536];\n"
+            "    stack_t pilha = { .ss_sp = pilha_sinal, .ss_size = sizeof(pilha_sinal) };\n"
+            "    struct sigaction acao;\n"
+            "    memset(&acao, 0, sizeof(acao));\n"
+            "    acao.sa_handler = cm_ao_sinal;\n"
+            "    acao.sa_flags = SA_ONSTACK;\n"
+            "    sigaltstack(&pilha, NULL);\n"
+            "    sigaction(SIGSEGV, &acao, NULL);\n"
+            "    cm_iniciar_entrada();\n"
+            "    f_main();\n"
+            "    cm_descarregar();\n"
+            "    return 0;\n"
+            "}\n");
+
+    e.nivel = 0;
+    fechar_escopo(&e);
+    return e.erros;
+}
+
+/* Compilação e cache */
+
+/* Caminho do executável em cache (compilado agora se preciso), ou NULL */
+static char* executavel_em_cache(TreeNode *raiz, FILE *relatorio) {
+    char *fonte = NULL;
+    size_t tam = 0;
+    FILE *memoria = open_memstream(&fonte, &tam);
+    int erros = c_emitir_programa(raiz, memoria);
+    fclose(memoria);
+    if (erros > 0) {
+        free(fonte);
+        return NULL;
+    }
+
+    const char *cc = getenv("CMINUS_CC");
+    if (!cc || !*cc) cc = "cc -O2";
+    unsigned long long h = cache_fnv1a(fonte, tam, CACHE_FNV_INICIO);
+    h = cache_fnv1a(cc, strlen(cc), h);
+
+    char *dir = cache_diretorio();
+    if (!cache_criar_diretorio(dir)) {
+        perror(dir);
+        free(dir);
+        free(fonte);
+        return NULL;
+    }
+    size_t n = strlen(dir) + strlen(cc) + 128;
+    char *executavel = (char*)malloc(n);
+    snprintf(executavel, n, "%s/c-%016llx", dir, h);
+
+    if (access(executavel, X_OK) == 0) {
+        if (relatorio) fprintf(relatorio, "[cache C] acerto: %s\n", executavel);
+    } else {
+        char *arquivo_c = (char*)malloc(n);
+        char *temporario = (char*)malloc(n);
+        char *comando = (char*)malloc(3 * n);
+        snprintf(arquivo_c, n, "%s/c-%016llx.%d.c", dir, h, (int)getpid());
+        snprintf(temporario, n, "%s/c-%016llx.%d", dir, h, (int)getpid());
+        snprintf(comando, 3 * n, "%s -o '%s' '%s'", cc, temporario, arquivo_c);
+
+        FILE *arq = fopen(arquivo_c, "w");
+        int status = 1;
+        if (arq) {
+            fwrite(fonte, 1, tam, arq);
+            fclose(arq);
+            status = system(comando);
+            remove(arquivo_c);
+        } else {
+            perror(arquivo_c);
+        }
+        // rename é atômico: execuções simultâneas não veem um executável pela metade
+        if (status == 0 && rename(temporario, executavel) == 0) {
+            if (relatorio) fprintf(relatorio, "[cache C] compilado com '%s': %s\n", cc, executavel);
+        } else {
+            fprintf(stderr, "Falha ao compilar o C gerado com '%s'\n", cc);
+            remove(temporario);
+            free(executavel);
+            executavel = NULL;
+        }
+        free(arquivo_c);
+        free(temporario);
+        free(comando);
+    }
+    free(dir);
+    free(fonte);
+    return executavel;
+}
+
+int c_gerar_executavel(TreeNode *raiz, const char *saida, FILE *relatorio) {
+    char *executavel = executavel_em_cache(raiz, relatorio);
+    if (!executavel) return 1;
+
+    FILE *de = fopen(executavel, "rb");
+    FILE *para = fopen(saida, "wb");
+    int status = 0;
+    if (!de || !para) {
+        perror(de ? saida : executavel);
+        status = 1;
+    } else {
+        char buffer[65536];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), de)) > 0) {
+            if (fwrite(buffer, 1, n, para) != n) {
+                perror(saida);
+                status = 1;
+                break;
+            }
+        }
+    }
+    if (de) fclose(de);
+    if (para) fclose(para);
+    if (status == 0) chmod(saida, 0755);
+    free(executavel);
+    return status;
+}
+
+int c_executar(TreeNode *raiz, FILE *relatorio) {
+    char *executavel = executavel_em_cache(raiz, relatorio);
+    if (!executavel) return 1;
+    fflush(stdout);
+    execl(executavel, executavel, (char*)NULL);
+    perror(executavel);
+    free(executavel);
+    return 1;
+}
@@ -0,0 +1,38 @@
+#ifndef TRANSPILADOR_C_H
+#define TRANSPILADOR_C_H
+
+#include <stdio.h>
+#include "tree.h"
+
+/*
+ * Backend que traduz a árvore analisada para C, para aproveitar o
+ * otimizador do compilador C do sistema em programas de execução longa.
+ *
+ * Os nomes ganham prefixos (g_ globais, f_ funções, p_ parâmetros, l_
+ * locais, com sufixo numérico quando um bloco interno esconde outro
+ * nome), então nada colide com palavras reservadas nem com a biblioteca C.
+ * Parâmetros array viram ponteiros, locais de blocos internos sobem para
+ * o início da função inicializados com zero, e a aritmética passa por
+ * funções de 32 bits com volta. A ordem de avaliação da esquerda para a
+ * direita é garantida com temporários e o operador vírgula onde o C a
+ * deixaria indefinida. input() e output() usam um runtime próprio com
+ * buffers, sem stdio.
+ *
+ * Retorna o número de erros (nomes não declarados).
+ */
+int c_emitir_programa(TreeNode *raiz, FILE *saida);
+
+/*
+ * Gera o C, compila com o compilador do sistema (variável CMINUS_CC,
+ * padrão "cc -O2") e guarda o executável num cache indexado pelo conteúdo
+ * do C e pelo comando (CMINUS_CACHE, padrão ~/.cache/cminus): o mesmo
+ * programa não é compilado de novo. Com 'relatorio' informa se houve
+ * acerto no cache.
+ *
+ * c_gerar_executavel copia o executável para 'saida'; c_executar troca o
+ * processo atual pelo programa (só retorna em caso de falha).
+ */
+int c_gerar_executavel(TreeNode *raiz, const char *saida, FILE *relatorio);
+int c_executar(TreeNode *raiz, FILE *relatorio);
+
+#endif // TRANSPILADOR_C_H
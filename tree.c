@@ -26,6 +26,8 @@ TreeNode* new_node(char *node_type, char *value) {
     node->value = value ? strdup(value) : NULL;
     
     node->num_children = 0;
+    node->capacity = 0;
+    node->children = NULL;
     
     return node;
 }
@@ -40,11 +42,19 @@ TreeNode* new_node(char *node_type, char *value) {
  * 
  */
 void add_child(TreeNode *parent, TreeNode *child) {
-    /* Verifica se o filho existe e se há espaço disponível no array de filhos */
-    if (child && parent->num_children < 10) {
-        /* Adiciona o filho na próxima posição disponível */
-        parent->children[parent->num_children++] = child;
+    /* Verifica se o filho existe */
+    if (!child) return;
+
+    /* Aumenta o array de filhos quando necessário (listas de declarações e
+     * comandos não têm limite de tamanho) */
+    if (parent->num_children == parent->capacity) {
+        parent->capacity = parent->capacity ? parent->capacity * 2 : 4;
+        parent->children = (TreeNode**)realloc(parent->children,
+                                               sizeof(TreeNode*) * parent->capacity);
     }
+
+    /* Adiciona o filho na próxima posição disponível */
+    parent->children[parent->num_children++] = child;
 }
 
 /**
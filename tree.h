@@ -6,7 +6,8 @@ typedef struct TreeNode {
     char *node_type;
     char *value;
     int num_children;
-    struct TreeNode *children[10];  
+    int capacity;
+    struct TreeNode **children;
 } TreeNode;
 
 // Funções para manipulação da árvore
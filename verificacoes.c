@@ -0,0 +1,760 @@
+/***********************************************/
+/* Eliminação de verificações de índice        */
+/* (--verificar-indices): faixa da variável de */
+/* indução dos laços, faixa dos índices e      */
+/* verificações repetidas                      */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "otimizador.h"
+
+/*
+ * Variável de indução de um laço while (i < n) { ... i = i + 1; }: phi
+ * do cabeçalho que começa em 'inicio' (vindo do preheader) e anda 'passo'
+ * (+1 ou -1) em toda aresta de retorno. O laço continua enquanto
+ * 'phi cond limite', com cond entre IR_LT, IR_LE, IR_GT e IR_GE.
+ */
+typedef struct {
+    IrInstr *phi;
+    IrInstr *inicio;
+    IrInstr *limite;
+    IrOp cond;
+    int passo;
+} Inducao;
+
+/*
+ * Índice base * escala + desloc + sinal * x, com base (o phi), escala e x
+ * opcionais. É linear no phi: numa faixa dele, os valores extremos do
+ * índice estão nas pontas.
+ */
+typedef struct {
+    IrInstr *base;
+    IrInstr *escala;
+    long long desloc;
+    IrInstr *x;
+    int sinal;
+} Indice;
+
+static int no_laco(IrLaco *laco, IrBloco *b) {
+    return laco->contem[b->ordem];
+}
+
+/* Constante ou definido fora do laço (domina o preheader) */
+static int fora_do_laco(IrLaco *laco, IrInstr *v) {
+    v = ir_valor(v);
+    return v->op == IR_CONST || !no_laco(laco, v->bloco);
+}
+
+static IrOp inverter(IrOp op) {
+    switch (op) {
+        case IR_LT: return IR_GE;
+        case IR_LE: return IR_GT;
+        case IR_GT: return IR_LE;
+        default:    return IR_LT;
+    }
+}
+
+static IrOp trocar_lados(IrOp op) {
+    switch (op) {
+        case IR_LT: return IR_GT;
+        case IR_LE: return IR_GE;
+        case IR_GT: return IR_LT;
+        default:    return IR_LE;
+    }
+}
+
+/* phi + 1 (passo 1), phi - 1 ou phi + (-1) (passo -1), senão 0 */
+static int passo_de(IrInstr *phi, IrInstr *v) {
+    v = ir_valor(v);
+    if (v->num_args != 2) return 0;
+    IrInstr *a = ir_valor(v->args[0]), *b = ir_valor(v->args[1]);
+    if (v->op == IR_ADD && b == phi && a->op == IR_CONST) {
+        IrInstr *t = a;
+        a = b;
+        b = t;
+    }
+    if (a != phi || b->op != IR_CONST) return 0;
+    if (v->op == IR_ADD && (b->imm == 1 || b->imm == -1)) return b->imm;
+    if (v->op == IR_SUB && b->imm == 1) return -1;
+    return 0;
+}
+
+/*
+ * Reconhece a variável de indução que controla a saída do cabeçalho: o
+ * desvio do cabeçalho compara um phi dele com um valor fora do laço.
+ */
+static int encontrar_inducao(IrLaco *laco, Inducao *iv) {
+    IrBloco *cabecalho = laco->cabecalho;
+    IrInstr *br = ir_terminador(cabecalho);
+    if (!br || br->op != IR_BR) return 0;
+
+    int dentro = no_laco(laco, br->alvos[0]);
+    if (dentro == no_laco(laco, br->alvos[1])) return 0;
+    IrInstr *c = ir_valor(br->args[0]);
+    if (c->op != IR_LT && c->op != IR_LE && c->op != IR_GT && c->op != IR_GE) return 0;
+
+    IrOp op = dentro ? c->op : inverter(c->op);
+    IrInstr *a = ir_valor(c->args[0]), *b = ir_valor(c->args[1]);
+    if (b->op == IR_PHI && b->bloco == cabecalho) {
+        IrInstr *t = a;
+        a = b;
+        b = t;
+        op = trocar_lados(op);
+    }
+    if (a->op != IR_PHI || a->bloco != cabecalho || !fora_do_laco(laco, b)) return 0;
+
+    iv->phi = a;
+    iv->inicio = NULL;
+    iv->limite = b;
+    iv->cond = op;
+    iv->passo = 0;
+    for (int k = 0; k < a->num_args; k++) {
+        if (a->origens[k] == laco->preheader) {
+            iv->inicio = ir_valor(a->args[k]);
+            continue;
+        }
+        int passo = passo_de(a, a->args[k]);
+        if (passo == 0 || (iv->passo != 0 && passo != iv->passo)) return 0;
+        iv->passo = passo;
+    }
+    if (!iv->inicio || iv->passo == 0) return 0;
+    // subindo, o laço tem que parar por cima; descendo, por baixo
+    if (iv->passo > 0) return op == IR_LT || op == IR_LE;
+    return op == IR_GT || op == IR_GE;
+}
+
+/* phi ou phi * invariante */
+static int termo_do_phi(IrLaco *laco, IrInstr *phi, IrInstr *v, Indice *ind) {
+    v = ir_valor(v);
+    if (v == phi) {
+        ind->base = phi;
+        return 1;
+    }
+    if (v->op != IR_MUL) return 0;
+    IrInstr *a = ir_valor(v->args[0]), *b = ir_valor(v->args[1]);
+    if (b == phi) {
+        IrInstr *t = a;
+        a = b;
+        b = t;
+    }
+    if (a != phi || !fora_do_laco(laco, b)) return 0;
+    ind->base = phi;
+    ind->escala = b;
+    return 1;
+}
+
+/* Índice como termo do phi + constante + invariante, ou só invariante */
+static int decompor(IrLaco *laco, IrInstr *phi, IrInstr *v, Indice *ind) {
+    v = ir_valor(v);
+    memset(ind, 0, sizeof(Indice));
+    if (termo_do_phi(laco, phi, v, ind)) return 1;
+    if (fora_do_laco(laco, v)) {
+        if (v->op == IR_CONST) ind->desloc = v->imm;
+        else {
+            ind->x = v;
+            ind->sinal = 1;
+        }
+        return 1;
+    }
+    if (v->op != IR_ADD && v->op != IR_SUB) return 0;
+    IrInstr *a = ir_valor(v->args[0]), *b = ir_valor(v->args[1]);
+    if (v->op == IR_ADD && fora_do_laco(laco, a)) {
+        IrInstr *t = a;
+        a = b;
+        b = t;
+    }
+    if (!fora_do_laco(laco, b) || !termo_do_phi(laco, phi, a, ind)) return 0;
+    int sinal = v->op == IR_ADD ? 1 : -1;
+    if (b->op == IR_CONST) ind->desloc = sinal * (long long)b->imm;
+    else {
+        ind->x = b;
+        ind->sinal = sinal;
+    }
+    return 1;
+}
+
+/* Laço sem saídas fora do cabeçalho: cada volta iniciada chega ao fim */
+static int sai_so_pelo_cabecalho(IrFuncao *f, IrLaco *laco, int num_blocos) {
+    for (int b = 0; b < num_blocos; b++) {
+        IrBloco *bloco = f->blocos[b];
+        if (!no_laco(laco, bloco) || bloco == laco->cabecalho) continue;
+        IrInstr *term = ir_terminador(bloco);
+        if (!term || term->op == IR_RET) return 0;
+        for (int k = 0; k < term->num_alvos; k++) {
+            if (!no_laco(laco, term->alvos[k])) return 0;
+        }
+    }
+    return 1;
+}
+
+/* O bloco executa em toda volta do laço (domina as arestas de retorno) */
+static int executa_sempre(IrLaco *laco, IrBloco *bloco) {
+    IrBloco *cabecalho = laco->cabecalho;
+    for (int p = 0; p < cabecalho->num_preds; p++) {
+        IrBloco *fim = cabecalho->preds[p];
+        if (no_laco(laco, fim) && !ir_domina(bloco, fim)) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Instruções no bloco de guarda: reaproveita as iguais que já estão nele;
+ * sem 'criar', só procura (NULL se não há).
+ */
+static IrInstr* constante(IrFuncao *f, IrBloco *bloco, long long valor, int criar) {
+    for (IrInstr *i = bloco->primeiro; i; i = i->prox) {
+        if (i->op == IR_CONST && i->imm == valor) return i;
+    }
+    if (!criar) return NULL;
+    IrInstr *c = ir_nova_instr(f, IR_CONST, IR_T_INT);
+    c->imm = (int)valor;
+    ir_inserir_antes_terminador(bloco, c);
+    return c;
+}
+
+static IrInstr* binaria(IrFuncao *f, IrBloco *bloco, IrOp op, IrInstr *a, IrInstr *b, int criar) {
+    if (!a || !b) return NULL;
+    a = ir_valor(a);
+    b = ir_valor(b);
+    for (IrInstr *i = bloco->primeiro; i; i = i->prox) {
+        if (i->op == op && ir_valor(i->args[0]) == a && ir_valor(i->args[1]) == b) return i;
+    }
+    if (!criar) return NULL;
+    IrInstr *i = ir_nova_instr(f, op, op == IR_VERIFICA ? IR_T_VOID : IR_T_INT);
+    ir_add_arg(i, a);
+    ir_add_arg(i, b);
+    ir_inserir_antes_terminador(bloco, i);
+    return i;
+}
+
+static int cabe_int(long long v) {
+    return v >= -2147483647LL - 1 && v <= 2147483647LL;
+}
+
+/* v + c no fim do bloco, com v opcional */
+static IrInstr* somar(IrFuncao *f, IrBloco *bloco, IrInstr *v, long long c, int criar) {
+    if (!v) return constante(f, bloco, c, criar);
+    if (c == 0) return v;
+    return binaria(f, bloco, IR_ADD, v, constante(f, bloco, c, criar), criar);
+}
+
+/*
+ * Valor do índice quando a variável de indução vale base + k, calculado
+ * no fim de 'bloco' (NULL se uma constante não cabe em 32 bits).
+ */
+static IrInstr* extremo(IrFuncao *f, IrBloco *bloco, IrInstr *base, long long k, Indice *ind,
+                        int criar) {
+    IrInstr *v = base;
+    if (v && v->op == IR_CONST) {
+        k += v->imm;
+        v = NULL;
+    }
+    IrInstr *escala = ind->escala ? ir_valor(ind->escala) : NULL;
+    // só procurando, uma multiplicação que falta dá NULL
+    if (escala && escala->op == IR_CONST) {
+        if (v && escala->imm != 1 && !(v = binaria(f, bloco, IR_MUL, v, escala, criar))) return NULL;
+        k *= escala->imm;
+    } else if (escala && (v || k != 0)) {
+        if (!cabe_int(k)) return NULL;
+        v = binaria(f, bloco, IR_MUL, somar(f, bloco, v, k, criar), escala, criar);
+        if (!v) return NULL;
+        k = 0;
+    }
+    k += ind->desloc;
+    if (!cabe_int(k)) return NULL;
+
+    if (!ind->x) return somar(f, bloco, v, k, criar);
+    if (!v && k == 0 && ind->sinal > 0) return ind->x;
+    return binaria(f, bloco, ind->sinal > 0 ? IR_ADD : IR_SUB, somar(f, bloco, v, k, criar),
+                   ind->x, criar);
+}
+
+/* Valor constante conhecido de (base + k) * escala + desloc (0 se não é constante) */
+static int extremo_constante(IrInstr *base, long long k, Indice *ind, long long *valor) {
+    IrInstr *escala = ind->escala ? ir_valor(ind->escala) : NULL;
+    if (ind->x || (base && base->op != IR_CONST) || (escala && escala->op != IR_CONST)) return 0;
+    *valor = (k + (base ? base->imm : 0)) * (escala ? escala->imm : 1) + ind->desloc;
+    return 1;
+}
+
+/*
+ * Com escala, o índice só é linear no phi enquanto a conta em 32 bits não
+ * transborda: pelas faixas no preheader, (base + k) * escala + desloc +
+ * sinal * x tem que caber em int para todo phi entre os dois extremos.
+ */
+static int sem_transbordo(FaixasIr *fx, IrLaco *laco, IrInstr *bmin, long long kmin,
+                          IrInstr *bmax, long long kmax, Indice *ind) {
+    IrInstr *escala = ind->escala ? ir_valor(ind->escala) : NULL;
+    if (!escala || (escala->op == IR_CONST && escala->imm == 1)) return 1;
+    FaixaIr fmin = faixas_no_bloco(fx, bmin, laco->preheader);
+    FaixaIr fmax = faixas_no_bloco(fx, bmax, laco->preheader);
+    FaixaIr fe = faixas_no_bloco(fx, escala, laco->preheader);
+    if (fmin.min > fmin.max || fmax.min > fmax.max || fe.min > fe.max) return 0;
+
+    long long pontas[2] = { fmin.min + kmin, fmax.max + kmax };
+    long long menor = 0, maior = 0;
+    for (int a = 0; a < 2; a++) {
+        long long produtos[2] = { pontas[a] * fe.min, pontas[a] * fe.max };
+        for (int b = 0; b < 2; b++) {
+            if ((a == 0 && b == 0) || produtos[b] < menor) menor = produtos[b];
+            if ((a == 0 && b == 0) || produtos[b] > maior) maior = produtos[b];
+        }
+    }
+    menor += ind->desloc;
+    maior += ind->desloc;
+    if (ind->x) {
+        FaixaIr fxv = faixas_no_bloco(fx, ind->x, laco->preheader);
+        if (fxv.min > fxv.max) return 0;
+        menor += ind->sinal > 0 ? fxv.min : -(long long)fxv.max;
+        maior += ind->sinal > 0 ? fxv.max : -(long long)fxv.min;
+    }
+    return cabe_int(menor) && cabe_int(maior);
+}
+
+/*
+ * Bloco de guarda entre o preheader e o cabeçalho, só executado quando o
+ * laço dá pelo menos uma volta. Com a condição de entrada constante e
+ * verdadeira, o próprio preheader serve.
+ */
+static IrBloco* criar_guarda(IrFuncao *f, IrLaco *laco, Inducao *iv) {
+    IrBloco *pre = laco->preheader;
+    IrBloco *cabecalho = laco->cabecalho;
+    IrInstr *jmp = ir_terminador(pre);
+
+    if (iv->inicio->op == IR_CONST && iv->limite->op == IR_CONST) {
+        int entra = 0;
+        ir_dobrar_constantes(iv->cond, iv->inicio->imm, iv->limite->imm, &entra);
+        return entra ? pre : NULL;
+    }
+
+    IrBloco *guarda = ir_novo_bloco(f);
+    // mesma posição do preheader nos vetores 'contem' dos laços externos
+    guarda->ordem = pre->ordem;
+    guarda->idom = pre;
+    IrInstr *salto = ir_nova_instr(f, IR_JMP, IR_T_VOID);
+    ir_add_alvo(salto, cabecalho);
+    ir_inserir_fim(guarda, salto);
+
+    IrInstr *cond = ir_nova_instr(f, iv->cond, IR_T_INT);
+    ir_add_arg(cond, iv->inicio);
+    ir_add_arg(cond, iv->limite);
+    ir_inserir_antes(jmp, cond);
+    IrInstr *br = ir_nova_instr(f, IR_BR, IR_T_VOID);
+    ir_add_arg(br, cond);
+    ir_add_alvo(br, guarda);
+    ir_add_alvo(br, cabecalho);
+    ir_remover(jmp);
+    ir_inserir_fim(pre, br);
+
+    for (IrInstr *phi = cabecalho->primeiro; phi && phi->op == IR_PHI; phi = phi->prox) {
+        int num = phi->num_args;
+        for (int a = 0; a < num; a++) {
+            if (phi->origens[a] == pre) ir_add_phi_arg(phi, phi->args[a], guarda);
+        }
+    }
+    ir_add_pred(cabecalho, guarda);
+    return guarda;
+}
+
+/*
+ * Cópia do laço, com as verificações que ele ainda tem, para a qual a
+ * guarda desvia quando um extremo sai do array. A cópia tem o mesmo 'ordem'
+ * de cada original, e assim continua dentro dos laços externos. O laço só
+ * sai pelo cabeçalho. Os valores do cabeçalho usados depois dele passam
+ * por phis num bloco de saída novo, que junta as duas versões. Devolve o
+ * cabeçalho da cópia.
+ */
+static IrBloco* versionar(IrFuncao *f, IrLaco *laco, IrBloco *guarda) {
+    int n = f->num_blocos;
+    IrBloco *cabecalho = laco->cabecalho;
+    IrBloco **copias = (IrBloco**)malloc(sizeof(IrBloco*) * (n + 1));
+    int num_valores = f->prox_valor;
+    IrInstr **mapa = (IrInstr**)calloc(num_valores + 1, sizeof(IrInstr*));
+
+    for (int b = 0; b < n; b++) {
+        IrBloco *bloco = f->blocos[b];
+        bloco->aux = -1;
+        if (!no_laco(laco, bloco)) continue;
+        bloco->aux = b;
+        copias[b] = ir_novo_bloco(f);
+        copias[b]->ordem = bloco->ordem;
+    }
+
+    // primeira passada: as cópias (phis podem usar valores de adiante)
+    for (int b = 0; b < n; b++) {
+        if (f->blocos[b]->aux < 0) continue;
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            IrInstr *novo = ir_nova_instr(f, i->op, i->tipo);
+            novo->imm = i->imm;
+            novo->nome = i->nome;
+            novo->flags = i->flags;
+            for (int k = 0; k < i->num_alvos; k++) {
+                IrBloco *alvo = i->alvos[k];
+                ir_add_alvo(novo, alvo->aux >= 0 ? copias[alvo->aux] : alvo);
+            }
+            ir_inserir_fim(copias[b], novo);
+            mapa[i->id] = novo;
+        }
+    }
+
+    // segunda passada: operandos, predecessores e dominadores
+    IrBloco *copia_cabecalho = copias[cabecalho->aux];
+    for (int b = 0; b < n; b++) {
+        IrBloco *bloco = f->blocos[b];
+        if (bloco->aux < 0) continue;
+        for (IrInstr *i = bloco->primeiro; i; i = i->prox) {
+            IrInstr *novo = mapa[i->id];
+            int entrada = 0;
+            for (int a = 0; a < i->num_args; a++) {
+                IrInstr *arg = ir_valor(i->args[a]);
+                if (arg->id < num_valores && mapa[arg->id]) arg = mapa[arg->id];
+                if (i->op != IR_PHI) ir_add_arg(novo, arg);
+                else if (i->origens[a]->aux >= 0) ir_add_phi_arg(novo, arg, copias[i->origens[a]->aux]);
+                else if (!entrada++) ir_add_phi_arg(novo, arg, guarda);
+            }
+        }
+        for (int p = 0; p < bloco->num_preds; p++) {
+            if (bloco->preds[p]->aux >= 0) ir_add_pred(copias[b], copias[bloco->preds[p]->aux]);
+        }
+        int idom_no_laco = bloco != cabecalho && bloco->idom && bloco->idom->aux >= 0;
+        copias[b]->idom = idom_no_laco ? copias[bloco->idom->aux] : guarda;
+    }
+    ir_add_pred(copia_cabecalho, guarda);
+
+    // bloco de saída entre os cabeçalhos e o destino de fora
+    IrInstr *br = ir_terminador(cabecalho);
+    int k_fora = no_laco(laco, br->alvos[0]) ? 1 : 0;
+    IrBloco *fora = br->alvos[k_fora];
+    IrBloco *saida = ir_novo_bloco(f);
+    saida->ordem = fora->ordem;
+    saida->idom = laco->preheader;
+    IrInstr *salto = ir_nova_instr(f, IR_JMP, IR_T_VOID);
+    ir_add_alvo(salto, fora);
+    ir_inserir_fim(saida, salto);
+    br->alvos[k_fora] = saida;
+    ir_terminador(copia_cabecalho)->alvos[k_fora] = saida;
+    ir_add_pred(saida, cabecalho);
+    ir_add_pred(saida, copia_cabecalho);
+    ir_trocar_origem_phis(fora, cabecalho, saida);
+    for (int p = 0; p < fora->num_preds; p++) {
+        if (fora->preds[p] == cabecalho) fora->preds[p] = saida;
+    }
+    if (fora->idom == cabecalho) fora->idom = saida;
+
+    // usos de fora do laço (só podem ser do cabeçalho) passam pelos phis
+    IrInstr **juntos = (IrInstr**)calloc(num_valores + 1, sizeof(IrInstr*));
+    for (int b = 0; b < n; b++) {
+        if (f->blocos[b]->aux >= 0) continue;
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            for (int a = 0; a < i->num_args; a++) {
+                IrInstr *v = ir_valor(i->args[a]);
+                if (v->id >= num_valores || !mapa[v->id]) continue;
+                if (!juntos[v->id]) {
+                    juntos[v->id] = ir_nova_instr(f, IR_PHI, v->tipo);
+                    ir_add_phi_arg(juntos[v->id], v, cabecalho);
+                    ir_add_phi_arg(juntos[v->id], mapa[v->id], copia_cabecalho);
+                    ir_inserir_inicio(saida, juntos[v->id]);
+                }
+                i->args[a] = juntos[v->id];
+            }
+        }
+    }
+
+    free(juntos);
+    free(mapa);
+    free(copias);
+    return copia_cabecalho;
+}
+
+/*
+ * Troca as verificações criadas na guarda (de 'primeira' até o
+ * terminador) por uma sequência de desvios, um por extremo < 0 ou
+ * extremo >= tamanho, que desviam para a cópia que verifica a cada volta;
+ * sem nenhum desvio, segue para o laço sem verificações. A cópia é o
+ * primeiro alvo para ficar depois do laço rápido na RPO, o que poupa
+ * registradores no laço rápido. Retorna 0 se a guarda não verifica nada.
+ */
+static int desviar_pela_guarda(IrFuncao *f, IrLaco *laco, IrBloco *guarda, IrInstr *primeira) {
+    IrBloco *cabecalho = laco->cabecalho;
+    int num = 0;
+    for (IrInstr *i = primeira; i && !ir_eh_terminador(i); i = i->prox) {
+        num += i->op == IR_VERIFICA;
+    }
+    if (num == 0) return 0;
+    IrInstr **verificacoes = (IrInstr**)malloc(sizeof(IrInstr*) * num);
+    num = 0;
+    for (IrInstr *i = primeira; i && !ir_eh_terminador(i); i = i->prox) {
+        if (i->op == IR_VERIFICA) verificacoes[num++] = i;
+    }
+
+    // entrada única da cópia, para os phis do cabeçalho dela
+    IrBloco *lento = ir_novo_bloco(f);
+    lento->ordem = guarda->ordem;
+    lento->idom = guarda;
+    IrBloco *copia = versionar(f, laco, lento);
+    IrInstr *salto = ir_nova_instr(f, IR_JMP, IR_T_VOID);
+    ir_add_alvo(salto, copia);
+    ir_inserir_fim(lento, salto);
+
+    IrInstr *zero = constante(f, guarda, 0, 1);
+    IrBloco *bloco = guarda;
+    ir_remover(ir_terminador(guarda));
+    for (int t = 0; t < 2 * num; t++) {
+        IrInstr *v = verificacoes[t / 2];
+        IrInstr *cond = ir_nova_instr(f, t % 2 ? IR_GE : IR_LT, IR_T_INT);
+        ir_add_arg(cond, v->args[0]);
+        ir_add_arg(cond, t % 2 ? v->args[1] : zero);
+        ir_inserir_fim(bloco, cond);
+
+        IrBloco *seguinte = cabecalho;
+        if (t + 1 < 2 * num) {
+            seguinte = ir_novo_bloco(f);
+            seguinte->ordem = guarda->ordem;
+            seguinte->idom = bloco;
+            ir_add_pred(seguinte, bloco);
+        }
+        IrInstr *br = ir_nova_instr(f, IR_BR, IR_T_VOID);
+        ir_add_arg(br, cond);
+        ir_add_alvo(br, lento);
+        ir_add_alvo(br, seguinte);
+        ir_inserir_fim(bloco, br);
+        ir_add_pred(lento, bloco);
+        if (seguinte == cabecalho) {
+            ir_trocar_origem_phis(cabecalho, guarda, bloco);
+            for (int p = 0; p < cabecalho->num_preds; p++) {
+                if (cabecalho->preds[p] == guarda) cabecalho->preds[p] = bloco;
+            }
+        }
+        bloco = seguinte;
+    }
+    for (int v = 0; v < num; v++) ir_remover(verificacoes[v]);
+    free(verificacoes);
+    return 1;
+}
+
+/*
+ * Verificações dentro de um laço controlado por variável de indução. Com
+ * o índice phi + c (ou phi + c + x, x invariante) e o laço dando voltas
+ * com o phi de 'inicio' até o limite, o índice percorre uma faixa
+ * contínua cujos extremos são conhecidos antes do laço. Se os extremos
+ * cabem no array pelas constantes, a verificação sai; senão, quando o
+ * bloco executa em toda volta, ela sai e os extremos vão para um bloco de
+ * guarda antes do laço. Depois, nos blocos que não executam em toda
+ * volta, saem as verificações cujos extremos a guarda já testa. Com algum
+ * extremo fora do array, a guarda desvia para uma cópia do laço que
+ * verifica a cada volta, e o erro sai na volta em que ocorre.
+ *
+ * Sem escala, um índice que transborda no meio da faixa também transborda
+ * num dos extremos (os arrays têm menos de 2^30 elementos); com escala, as
+ * faixas em 'fx' têm que provar que a conta não transborda.
+ */
+static void verificar_laco(IrFuncao *f, FaixasIr *fx, IrLaco *laco, int num_blocos,
+                           int *removidas, int *icadas) {
+    Inducao iv;
+    if (!laco->preheader || !encontrar_inducao(laco, &iv)) return;
+    IrInstr *jmp = ir_terminador(laco->preheader);
+    int pode_icar = jmp && jmp->op == IR_JMP && sai_so_pelo_cabecalho(f, laco, num_blocos);
+
+    // faixa do phi dentro do corpo: [base_min + k_min, base_max + k_max]
+    IrInstr *base_min, *base_max;
+    long long k_min = 0, k_max = 0;
+    if (iv.passo > 0) {
+        base_min = iv.inicio;
+        base_max = iv.limite;
+        if (iv.cond == IR_LT) k_max = -1;
+    } else {
+        base_min = iv.limite;
+        base_max = iv.inicio;
+        if (iv.cond == IR_GT) k_min = 1;
+    }
+
+    IrBloco *guarda = NULL;
+    IrInstr *marca = NULL;      // última instrução que a guarda já tinha
+    int sem_guarda = 0;
+    // as verificações só saem depois da cópia do laço, que fica com todas
+    int num_saem = 0, cap_saem = 16;
+    IrInstr **saem = (IrInstr**)malloc(sizeof(IrInstr*) * cap_saem);
+    for (int passada = 0; passada < 2; passada++) {
+        for (int b = 0; b < num_blocos; b++) {
+            IrBloco *bloco = f->blocos[b];
+            if (!no_laco(laco, bloco) || bloco == laco->cabecalho) continue;
+            int sempre = pode_icar && executa_sempre(laco, bloco);
+            if (sempre != (passada == 0)) continue;
+
+            IrInstr *i = bloco->primeiro;
+            while (i) {
+                IrInstr *prox = i->prox;
+                Indice ind;
+                if (i->op != IR_VERIFICA || !fora_do_laco(laco, i->args[1]) ||
+                    !decompor(laco, iv.phi, i->args[0], &ind)) {
+                    i = prox;
+                    continue;
+                }
+
+                IrInstr *tamanho = ir_valor(i->args[1]);
+                IrInstr *bmin = ind.base ? base_min : NULL, *bmax = ind.base ? base_max : NULL;
+                long long kmin = ind.base ? k_min : 0, kmax = ind.base ? k_max : 0;
+                if (!sem_transbordo(fx, laco, bmin, kmin, bmax, kmax, &ind)) {
+                    i = prox;
+                    continue;
+                }
+                long long menor, maior;
+                int min_ok = extremo_constante(bmin, kmin, &ind, &menor) && menor >= 0;
+                int max_ok = 0;
+                if (extremo_constante(bmax, kmax, &ind, &maior)) {
+                    max_ok = tamanho->op == IR_CONST && maior < tamanho->imm;
+                } else if (ind.base && !ind.escala && !ind.x && bmax == iv.limite && ir_valor(bmax) == tamanho) {
+                    // i < n com n o próprio tamanho
+                    max_ok = kmax + ind.desloc < 0;
+                }
+
+                if (!min_ok || !max_ok) {
+                    if (sempre && !guarda && !sem_guarda) {
+                        guarda = criar_guarda(f, laco, &iv);
+                        sem_guarda = !guarda;   // o laço nunca executa
+                        if (guarda) marca = ir_terminador(guarda)->ant;
+                    }
+                    if (!guarda) {
+                        i = prox;
+                        continue;
+                    }
+                    IrInstr *vmin = min_ok ? NULL : extremo(f, guarda, bmin, kmin, &ind, sempre);
+                    IrInstr *vmax = max_ok ? NULL : extremo(f, guarda, bmax, kmax, &ind, sempre);
+                    if ((!min_ok && !binaria(f, guarda, IR_VERIFICA, vmin, tamanho, sempre)) ||
+                        (!max_ok && !binaria(f, guarda, IR_VERIFICA, vmax, tamanho, sempre))) {
+                        i = prox;
+                        continue;
+                    }
+                }
+
+                if (num_saem == cap_saem) {
+                    cap_saem *= 2;
+                    saem = (IrInstr**)realloc(saem, sizeof(IrInstr*) * cap_saem);
+                }
+                saem[num_saem++] = i;
+                if (min_ok && max_ok) (*removidas)++;
+                else if (sempre) (*icadas)++;
+                else (*removidas)++;
+                i = prox;
+            }
+        }
+    }
+
+    // o que a guarda ganhou fica depois da marca
+    if (guarda) desviar_pela_guarda(f, laco, guarda, marca ? marca->prox : guarda->primeiro);
+    for (int k = 0; k < num_saem; k++) ir_remover(saem[k]);
+    free(saem);
+}
+
+static int mesma_verificacao(IrInstr *a, IrInstr *b) {
+    return ir_valor(a->args[0]) == ir_valor(b->args[0]) && ir_valor(a->args[1]) == ir_valor(b->args[1]);
+}
+
+static int comparar_verificacoes(const void *a, const void *b) {
+    IrInstr *va = *(IrInstr* const*)a, *vb = *(IrInstr* const*)b;
+    int ia = ir_valor(va->args[0])->id, ib = ir_valor(vb->args[0])->id;
+    if (ia != ib) return ia - ib;
+    return ir_valor(va->args[1])->id - ir_valor(vb->args[1])->id;
+}
+
+/* A verificação 'a' sempre executa antes de 'b' */
+static int executa_antes(IrInstr *a, IrInstr *b) {
+    if (a->bloco == b->bloco) return a->aux < b->aux;
+    return ir_domina(a->bloco, b->bloco);
+}
+
+/*
+ * Saem as verificações cujo índice, pela faixa no bloco, cabe no menor
+ * tamanho possível (índice e tamanho constantes, ou um índice que os
+ * desvios acima já limitam), e as dominadas por outra igual (mesmo
+ * índice e tamanho). Exige o CFG calculado.
+ */
+static int remover_redundantes(IrFuncao *f, FaixasIr *fx) {
+    int num = 0, cap = 16, removidas = 0;
+    IrInstr **lista = (IrInstr**)malloc(sizeof(IrInstr*) * cap);
+    for (int b = 0; b < f->num_blocos; b++) {
+        int pos = 0;
+        IrInstr *i = f->blocos[b]->primeiro;
+        while (i) {
+            IrInstr *prox = i->prox;
+            i->aux = pos++;
+            if (i->op == IR_VERIFICA) {
+                FaixaIr indice = faixas_no_bloco(fx, i->args[0], f->blocos[b]);
+                FaixaIr tamanho = faixas_no_bloco(fx, i->args[1], f->blocos[b]);
+                if (indice.min >= 0 && indice.max < tamanho.min) {
+                    ir_remover(i);
+                    removidas++;
+                } else {
+                    if (num == cap) {
+                        cap *= 2;
+                        lista = (IrInstr**)realloc(lista, sizeof(IrInstr*) * cap);
+                    }
+                    lista[num++] = i;
+                }
+            }
+            i = prox;
+        }
+    }
+
+    // iguais ficam juntas depois da ordenação
+    char *removida = (char*)calloc(num + 1, 1);
+    qsort(lista, num, sizeof(IrInstr*), comparar_verificacoes);
+    for (int inicio = 0, fim; inicio < num; inicio = fim) {
+        for (fim = inicio + 1; fim < num && mesma_verificacao(lista[inicio], lista[fim]); fim++) {}
+        for (int k = inicio; k < fim; k++) {
+            for (int j = inicio; j < fim; j++) {
+                if (j == k || removida[j] || !executa_antes(lista[j], lista[k])) continue;
+                ir_remover(lista[k]);
+                removida[k] = 1;
+                removidas++;
+                break;
+            }
+        }
+    }
+    free(removida);
+    free(lista);
+    return removidas;
+}
+
+/*
+ * Elimina e antecipa as verificações de --verificar-indices. Retorna
+ * quantas foram removidas; 'icadas' recebe quantas saíram de laços
+ * trocadas pelo teste dos extremos na guarda.
+ */
+int otimizar_verificacoes(IrFuncao *f, int *icadas) {
+    int removidas = 0;
+    *icadas = 0;
+
+    int tem = 0;
+    for (int b = 0; b < f->num_blocos && !tem; b++) {
+        for (IrInstr *i = f->blocos[b]->primeiro; i; i = i->prox) {
+            if (i->op == IR_VERIFICA) tem = 1;
+        }
+    }
+    if (!tem) return 0;
+
+    IrLaco **lacos;
+    ir_inserir_preheaders(f);
+    int num = ir_encontrar_lacos(f, &lacos);
+    // as guardas e as cópias dos laços criadas no caminho ficam fora da
+    // varredura; as faixas só são consultadas nos preheaders, acima delas
+    int num_blocos = f->num_blocos;
+    FaixasIr fx;
+    faixas_calcular(&fx, f);
+    for (int l = 0; l < num; l++) {
+        verificar_laco(f, &fx, lacos[l], num_blocos, &removidas, icadas);
+    }
+    faixas_liberar(&fx);
+    ir_liberar_lacos(lacos, num);
+    if (f->num_blocos > num_blocos) ir_calcular_cfg(f);
+
+    faixas_calcular(&fx, f);
+    removidas += remover_redundantes(f, &fx);
+    faixas_liberar(&fx);
+    // os índices das verificações removidas podem ter ficado sem uso
+    if (removidas > 0) ir_eliminar_codigo_morto(f);
+    return removidas;
+}
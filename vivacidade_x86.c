@@ -0,0 +1,101 @@
+/***********************************************/
+/* Vivacidade dos registradores virtuais       */
+/* Análise iterativa para trás sobre os blocos */
+/* de máquina, usada pelos alocadores          */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "x86.h"
+
+/*
+ * Numera as instruções na ordem dos blocos: a instrução n lê na posição
+ * 2n e escreve na posição 2n + 1. Retorna o número de instruções.
+ */
+int x86_numerar(MFuncao *mf) {
+    int n = 0;
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        for (MInstr *m = b->primeiro; m; m = m->prox) m->pos = n++;
+    }
+    return n;
+}
+
+static unsigned long* novo_conjunto(int palavras) {
+    return (unsigned long*)calloc(palavras + 1, sizeof(unsigned long));
+}
+
+void x86_calcular_vivacidade(MFuncao *mf, VivacidadeX86 *viv) {
+    int n = mf->num_blocos;
+    int palavras = (mf->num_vregs + 8 * (int)sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long));
+    viv->num_palavras = palavras;
+    viv->entrada = (unsigned long**)malloc(sizeof(unsigned long*) * (n + 1));
+    viv->saida = (unsigned long**)malloc(sizeof(unsigned long*) * (n + 1));
+
+    // usos antes de definição (gen) e definições (kill) de cada bloco
+    unsigned long **gen = (unsigned long**)malloc(sizeof(unsigned long*) * (n + 1));
+    unsigned long **kill = (unsigned long**)malloc(sizeof(unsigned long*) * (n + 1));
+    MBloco **blocos = (MBloco**)malloc(sizeof(MBloco*) * (n + 1));
+
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        int o = b->ordem;
+        blocos[o] = b;
+        viv->entrada[o] = novo_conjunto(palavras);
+        viv->saida[o] = novo_conjunto(palavras);
+        gen[o] = novo_conjunto(palavras);
+        kill[o] = novo_conjunto(palavras);
+
+        for (MInstr *m = b->primeiro; m; m = m->prox) {
+            int regs[8];
+            int num = x86_usos(m, regs);
+            for (int k = 0; k < num; k++) {
+                if (!X86_EH_VIRTUAL(regs[k])) continue;
+                int v = regs[k] - X86_NUM_REGS;
+                if (!BIT_TEM(kill[o], v)) BIT_POE(gen[o], v);
+            }
+            num = x86_defs(m, regs);
+            for (int k = 0; k < num; k++) {
+                if (X86_EH_VIRTUAL(regs[k])) BIT_POE(kill[o], regs[k] - X86_NUM_REGS);
+            }
+        }
+    }
+
+    // ponto fixo, de trás para frente na ordem dos blocos
+    int mudou = 1;
+    while (mudou) {
+        mudou = 0;
+        for (int o = n - 1; o >= 0; o--) {
+            MBloco *b = blocos[o];
+            unsigned long *saida = viv->saida[o];
+            unsigned long *entrada = viv->entrada[o];
+            for (int s = 0; s < b->num_suc; s++) {
+                unsigned long *suc = viv->entrada[b->suc[s]->ordem];
+                for (int w = 0; w < palavras; w++) saida[w] |= suc[w];
+            }
+            for (int w = 0; w < palavras; w++) {
+                unsigned long novo = gen[o][w] | (saida[w] & ~kill[o][w]);
+                if (novo != entrada[w]) {
+                    entrada[w] = novo;
+                    mudou = 1;
+                }
+            }
+        }
+    }
+
+    for (int o = 0; o < n; o++) {
+        free(gen[o]);
+        free(kill[o]);
+    }
+    free(gen);
+    free(kill);
+    free(blocos);
+}
+
+void x86_liberar_vivacidade(MFuncao *mf, VivacidadeX86 *viv) {
+    for (int o = 0; o < mf->num_blocos; o++) {
+        free(viv->entrada[o]);
+        free(viv->saida[o]);
+    }
+    free(viv->entrada);
+    free(viv->saida);
+}
@@ -0,0 +1,393 @@
+/***********************************************/
+/* Máquina virtual do bytecode                 */
+/* Pilha de registradores contígua, quadros    */
+/* pré-alocados e memória plana de int         */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bytecode.h"
+#include "entrada_saida.h"
+
+#define VM_MAX_REGS     (1 << 22)   /* pilha de registradores */
+#define VM_MAX_QUADROS  (1 << 20)
+#define VM_PERFIL_PARES 12
+
+/*
+ * Código em threading direto: cada instrução vira uma célula com o
+ * endereço do seu tratador (computed goto) e a palavra original. O salto
+ * para a próxima instrução é um 'goto *' indireto no fim de cada tratador,
+ * um ponto de previsão por tratador em vez do único 'switch'.
+ */
+typedef struct {
+    const void *rotulo;
+    BcInstr i;
+    int laco;                   /* volta de laço nas camadas: índice do While */
+} Celula;
+
+typedef struct {
+    BcFuncao *f;
+    const Celula *retorno;      /* pc do chamador */
+    int *regs;                  /* registradores do chamador */
+    int topo_arrays;            /* arrays locais do chamador */
+} Quadro;
+
+static int erro_execucao(const char *mensagem, BcFuncao *f) {
+    es_descarregar();
+    fprintf(stderr, "ERRO DE EXECUCAO: %s em %s\n", mensagem, f->nome);
+    return 1;
+}
+
+/* Contagens do perfil: por opcode e por par de opcodes consecutivos */
+typedef struct {
+    unsigned long long ops[BC_NUM_OPS];
+    unsigned long long pares[BC_NUM_OPS][BC_NUM_OPS];
+} Perfil;
+
+static void imprimir_perfil(Perfil *pf, FILE *saida) {
+    unsigned long long total = 0;
+    for (int o = 0; o < BC_NUM_OPS; o++) total += pf->ops[o];
+    fprintf(saida, "perfil da maquina virtual: %llu instrucoes\n", total);
+    if (total == 0) return;
+
+    // opcodes em ordem decrescente de execuções
+    int ordem[BC_NUM_OPS];
+    for (int o = 0; o < BC_NUM_OPS; o++) ordem[o] = o;
+    for (int a = 1; a < BC_NUM_OPS; a++) {
+        for (int b = a; b > 0 && pf->ops[ordem[b]] > pf->ops[ordem[b - 1]]; b--) {
+            int t = ordem[b]; ordem[b] = ordem[b - 1]; ordem[b - 1] = t;
+        }
+    }
+    for (int a = 0; a < BC_NUM_OPS && pf->ops[ordem[a]] > 0; a++) {
+        fprintf(saida, "  %-7s %12llu  %5.1f%%\n", bc_nome_op((BcOp)ordem[a]),
+                pf->ops[ordem[a]], 100.0 * pf->ops[ordem[a]] / total);
+    }
+
+    // os pares mais frequentes: candidatos a superinstrução
+    fprintf(saida, "pares mais frequentes:\n");
+    for (int n = 0; n < VM_PERFIL_PARES; n++) {
+        int ma = -1, mb = -1;
+        for (int a = 0; a < BC_NUM_OPS; a++) {
+            for (int b = 0; b < BC_NUM_OPS; b++) {
+                if (pf->pares[a][b] > 0 && (ma < 0 || pf->pares[a][b] > pf->pares[ma][mb])) {
+                    ma = a;
+                    mb = b;
+                }
+            }
+        }
+        if (ma < 0) break;
+        fprintf(saida, "  %-7s -> %-7s %12llu  %5.1f%%\n", bc_nome_op((BcOp)ma),
+                bc_nome_op((BcOp)mb), pf->pares[ma][mb], 100.0 * pf->pares[ma][mb] / total);
+        pf->pares[ma][mb] = 0;
+    }
+}
+
+/*
+ * Código nativo das camadas: os argumentos que sobram são ignorados (no
+ * System V quem chama desempilha), então um só tipo serve para todos.
+ */
+typedef int (*CodigoNativo)(long, long, long, long, long, long, long, long,
+                            long, long, long, long, long, long, long, long);
+
+static int chamar_nativo(void *codigo, const long *a) {
+    return ((CodigoNativo)codigo)(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7],
+                                  a[8], a[9], a[10], a[11], a[12], a[13], a[14], a[15]);
+}
+
+static int executar(BcPrograma *p, FILE *perfil, BcCamadas *camadas) {
+    if (p->principal < 0) {
+        fprintf(stderr, "ERRO: programa sem main\n");
+        return 1;
+    }
+    if (p->tam_globais > VM_MAX_MEMORIA) {
+        fprintf(stderr, "ERRO: globais grandes demais para a maquina virtual\n");
+        return 1;
+    }
+
+    static const void *const rotulos[BC_NUM_OPS] = {
+        [BC_MOVE] = &&op_move, [BC_LOADI] = &&op_loadi, [BC_LOADK] = &&op_loadk,
+        [BC_GETG] = &&op_getg, [BC_SETG] = &&op_setg, [BC_LADDR] = &&op_laddr,
+        [BC_LOAD] = &&op_load, [BC_STORE] = &&op_store,
+        [BC_ADD] = &&op_add, [BC_SUB] = &&op_sub, [BC_MUL] = &&op_mul, [BC_DIV] = &&op_div,
+        [BC_LT] = &&op_lt, [BC_LE] = &&op_le, [BC_GT] = &&op_gt,
+        [BC_GE] = &&op_ge, [BC_EQ] = &&op_eq, [BC_NE] = &&op_ne,
+        [BC_JMP] = &&op_jmp, [BC_JMPF] = &&op_jmpf, [BC_CALL] = &&op_call,
+        [BC_INPUT] = &&op_input, [BC_OUTPUT] = &&op_output,
+        [BC_RET] = &&op_ret, [BC_RET0] = &&op_ret0,
+        [BC_ADDK] = &&op_addk, [BC_SUBK] = &&op_subk, [BC_MULK] = &&op_mulk,
+        [BC_DIVK] = &&op_divk,
+        [BC_JLT] = &&op_jlt, [BC_JLE] = &&op_jle, [BC_JGT] = &&op_jgt,
+        [BC_JGE] = &&op_jge, [BC_JEQ] = &&op_jeq, [BC_JNE] = &&op_jne,
+        [BC_JLTK] = &&op_jltk, [BC_JLEK] = &&op_jlek, [BC_JGTK] = &&op_jgtk,
+        [BC_JGEK] = &&op_jgek, [BC_JEQK] = &&op_jeqk, [BC_JNEK] = &&op_jnek,
+        [BC_LOADG] = &&op_loadg, [BC_LOADL] = &&op_loadl,
+        [BC_STOREG] = &&op_storeg, [BC_STOREL] = &&op_storel,
+    };
+
+    // nas camadas as chamadas e as voltas de laço passam pelos contadores
+    unsigned *contagem = NULL;
+    unsigned **voltas = NULL;
+    if (camadas) {
+        contagem = (unsigned*)calloc(p->num_funcoes, sizeof(unsigned));
+        voltas = (unsigned**)malloc(sizeof(unsigned*) * p->num_funcoes);
+        for (int n = 0; n < p->num_funcoes; n++) {
+            voltas[n] = (unsigned*)calloc(p->funcoes[n].num_lacos + 1, sizeof(unsigned));
+        }
+    }
+
+    // com perfil toda célula passa antes pelo contador
+    Perfil *pf = perfil ? (Perfil*)calloc(1, sizeof(Perfil)) : NULL;
+    Celula **codigos = (Celula**)malloc(sizeof(Celula*) * p->num_funcoes);
+    for (int n = 0; n < p->num_funcoes; n++) {
+        BcFuncao *fn = &p->funcoes[n];
+        codigos[n] = (Celula*)malloc(sizeof(Celula) * (fn->tam_codigo ? fn->tam_codigo : 1));
+        for (int c = 0; c < fn->tam_codigo; c++) {
+            BcOp op = BC_OP(fn->codigo[c]);
+            if (op >= BC_NUM_OPS) {
+                fprintf(stderr, "ERRO INTERNO: opcode %d invalido\n", op);
+                exit(1);
+            }
+            codigos[n][c].rotulo = pf ? &&perfilar : rotulos[op];
+            codigos[n][c].i = fn->codigo[c];
+            codigos[n][c].laco = -1;
+            if (camadas && op == BC_CALL) codigos[n][c].rotulo = &&op_call_contada;
+            if (camadas && op == BC_JMP && BC_SBX(fn->codigo[c]) < 0) {
+                // o único desvio para trás é a volta de um While
+                int alvo = c + 1 + BC_SBX(fn->codigo[c]);
+                for (int l = 0; l < fn->num_lacos; l++) {
+                    if (fn->lacos[l] == alvo) codigos[n][c].laco = l;
+                }
+                if (codigos[n][c].laco >= 0) codigos[n][c].rotulo = &&op_volta;
+            }
+        }
+    }
+
+    int *pilha = (int*)calloc(VM_MAX_REGS, sizeof(int));
+    Quadro *quadros = (Quadro*)malloc(sizeof(Quadro) * VM_MAX_QUADROS);
+    int *memoria = camadas ? camadas->memoria : (int*)calloc(VM_MAX_MEMORIA, sizeof(int));
+    int *fim_pilha = pilha + VM_MAX_REGS;
+    int status = 0;
+
+    BcFuncao *f = &p->funcoes[p->principal];
+    int *r = pilha;
+    int topo_arrays = p->tam_globais;
+    int arrays = topo_arrays;
+    int num_quadros = 0;
+    int anterior = -1;
+    const Celula *pc;
+    const int *k;
+    BcInstr i;
+
+#define PROXIMA()                       \
+    do {                                \
+        i = pc->i;                      \
+        goto *(pc++)->rotulo;           \
+    } while (0)
+
+    // entrada numa função: locais zerados, arrays locais zerados
+#define ENTRAR()                                                              \
+    do {                                                                      \
+        if (r + f->num_regs > fim_pilha || topo_arrays + f->tam_arrays > VM_MAX_MEMORIA) { \
+            status = erro_execucao("estouro da pilha", f);                    \
+            goto fim;                                                         \
+        }                                                                     \
+        memset(r + f->num_params, 0, sizeof(int) * (f->num_regs - f->num_params)); \
+        arrays = topo_arrays;                                                 \
+        memset(memoria + arrays, 0, sizeof(int) * f->tam_arrays);             \
+        topo_arrays += f->tam_arrays;                                         \
+        pc = codigos[f - p->funcoes];                                         \
+        k = f->constantes;                                                    \
+    } while (0)
+
+    ENTRAR();
+    PROXIMA();
+
+perfilar:
+    pf->ops[BC_OP(i)]++;
+    if (anterior >= 0) pf->pares[anterior][BC_OP(i)]++;
+    anterior = BC_OP(i);
+    goto *rotulos[BC_OP(i)];
+
+op_move:  r[BC_A(i)] = r[BC_B(i)]; PROXIMA();
+op_loadi: r[BC_A(i)] = BC_SBX(i); PROXIMA();
+op_loadk: r[BC_A(i)] = k[BC_BX(i)]; PROXIMA();
+op_getg:  r[BC_A(i)] = memoria[BC_BX(i)]; PROXIMA();
+op_setg:  memoria[BC_BX(i)] = r[BC_A(i)]; PROXIMA();
+op_laddr: r[BC_A(i)] = arrays + BC_BX(i); PROXIMA();
+op_load:  r[BC_A(i)] = memoria[r[BC_B(i)] + r[BC_C(i)]]; PROXIMA();
+op_store: memoria[r[BC_A(i)] + r[BC_B(i)]] = r[BC_C(i)]; PROXIMA();
+
+    // aritmética de 32 bits com volta, como no código nativo
+op_add: r[BC_A(i)] = (int)((unsigned)r[BC_B(i)] + (unsigned)r[BC_C(i)]); PROXIMA();
+op_sub: r[BC_A(i)] = (int)((unsigned)r[BC_B(i)] - (unsigned)r[BC_C(i)]); PROXIMA();
+op_mul: r[BC_A(i)] = (int)((unsigned)r[BC_B(i)] * (unsigned)r[BC_C(i)]); PROXIMA();
+op_div: {
+        int a = r[BC_B(i)], b = r[BC_C(i)];
+        if (b == 0 || (b == -1 && a == (int)0x80000000)) {
+            status = erro_execucao("divisao por zero", f);
+            goto fim;
+        }
+        r[BC_A(i)] = a / b;
+        PROXIMA();
+    }
+
+op_lt: r[BC_A(i)] = r[BC_B(i)] < r[BC_C(i)]; PROXIMA();
+op_le: r[BC_A(i)] = r[BC_B(i)] <= r[BC_C(i)]; PROXIMA();
+op_gt: r[BC_A(i)] = r[BC_B(i)] > r[BC_C(i)]; PROXIMA();
+op_ge: r[BC_A(i)] = r[BC_B(i)] >= r[BC_C(i)]; PROXIMA();
+op_eq: r[BC_A(i)] = r[BC_B(i)] == r[BC_C(i)]; PROXIMA();
+op_ne: r[BC_A(i)] = r[BC_B(i)] != r[BC_C(i)]; PROXIMA();
+
+op_jmp:
+    pc += BC_SBX(i);
+    PROXIMA();
+op_jmpf:
+    if (r[BC_A(i)] == 0) pc += BC_SBX(i);
+    PROXIMA();
+
+op_call: {
+        if (num_quadros == VM_MAX_QUADROS) {
+            status = erro_execucao("estouro da pilha", f);
+            goto fim;
+        }
+        Quadro *q = &quadros[num_quadros++];
+        q->f = f;
+        q->retorno = pc;
+        q->regs = r;
+        q->topo_arrays = arrays;
+        r += BC_A(i);
+        f = &p->funcoes[BC_BX(i)];
+        ENTRAR();
+        PROXIMA();
+    }
+
+    // camadas: a função já tem código nativo?
+op_call_contada: {
+        int n = BC_BX(i);
+        void *nativo = __atomic_load_n(&camadas->nativas[n], __ATOMIC_ACQUIRE);
+        if (nativo) {
+            BcFuncao *g = &p->funcoes[n];
+            int *a = r + BC_A(i);
+            long args[VM_ARGS_NATIVOS] = { 0 };
+            for (int j = 0; j < g->num_params; j++) {
+                args[j] = g->param_array[j] ? (long)(memoria + a[j]) : (long)a[j];
+            }
+            int v = chamar_nativo(nativo, args);
+            a[0] = g->retorna_int ? v : 0;
+            camadas->entradas_nativas++;
+            PROXIMA();
+        }
+        if (++contagem[n] == camadas->limite) camadas->pedir(camadas->dados, n, -1);
+        goto op_call;
+    }
+
+    // camadas: volta de laço; com o código do laço pronto, o resto da
+    // função continua nele a partir do cabeçalho
+op_volta: {
+        int n = (int)(f - p->funcoes);
+        int l = pc[-1].laco;
+        if (++contagem[n] == camadas->limite) camadas->pedir(camadas->dados, n, -1);
+        if (voltas[n][l] < camadas->limite) {
+            if (++voltas[n][l] == camadas->limite) camadas->pedir(camadas->dados, n, l);
+            goto op_jmp;
+        }
+        void *nativo = __atomic_load_n(&camadas->osr[n][l], __ATOMIC_ACQUIRE);
+        if (!nativo) goto op_jmp;
+        long args[VM_ARGS_NATIVOS] = { 0 };
+        int num = 0;
+        args[num++] = (long)r;
+        for (int j = 0; j < f->num_params; j++) {
+            if (f->param_array[j]) args[num++] = (long)(memoria + r[j]);
+        }
+        for (int a = 0; a < f->num_arrays; a++) {
+            args[num++] = (long)(memoria + arrays + f->desloc_arrays[a]);
+        }
+        int v = chamar_nativo(nativo, args);
+        r[0] = f->retorna_int ? v : 0;
+        camadas->entradas_osr++;
+        goto retornar;
+    }
+
+    // superinstruções
+op_addk: r[BC_A(i)] = (int)((unsigned)r[BC_B(i)] + (unsigned)k[BC_C(i)]); PROXIMA();
+op_subk: r[BC_A(i)] = (int)((unsigned)r[BC_B(i)] - (unsigned)k[BC_C(i)]); PROXIMA();
+op_mulk: r[BC_A(i)] = (int)((unsigned)r[BC_B(i)] * (unsigned)k[BC_C(i)]); PROXIMA();
+op_divk: r[BC_A(i)] = r[BC_B(i)] / k[BC_C(i)]; PROXIMA();
+
+    // comparação e desvio: a célula seguinte é o JMP com o deslocamento
+#define DESVIAR_SE(cond)                    \
+    do {                                    \
+        if (cond) pc += 1 + BC_SBX(pc->i);  \
+        else pc++;                          \
+        PROXIMA();                          \
+    } while (0)
+op_jlt:  DESVIAR_SE(r[BC_A(i)] < r[BC_B(i)]);
+op_jle:  DESVIAR_SE(r[BC_A(i)] <= r[BC_B(i)]);
+op_jgt:  DESVIAR_SE(r[BC_A(i)] > r[BC_B(i)]);
+op_jge:  DESVIAR_SE(r[BC_A(i)] >= r[BC_B(i)]);
+op_jeq:  DESVIAR_SE(r[BC_A(i)] == r[BC_B(i)]);
+op_jne:  DESVIAR_SE(r[BC_A(i)] != r[BC_B(i)]);
+op_jltk: DESVIAR_SE(r[BC_A(i)] < k[BC_B(i)]);
+op_jlek: DESVIAR_SE(r[BC_A(i)] <= k[BC_B(i)]);
+op_jgtk: DESVIAR_SE(r[BC_A(i)] > k[BC_B(i)]);
+op_jgek: DESVIAR_SE(r[BC_A(i)] >= k[BC_B(i)]);
+op_jeqk: DESVIAR_SE(r[BC_A(i)] == k[BC_B(i)]);
+op_jnek: DESVIAR_SE(r[BC_A(i)] != k[BC_B(i)]);
+#undef DESVIAR_SE
+
+op_loadg:  r[BC_A(i)] = memoria[k[BC_C(i)] + r[BC_B(i)]]; PROXIMA();
+op_loadl:  r[BC_A(i)] = memoria[arrays + k[BC_C(i)] + r[BC_B(i)]]; PROXIMA();
+op_storeg: memoria[k[BC_A(i)] + r[BC_B(i)]] = r[BC_C(i)]; PROXIMA();
+op_storel: memoria[arrays + k[BC_A(i)] + r[BC_B(i)]] = r[BC_C(i)]; PROXIMA();
+
+op_input:  r[BC_A(i)] = es_input(); PROXIMA();
+op_output: es_output(r[BC_A(i)]); PROXIMA();
+
+op_ret:
+    r[0] = r[BC_A(i)];
+    goto retornar;
+op_ret0:
+    r[0] = 0;
+retornar:
+    if (num_quadros == 0) goto fim;
+    {
+        Quadro *q = &quadros[--num_quadros];
+        topo_arrays = arrays;
+        f = q->f;
+        pc = q->retorno;
+        r = q->regs;
+        arrays = q->topo_arrays;
+        k = f->constantes;
+    }
+    PROXIMA();
+#undef PROXIMA
+#undef ENTRAR
+
+fim:
+    es_descarregar();
+    if (pf) {
+        imprimir_perfil(pf, perfil);
+        free(pf);
+    }
+    for (int n = 0; n < p->num_funcoes; n++) free(codigos[n]);
+    free(codigos);
+    free(pilha);
+    free(quadros);
+    if (camadas) {
+        for (int n = 0; n < p->num_funcoes; n++) free(voltas[n]);
+        free(voltas);
+        free(contagem);
+    } else {
+        free(memoria);
+    }
+    return status;
+}
+
+int vm_executar(BcPrograma *p, FILE *perfil) {
+    return executar(p, perfil, NULL);
+}
+
+int vm_executar_camadas(BcPrograma *p, BcCamadas *camadas) {
+    return executar(p, NULL, camadas);
+}
@@ -0,0 +1,308 @@
+/***********************************************/
+/* Instruções de máquina x86-64                */
+/* Construção, usos e definições de            */
+/* registradores e montagem do quadro          */
+/***********************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "x86.h"
+
+const int x86_regs_args[6] = { X86_RDI, X86_RSI, X86_RDX, X86_RCX, X86_R8, X86_R9 };
+
+/* Registradores que a função chamada precisa preservar */
+int x86_preservado(int reg) {
+    return reg == X86_RBX || reg == X86_RBP || reg == X86_RSP ||
+           (reg >= X86_R12 && reg <= X86_R15);
+}
+
+const char* x86_nome_reg(int reg, int tam) {
+    static const char *q[] = { "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                               "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15" };
+    static const char *l[] = { "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+                               "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d" };
+    static const char *b[] = { "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+                               "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b" };
+    if (tam == 8) return q[reg];
+    if (tam == 1) return b[reg];
+    return l[reg];
+}
+
+MInstr* x86_nova(MOp op, int tam) {
+    MInstr *m = (MInstr*)calloc(1, sizeof(MInstr));
+    m->op = op;
+    m->tam = tam;
+    return m;
+}
+
+MOperando x86_reg(int reg) {
+    MOperando o;
+    memset(&o, 0, sizeof(o));
+    o.tipo = OPR_REG;
+    o.reg = reg;
+    return o;
+}
+
+MOperando x86_imm(long long valor) {
+    MOperando o;
+    memset(&o, 0, sizeof(o));
+    o.tipo = OPR_IMM;
+    o.imm = valor;
+    return o;
+}
+
+MOperando x86_mem(int base, int indice, int escala, long long desloc) {
+    MOperando o;
+    memset(&o, 0, sizeof(o));
+    o.tipo = OPR_MEM;
+    o.reg = base;
+    o.indice = indice;
+    o.escala = escala;
+    o.imm = desloc;
+    return o;
+}
+
+void x86_inserir_fim(MBloco *bloco, MInstr *m) {
+    m->prox = NULL;
+    m->ant = bloco->ultimo;
+    if (bloco->ultimo) bloco->ultimo->prox = m;
+    else bloco->primeiro = m;
+    bloco->ultimo = m;
+}
+
+void x86_inserir_antes(MBloco *bloco, MInstr *pos, MInstr *m) {
+    if (!pos) {
+        x86_inserir_fim(bloco, m);
+        return;
+    }
+    m->prox = pos;
+    m->ant = pos->ant;
+    if (pos->ant) pos->ant->prox = m;
+    else bloco->primeiro = m;
+    pos->ant = m;
+}
+
+void x86_inserir_depois(MBloco *bloco, MInstr *pos, MInstr *m) {
+    x86_inserir_antes(bloco, pos->prox, m);
+}
+
+void x86_remover(MBloco *bloco, MInstr *m) {
+    if (m->ant) m->ant->prox = m->prox;
+    else bloco->primeiro = m->prox;
+    if (m->prox) m->prox->ant = m->ant;
+    else bloco->ultimo = m->ant;
+    m->ant = m->prox = NULL;
+}
+
+/* O destino também é lido (instruções de dois endereços) */
+static int destino_lido(MOp op) {
+    switch (op) {
+        case M_ADD: case M_SUB: case M_IMUL: case M_XOR: case M_AND: case M_SHL: case M_SAR:
+        case M_SHR: case M_CMP: case M_CMOV: case M_PUSH: case M_IDIV: case M_DIV: case M_NEG:
+        case M_JMP:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int destino_escrito(MOp op) {
+    switch (op) {
+        case M_MOV: case M_MOVSX: case M_MOVZX8: case M_LEA: case M_ADD: case M_SUB:
+        case M_IMUL: case M_XOR: case M_AND: case M_SHL: case M_SAR: case M_SHR: case M_SETCC:
+        case M_CMOV: case M_POP: case M_NEG:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int add_reg(int *regs, int num, int reg) {
+    if (reg < 0 || reg == X86_RSP || reg == X86_RBP) return num;
+    for (int i = 0; i < num; i++) {
+        if (regs[i] == reg) return num;
+    }
+    regs[num] = reg;
+    return num + 1;
+}
+
+/*
+ * Registradores lidos pela instrução, incluindo os implícitos (argumentos
+ * de chamada, eax/edx da divisão). rsp e rbp não entram. 'regs' precisa de
+ * espaço para 8 entradas.
+ */
+int x86_usos(MInstr *m, int *regs) {
+    int num = 0;
+    for (int k = 0; k < 2; k++) {
+        MOperando *o = &m->ops[k];
+        if (o->tipo == OPR_MEM) {
+            num = add_reg(regs, num, o->reg);
+            num = add_reg(regs, num, o->indice);
+        } else if (o->tipo == OPR_REG && (k == 1 || destino_lido(m->op))) {
+            num = add_reg(regs, num, o->reg);
+        }
+    }
+    switch (m->op) {
+        case M_CDQ:
+            num = add_reg(regs, num, X86_RAX);
+            break;
+        case M_IDIV:
+        case M_DIV:
+            num = add_reg(regs, num, X86_RAX);
+            num = add_reg(regs, num, X86_RDX);
+            break;
+        case M_CALL:
+        case M_CAUDA:
+            for (int a = 0; a < m->num_args_reg; a++) num = add_reg(regs, num, x86_regs_args[a]);
+            break;
+        case M_RETORNO:
+            num = add_reg(regs, num, X86_RAX);
+            break;
+        case M_REP_STOSQ:
+            num = add_reg(regs, num, X86_RDI);
+            num = add_reg(regs, num, X86_RCX);
+            num = add_reg(regs, num, X86_RAX);
+            break;
+        default:
+            break;
+    }
+    return num;
+}
+
+/* Registradores escritos pela instrução (sem os destruídos por chamadas) */
+int x86_defs(MInstr *m, int *regs) {
+    int num = 0;
+    if (destino_escrito(m->op) && m->ops[0].tipo == OPR_REG) {
+        num = add_reg(regs, num, m->ops[0].reg);
+    }
+    switch (m->op) {
+        case M_CDQ:
+            num = add_reg(regs, num, X86_RDX);
+            break;
+        case M_IDIV:
+        case M_DIV:
+            num = add_reg(regs, num, X86_RAX);
+            num = add_reg(regs, num, X86_RDX);
+            break;
+        case M_CALL:
+            num = add_reg(regs, num, X86_RAX);
+            break;
+        default:
+            break;
+    }
+    return num;
+}
+
+/* Máscara dos registradores físicos que a instrução pode destruir */
+int x86_regs_destruidos(MInstr *m) {
+    switch (m->op) {
+        case M_CALL:
+            return (1 << X86_RAX) | (1 << X86_RCX) | (1 << X86_RDX) | (1 << X86_RSI) |
+                   (1 << X86_RDI) | (1 << X86_R8) | (1 << X86_R9) | (1 << X86_R10) |
+                   (1 << X86_R11);
+        case M_ZERAR:
+        case M_REP_STOSQ:
+            return (1 << X86_RAX) | (1 << X86_RCX) | (1 << X86_RDI);
+        case M_IDIV:
+        case M_DIV:
+            return (1 << X86_RAX) | (1 << X86_RDX);
+        case M_SYSCALL:
+            return (1 << X86_RAX) | (1 << X86_RCX) | (1 << X86_R11);
+        case M_CDQ:
+            return 1 << X86_RDX;
+        default:
+            return 0;
+    }
+}
+
+static void inserir_restauracoes(MFuncao *mf, MBloco *bloco, MInstr *pos, int *desloc_salvo) {
+    for (int r = 0; r < X86_NUM_REGS; r++) {
+        if (!(mf->salvos & (1 << r))) continue;
+        MInstr *m = x86_nova(M_MOV, 8);
+        m->ops[0] = x86_reg(r);
+        m->ops[1] = x86_mem(X86_RBP, -1, 1, -desloc_salvo[r]);
+        x86_inserir_antes(bloco, pos, m);
+    }
+}
+
+/*
+ * Monta o quadro depois da alocação:
+ *
+ *   [rbp - bytes_arrays, rbp)    arrays locais
+ *   abaixo deles                 posições dos virtuais na pilha
+ *   abaixo delas                 registradores preservados usados
+ *
+ * e troca as pseudo-instruções de entrada, retorno, cauda e zeragem pelas
+ * instruções reais.
+ */
+void x86_finalizar_quadro(MFuncao *mf) {
+    int desloc_salvo[X86_NUM_REGS];
+    int topo = mf->bytes_arrays + 8 * mf->num_slots;
+    for (int r = 0; r < X86_NUM_REGS; r++) {
+        if (mf->salvos & (1 << r)) {
+            topo += 8;
+            desloc_salvo[r] = topo;
+        }
+    }
+    int tamanho = (topo + 15) & ~15;
+
+    MBloco *entrada = mf->blocos;
+    MInstr *primeira = x86_nova(M_PUSH, 8);
+    primeira->ops[0] = x86_reg(X86_RBP);
+    MInstr *m = x86_nova(M_MOV, 8);
+    m->ops[0] = x86_reg(X86_RBP);
+    m->ops[1] = x86_reg(X86_RSP);
+    MInstr *seq[2 + X86_NUM_REGS + 1];
+    int num = 0;
+    seq[num++] = primeira;
+    seq[num++] = m;
+    if (tamanho > 0) {
+        m = x86_nova(M_SUB, 8);
+        m->ops[0] = x86_reg(X86_RSP);
+        m->ops[1] = x86_imm(tamanho);
+        seq[num++] = m;
+    }
+    for (int r = 0; r < X86_NUM_REGS; r++) {
+        if (!(mf->salvos & (1 << r))) continue;
+        m = x86_nova(M_MOV, 8);
+        m->ops[0] = x86_mem(X86_RBP, -1, 1, -desloc_salvo[r]);
+        m->ops[1] = x86_reg(r);
+        seq[num++] = m;
+    }
+    for (int i = num - 1; i >= 0; i--) x86_inserir_antes(entrada, entrada->primeiro, seq[i]);
+
+    for (MBloco *b = mf->blocos; b; b = b->prox) {
+        MInstr *i = b->primeiro;
+        while (i) {
+            MInstr *prox = i->prox;
+            if (i->op == M_ZERAR) {
+                MInstr *lea = x86_nova(M_LEA, 8);
+                lea->ops[0] = x86_reg(X86_RDI);
+                lea->ops[1] = x86_mem(X86_RBP, -1, 1, -mf->bytes_arrays);
+                MInstr *cont = x86_nova(M_MOV, 4);
+                cont->ops[0] = x86_reg(X86_RCX);
+                cont->ops[1] = x86_imm(mf->bytes_arrays / 8);
+                MInstr *zero = x86_nova(M_XOR, 4);
+                zero->ops[0] = x86_reg(X86_RAX);
+                zero->ops[1] = x86_reg(X86_RAX);
+                x86_inserir_antes(b, i, lea);
+                x86_inserir_antes(b, i, cont);
+                x86_inserir_antes(b, i, zero);
+                i->op = M_REP_STOSQ;
+                i->tam = 8;
+            } else if (i->op == M_RETORNO || i->op == M_CAUDA) {
+                MInstr *leave = x86_nova(M_LEAVE, 8);
+                x86_inserir_antes(b, i, leave);
+                inserir_restauracoes(mf, b, leave, desloc_salvo);
+                if (i->op == M_RETORNO) {
+                    i->op = M_RET;
+                } else {
+                    i->op = M_JMP;
+                    i->num_args_reg = 0;
+                }
+            }
+            i = prox;
+        }
+    }
+}
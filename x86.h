@@ -0,0 +1,315 @@
+#ifndef X86_H
+#define X86_H
+
+#include <stdio.h>
+#include "ir.h"
+
+/*
+ * Backend x86-64 (System V).
+ *
+ * A IR de cada função, já fora do SSA, vira uma lista de instruções de
+ * máquina por bloco (MInstr) sobre registradores virtuais: o valor %n da IR
+ * é o registrador virtual X86_NUM_REGS + n. O alocador troca os virtuais
+ * por físicos ou posições na pilha, o quadro da função é montado por
+ * x86_finalizar_quadro() e o emissor escreve o texto para o GNU as.
+ */
+
+/* Registradores físicos na numeração do hardware */
+typedef enum {
+    X86_RAX, X86_RCX, X86_RDX, X86_RBX, X86_RSP, X86_RBP, X86_RSI, X86_RDI,
+    X86_R8, X86_R9, X86_R10, X86_R11, X86_R12, X86_R13, X86_R14, X86_R15,
+    X86_NUM_REGS
+} X86Reg;
+
+#define X86_EH_VIRTUAL(r) ((r) >= X86_NUM_REGS)
+
+/* Registradores temporários do reescritor (nunca alocados) */
+#define X86_TEMP0 X86_R10
+#define X86_TEMP1 X86_R11
+
+typedef enum {
+    M_MOV,
+    M_MOVSX,        /* movslq: 32 -> 64 bits com sinal */
+    M_MOVZX8,       /* movzbl: 8 -> 32 bits */
+    M_LEA,
+    M_ADD,
+    M_SUB,
+    M_IMUL,
+    M_XOR,
+    M_AND,
+    M_SHL,          /* deslocamentos por imediato */
+    M_SAR,
+    M_SHR,
+    M_CMP,
+    M_CDQ,          /* cltd: estende eax para edx:eax */
+    M_IDIV,
+    M_DIV,          /* divl sem sinal (runtime) */
+    M_NEG,
+    M_SETCC,
+    M_CMOV,         /* cmovcc: destino = origem se cond */
+    M_PUSH,
+    M_POP,
+    M_JMP,          /* para bloco, função ou registrador (jmp *r) */
+    M_JCC,
+    M_CALL,
+    M_LEAVE,
+    M_RET,
+    M_REP_STOSQ,
+    M_SYSCALL,
+
+    /* Pseudo-instruções trocadas por x86_finalizar_quadro(), que também
+     * cria o prólogo */
+    M_RETORNO,      /* epílogo + ret */
+    M_CAUDA,        /* epílogo + jmp para a função */
+    M_ZERAR         /* zera a área dos arrays locais */
+} MOp;
+
+/* Condições na codificação do hardware (Jcc = 0x70 + cond) */
+typedef enum {
+    CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7,
+    CC_L = 0xc, CC_GE = 0xd, CC_LE = 0xe, CC_G = 0xf
+} MCond;
+
+typedef enum {
+    OPR_NENHUM,
+    OPR_REG,        /* físico ou virtual */
+    OPR_IMM,
+    OPR_MEM,        /* desloc(base, indice, escala); base -1 com simbolo: rip */
+    OPR_BLOCO,
+    OPR_SIMBOLO,    /* função chamada */
+    OPR_TABELA      /* tabela de saltos, relativo ao rip */
+} MTipoOperando;
+
+struct MBloco;
+struct MTabela;
+
+typedef struct {
+    MTipoOperando tipo;
+    int reg;                    /* REG; MEM: base (-1 se relativo ao rip) */
+    int indice;                 /* MEM: -1 sem índice */
+    int escala;
+    long long imm;              /* IMM; MEM: deslocamento */
+    const char *simbolo;        /* MEM/SIMBOLO */
+    struct MBloco *bloco;
+    struct MTabela *tabela;
+} MOperando;
+
+typedef struct MInstr {
+    MOp op;
+    int tam;                    /* 1, 4 ou 8 bytes */
+    MCond cond;
+    MOperando ops[2];           /* ops[0] destino, ops[1] origem */
+    int num_args_reg;           /* M_CALL/M_CAUDA: argumentos em registradores */
+    int pos;                    /* numeração linear (alocadores) */
+    struct MInstr *ant;
+    struct MInstr *prox;
+} MInstr;
+
+typedef struct MBloco {
+    int id;
+    int ordem;                  /* posição na lista de blocos */
+    int profundidade;           /* laços que contêm o bloco */
+    MInstr *primeiro;
+    MInstr *ultimo;
+    int num_suc;
+    struct MBloco **suc;
+    struct MBloco *prox;        /* ordem de emissão */
+} MBloco;
+
+/*
+ * Tabela de saltos, escrita depois do último bloco da função: para cada
+ * índice, a distância do bloco de destino ao início da tabela.
+ */
+typedef struct MTabela {
+    int id;
+    int num_alvos;
+    MBloco **alvos;
+    struct MTabela *prox;
+} MTabela;
+
+typedef struct MFuncao {
+    char *nome;
+    MBloco *blocos;
+    int num_blocos;
+    int num_vregs;              /* virtuais: X86_NUM_REGS .. X86_NUM_REGS+num_vregs-1 */
+    MTabela *tabelas;
+    int num_tabelas;
+
+    int bytes_arrays;           /* arrays locais em [rbp - bytes_arrays, rbp) */
+    int num_slots;              /* posições de 8 bytes abaixo dos arrays */
+    int *reg_vreg;              /* registrador físico de cada virtual ou -1 */
+    int *slot_vreg;             /* posição na pilha de cada virtual ou -1 */
+    int salvos;                 /* máscara de registradores preservados usados */
+    char *remat;                /* virtual na pilha refeito com mov $imm (ou NULL) */
+    long long *remat_valor;
+
+    /* Estatísticas do alocador */
+    int num_intervalos;
+    int num_spills;
+    int num_recargas;
+    int num_guardas;
+    int num_remat;
+    int num_copias_unidas;
+
+    struct MFuncao *prox;
+} MFuncao;
+
+/* Registradores de argumento do System V */
+extern const int x86_regs_args[6];
+int x86_preservado(int reg);
+const char* x86_nome_reg(int reg, int tam);
+
+/* Construção */
+MInstr* x86_nova(MOp op, int tam);
+MOperando x86_reg(int reg);
+MOperando x86_imm(long long valor);
+MOperando x86_mem(int base, int indice, int escala, long long desloc);
+void x86_inserir_fim(MBloco *bloco, MInstr *m);
+void x86_inserir_antes(MBloco *bloco, MInstr *pos, MInstr *m);
+void x86_inserir_depois(MBloco *bloco, MInstr *pos, MInstr *m);
+void x86_remover(MBloco *bloco, MInstr *m);
+
+/* Usos e definições de registradores (físicos e virtuais) */
+int x86_usos(MInstr *m, int *regs);
+int x86_defs(MInstr *m, int *regs);
+int x86_regs_destruidos(MInstr *m);
+
+/*
+ * Vivacidade dos virtuais por bloco (conjuntos de bits indexados por
+ * virtual - X86_NUM_REGS e pelo MBloco.ordem).
+ */
+typedef struct {
+    int num_palavras;
+    unsigned long **entrada;
+    unsigned long **saida;
+} VivacidadeX86;
+
+#define BIT_TEM(c, v) (((c)[(v) / (8 * sizeof(unsigned long))] >> ((v) % (8 * sizeof(unsigned long)))) & 1UL)
+#define BIT_POE(c, v) ((c)[(v) / (8 * sizeof(unsigned long))] |= 1UL << ((v) % (8 * sizeof(unsigned long))))
+#define BIT_TIRA(c, v) ((c)[(v) / (8 * sizeof(unsigned long))] &= ~(1UL << ((v) % (8 * sizeof(unsigned long)))))
+
+void x86_calcular_vivacidade(MFuncao *mf, VivacidadeX86 *viv);
+void x86_liberar_vivacidade(MFuncao *mf, VivacidadeX86 *viv);
+int x86_numerar(MFuncao *mf);
+
+typedef enum {
+    ALOCADOR_PILHA,             /* todo virtual na pilha */
+    ALOCADOR_LINEAR,            /* varredura linear (padrão) */
+    ALOCADOR_GRAFO              /* coloração de grafo (Chaitin/Briggs) */
+} AlocadorX86;
+
+typedef struct CacheX86 CacheX86;      /* cache.h */
+
+typedef struct {
+    AlocadorX86 alocador;
+    FILE *relatorio;            /* estatísticas de alocação por função */
+    CacheX86 *cache;            /* código por função em disco, ou NULL */
+} OpcoesX86;
+
+/* Etapas */
+void ir_sair_ssa(IrFuncao *f);
+MFuncao* x86_selecionar(IrModulo *mod, IrFuncao *f);
+void x86_preparar_alocacao(MFuncao *mf);
+void x86_alocar_pilha(MFuncao *mf);
+void x86_alocar_linear(MFuncao *mf);
+void x86_alocar_grafo(MFuncao *mf);
+void x86_reescrever(MFuncao *mf);
+void x86_finalizar_quadro(MFuncao *mf);
+
+/* Da IR ao código de máquina alocado e com o quadro montado */
+MFuncao* x86_gerar_funcao(IrModulo *mod, IrFuncao *f, OpcoesX86 *op);
+
+/* Emissão em texto */
+void x86_emitir_funcao(MFuncao *mf, FILE *saida);
+void x86_emitir_runtime(FILE *saida);
+void x86_relatorio_alocacao(MFuncao *mf, FILE *saida);
+void x86_emitir_modulo(IrModulo *mod, OpcoesX86 *op, FILE *saida);
+
+/* Runtime: funções de máquina (_start, rt_getc, rt_input, rt_output, rt_indice) */
+MFuncao* x86_runtime(void);
+
+/*
+ * Código de máquina em memória: o texto codificado, o tamanho do .bss, os
+ * símbolos definidos e as referências relativas ao rip (rel32) ainda por
+ * resolver. x86_codigo_ligar() resolve tudo dadas as bases do texto e do
+ * .bss, sem montador ou ligador externos.
+ */
+typedef enum { SECAO_TEXTO, SECAO_BSS } SecaoX86;
+
+typedef struct {
+    const char *nome;
+    SecaoX86 secao;
+    long long valor;            /* deslocamento dentro da seção */
+} SimboloX86;
+
+typedef struct {
+    int pos;                    /* campo de 32 bits no texto */
+    int fim;                    /* fim da instrução (base do rip) */
+    const char *simbolo;
+    long long desloc;
+} RelocX86;
+
+typedef struct {
+    unsigned char *texto;
+    int tam_texto;
+    int cap_texto;
+    long long tam_bss;
+
+    SimboloX86 *simbolos;
+    int num_simbolos;
+    int cap_simbolos;
+
+    RelocX86 *relocs;
+    int num_relocs;
+    int cap_relocs;
+} CodigoX86;
+
+void x86_codigo_iniciar(CodigoX86 *c);
+void x86_codigo_liberar(CodigoX86 *c);
+SimboloX86* x86_codigo_simbolo(CodigoX86 *c, const char *nome);
+void x86_codigo_definir(CodigoX86 *c, const char *nome, SecaoX86 secao, long long valor);
+void x86_codigo_bss(CodigoX86 *c, const char *nome, long long bytes);
+void x86_codificar_funcao(CodigoX86 *c, MFuncao *mf);
+void x86_codigo_anexar(CodigoX86 *c, CodigoX86 *outro);    /* texto, símbolos e relocs */
+void x86_codigo_externo(CodigoX86 *c, const char *nome, void *endereco);
+void x86_codificar_runtime(CodigoX86 *c);
+void x86_codificar_modulo(IrModulo *mod, OpcoesX86 *op, CodigoX86 *c);
+int x86_codigo_ligar(CodigoX86 *c, unsigned long long base_texto, unsigned long long base_bss);
+
+/* Executável ELF64 estático com o código ligado */
+int x86_escrever_elf(CodigoX86 *c, const char *caminho);
+
+/*
+ * Execução em memória: o código vai para uma região executável e main é
+ * chamada direto, com input/output ligados a rotinas de E/S do próprio
+ * compilador. Retorna o código de saída do programa.
+ */
+int x86_executar(IrModulo *mod, OpcoesX86 *op);
+
+/* O mesmo em dois passos: código carregado e ligado, pronto para chamar */
+typedef struct {
+    unsigned char *regiao;      /* texto seguido do .bss */
+    size_t tamanho;
+    void (*principal)(void);    /* main do programa */
+} ProgramaX86;
+
+int x86_carregar(IrModulo *mod, OpcoesX86 *op, ProgramaX86 *prog);   /* 0 se falhou */
+void x86_descarregar(ProgramaX86 *prog);
+
+/*
+ * Execução em lote (--lote): o programa é carregado uma vez e cada
+ * arquivo <nome>.in do diretório roda num processo filho criado com fork
+ * a partir desse estado, sem exec nem nova compilação. O filho tem stdin
+ * no .in, stdout em <nome>.saida e limites de CPU e memória; a saída é
+ * comparada com <nome>.out quando ele existe. Imprime uma linha por
+ * entrada (situação, tempo real e de CPU) e o total. Retorna 0 se todas
+ * terminaram normalmente com a saída esperada.
+ */
+typedef struct {
+    int cpu_segundos;           /* RLIMIT_CPU */
+    int memoria_mb;             /* RLIMIT_AS além do já mapeado */
+} LimitesLote;
+
+int x86_executar_lote(IrModulo *mod, OpcoesX86 *op, const char *diretorio, LimitesLote *limites);
+
+#endif // X86_H